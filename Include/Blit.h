@@ -0,0 +1,409 @@
+/**
+ * @file Blit.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the 2D drawing primitives shared by the
+ * bootloader and the kernel, which fill, copy, blend, and convert
+ * rectangles of 32-bit pixels. Each has a scalar, an SSE2, and an AVX2
+ * path, all giving exactly the same pixels, and the best one the
+ * processor can run is picked at runtime. The vector paths carry the same
+ * restrictions as the SSE2 memory primitives: they clobber the vector
+ * registers, so the kernel, which saves no vector state, may only reach
+ * them with interrupts disabled.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_BLIT_H
+#define COBALT_BLIT_H
+
+#include <Types.h>
+
+/**
+ * @brief The rows each benchmarked operation is run over, and the width of
+ * each row in pixels. The rows are laid out back to back.
+ * @since 0.1.0.6
+ */
+#define COBALT_BLIT_BENCHMARK_SIZE 512
+
+/**
+ * @brief A way of running the primitives.
+ * @since 0.1.0.6
+ */
+typedef enum : cobalt_u32_t
+{
+    /**
+     * @brief General purpose registers alone.
+     * @since 0.1.0.6
+     */
+    COBALT_BLIT_SCALAR,
+    /**
+     * @brief 128-bit SSE2 vectors.
+     * @since 0.1.0.6
+     */
+    COBALT_BLIT_SSE2,
+    /**
+     * @brief 256-bit AVX2 vectors.
+     * @since 0.1.0.6
+     */
+    COBALT_BLIT_AVX2,
+    /**
+     * @brief The number of paths.
+     * @since 0.1.0.6
+     */
+    COBALT_BLIT_PATH_COUNT
+} cobalt_blit_path_t;
+
+/**
+ * @brief A primitive, as the benchmark names it.
+ * @since 0.1.0.6
+ */
+typedef enum : cobalt_u32_t
+{
+    /**
+     * @brief Cobalt_FillRect.
+     * @since 0.1.0.6
+     */
+    COBALT_BLIT_FILL,
+    /**
+     * @brief Cobalt_CopyRect, between overlapping rectangles.
+     * @since 0.1.0.6
+     */
+    COBALT_BLIT_COPY,
+    /**
+     * @brief Cobalt_BlendRect.
+     * @since 0.1.0.6
+     */
+    COBALT_BLIT_BLEND,
+    /**
+     * @brief Cobalt_ConvertRect.
+     * @since 0.1.0.6
+     */
+    COBALT_BLIT_CONVERT,
+    /**
+     * @brief The number of primitives.
+     * @since 0.1.0.6
+     */
+    COBALT_BLIT_OPERATION_COUNT
+} cobalt_blit_operation_t;
+
+/**
+ * @brief A rectangle of pixels in memory to draw into or from.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief The pixels, row by row.
+     * @since 0.1.0.6
+     */
+    cobalt_u32_t *pixels;
+
+    /**
+     * @brief The width of the surface in pixels.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t width;
+
+    /**
+     * @brief The height of the surface in pixels.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t height;
+
+    /**
+     * @brief The distance between the starts of two rows in pixels.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t pitch;
+} cobalt_surface_t;
+
+/**
+ * @brief Find the fastest path this processor can run, and use it from
+ * here on. Until this is called, the scalar path is used.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return The path picked.
+ */
+cobalt_blit_path_t Cobalt_SelectBlitPath(void);
+
+/**
+ * @brief Get whether this processor can run a path. AVX2 also needs the
+ * operating system to have turned on the upper halves of the registers.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param path The path.
+ * @return Whether or not the path can run.
+ */
+bool Cobalt_BlitPathSupported(cobalt_blit_path_t path);
+
+/**
+ * @brief Use a path from here on.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param path The path. It must be supported.
+ */
+void Cobalt_SetBlitPath(cobalt_blit_path_t path);
+
+/**
+ * @brief Fill a rectangle with one pixel.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param surface The surface to draw into.
+ * @param x The left edge of the rectangle.
+ * @param y The top edge of the rectangle.
+ * @param width The width of the rectangle.
+ * @param height The height of the rectangle. Whatever lies off the surface
+ * is left alone.
+ * @param pixel The pixel to fill with.
+ */
+void Cobalt_FillRect(const cobalt_surface_t *surface, cobalt_u64_t x,
+                     cobalt_u64_t y, cobalt_u64_t width,
+                     cobalt_u64_t height, cobalt_u32_t pixel);
+
+/**
+ * @brief Copy a rectangle from one surface to another, or within one. The
+ * two rectangles may overlap.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param destination The surface to draw into.
+ * @param x The left edge of the rectangle in the destination.
+ * @param y The top edge of the rectangle in the destination.
+ * @param source The surface to copy from.
+ * @param sourceX The left edge of the rectangle in the source.
+ * @param sourceY The top edge of the rectangle in the source.
+ * @param width The width of the rectangle.
+ * @param height The height of the rectangle. The rectangle is clipped to
+ * both surfaces.
+ */
+void Cobalt_CopyRect(const cobalt_surface_t *destination, cobalt_u64_t x,
+                     cobalt_u64_t y, const cobalt_surface_t *source,
+                     cobalt_u64_t sourceX, cobalt_u64_t sourceY,
+                     cobalt_u64_t width, cobalt_u64_t height);
+
+/**
+ * @brief Blend a rectangle of one surface over another, by the alpha in
+ * the top byte of each source pixel. Every byte of the result, including
+ * the top one, is the source's and the destination's mixed by that alpha
+ * and rounded to nearest. The rectangles must not overlap, unless they
+ * are one and the same.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param destination The surface to draw into.
+ * @param x The left edge of the rectangle in the destination.
+ * @param y The top edge of the rectangle in the destination.
+ * @param source The surface to blend from.
+ * @param sourceX The left edge of the rectangle in the source.
+ * @param sourceY The top edge of the rectangle in the source.
+ * @param width The width of the rectangle.
+ * @param height The height of the rectangle, clipped as for
+ * Cobalt_CopyRect.
+ */
+void Cobalt_BlendRect(const cobalt_surface_t *destination, cobalt_u64_t x,
+                      cobalt_u64_t y, const cobalt_surface_t *source,
+                      cobalt_u64_t sourceX, cobalt_u64_t sourceY,
+                      cobalt_u64_t width, cobalt_u64_t height);
+
+/**
+ * @brief Copy a rectangle between surfaces, swapping the bottom and third
+ * bytes of each pixel, which turns BGRX into RGBX and back again. The
+ * rectangles must not overlap, unless they're one and the same.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param destination The surface to draw into.
+ * @param x The left edge of the rectangle in the destination.
+ * @param y The top edge of the rectangle in the destination.
+ * @param source The surface to convert from.
+ * @param sourceX The left edge of the rectangle in the source.
+ * @param sourceY The top edge of the rectangle in the source.
+ * @param width The width of the rectangle.
+ * @param height The height of the rectangle, clipped as for
+ * Cobalt_CopyRect.
+ */
+void Cobalt_ConvertRect(const cobalt_surface_t *destination,
+                        cobalt_u64_t x, cobalt_u64_t y,
+                        const cobalt_surface_t *source,
+                        cobalt_u64_t sourceX, cobalt_u64_t sourceY,
+                        cobalt_u64_t width, cobalt_u64_t height);
+
+/**
+ * @brief Time every primitive on every path this processor supports, over
+ * COBALT_BLIT_BENCHMARK_SIZE rows of as many pixels. The path in use is
+ * left as it was. This takes nothing from the kernel, so it can be linked
+ * into an ordinary program and run on the build machine as well.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param scratch Room for two surfaces' worth of pixels, which is
+ * 2 * COBALT_BLIT_BENCHMARK_SIZE squared pixels.
+ * @param ticksPerMicrosecond The rate of the timestamp counter.
+ * @param results Filled with the megapixels per second each primitive
+ * managed on each path, or zero for a path that isn't supported.
+ */
+void Cobalt_BenchmarkBlit(
+    cobalt_u32_t *scratch, cobalt_u64_t ticksPerMicrosecond,
+    cobalt_u64_t results[COBALT_BLIT_OPERATION_COUNT]
+                        [COBALT_BLIT_PATH_COUNT]);
+
+/**
+ * @brief Fill a run of pixels with one pixel.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param destination The pixels to fill.
+ * @param pixel The pixel to fill with.
+ * @param count The number of pixels. This may be zero.
+ */
+void Cobalt_FillPixels(cobalt_u32_t *destination, cobalt_u32_t pixel,
+                       cobalt_u64_t count);
+
+/**
+ * @brief Copy a run of pixels. The runs may overlap.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param destination The pixels to copy into.
+ * @param source The pixels to copy from.
+ * @param count The number of pixels. This may be zero.
+ */
+void Cobalt_CopyPixels(cobalt_u32_t *destination,
+                       const cobalt_u32_t *source, cobalt_u64_t count);
+
+/**
+ * @brief Blend a run of pixels over another; see Cobalt_BlendRect.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param destination The pixels to blend into.
+ * @param source The pixels to blend from.
+ * @param count The number of pixels. This may be zero.
+ */
+void Cobalt_BlendPixels(cobalt_u32_t *destination,
+                        const cobalt_u32_t *source, cobalt_u64_t count);
+
+/**
+ * @brief Copy a run of pixels, swapping their red and blue bytes; see
+ * Cobalt_ConvertRect.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param destination The pixels to copy into.
+ * @param source The pixels to copy from.
+ * @param count The number of pixels. This may be zero.
+ */
+void Cobalt_ConvertPixels(cobalt_u32_t *destination,
+                          const cobalt_u32_t *source, cobalt_u64_t count);
+
+/**
+ * @brief The SSE2 path of Cobalt_FillPixels. This is built with vector
+ * registers enabled; see the top of the file.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param destination The pixels to fill.
+ * @param pixel The pixel to fill with.
+ * @param count The number of pixels. This may be zero.
+ */
+void Cobalt_FillPixelsSSE2(cobalt_u32_t *destination, cobalt_u32_t pixel,
+                           cobalt_u64_t count);
+
+/**
+ * @brief The SSE2 path of Cobalt_CopyPixels.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param destination The pixels to copy into.
+ * @param source The pixels to copy from.
+ * @param count The number of pixels. This may be zero.
+ */
+void Cobalt_CopyPixelsSSE2(cobalt_u32_t *destination,
+                           const cobalt_u32_t *source, cobalt_u64_t count);
+
+/**
+ * @brief The SSE2 path of Cobalt_BlendPixels.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param destination The pixels to blend into.
+ * @param source The pixels to blend from.
+ * @param count The number of pixels. This may be zero.
+ */
+void Cobalt_BlendPixelsSSE2(cobalt_u32_t *destination,
+                            const cobalt_u32_t *source,
+                            cobalt_u64_t count);
+
+/**
+ * @brief The SSE2 path of Cobalt_ConvertPixels.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param destination The pixels to copy into.
+ * @param source The pixels to copy from.
+ * @param count The number of pixels. This may be zero.
+ */
+void Cobalt_ConvertPixelsSSE2(cobalt_u32_t *destination,
+                              const cobalt_u32_t *source,
+                              cobalt_u64_t count);
+
+/**
+ * @brief The AVX2 path of Cobalt_FillPixels. This must only be called
+ * where Cobalt_BlitPathSupported says AVX2 can run.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param destination The pixels to fill.
+ * @param pixel The pixel to fill with.
+ * @param count The number of pixels. This may be zero.
+ */
+void Cobalt_FillPixelsAVX2(cobalt_u32_t *destination, cobalt_u32_t pixel,
+                           cobalt_u64_t count);
+
+/**
+ * @brief The AVX2 path of Cobalt_CopyPixels.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param destination The pixels to copy into.
+ * @param source The pixels to copy from.
+ * @param count The number of pixels. This may be zero.
+ */
+void Cobalt_CopyPixelsAVX2(cobalt_u32_t *destination,
+                           const cobalt_u32_t *source, cobalt_u64_t count);
+
+/**
+ * @brief The AVX2 path of Cobalt_BlendPixels.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param destination The pixels to blend into.
+ * @param source The pixels to blend from.
+ * @param count The number of pixels. This may be zero.
+ */
+void Cobalt_BlendPixelsAVX2(cobalt_u32_t *destination,
+                            const cobalt_u32_t *source,
+                            cobalt_u64_t count);
+
+/**
+ * @brief The AVX2 path of Cobalt_ConvertPixels.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param destination The pixels to copy into.
+ * @param source The pixels to copy from.
+ * @param count The number of pixels. This may be zero.
+ */
+void Cobalt_ConvertPixelsAVX2(cobalt_u32_t *destination,
+                              const cobalt_u32_t *source,
+                              cobalt_u64_t count);
+
+#endif // COBALT_BLIT_H
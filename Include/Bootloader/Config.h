@@ -0,0 +1,130 @@
+/**
+ * @file Config.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the interface for reading the boot
+ * configuration file, \COBALT.CFG, off of the boot volume. The file is a
+ * list of "key = value" lines, with blank lines and lines beginning with
+ * '#' ignored. The keys understood are "timeout" (in seconds, where zero
+ * boots immediately), "kernel" (the kernel's path on the volume),
+ * "graphics" (the preferred resolution, as WIDTHxHEIGHT), and "format"
+ * (the preferred pixel format, one of "rgb", "bgr", "bitmask", or
+ * "any").
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_BOOTLOADER_CONFIG_H
+#define COBALT_BOOTLOADER_CONFIG_H
+
+#include <Bootloader/EFI/Files.h>
+#include <Bootloader/Types.h>
+#include <Types.h>
+
+/**
+ * @brief The path of the boot configuration file on the boot volume.
+ * @since 0.1.0.6
+ */
+#define COBALT_CONFIG_PATH L"\\COBALT.CFG"
+
+/**
+ * @brief The longest kernel path the configuration may give, in
+ * characters, including the null terminator.
+ * @since 0.1.0.6
+ */
+#define COBALT_CONFIG_PATH_LENGTH 128
+
+/**
+ * @brief The longest timeout the configuration may give, in seconds.
+ * @since 0.1.0.6
+ */
+#define COBALT_CONFIG_MAXIMUM_TIMEOUT 3600
+
+/**
+ * @brief The boot configuration. Anything the configuration file doesn't
+ * mention keeps its default value.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief How long to wait for a key before booting, in seconds. Zero
+     * boots straight away. This defaults to five seconds.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t timeout;
+
+    /**
+     * @brief The path of the kernel on the boot volume. This defaults to
+     * \KERNEL.efi.
+     * @since 0.1.0.6
+     */
+    COBALT_WIDECHAR kernelPath[COBALT_CONFIG_PATH_LENGTH];
+
+    /**
+     * @brief The preferred horizontal resolution of the display, or zero
+     * if there's no preference.
+     * @since 0.1.0.6
+     */
+    cobalt_u32_t graphicsWidth;
+
+    /**
+     * @brief The preferred vertical resolution of the display, or zero if
+     * there's no preference.
+     * @since 0.1.0.6
+     */
+    cobalt_u32_t graphicsHeight;
+
+    /**
+     * @brief The preferred pixel format of the display, or PixelFormatMax
+     * if there's no preference, which is the default.
+     * @since 0.1.0.6
+     */
+    EFI_GRAPHICS_PIXEL_FORMAT graphicsFormat;
+} cobalt_boot_config_t;
+
+/**
+ * @brief Fill a configuration with its default values.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param config The configuration to fill.
+ */
+void Cobalt_DefaultConfig(cobalt_boot_config_t *config);
+
+/**
+ * @brief Parse the text of a configuration file on top of the given
+ * configuration. A line that can't be understood is skipped, and parsing
+ * carries on with the next.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param text The text of the file. This need not be null-terminated.
+ * @param size The size of the text in bytes.
+ * @param config The configuration to fill.
+ * @return The number of the first line (counting from one) that couldn't
+ * be understood, or zero if every line was.
+ */
+cobalt_u64_t Cobalt_ParseConfig(const char *text, cobalt_u64_t size,
+                                cobalt_boot_config_t *config);
+
+/**
+ * @brief Read and parse the configuration file from the boot volume. A
+ * missing or empty file is not an error; the configuration simply keeps
+ * its defaults.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param root The root of the boot volume.
+ * @param bootServices The EFI boot services table.
+ * @param config The configuration to fill.
+ * @return The status of the operation.
+ */
+EFI_STATUS Cobalt_ReadConfig(cobalt_efi_root_volume_t *root,
+                             EFI_BOOT_SERVICES *bootServices,
+                             cobalt_boot_config_t *config);
+
+#endif // COBALT_BOOTLOADER_CONFIG_H
@@ -0,0 +1,37 @@
+/**
+ * @file Decompress.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the interface for Cobalt's LZ4 block format
+ * decompressor. It depends on nothing but the processor, and so builds
+ * just as well on a host machine as it does in the bootloader.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_BOOTLOADER_DECOMPRESS_H
+#define COBALT_BOOTLOADER_DECOMPRESS_H
+
+#include <Types.h>
+
+/**
+ * @brief Decompress a single LZ4 block straight into its destination.
+ * Every read and write is bounds-checked, so malformed input fails rather
+ * than scribbling over memory.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param source The compressed block.
+ * @param sourceSize The size of the compressed block in bytes.
+ * @param destination The buffer to decompress into.
+ * @param destinationSize The exact size of the decompressed data.
+ * @return Whether or not the block was valid and decompressed to exactly
+ * destinationSize bytes.
+ */
+bool Cobalt_Decompress(const void *source, cobalt_u64_t sourceSize,
+                       void *destination, cobalt_u64_t destinationSize);
+
+#endif // COBALT_BOOTLOADER_DECOMPRESS_H
@@ -4,7 +4,7 @@
  * @brief This file contains the Cobalt interface for opening files via the
  * UEFI framework's provided simple filesystem protocol.
  * @since 0.1.0.3
- * @updated 0.1.0.5
+ * @updated 0.1.0.6
  *
  * @copyright (c) 2025 Israfil Argos
  * This file is under the AGPLv3. For information on what that entails, see
@@ -16,12 +16,38 @@
 
 #include <efi.h>
 
-#include <Headers/DOS.h>
-
 typedef EFI_SIMPLE_FILE_SYSTEM_PROTOCOL cobalt_efi_filesystem_t;
 typedef EFI_FILE cobalt_efi_root_volume_t;
 typedef EFI_FILE cobalt_efi_file_t;
 
+/**
+ * @brief A read that may still be in flight. Where the firmware can't
+ * read asynchronously, the read has already been done by the time this
+ * is filled, and finishing it just reports the result.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief The token handed to ReadEx. Its event is nullptr once the
+     * read is known to be complete.
+     * @since 0.1.0.6
+     */
+    EFI_FILE_IO_TOKEN token;
+
+    /**
+     * @brief The offset within the file the read started at.
+     * @since 0.1.0.6
+     */
+    UINT64 offset;
+
+    /**
+     * @brief The number of bytes asked for.
+     * @since 0.1.0.6
+     */
+    UINT64 size;
+} cobalt_file_request_t;
+
 EFI_STATUS
 Cobalt_OpenFilesystem(EFI_HANDLE *imageHandle, EFI_HANDLE *deviceHandle,
                       EFI_BOOT_SERVICES *bootServices,
@@ -38,7 +64,106 @@ EFI_STATUS Cobalt_OpenFile(cobalt_efi_root_volume_t *root,
 
 EFI_STATUS Cobalt_CloseFile(cobalt_efi_file_t *file);
 
-EFI_STATUS Cobalt_ReadDOSHeader(cobalt_efi_file_t *file,
-                                cobalt_dos_header_t *header);
+/**
+ * @brief Read the entirety of a file into a freshly allocated,
+ * page-aligned buffer with a single read call. Every call into the
+ * firmware's filesystem driver is a round trip to the disk, so this is far
+ * faster than reading a file piecemeal.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param file The file to read. This is read from its start.
+ * @param bootServices The EFI boot services table.
+ * @param buffer A pointer to be filled with the allocated buffer. This
+ * must be freed with FreePages and a page count of
+ * EFI_SIZE_TO_PAGES(*size).
+ * @param size A pointer to be filled with the size of the file in bytes.
+ * @return The status of the operation.
+ */
+EFI_STATUS Cobalt_ReadFile(cobalt_efi_file_t *file,
+                           EFI_BOOT_SERVICES *bootServices, void **buffer,
+                           UINT64 *size);
+
+/**
+ * @brief Get the size of a file.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param file The file to query.
+ * @param bootServices The EFI boot services table.
+ * @param size A pointer to be filled with the size of the file in bytes.
+ * @return The status of the operation.
+ */
+EFI_STATUS Cobalt_GetFileSize(cobalt_efi_file_t *file,
+                              EFI_BOOT_SERVICES *bootServices,
+                              UINT64 *size);
+
+/**
+ * @brief Read part of a file into a freshly allocated, page-aligned
+ * buffer with a single read call.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param file The file to read.
+ * @param bootServices The EFI boot services table.
+ * @param offset The offset within the file to start reading at.
+ * @param size The number of bytes to read. The read fails if the file
+ * holds fewer than this many bytes past the offset.
+ * @param buffer A pointer to be filled with the allocated buffer. This
+ * must be freed with FreePages and a page count of
+ * EFI_SIZE_TO_PAGES(size).
+ * @return The status of the operation.
+ */
+EFI_STATUS Cobalt_ReadFileRange(cobalt_efi_file_t *file,
+                                EFI_BOOT_SERVICES *bootServices,
+                                UINT64 offset, UINT64 size, void **buffer);
+
+/**
+ * @brief Check whether a file supports asynchronous reads, which arrived
+ * with revision 2 of the file protocol.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param file The file to check.
+ * @return Whether or not ReadEx may be called on the file.
+ */
+bool Cobalt_FileSupportsAsync(cobalt_efi_file_t *file);
+
+/**
+ * @brief Start reading part of a file into the given buffer. The read is
+ * queued with ReadEx where the firmware supports it, and otherwise (or if
+ * ReadEx refuses the request) is done synchronously before returning.
+ * Either way, the buffer must not be touched until the read is finished
+ * with Cobalt_FinishFileRead.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param file The file to read.
+ * @param bootServices The EFI boot services table.
+ * @param offset The offset within the file to start reading at.
+ * @param size The number of bytes to read.
+ * @param buffer The buffer to read into.
+ * @param request The request to fill. This must stay where it is until
+ * the read is finished.
+ * @return The status of the operation. On failure, there is nothing to
+ * finish.
+ */
+EFI_STATUS Cobalt_BeginFileRead(cobalt_efi_file_t *file,
+                                EFI_BOOT_SERVICES *bootServices,
+                                UINT64 offset, UINT64 size, void *buffer,
+                                cobalt_file_request_t *request);
+
+/**
+ * @brief Wait for a read started with Cobalt_BeginFileRead to complete.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param bootServices The EFI boot services table.
+ * @param request The request to wait on.
+ * @return The status of the read. This is EFI_END_OF_FILE if fewer bytes
+ * were read than were asked for.
+ */
+EFI_STATUS Cobalt_FinishFileRead(EFI_BOOT_SERVICES *bootServices,
+                                 cobalt_file_request_t *request);
 
 #endif // COBALT_BOOTLOADER_EFI_FILES_H
@@ -3,9 +3,31 @@
 
 #include <efi.h>
 
+/**
+ * @brief Pick a graphics mode on the first graphics device that has a
+ * usable one, set it, and describe it for the kernel. The mode that best
+ * fits the request is chosen, and the one already active wins any tie,
+ * so that the modeset can be skipped. The choice is cached in an EFI
+ * variable, and trusted on later boots for as long as the request and
+ * the mode stay the same.
+ *
+ * @param graphicsMode The description of the mode to fill.
+ * @param imageHandle The loader's image handle.
+ * @param services The EFI boot services table.
+ * @param runtime The EFI runtime services table, for the cache.
+ * @param preferredWidth The preferred horizontal resolution, or zero if
+ * there's no preference, in which case the active mode is kept.
+ * @param preferredHeight The preferred vertical resolution.
+ * @param preferredFormat The preferred pixel format, or PixelFormatMax if
+ * any with a framebuffer will do.
+ * @return The status of the operation.
+ */
 EFI_STATUS
 Cobalt_InitializeGraphics(EFI_GRAPHICS_OUTPUT_PROTOCOL_MODE *graphicsMode,
                           EFI_HANDLE *imageHandle,
-                          EFI_BOOT_SERVICES *services);
+                          EFI_BOOT_SERVICES *services,
+                          EFI_RUNTIME_SERVICES *runtime,
+                          UINT32 preferredWidth, UINT32 preferredHeight,
+                          EFI_GRAPHICS_PIXEL_FORMAT preferredFormat);
 
 #endif // COBALT_BOOTLOADER_EFI_GRAPHICS_H
@@ -6,7 +6,7 @@
  * bootloader section of the operating system. All functions within this
  * file deal exclusively in UTF-16 strings.
  * @since 0.1.0.0
- * @updated 0.1.0.3
+ * @updated 0.1.0.6
  *
  * @copyright (c) 2025 Israfil Argos
  * This file is under the AGPLv3. For information on what that entails, see
@@ -53,14 +53,20 @@ EFI_STATUS Cobalt_PrimitiveClear(void);
  * @brief An incredibly primitive formatted string printer using a
  * libc-style format string, with MUCH more simplified formatters. As
  * follows, the allowed formatters are: `s`: wide string, `L`: integer,
- * `U`: unsigned integer.
+ * `U`: unsigned integer, `X`/`x`: unsigned integer in upper or lower case
+ * hexadecimal, `p`: pointer, `%`: a percent sign. Any formatter may be
+ * given a field width, which numbers may start with a zero to pad with
+ * zeroes instead of spaces, as in `%08X`. The output is gathered into a
+ * buffer and handed to the firmware in as few calls as it fits in,
+ * usually one.
  * @authors Israfil Argos
  * @since 0.1.0.0
  *
  * @param format The format string to interleave with the supplied
  * arguments. If this is simply a string, it is far more advised to just
  * use the PrimitivePuts function.
- * @param ... The arguments to interleave with the format string.
+ * @param args The arguments to interleave with the format string. Every
+ * integer is read as 64 bits wide.
  * @return The status code of the operation. Should a print fail, this will
  * be a failure as deigned by EFI_ERROR.
  *
@@ -71,9 +77,8 @@ EFI_STATUS Cobalt_PrimitivePrintfv(COBALT_WIDESTR format, va_list args);
 
 /**
  * @brief An incredibly primitive formatted string printer using a
- * libc-style format string, with MUCH more simplified formatters. As
- * follows, the allowed formatters are: `s`: wide string, `L`: integer,
- * `U`: unsigned integer.
+ * libc-style format string, with MUCH more simplified formatters. See
+ * Cobalt_PrimitivePrintfv for the allowed formatters.
  * @authors Israfil Argos
  * @since 0.1.0.0
  *
@@ -100,6 +105,17 @@ EFI_STATUS Cobalt_PrimitivePrintf(COBALT_WIDESTR format, ...);
  */
 EFI_STATUS Cobalt_PrimitivePuts(COBALT_WIDESTR string);
 
+/**
+ * @brief Print a message followed by the time the loader started, as the
+ * firmware reported it. The firmware's clock is only read once, when the
+ * loader starts, since it's slow to read.
+ * @authors Israfil Argos
+ * @since 0.1.0.0
+ *
+ * @param messageFormat The format string to print before the time.
+ * @param ... The arguments to interleave with the format string.
+ * @return The status of the print.
+ */
 EFI_STATUS Cobalt_PrimitiveTimestamp(COBALT_WIDESTR messageFormat, ...);
 
 #endif // COBALT_BOOTLOADER_EFI_PRINT_H
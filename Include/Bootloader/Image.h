@@ -0,0 +1,222 @@
+/**
+ * @file Image.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the interface for parsing a PE executable that
+ * has already been read wholesale into memory, and for placing its
+ * sections where they belong. The executable may also be wrapped in a
+ * packed container, as described in Headers/Pack.h. Where the firmware
+ * can read asynchronously, the sections of a plain image can instead be
+ * streamed straight from the file to their place in memory.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_BOOTLOADER_IMAGE_H
+#define COBALT_BOOTLOADER_IMAGE_H
+
+#include <Bootloader/EFI/Files.h>
+#include <Bootloader/Types.h>
+#include <Headers/DOS.h>
+#include <Headers/PE.h>
+#include <Headers/Pack.h>
+
+/**
+ * @brief A parsed PE image. Every pointer within this structure points
+ * into the file buffer it was parsed from, and has been bounds-checked
+ * against that buffer.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief The raw file buffer the image was parsed from. For a packed
+     * image, this is just the raw image headers within the container.
+     * @since 0.1.0.6
+     */
+    const cobalt_u8_t *file;
+
+    /**
+     * @brief The size of the raw file buffer in bytes.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t fileSize;
+
+    /**
+     * @brief The packed container the image was parsed from, or nullptr
+     * if the image was not packed.
+     * @since 0.1.0.6
+     */
+    const cobalt_u8_t *pack;
+
+    /**
+     * @brief The packed container's section table, with one entry per
+     * section of the PE section table. This is nullptr if the image was
+     * not packed.
+     * @since 0.1.0.6
+     */
+    const cobalt_pack_section_t *packedSections;
+
+    /**
+     * @brief The PE header of the image.
+     * @since 0.1.0.6
+     */
+    const cobalt_pe_header_t *peHeader;
+
+    /**
+     * @brief The section table of the image. This is found via the COFF
+     * header's optional header size, not the size of our structure.
+     * @since 0.1.0.6
+     */
+    const cobalt_image_section_header_t *sections;
+
+    /**
+     * @brief The number of entries in the section table.
+     * @since 0.1.0.6
+     */
+    cobalt_u16_t sectionCount;
+
+    /**
+     * @brief The number of bytes the image takes up once loaded, from the
+     * image base to the end of the furthest section.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t virtualSize;
+
+    /**
+     * @brief The number of bytes of the loaded image that come from the
+     * file--the headers plus each section's raw data. Everything else in
+     * the image's virtual size is zero.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t loadedSize;
+} cobalt_image_t;
+
+/**
+ * @brief The section reads of an image being streamed from its file.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief One request per section with data to read.
+     * @since 0.1.0.6
+     */
+    cobalt_file_request_t *requests;
+
+    /**
+     * @brief The number of requests that have been started.
+     * @since 0.1.0.6
+     */
+    cobalt_u16_t count;
+} cobalt_image_reads_t;
+
+/**
+ * @brief Parse and validate a PE image held entirely in memory. Every
+ * header and section's raw data is bounds-checked against the buffer, so
+ * later stages can trust the result. Packed containers are recognized by
+ * their magic number and parsed in the same way.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param file The buffer holding the image file.
+ * @param fileSize The size of the buffer in bytes.
+ * @param image The image structure to fill.
+ * @return The status of the operation. This is EFI_LOAD_ERROR for a
+ * truncated image and EFI_UNSUPPORTED for an image that isn't PE32+.
+ */
+EFI_STATUS Cobalt_ParseImage(const void *file, cobalt_u64_t fileSize,
+                             cobalt_image_t *image);
+
+/**
+ * @brief Parse and validate the headers of a PE image whose sections are
+ * still in its file. The sections' raw data is bounds-checked against the
+ * size of the file rather than the buffer.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param headers The buffer holding the start of the image file.
+ * @param headersSize The size of the buffer in bytes.
+ * @param fileSize The size of the whole image file in bytes.
+ * @param image The image structure to fill.
+ * @return The status of the operation. This is EFI_BUFFER_TOO_SMALL,
+ * with nothing printed, if the image's headers run past the buffer or the
+ * image is packed; in either case the whole file is needed.
+ */
+EFI_STATUS Cobalt_ParseImageHeaders(const void *headers,
+                                    cobalt_u64_t headersSize,
+                                    cobalt_u64_t fileSize,
+                                    cobalt_image_t *image);
+
+/**
+ * @brief Copy the headers and every section of a parsed image to their
+ * place relative to the given base. Packed sections are decompressed
+ * straight into place. The destination must span at least the image's
+ * virtual size. Nothing outside of the file data is touched; see
+ * Cobalt_ZeroImageGaps for the rest.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param image The parsed image.
+ * @param base The address the image is being loaded at.
+ * @return The status of the operation. This is EFI_VOLUME_CORRUPTED if
+ * a packed section failed to decompress.
+ */
+EFI_STATUS Cobalt_LoadImageSections(const cobalt_image_t *image,
+                                    EFI_PHYSICAL_ADDRESS base);
+
+/**
+ * @brief Copy the headers of a parsed image into place and start reading
+ * every section from the image's file straight to its place relative to
+ * the given base. All of the reads are queued at once, so the caller is
+ * free to get on with other work until Cobalt_FinishImageReads.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param image The parsed image. This must not be packed.
+ * @param file The file the image was parsed from.
+ * @param bootServices The EFI boot services table.
+ * @param base The address the image is being loaded at.
+ * @param reads The reads to fill. These must be finished even on failure.
+ * @return The status of the operation.
+ */
+EFI_STATUS Cobalt_BeginImageReads(const cobalt_image_t *image,
+                                  cobalt_efi_file_t *file,
+                                  EFI_BOOT_SERVICES *bootServices,
+                                  EFI_PHYSICAL_ADDRESS base,
+                                  cobalt_image_reads_t *reads);
+
+/**
+ * @brief Wait for every section read of an image to complete.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param bootServices The EFI boot services table.
+ * @param reads The reads to wait on.
+ * @return The status of the first read to fail, or EFI_SUCCESS.
+ */
+EFI_STATUS Cobalt_FinishImageReads(EFI_BOOT_SERVICES *bootServices,
+                                   cobalt_image_reads_t *reads);
+
+/**
+ * @brief Zero every byte of a loaded image that neither its headers nor
+ * its sections' data cover--that is, the gaps between sections and each
+ * section's uninitialized tail. This never touches section data, so it is
+ * safe to run while the sections are still being read.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param image The parsed image.
+ * @param base The address the image is being loaded at.
+ * @param size The size of the memory the image is loaded into in bytes.
+ * This must be at least the image's virtual size.
+ * @return The number of bytes zeroed.
+ */
+cobalt_u64_t Cobalt_ZeroImageGaps(const cobalt_image_t *image,
+                                  EFI_PHYSICAL_ADDRESS base,
+                                  cobalt_u64_t size);
+
+#endif // COBALT_BOOTLOADER_IMAGE_H
@@ -1,8 +0,0 @@
-#ifndef COBALT_BOOTLOADER_MEMORY_H
-#define COBALT_BOOTLOADER_MEMORY_H
-
-#include <stddef.h>
-
-void Cobalt_ZeroMemory(void *buffer, size_t size);
-
-#endif // COBALT_BOOTLOADER_MEMORY_H
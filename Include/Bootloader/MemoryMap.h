@@ -0,0 +1,35 @@
+/**
+ * @file MemoryMap.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the interface for turning the firmware's
+ * memory map into the compact one handed to the kernel (see MemoryMap.h).
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_BOOTLOADER_MEMORY_MAP_H
+#define COBALT_BOOTLOADER_MEMORY_MAP_H
+
+#include <Bootloader/Types.h>
+#include <MemoryMap.h>
+
+/**
+ * @brief Convert the firmware's memory map into a sorted array of regions,
+ * merging neighbouring regions of the same type. A region is smaller than
+ * any descriptor, so this is done in place in the firmware map's buffer,
+ * and needs no allocation--which matters, since it runs after boot
+ * services are gone. The firmware map is unusable afterwards.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param memoryMap The firmware's memory map.
+ * @return The compacted memory map.
+ */
+cobalt_memory_regions_t
+Cobalt_CompactMemoryMap(const cobalt_memory_map_t *memoryMap);
+
+#endif // COBALT_BOOTLOADER_MEMORY_MAP_H
@@ -0,0 +1,129 @@
+/**
+ * @file Paging.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the interface for building the page tables
+ * the kernel is entered on. These map all of physical memory at the
+ * direct map base with the largest pages the processor allows, and the
+ * kernel image at its higher half base with each section's permissions.
+ * The lower half keeps an identity map of physical memory, since every
+ * pointer the loader hands the kernel is still physical.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_BOOTLOADER_PAGING_H
+#define COBALT_BOOTLOADER_PAGING_H
+
+#include <Bootloader/Image.h>
+#include <Bootloader/Types.h>
+#include <Paging.h>
+
+/**
+ * @brief A set of page tables being built. Every table is carved out of a
+ * single block of pages reserved up front, so that building the tables
+ * needs no boot services, and so that the memory map they're built from
+ * stays valid.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief The physical address of the PML4.
+     * @since 0.1.0.6
+     */
+    EFI_PHYSICAL_ADDRESS root;
+
+    /**
+     * @brief The physical address of the block tables are carved from.
+     * @since 0.1.0.6
+     */
+    EFI_PHYSICAL_ADDRESS poolBase;
+
+    /**
+     * @brief The number of pages in the block.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t poolPages;
+
+    /**
+     * @brief The number of pages of the block handed out so far.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t poolUsed;
+} cobalt_page_tables_t;
+
+/**
+ * @brief Reserve enough memory for every table the kernel's address space
+ * could need, and create an empty PML4. The estimate is taken from the
+ * current memory map, with slack for the map changing before the tables
+ * are filled in.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param bootServices The EFI boot services table.
+ * @param kernel The parsed kernel image.
+ * @param graphicsMode The graphics mode, whose framebuffer is left out.
+ * @param tables The tables to set up.
+ * @return The status of the operation.
+ */
+EFI_STATUS Cobalt_ReservePageTables(
+    EFI_BOOT_SERVICES *bootServices, const cobalt_image_t *kernel,
+    const EFI_GRAPHICS_OUTPUT_PROTOCOL_MODE *graphicsMode,
+    cobalt_page_tables_t *tables);
+
+/**
+ * @brief Map a loaded kernel image at COBALT_KERNEL_VIRTUAL_BASE with
+ * 4 KiB pages. Every page is read-only and non-executable unless a
+ * section that covers it is marked writable or executable.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param tables The tables to map the kernel into.
+ * @param kernel The parsed kernel image.
+ * @param base The physical address the kernel image is loaded at.
+ * @return The status of the operation. This is EFI_OUT_OF_RESOURCES if
+ * the reserved memory ran out.
+ */
+EFI_STATUS Cobalt_MapKernel(cobalt_page_tables_t *tables,
+                            const cobalt_image_t *kernel,
+                            EFI_PHYSICAL_ADDRESS base);
+
+/**
+ * @brief Map every range of the memory map and the first 4 GiB into the
+ * direct map, then mirror the direct map into the lower half as an
+ * identity map. Ranges are rounded out to 2 MiB, and whole gigabytes use
+ * 1 GiB pages where the processor has them. The framebuffer, rounded out
+ * to 2 MiB, is left unmapped, so that the kernel's write-combining
+ * mapping of it is the only one. Anything already mapped is left alone,
+ * so this can be run again with a newer memory map.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param tables The tables to map physical memory into.
+ * @param memoryMap The memory map to map.
+ * @param graphicsMode The graphics mode, whose framebuffer is left out.
+ * @return The status of the operation. This is EFI_OUT_OF_RESOURCES if
+ * the reserved memory ran out, and EFI_UNSUPPORTED if a range lies past
+ * the end of the direct map.
+ */
+EFI_STATUS Cobalt_MapPhysicalMemory(
+    cobalt_page_tables_t *tables, const cobalt_memory_map_t *memoryMap,
+    const EFI_GRAPHICS_OUTPUT_PROTOCOL_MODE *graphicsMode);
+
+/**
+ * @brief Switch the processor onto a set of page tables. This enables
+ * no-execute pages and supervisor write protection along the way. This
+ * must only be run once boot services have been exited, since the
+ * firmware's own mappings are gone afterwards.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param tables The tables to switch to.
+ */
+void Cobalt_EnablePageTables(const cobalt_page_tables_t *tables);
+
+#endif // COBALT_BOOTLOADER_PAGING_H
@@ -0,0 +1,81 @@
+/**
+ * @file Relocate.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the interface for applying a PE image's base
+ * relocation table once the image has been placed in memory. Like the
+ * decompressor, it depends on nothing but the processor, so it builds on
+ * a host machine as well as in the bootloader.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_BOOTLOADER_RELOCATE_H
+#define COBALT_BOOTLOADER_RELOCATE_H
+
+#include <Headers/PE.h>
+
+/**
+ * @brief The result of applying a relocation table.
+ * @since 0.1.0.6
+ */
+typedef enum
+{
+    /**
+     * @brief Every entry of the table was applied.
+     * @since 0.1.0.6
+     */
+    COBALT_RELOCATE_SUCCESS,
+    /**
+     * @brief The table itself lies outside of the image.
+     * @since 0.1.0.6
+     */
+    COBALT_RELOCATE_TABLE_OUT_OF_BOUNDS,
+    /**
+     * @brief A block's size was too small, misaligned, or ran past the end
+     * of the table.
+     * @since 0.1.0.6
+     */
+    COBALT_RELOCATE_MALFORMED_BLOCK,
+    /**
+     * @brief An entry asked for a fixup type we don't know how to apply.
+     * @since 0.1.0.6
+     */
+    COBALT_RELOCATE_UNKNOWN_TYPE,
+    /**
+     * @brief An entry pointed at a field outside of the image.
+     * @since 0.1.0.6
+     */
+    COBALT_RELOCATE_ENTRY_OUT_OF_BOUNDS
+} cobalt_relocate_status_t;
+
+/**
+ * @brief Apply an image's base relocation table. Entries are processed
+ * block by block, with each block's page and bounds worked out once up
+ * front. Nothing is skipped silently--the first entry that can't be
+ * applied stops the whole table.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param image The image in memory.
+ * @param imageSize The size of the image in memory in bytes.
+ * @param tableOffset The offset of the base relocation table within the
+ * image, as given by its data directory entry.
+ * @param tableSize The size of the base relocation table in bytes.
+ * @param delta The loaded address of the image minus its preferred base.
+ * This may well be negative.
+ * @param failureOffset Filled with the offset into the table at which
+ * applying the table failed. This is untouched on success.
+ * @return The result of the operation.
+ */
+cobalt_relocate_status_t Cobalt_Relocate(cobalt_u8_t *image,
+                                         cobalt_u64_t imageSize,
+                                         cobalt_u32_t tableOffset,
+                                         cobalt_u32_t tableSize,
+                                         cobalt_i64_t delta,
+                                         cobalt_u64_t *failureOffset);
+
+#endif // COBALT_BOOTLOADER_RELOCATE_H
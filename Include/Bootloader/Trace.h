@@ -0,0 +1,80 @@
+/**
+ * @file Trace.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the bootloader's interface for recording
+ * phases of the boot into the boot trace (see the common Trace.h).
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_BOOTLOADER_TRACE_H
+#define COBALT_BOOTLOADER_TRACE_H
+
+#include <Trace.h>
+#include <efi.h>
+
+/**
+ * @brief The boot trace the bootloader records into. This is copied into
+ * the kernel's handoff structure just before the kernel is entered.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+extern cobalt_trace_t cobalt_bootTrace;
+
+/**
+ * @brief Reset the boot trace and measure the rate of the timestamp
+ * counter. The rate is taken from CPUID where the processor reports it,
+ * and otherwise measured against a one millisecond firmware stall.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param services The EFI boot services table.
+ */
+void Cobalt_TraceInitialize(EFI_BOOT_SERVICES *services);
+
+/**
+ * @brief Begin a traced phase of the boot.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param name The name of the phase. Names longer than the trace allows
+ * are truncated.
+ * @return A handle to the event, to be passed to Cobalt_TraceEnd.
+ */
+cobalt_u32_t Cobalt_TraceBegin(const char *name);
+
+/**
+ * @brief End a traced phase of the boot.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param event The handle returned by Cobalt_TraceBegin.
+ */
+void Cobalt_TraceEnd(cobalt_u32_t event);
+
+/**
+ * @brief Get the length of an ended phase in microseconds.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param event The handle returned by Cobalt_TraceBegin.
+ * @return The length of the phase, or zero if it was dropped.
+ */
+cobalt_u64_t Cobalt_TraceMicroseconds(cobalt_u32_t event);
+
+/**
+ * @brief Record a named value in the boot trace.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param name The name of the counter. Names longer than the trace allows
+ * are truncated.
+ * @param value The value to record.
+ */
+void Cobalt_TraceCounter(const char *name, cobalt_u64_t value);
+
+#endif // COBALT_BOOTLOADER_TRACE_H
@@ -1,6 +1,8 @@
 #ifndef COBALT_BOOTLOADER_TYPES_H
 #define COBALT_BOOTLOADER_TYPES_H
 
+#include <MemoryMap.h>
+#include <Trace.h>
 #include <efi.h>
 #include <stdint.h>
 
@@ -22,12 +24,19 @@ typedef struct
 
 typedef struct
 {
-    cobalt_memory_map_t memoryMap;
+    cobalt_memory_regions_t memoryMap;
     cobalt_efi_tables_t configurationTables;
     EFI_RUNTIME_SERVICES *runtimeServices;
     uint64_t kernelBase;
     uint64_t kernelPageCount;
+    uint64_t kernelVirtualBase;
+    uint64_t pageTableRoot;
+    uint64_t pageTableBase;
+    uint64_t pageTablePageCount;
     EFI_GRAPHICS_OUTPUT_PROTOCOL_MODE graphicsMode;
+    cobalt_trace_t bootTrace;
+    EFI_TIME bootTime;
+    uint64_t bootTimestamp;
 } cobalt_efi_info_t;
 
 typedef struct
@@ -48,12 +57,6 @@ typedef struct
     UINT32 Characteristics;
 } cobalt_image_section_header_t;
 
-typedef struct
-{
-    UINT32 VirtualAddress;
-    UINT32 SizeOfBlock;
-} cobalt_image_base_relocation_t;
-
 #define NL L"\n\r"
 
 extern cobalt_efi_info_t cobalt_efiInfo;
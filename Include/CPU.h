@@ -0,0 +1,306 @@
+/**
+ * @file CPU.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains small inline wrappers around processor
+ * instructions that both the bootloader and the kernel need, and which C
+ * has no way to spell on its own.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_CPU_H
+#define COBALT_CPU_H
+
+#include <Types.h>
+
+/**
+ * @brief Read the processor's timestamp counter. This is a cycle count
+ * since reset, and is by far the cheapest clock we have access to.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return The current value of the timestamp counter.
+ */
+static inline cobalt_u64_t Cobalt_ReadTimestamp(void)
+{
+    cobalt_u32_t low, high;
+    __asm__ volatile("rdtsc" : "=a"(low), "=d"(high));
+    return ((cobalt_u64_t)high << 32) | low;
+}
+
+/**
+ * @brief Query the processor's identification and feature information.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param leaf The leaf (EAX value) to query.
+ * @param subleaf The subleaf (ECX value) to query.
+ * @param registers Filled with EAX, EBX, ECX, and EDX, in that order.
+ */
+static inline void Cobalt_CPUID(cobalt_u32_t leaf, cobalt_u32_t subleaf,
+                                cobalt_u32_t registers[4])
+{
+    __asm__ volatile("cpuid"
+                     : "=a"(registers[0]), "=b"(registers[1]),
+                       "=c"(registers[2]), "=d"(registers[3])
+                     : "a"(leaf), "c"(subleaf));
+}
+
+/**
+ * @brief Read a model-specific register.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param msr The index of the register to read.
+ * @return The value of the register.
+ */
+static inline cobalt_u64_t Cobalt_ReadMSR(cobalt_u32_t msr)
+{
+    cobalt_u32_t low, high;
+    __asm__ volatile("rdmsr" : "=a"(low), "=d"(high) : "c"(msr));
+    return ((cobalt_u64_t)high << 32) | low;
+}
+
+/**
+ * @brief Write a model-specific register.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param msr The index of the register to write.
+ * @param value The value to write.
+ */
+static inline void Cobalt_WriteMSR(cobalt_u32_t msr, cobalt_u64_t value)
+{
+    __asm__ volatile("wrmsr"
+                     :
+                     : "c"(msr), "a"((cobalt_u32_t)value),
+                       "d"((cobalt_u32_t)(value >> 32)));
+}
+
+/**
+ * @brief Read the CR0 control register.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return The value of CR0.
+ */
+static inline cobalt_u64_t Cobalt_ReadCR0(void)
+{
+    cobalt_u64_t value;
+    __asm__ volatile("mov %%cr0, %0" : "=r"(value));
+    return value;
+}
+
+/**
+ * @brief Write the CR0 control register.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param value The value to write.
+ */
+static inline void Cobalt_WriteCR0(cobalt_u64_t value)
+{
+    __asm__ volatile("mov %0, %%cr0" : : "r"(value) : "memory");
+}
+
+/**
+ * @brief Read the CR3 control register, which holds the physical address
+ * of the current PML4.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return The value of CR3.
+ */
+static inline cobalt_u64_t Cobalt_ReadCR3(void)
+{
+    cobalt_u64_t value;
+    __asm__ volatile("mov %%cr3, %0" : "=r"(value));
+    return value;
+}
+
+/**
+ * @brief Write the CR3 control register, switching address spaces. This
+ * flushes every TLB entry that isn't global, unless PCIDs are enabled, in
+ * which case only the new PCID's entries are flushed, and only if bit 63
+ * of the value is clear.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param value The value to write.
+ */
+static inline void Cobalt_WriteCR3(cobalt_u64_t value)
+{
+    __asm__ volatile("mov %0, %%cr3" : : "r"(value) : "memory");
+}
+
+/**
+ * @brief Read the CR2 control register, which holds the address that
+ * caused the last page fault.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return The value of CR2.
+ */
+static inline cobalt_u64_t Cobalt_ReadCR2(void)
+{
+    cobalt_u64_t value;
+    __asm__ volatile("mov %%cr2, %0" : "=r"(value));
+    return value;
+}
+
+/**
+ * @brief Read the CR4 control register.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return The value of CR4.
+ */
+static inline cobalt_u64_t Cobalt_ReadCR4(void)
+{
+    cobalt_u64_t value;
+    __asm__ volatile("mov %%cr4, %0" : "=r"(value));
+    return value;
+}
+
+/**
+ * @brief Write the CR4 control register.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param value The value to write.
+ */
+static inline void Cobalt_WriteCR4(cobalt_u64_t value)
+{
+    __asm__ volatile("mov %0, %%cr4" : : "r"(value) : "memory");
+}
+
+/**
+ * @brief Read the extended control register XCR0, which says what state
+ * the operating system saves, and so which vector registers it allows.
+ * This faults unless CPUID.1:ECX reports OSXSAVE.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return The value of XCR0.
+ */
+static inline cobalt_u64_t Cobalt_ReadXCR0(void)
+{
+    cobalt_u32_t low, high;
+    __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return (cobalt_u64_t)high << 32 | low;
+}
+
+/**
+ * @brief Drop the TLB entries of a page on this processor, global or
+ * not, under the current PCID.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param address Any address within the page.
+ */
+static inline void Cobalt_InvalidatePage(cobalt_u64_t address)
+{
+    __asm__ volatile("invlpg (%0)" : : "r"(address) : "memory");
+}
+
+/**
+ * @brief Hint to the processor that we're spinning on a lock or flag.
+ * This saves power, and keeps the spin from starving a hyperthread
+ * sibling that may be the one about to release it.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+static inline void Cobalt_Pause(void) { __asm__ volatile("pause"); }
+
+/**
+ * @brief Disable maskable interrupts on this processor.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return The flags register from before interrupts were disabled, to
+ * hand to Cobalt_RestoreInterrupts.
+ */
+static inline cobalt_u64_t Cobalt_DisableInterrupts(void)
+{
+    cobalt_u64_t flags;
+    __asm__ volatile("pushfq\n\t"
+                     "popq %0\n\t"
+                     "cli"
+                     : "=r"(flags)
+                     :
+                     : "memory");
+    return flags;
+}
+
+/**
+ * @brief Re-enable maskable interrupts on this processor, if they were
+ * enabled before the matching Cobalt_DisableInterrupts.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param flags The flags returned by Cobalt_DisableInterrupts.
+ */
+static inline void Cobalt_RestoreInterrupts(cobalt_u64_t flags)
+{
+    // The interrupt flag is bit 9 of the flags register.
+    if (flags & (1 << 9)) __asm__ volatile("sti" : : : "memory");
+}
+
+/**
+ * @brief Stop this processor for good, with interrupts disabled.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+[[noreturn]] static inline void Cobalt_Halt(void)
+{
+    for (;;) __asm__ volatile("cli\n\thlt");
+}
+
+/**
+ * @brief Write a byte to an I/O port.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param port The port to write to.
+ * @param value The byte to write.
+ */
+static inline void Cobalt_OutByte(cobalt_u16_t port, cobalt_u8_t value)
+{
+    __asm__ volatile("outb %0, %1" : : "a"(value), "Nd"(port));
+}
+
+/**
+ * @brief Read a byte from an I/O port.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param port The port to read from.
+ * @return The byte read.
+ */
+static inline cobalt_u8_t Cobalt_InByte(cobalt_u16_t port)
+{
+    cobalt_u8_t value;
+    __asm__ volatile("inb %1, %0" : "=a"(value) : "Nd"(port));
+    return value;
+}
+
+/**
+ * @brief Read a doubleword from an I/O port.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param port The port to read from.
+ * @return The doubleword read.
+ */
+static inline cobalt_u32_t Cobalt_InLong(cobalt_u16_t port)
+{
+    cobalt_u32_t value;
+    __asm__ volatile("inl %1, %0" : "=a"(value) : "Nd"(port));
+    return value;
+}
+
+#endif // COBALT_CPU_H
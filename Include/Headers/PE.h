@@ -5,7 +5,7 @@
  * data imperative to jumping into the executable portion of the PE
  * executable file.
  * @since 0.1.0.1
- * @updated 0.1.0.2
+ * @updated 0.1.0.6
  *
  * @copyright (c) 2025 Israfil Argos
  * This file is under the AGPLv3. For information on what that entails, see
@@ -661,4 +661,96 @@ typedef struct
     optionalHeader;
 } cobalt_pe_header_t;
 
+/**
+ * @brief The index of the base relocation table within the optional
+ * header's data directory.
+ * @since 0.1.0.6
+ */
+#define COBALT_DIRECTORY_BASE_RELOCATION 5
+
+/**
+ * @brief The memory permission flags of a section's Characteristics
+ * field. Any other flags of that field describe the section's contents
+ * or linking, and don't matter to a loader.
+ * @since 0.1.0.6
+ */
+typedef enum : cobalt_u32_t
+{
+    /**
+     * @brief The section can be executed as code.
+     * @since 0.1.0.6
+     */
+    COBALT_SECTION_EXECUTE = 0x20000000,
+    /**
+     * @brief The section can be read.
+     * @since 0.1.0.6
+     */
+    COBALT_SECTION_READ = 0x40000000,
+    /**
+     * @brief The section can be written to.
+     * @since 0.1.0.6
+     */
+    COBALT_SECTION_WRITE = 0x80000000
+} cobalt_section_flags_t;
+
+/**
+ * @brief The types of fixup a base relocation entry can ask for. The type
+ * is stored in the top four bits of each entry, above a 12-bit offset
+ * into the block's page.
+ * @since 0.1.0.6
+ */
+typedef enum : cobalt_u16_t
+{
+    /**
+     * @brief The entry is skipped. This is used to pad blocks out to a
+     * 32-bit boundary.
+     * @since 0.1.0.6
+     */
+    COBALT_RELOCATION_ABSOLUTE = 0,
+    /**
+     * @brief Add the high 16 bits of the delta to the 16-bit field at the
+     * offset.
+     * @since 0.1.0.6
+     */
+    COBALT_RELOCATION_HIGH = 1,
+    /**
+     * @brief Add the low 16 bits of the delta to the 16-bit field at the
+     * offset.
+     * @since 0.1.0.6
+     */
+    COBALT_RELOCATION_LOW = 2,
+    /**
+     * @brief Add the low 32 bits of the delta to the 32-bit field at the
+     * offset.
+     * @since 0.1.0.6
+     */
+    COBALT_RELOCATION_HIGHLOW = 3,
+    /**
+     * @brief Add the delta to the 64-bit field at the offset.
+     * @since 0.1.0.6
+     */
+    COBALT_RELOCATION_DIR64 = 10
+} cobalt_relocation_type_t;
+
+/**
+ * @brief The header of a single block of the base relocation table. Each
+ * block covers one 4K page, and is followed by (SizeOfBlock - 8) / 2
+ * 16-bit entries.
+ * @since 0.1.0.2
+ */
+typedef struct
+{
+    /**
+     * @brief The address of the block's page relative to the image base.
+     * @since 0.1.0.2
+     */
+    cobalt_u32_t VirtualAddress;
+
+    /**
+     * @brief The size of the block in bytes, including this header.
+     * @since 0.1.0.2
+     */
+    cobalt_u32_t SizeOfBlock;
+} cobalt_image_base_relocation_t;
+
 #endif // COBALT_HEADERS_PE_H
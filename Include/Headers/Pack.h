@@ -0,0 +1,102 @@
+/**
+ * @file Pack.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the description of Cobalt's packed kernel
+ * container. This is a PE image whose headers are kept raw and whose
+ * sections are each compressed in the LZ4 block format, so that the
+ * loader has far fewer bytes to pull off of the disk.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_HEADERS_PACK_H
+#define COBALT_HEADERS_PACK_H
+
+#include <Types.h>
+
+/**
+ * @brief The magic number of a packed container. This is the characters
+ * 'C', 'B', 'P', and 'K', flipped for endianness.
+ * @since 0.1.0.6
+ */
+#define COBALT_PACK_MAGIC 0x4B504243
+
+/**
+ * @brief The version of the container format this tree reads and writes.
+ * @since 0.1.0.6
+ */
+#define COBALT_PACK_VERSION 1
+
+/**
+ * @brief The header of a packed container. This is followed directly by
+ * the section table, then the raw image headers, then the compressed
+ * section data.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief The magic number of the file. This should always be
+     * COBALT_PACK_MAGIC.
+     * @since 0.1.0.6
+     */
+    cobalt_u32_t magicNumber;
+
+    /**
+     * @brief The version of the container format. This should always be
+     * COBALT_PACK_VERSION.
+     * @since 0.1.0.6
+     */
+    cobalt_u32_t version;
+
+    /**
+     * @brief The size in bytes of the raw image headers--the DOS header,
+     * PE header, and PE section table--stored after the section table.
+     * @since 0.1.0.6
+     */
+    cobalt_u32_t headerSize;
+
+    /**
+     * @brief The number of entries in the section table. This always
+     * matches the section count of the PE header.
+     * @since 0.1.0.6
+     */
+    cobalt_u32_t sectionCount;
+} cobalt_pack_header_t;
+
+/**
+ * @brief A single entry of the packed container's section table. Entries
+ * are in the same order as the sections of the PE section table.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief The offset of the section's compressed data relative to the
+     * start of the container.
+     * @since 0.1.0.6
+     */
+    cobalt_u32_t offset;
+
+    /**
+     * @brief The size in bytes of the section's compressed data.
+     * @since 0.1.0.6
+     */
+    cobalt_u32_t compressedSize;
+
+    /**
+     * @brief The size in bytes of the section's data once decompressed.
+     * This is the number of bytes the section would have been loaded with
+     * from an unpacked image.
+     * @since 0.1.0.6
+     */
+    cobalt_u32_t decompressedSize;
+
+    PAD(4); // Reserved, keeps entries 16 bytes wide.
+} cobalt_pack_section_t;
+
+#endif // COBALT_HEADERS_PACK_H
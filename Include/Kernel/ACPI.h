@@ -0,0 +1,86 @@
+/**
+ * @file ACPI.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the kernel's interface for finding the
+ * firmware's ACPI tables. The root pointer comes from the EFI
+ * configuration tables the loader passed along, and every table is read
+ * in place through the direct map.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_KERNEL_ACPI_H
+#define COBALT_KERNEL_ACPI_H
+
+#include <Bootloader/Types.h>
+#include <Types.h>
+
+/**
+ * @brief The header every ACPI system description table starts with.
+ * @since 0.1.0.6
+ */
+typedef struct __attribute__((packed))
+{
+    /**
+     * @brief The four-character signature of the table, such as "APIC"
+     * for the MADT. This isn't null-terminated.
+     * @since 0.1.0.6
+     */
+    char signature[4];
+
+    /**
+     * @brief The size of the table in bytes, header included.
+     * @since 0.1.0.6
+     */
+    cobalt_u32_t length;
+
+    /**
+     * @brief The revision of the table's layout.
+     * @since 0.1.0.6
+     */
+    cobalt_u8_t revision;
+
+    /**
+     * @brief The byte that makes every byte of the table sum to zero.
+     * @since 0.1.0.6
+     */
+    cobalt_u8_t checksum;
+
+    /**
+     * @brief The identifiers of whoever built the table.
+     * @since 0.1.0.6
+     */
+    char oemID[6];
+    char oemTableID[8];
+    cobalt_u32_t oemRevision;
+    cobalt_u32_t creatorID;
+    cobalt_u32_t creatorRevision;
+} cobalt_acpi_header_t;
+
+/**
+ * @brief Find and check the ACPI root table.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param efiInfo The information the loader handed to the kernel.
+ * @return Whether or not a valid root table was found.
+ */
+bool Cobalt_InitializeACPI(const cobalt_efi_info_t *efiInfo);
+
+/**
+ * @brief Find an ACPI table by its signature. Tables that fail their
+ * checksum are passed over.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param signature The four-character signature of the table.
+ * @return The first table with that signature, or nullptr if there's
+ * none or ACPI couldn't be set up.
+ */
+const cobalt_acpi_header_t *Cobalt_FindACPITable(const char *signature);
+
+#endif // COBALT_KERNEL_ACPI_H
@@ -0,0 +1,97 @@
+/**
+ * @file APIC.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the interface of the kernel's local APIC
+ * driver. The x2APIC is used wherever the processor has one, since its
+ * registers are MSRs and sending an IPI is a single write; otherwise the
+ * memory-mapped xAPIC is reached through the direct map.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_KERNEL_APIC_H
+#define COBALT_KERNEL_APIC_H
+
+#include <Types.h>
+
+/**
+ * @brief Enable this processor's local APIC, and point its spurious
+ * interrupts at COBALT_VECTOR_SPURIOUS.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+void Cobalt_InitializeLocalAPIC(void);
+
+/**
+ * @brief Send a fixed interrupt to another processor.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param apicID The ID of the target's local APIC.
+ * @param vector The vector to raise on the target.
+ */
+void Cobalt_SendIPI(cobalt_u32_t apicID, cobalt_u8_t vector);
+
+/**
+ * @brief Send an INIT IPI to another processor, resetting it into its
+ * wait-for-startup state.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param apicID The ID of the target's local APIC.
+ */
+void Cobalt_SendInitIPI(cobalt_u32_t apicID);
+
+/**
+ * @brief Send a startup IPI to a processor waiting for one, which starts
+ * it in real mode at the start of the given page.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param apicID The ID of the target's local APIC.
+ * @param page The physical address of the page over 4 KiB. The page
+ * must lie below 1 MiB.
+ */
+void Cobalt_SendStartupIPI(cobalt_u32_t apicID, cobalt_u8_t page);
+
+/**
+ * @brief Set up this processor's local APIC timer to raise a vector once
+ * it's armed and its deadline passes. The timer takes its deadlines as
+ * timestamps wherever the processor has the TSC-deadline mode; otherwise
+ * it counts down in one-shot mode, at a rate measured against the
+ * timestamp counter the first time this is called and taken to be the
+ * same on every processor after that. The timer starts out disarmed.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param vector The vector to raise.
+ * @param ticksPerMicrosecond The rate of the timestamp counter.
+ * @return Whether or not the timer is in TSC-deadline mode.
+ */
+bool Cobalt_InitializeLocalTimer(cobalt_u8_t vector,
+                                 cobalt_u64_t ticksPerMicrosecond);
+
+/**
+ * @brief Arm this processor's local APIC timer, replacing whatever
+ * deadline it was armed with before. A deadline that's already passed
+ * fires straight away.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param deadline The value of the timestamp counter to fire at, or zero
+ * to disarm the timer.
+ */
+void Cobalt_ArmLocalTimer(cobalt_u64_t deadline);
+
+/**
+ * @brief Tell the local APIC that the interrupt being handled is done.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+void Cobalt_EndOfInterrupt(void);
+
+#endif // COBALT_KERNEL_APIC_H
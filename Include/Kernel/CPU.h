@@ -0,0 +1,219 @@
+/**
+ * @file CPU.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the kernel's per-processor state. Each
+ * processor's GS base points at its own block, so that finding it costs a
+ * single GS-relative load. Each processor also gets its own descriptor
+ * table and task state segment, so that nothing about its stacks is
+ * shared with another.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_KERNEL_CPU_H
+#define COBALT_KERNEL_CPU_H
+
+#include <Types.h>
+
+/**
+ * @brief The most processors the kernel will bring up.
+ * @since 0.1.0.6
+ */
+#define COBALT_MAXIMUM_CPUS 64
+
+/**
+ * @brief The size of a cache line. Data written by different processors
+ * is kept at least this far apart so that they don't fight over a line.
+ * @since 0.1.0.6
+ */
+#define COBALT_CACHE_LINE_SIZE 64
+
+/**
+ * @brief The state the kernel keeps for each processor.
+ * @since 0.1.0.6
+ */
+typedef struct cobalt_cpu
+{
+    /**
+     * @brief A pointer to this very block. This must stay first, since
+     * it is what Cobalt_CurrentCPU reads through GS. Each block starts
+     * a cache line of its own.
+     * @since 0.1.0.6
+     */
+    alignas(COBALT_CACHE_LINE_SIZE) struct cobalt_cpu *self;
+
+    /**
+     * @brief The index of the processor, counting up from zero for the
+     * bootstrap processor. This must stay second, since it is what
+     * Cobalt_CPUIndex reads through GS.
+     * @since 0.1.0.6
+     */
+    cobalt_u32_t index;
+
+    /**
+     * @brief How many sections that mustn't be preempted the processor is
+     * in. This must stay third, since it is what Cobalt_DisablePreemption
+     * counts through GS.
+     * @since 0.1.0.6
+     */
+    cobalt_u32_t preemptDepth;
+
+    /**
+     * @brief The ID of the processor's local APIC, which is what
+     * interprocessor interrupts are addressed to.
+     * @since 0.1.0.6
+     */
+    cobalt_u32_t apicID;
+
+    /**
+     * @brief The address space the processor has loaded, or nullptr if
+     * it's only ever run the kernel's.
+     * @since 0.1.0.6
+     */
+    struct cobalt_address_space *addressSpace;
+
+    /**
+     * @brief The top of the processor's kernel stack, which the processor
+     * switches to when interrupted in user mode. This is zero for the
+     * bootstrap processor, which runs on the stack the loader left it.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t stackTop;
+} cobalt_cpu_t;
+
+/**
+ * @brief The segment selectors of the kernel's descriptor tables. The
+ * user segments are ordered the way SYSRET expects them.
+ * @since 0.1.0.6
+ */
+typedef enum : cobalt_u16_t
+{
+    /**
+     * @brief The kernel's code segment.
+     * @since 0.1.0.6
+     */
+    COBALT_KERNEL_CODE_SELECTOR = 0x08,
+    /**
+     * @brief The kernel's data segment.
+     * @since 0.1.0.6
+     */
+    COBALT_KERNEL_DATA_SELECTOR = 0x10,
+    /**
+     * @brief User mode's data segment.
+     * @since 0.1.0.6
+     */
+    COBALT_USER_DATA_SELECTOR = 0x18 | 3,
+    /**
+     * @brief User mode's code segment.
+     * @since 0.1.0.6
+     */
+    COBALT_USER_CODE_SELECTOR = 0x20 | 3,
+    /**
+     * @brief The processor's task state segment.
+     * @since 0.1.0.6
+     */
+    COBALT_TASK_STATE_SELECTOR = 0x28
+} cobalt_selector_t;
+
+/**
+ * @brief Set up the per-processor block of the processor we're running
+ * on, load its descriptor table and task state segment, and point its GS
+ * base at it. The stack top of the block should be filled in beforehand.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param index The index of the processor.
+ */
+void Cobalt_InitializeCPU(cobalt_u32_t index);
+
+/**
+ * @brief Mark the processor we're running on as online. This should only
+ * be done once it can take interprocessor interrupts, since others will
+ * start waiting on it to answer them.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+void Cobalt_SetCPUOnline(void);
+
+/**
+ * @brief Get the per-processor block of any processor.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param index The index of the processor.
+ * @return The processor's block.
+ */
+cobalt_cpu_t *Cobalt_GetCPU(cobalt_u32_t index);
+
+/**
+ * @brief Get the set of processors that are online.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return A mask with bit n set if processor n is online.
+ */
+cobalt_u64_t Cobalt_OnlineCPUs(void);
+
+/**
+ * @brief Get the per-processor block of the processor we're running on.
+ * The result is only meaningful for as long as we can't be moved to
+ * another processor.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return The processor's block.
+ */
+static inline cobalt_cpu_t *Cobalt_CurrentCPU(void)
+{
+    cobalt_cpu_t *cpu;
+    __asm__ volatile("movq %%gs:0, %0" : "=r"(cpu));
+    return cpu;
+}
+
+/**
+ * @brief Get the index of the processor we're running on. The result is
+ * only meaningful for as long as we can't be moved to another processor.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return The processor's index.
+ */
+static inline cobalt_u32_t Cobalt_CPUIndex(void)
+{
+    cobalt_u32_t index;
+    __asm__ volatile("movl %%gs:8, %0" : "=r"(index));
+    return index;
+}
+
+/**
+ * @brief Keep the scheduler from preempting the running thread until the
+ * matching Cobalt_EnablePreemption. Interrupts still come in. The count
+ * is a single instruction on the processor's own block, so it's safe to
+ * take on whatever processor we happen to be on; the thread can't move
+ * once it's done. The thread mustn't block or yield until the section
+ * ends.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+static inline void Cobalt_DisablePreemption(void)
+{
+    __asm__ volatile("incl %%gs:12" : : : "memory");
+}
+
+/**
+ * @brief End a section started by Cobalt_DisablePreemption. A thread
+ * whose time slice ran out during the section is preempted at the next
+ * timer tick.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+static inline void Cobalt_EnablePreemption(void)
+{
+    __asm__ volatile("decl %%gs:12" : : : "memory");
+}
+
+#endif // COBALT_KERNEL_CPU_H
@@ -0,0 +1,148 @@
+/**
+ * @file Clock.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the interface of the kernel's clock, which
+ * counts time with the timestamp counter. The counter's rate is measured
+ * once against the HPET, or the ACPI PM timer where there's no HPET, and
+ * turned into a fixed-point factor that takes ticks to nanoseconds with a
+ * multiply and a shift. The factor and the wall clock's offset sit behind
+ * a seqlock, so a read of the time writes nothing shared and never waits
+ * unless the clock is being set.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_KERNEL_CLOCK_H
+#define COBALT_KERNEL_CLOCK_H
+
+#include <Bootloader/Types.h>
+#include <Types.h>
+
+/**
+ * @brief The length of each calibration round in microseconds.
+ * @since 0.1.0.6
+ */
+#define COBALT_CALIBRATION_LENGTH 10000
+
+/**
+ * @brief The number of calibration rounds. The round whose readings of
+ * the reference timer were bracketed most tightly by the timestamp
+ * counter wins.
+ * @since 0.1.0.6
+ */
+#define COBALT_CALIBRATION_ROUNDS 5
+
+/**
+ * @brief The timer the timestamp counter was measured against.
+ * @since 0.1.0.6
+ */
+typedef enum : cobalt_u32_t
+{
+    /**
+     * @brief Nothing; the rate is the loader's estimate.
+     * @since 0.1.0.6
+     */
+    COBALT_CLOCK_REFERENCE_NONE,
+    /**
+     * @brief The high precision event timer.
+     * @since 0.1.0.6
+     */
+    COBALT_CLOCK_REFERENCE_HPET,
+    /**
+     * @brief The ACPI power management timer.
+     * @since 0.1.0.6
+     */
+    COBALT_CLOCK_REFERENCE_PM_TIMER
+} cobalt_clock_reference_t;
+
+/**
+ * @brief Measure the rate of the timestamp counter and start the clock.
+ * This takes COBALT_CALIBRATION_ROUNDS times COBALT_CALIBRATION_LENGTH,
+ * with interrupts disabled. A timer that doesn't count is given up on
+ * after a few times a round, and the next one along is tried. The ACPI
+ * tables must already have been found.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param efiInfo The information the loader handed to the kernel, whose
+ * reading of the firmware's clock sets the wall clock and whose estimate
+ * of the counter's rate is used if there's no timer to measure it with.
+ * @return The timer the counter was measured against.
+ */
+cobalt_clock_reference_t
+Cobalt_InitializeClock(const cobalt_efi_info_t *efiInfo);
+
+/**
+ * @brief Get the rate of the timestamp counter.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return The rate in hertz, or zero before the clock is started.
+ */
+cobalt_u64_t Cobalt_ClockFrequency(void);
+
+/**
+ * @brief Get whether the timestamp counter ticks at a constant rate
+ * whatever the processor's power state, as the clock assumes.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return Whether or not the counter is invariant.
+ */
+bool Cobalt_ClockInvariant(void);
+
+/**
+ * @brief Get the time since the clock was started. This never goes back,
+ * so long as every processor's timestamp counter was started together,
+ * as they are on any processor with an invariant counter.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return The time in nanoseconds, or zero before the clock is started.
+ */
+cobalt_u64_t Cobalt_MonotonicNanoseconds(void);
+
+/**
+ * @brief Get what the timestamp counter will read when the monotonic
+ * clock reaches a time, which is how the local APIC takes its deadlines.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param nanoseconds The time, as Cobalt_MonotonicNanoseconds gives it.
+ * This must be less than a century or so after the clock was started.
+ * @return The timestamp.
+ */
+cobalt_u64_t Cobalt_ClockTimestamp(cobalt_u64_t nanoseconds);
+
+/**
+ * @brief Get the time of day.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return The time in nanoseconds since the Unix epoch, or the time since
+ * the clock was started if the firmware gave no time.
+ */
+cobalt_u64_t Cobalt_WallClockNanoseconds(void);
+
+/**
+ * @brief Set the time of day.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param nanoseconds The time in nanoseconds since the Unix epoch.
+ */
+void Cobalt_SetWallClock(cobalt_u64_t nanoseconds);
+
+/**
+ * @brief Time a run of reads of the clock, and report the cost of each
+ * over serial.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+void Cobalt_BenchmarkClock(void);
+
+#endif // COBALT_KERNEL_CLOCK_H
@@ -0,0 +1,86 @@
+/**
+ * @file Console.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the interface of the kernel's console, which
+ * draws text into the framebuffer's shadow buffer. Every glyph is drawn
+ * once up front at the screen's scale and in its pixel format, so drawing
+ * a character is a run of copies. Writes only change the text grid; once
+ * a call is done, the rows it touched are compared against what's on
+ * screen and only the cells that differ are redrawn. Scrolling moves the
+ * shadow buffer, and the text with it.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_KERNEL_CONSOLE_H
+#define COBALT_KERNEL_CONSOLE_H
+
+#include <Types.h>
+#include <stdarg.h>
+
+/**
+ * @brief Draw the glyphs, and clear the screen. The framebuffer must
+ * already be set up. Until this succeeds, writes to the console are
+ * dropped.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return Whether or not the console could be set up. This fails if
+ * there's no framebuffer, or memory has run out.
+ */
+bool Cobalt_InitializeConsole(void);
+
+/**
+ * @brief Write a string to the console. Text that runs past the end of a
+ * row wraps onto the next, and the screen scrolls once the last row is
+ * passed.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param string The ASCII string to write. Tabs, carriage returns, and
+ * backspaces move the cursor; anything else that isn't printable is drawn
+ * as a box.
+ */
+void Cobalt_ConsolePuts(const char *string);
+
+/**
+ * @brief A primitive formatted string printer, taking the same formatters
+ * as Cobalt_SerialPrintfv. The screen is drawn once, after the whole
+ * string has been laid out.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param format The format string to interleave with the arguments.
+ * @param args The arguments to interleave with the format string.
+ *
+ * @see Cobalt_ConsolePrintf
+ */
+void Cobalt_ConsolePrintfv(const char *format, va_list args);
+
+/**
+ * @brief A primitive formatted string printer. See Cobalt_ConsolePrintfv
+ * for the allowed formatters.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param format The format string to interleave with the arguments.
+ * @param ... The arguments to interleave with the format string.
+ *
+ * @see Cobalt_ConsolePrintfv
+ */
+void Cobalt_ConsolePrintf(const char *format, ...);
+
+/**
+ * @brief Time writing lines that each scroll the screen, and count how
+ * many cells were redrawn to do it. Both are reported over serial. This
+ * does nothing if the console isn't set up.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+void Cobalt_BenchmarkConsole(void);
+
+#endif // COBALT_KERNEL_CONSOLE_H
@@ -0,0 +1,148 @@
+/**
+ * @file Framebuffer.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the interface of the kernel's framebuffer.
+ * Everything is drawn into a shadow buffer in ordinary memory, so reading
+ * pixels back, as scrolling and blending do, never touches the device.
+ * Drawing marks rectangles of the shadow as damaged, and only those are
+ * copied out to the real framebuffer, with non-temporal stores a
+ * scanline at a time. Once the flusher thread is started, that copy
+ * happens at most once a frame however often the screen changes.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_KERNEL_FRAMEBUFFER_H
+#define COBALT_KERNEL_FRAMEBUFFER_H
+
+#include <Blit.h>
+#include <Bootloader/Types.h>
+#include <Types.h>
+
+/**
+ * @brief The shortest time between two flushes by the flusher thread, in
+ * nanoseconds. This is a frame at 60 Hz.
+ * @since 0.1.0.6
+ */
+#define COBALT_FRAMEBUFFER_INTERVAL 16666667
+
+/**
+ * @brief The most damaged rectangles kept apart. Past this, a new one is
+ * merged into whichever grows least by taking it in.
+ * @since 0.1.0.6
+ */
+#define COBALT_FRAMEBUFFER_MAXIMUM_DAMAGE 8
+
+/**
+ * @brief The shadow buffer, which is what gets drawn into. Its pixels are
+ * in the framebuffer's own format; see Cobalt_EncodeColour. It's a
+ * surface like any other, so the drawing primitives in Blit.h draw
+ * straight into it, and its pitch is the same as the real framebuffer's.
+ * @since 0.1.0.6
+ */
+typedef cobalt_surface_t cobalt_framebuffer_t;
+
+/**
+ * @brief Map the framebuffer the loader left behind write-combining, and
+ * set up its shadow buffer, which starts out zeroed. The virtual memory
+ * manager must already be set up.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param efiInfo The information the loader handed to the kernel, whose
+ * graphics mode describes the framebuffer.
+ * @return Whether or not the framebuffer could be set up. This fails if
+ * there's no framebuffer, or memory has run out.
+ */
+bool Cobalt_InitializeFramebuffer(const cobalt_efi_info_t *efiInfo);
+
+/**
+ * @brief Start the thread that flushes damage to the screen, after which
+ * Cobalt_PresentFramebuffer hands it the work instead of flushing there
+ * and then. The scheduler must already be set up.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return Whether or not the thread could be started.
+ */
+bool Cobalt_StartFramebufferFlusher(void);
+
+/**
+ * @brief Get the shadow buffer. Drawing into it isn't locked, so anything
+ * that draws has to keep to its own part of the screen or its own lock.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return The shadow buffer, or nullptr if the framebuffer isn't set up.
+ */
+const cobalt_framebuffer_t *Cobalt_GetFramebuffer(void);
+
+/**
+ * @brief Turn a colour into the framebuffer's pixel format.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param colour The colour, as 0xRRGGBB.
+ * @return The pixel.
+ */
+cobalt_u32_t Cobalt_EncodeColour(cobalt_u32_t colour);
+
+/**
+ * @brief Mark a rectangle of the shadow buffer as changed, so the next
+ * flush copies it out. This can be called from any processor, with
+ * interrupts disabled or not.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param x The left edge of the rectangle in pixels.
+ * @param y The top edge of the rectangle in pixels.
+ * @param width The width of the rectangle in pixels.
+ * @param height The height of the rectangle in pixels. Whatever lies off
+ * the screen is ignored.
+ */
+void Cobalt_DamageFramebuffer(cobalt_u64_t x, cobalt_u64_t y,
+                              cobalt_u64_t width, cobalt_u64_t height);
+
+/**
+ * @brief Scroll the whole shadow buffer up, fill the rows that come in at
+ * the bottom, and mark the screen as damaged.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param lines The number of rows of pixels to scroll by.
+ * @param colour The pixel to fill the new rows with, in the framebuffer's
+ * format.
+ */
+void Cobalt_ScrollFramebuffer(cobalt_u64_t lines, cobalt_u32_t colour);
+
+/**
+ * @brief Copy every damaged rectangle out to the screen now.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+void Cobalt_FlushFramebuffer(void);
+
+/**
+ * @brief Get the damage onto the screen. Once the flusher thread is
+ * started, this only wakes it, and the damage goes out with the next
+ * frame; before then it's flushed straight away.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+void Cobalt_PresentFramebuffer(void);
+
+/**
+ * @brief Time redrawing and flushing the whole screen, and scrolling it,
+ * then every drawing primitive on every path the processor supports, and
+ * report the throughput of each over serial. The screen is put back as it
+ * was afterward. This does nothing if the framebuffer isn't set up.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+void Cobalt_BenchmarkFramebuffer(void);
+
+#endif // COBALT_KERNEL_FRAMEBUFFER_H
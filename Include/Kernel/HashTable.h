@@ -0,0 +1,98 @@
+/**
+ * @file HashTable.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the interface of the kernel's hash table,
+ * which maps 64-bit keys to pointers. Lookups take no lock at all; they
+ * walk the buckets under RCU, while changes are made one at a time under
+ * the table's lock and free what they replace once no lookup can still
+ * be looking at it.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_KERNEL_HASH_TABLE_H
+#define COBALT_KERNEL_HASH_TABLE_H
+
+#include <Types.h>
+
+/**
+ * @brief A hash table.
+ * @since 0.1.0.6
+ */
+typedef struct cobalt_hash_table cobalt_hash_table_t;
+
+/**
+ * @brief Create an empty hash table. The number of buckets is fixed, so
+ * it should be about the number of keys the table is expected to hold.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param order The table has 2^order buckets. This must be at least one.
+ * @return The table, or nullptr if memory has run out.
+ */
+cobalt_hash_table_t *Cobalt_CreateHashTable(cobalt_u32_t order);
+
+/**
+ * @brief Destroy a hash table. This waits out a grace period, but nothing
+ * may start a lookup or a change once it's been called.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param table The table.
+ */
+void Cobalt_DestroyHashTable(cobalt_hash_table_t *table);
+
+/**
+ * @brief Map a key to a value, replacing whatever it mapped to before.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param table The table.
+ * @param key The key.
+ * @param value The value.
+ * @return Whether or not the key could be mapped. This fails only if
+ * memory has run out.
+ */
+bool Cobalt_HashTableInsert(cobalt_hash_table_t *table, cobalt_u64_t key,
+                            void *value);
+
+/**
+ * @brief Look up the value a key maps to. This never waits on a change.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param table The table.
+ * @param key The key.
+ * @return The value, or nullptr if the key isn't mapped.
+ */
+void *Cobalt_HashTableLookup(cobalt_hash_table_t *table, cobalt_u64_t key);
+
+/**
+ * @brief Unmap a key.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param table The table.
+ * @param key The key.
+ * @return Whether or not the key was mapped.
+ */
+bool Cobalt_HashTableRemove(cobalt_hash_table_t *table, cobalt_u64_t key);
+
+/**
+ * @brief Look keys up in a hash table with one thread, then twice as
+ * many, and so on up to one per processor online, first under RCU and
+ * then under a reader-writer lock, and report the lookups per millisecond
+ * of each over serial. This blocks the calling thread until every round
+ * is done.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param ticksPerMicrosecond The rate of the timestamp counter.
+ */
+void Cobalt_BenchmarkHashTable(cobalt_u64_t ticksPerMicrosecond);
+
+#endif // COBALT_KERNEL_HASH_TABLE_H
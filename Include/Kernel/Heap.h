@@ -0,0 +1,153 @@
+/**
+ * @file Heap.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the interface of the kernel's general-purpose
+ * heap. Small requests are rounded up to one of a set of size classes,
+ * four to each doubling, and served from runs of pages carved out of
+ * chunks that each processor's arena owns, so that the common case takes
+ * only a lock no other processor wants. Larger requests get a run of
+ * whole pages, and requests too large for a chunk get a block straight
+ * from the physical allocator. Every block records its size, so freeing
+ * needs only the pointer.
+ *
+ * Defining COBALT_HOSTED builds the heap against the C library instead
+ * of the physical allocator, with one arena per thread, so that it can
+ * be linked into an ordinary program and measured against synthetic
+ * traces.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_KERNEL_HEAP_H
+#define COBALT_KERNEL_HEAP_H
+
+#include <Types.h>
+
+/**
+ * @brief The alignment of every block the heap hands out, unless more is
+ * asked for.
+ * @since 0.1.0.6
+ */
+#define COBALT_HEAP_ALIGNMENT 16
+
+/**
+ * @brief The largest request served from a size class. Anything larger
+ * gets whole pages.
+ * @since 0.1.0.6
+ */
+#define COBALT_HEAP_SMALL_MAXIMUM 4096
+
+/**
+ * @brief Each arena takes memory from the physical allocator in chunks of
+ * 2^this pages, or 1 MiB.
+ * @since 0.1.0.6
+ */
+#define COBALT_HEAP_CHUNK_ORDER 8
+
+/**
+ * @brief A snapshot of the heap's counters, summed over every arena.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief The bytes in blocks that are handed out, counting each at
+     * its rounded-up size.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t activeBytes;
+
+    /**
+     * @brief The bytes the heap holds from the physical allocator. The
+     * gap between this and the active bytes is the heap's overhead and
+     * fragmentation.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t mappedBytes;
+
+    /**
+     * @brief The number of blocks handed out so far.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t allocations;
+
+    /**
+     * @brief The number of blocks freed so far.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t frees;
+} cobalt_heap_stats_t;
+
+/**
+ * @brief Allocate a block from the heap, aligned to COBALT_HEAP_ALIGNMENT.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param size The size of the block in bytes.
+ * @return The block, or nullptr if memory has run out.
+ */
+void *Cobalt_Allocate(cobalt_u64_t size);
+
+/**
+ * @brief Allocate a block from the heap with a stricter alignment.
+ * Alignments beyond a page are only honoured for blocks that fit within
+ * a chunk.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param size The size of the block in bytes.
+ * @param alignment The alignment of the block. This must be a power of
+ * two.
+ * @return The block, or nullptr if memory has run out or the alignment
+ * can't be met.
+ */
+void *Cobalt_AllocateAligned(cobalt_u64_t size, cobalt_u64_t alignment);
+
+/**
+ * @brief Resize a block, moving it if it doesn't fit where it is. A
+ * block that moves is only guaranteed COBALT_HEAP_ALIGNMENT.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param block The block, or nullptr to allocate a new one.
+ * @param size The new size of the block in bytes, or zero to free it.
+ * @return The resized block, or nullptr if it was freed or memory has
+ * run out. In the latter case the original block is left untouched.
+ */
+void *Cobalt_Reallocate(void *block, cobalt_u64_t size);
+
+/**
+ * @brief Return a block to the heap. This may be called from any
+ * processor, not only the one that allocated the block.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param block The block, or nullptr to do nothing.
+ */
+void Cobalt_Free(void *block);
+
+/**
+ * @brief Get the usable size of a block, which is at least the size it
+ * was allocated with.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param block The block.
+ * @return The number of bytes the block may hold.
+ */
+cobalt_u64_t Cobalt_AllocationSize(const void *block);
+
+/**
+ * @brief Take a snapshot of the heap's counters.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param stats The snapshot to fill.
+ */
+void Cobalt_GetHeapStats(cobalt_heap_stats_t *stats);
+
+#endif // COBALT_KERNEL_HEAP_H
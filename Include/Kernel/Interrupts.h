@@ -0,0 +1,132 @@
+/**
+ * @file Interrupts.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the interface of the kernel's interrupt
+ * descriptor table. Every vector funnels through one common entry that
+ * saves the general registers and calls whichever handler was installed
+ * for it. Handlers run with interrupts disabled and, like the rest of the
+ * kernel, must not touch the vector registers.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_KERNEL_INTERRUPTS_H
+#define COBALT_KERNEL_INTERRUPTS_H
+
+#include <Types.h>
+
+/**
+ * @brief The vectors the kernel gives a fixed meaning.
+ * @since 0.1.0.6
+ */
+typedef enum : cobalt_u8_t
+{
+    /**
+     * @brief The page fault exception.
+     * @since 0.1.0.6
+     */
+    COBALT_VECTOR_PAGE_FAULT = 14,
+    /**
+     * @brief The local APIC timer's interrupt.
+     * @since 0.1.0.6
+     */
+    COBALT_VECTOR_TIMER = 0xF0,
+    /**
+     * @brief The interprocessor interrupt that wakes an idle processor
+     * to look for work.
+     * @since 0.1.0.6
+     */
+    COBALT_VECTOR_RESCHEDULE = 0xFC,
+    /**
+     * @brief The interprocessor interrupt asking for TLB entries to be
+     * flushed.
+     * @since 0.1.0.6
+     */
+    COBALT_VECTOR_TLB_SHOOTDOWN = 0xFD,
+    /**
+     * @brief The vector the local APIC raises for spurious interrupts.
+     * @since 0.1.0.6
+     */
+    COBALT_VECTOR_SPURIOUS = 0xFF
+} cobalt_vector_t;
+
+/**
+ * @brief The state of the interrupted code, as the common entry saved it.
+ * Handlers may change it, and the changes take effect on return.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief The general registers, in the reverse of the order they're
+     * pushed in.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t r15, r14, r13, r12, r11, r10, r9, r8;
+    cobalt_u64_t rbp, rdi, rsi, rdx, rcx, rbx, rax;
+
+    /**
+     * @brief The vector that was raised.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t vector;
+
+    /**
+     * @brief The error code the processor pushed, or zero for vectors
+     * that don't have one.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t errorCode;
+
+    /**
+     * @brief The frame the processor pushed.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t rip, cs, rflags, rsp, ss;
+} cobalt_interrupt_frame_t;
+
+/**
+ * @brief A function that handles a vector.
+ * @since 0.1.0.6
+ *
+ * @param frame The state of the interrupted code.
+ */
+typedef void (*cobalt_interrupt_handler_t)(
+    cobalt_interrupt_frame_t *frame);
+
+/**
+ * @brief Build the interrupt descriptor table, if it hasn't been already,
+ * and load it on this processor. Vectors without a handler are reported
+ * and halt the processor.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+void Cobalt_InitializeInterrupts(void);
+
+/**
+ * @brief Install the handler of a vector.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param vector The vector.
+ * @param handler The handler, or nullptr to go back to the default.
+ */
+void Cobalt_SetInterruptHandler(cobalt_u8_t vector,
+                                cobalt_interrupt_handler_t handler);
+
+/**
+ * @brief Report an interrupt that couldn't be handled over serial, and
+ * halt the processor.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param frame The state of the interrupted code.
+ */
+[[noreturn]] void
+Cobalt_UnhandledInterrupt(cobalt_interrupt_frame_t *frame);
+
+#endif // COBALT_KERNEL_INTERRUPTS_H
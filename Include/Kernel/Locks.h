@@ -0,0 +1,429 @@
+/**
+ * @file Locks.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the kernel's locks beyond the basic spinlock.
+ * Ticket locks hand a short critical section out in order. MCS locks have
+ * each waiter spin on its own cache line, which holds up on paths that
+ * many processors contend for. Seqlocks let data that's read far more
+ * often than it's written be read without writing anything, and
+ * reader-writer locks let readers in together.
+ *
+ * Every lock here spins, with PAUSE between looks, and none of them
+ * touch the interrupt flag; whoever takes one from code an interrupt
+ * handler might also take it from has to disable interrupts first.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_KERNEL_LOCKS_H
+#define COBALT_KERNEL_LOCKS_H
+
+#include <CPU.h>
+#include <Kernel/CPU.h>
+#include <Kernel/Spinlock.h>
+#include <stdatomic.h>
+
+/**
+ * @brief The PAUSEs a ticket lock waiter spins for per waiter ahead of
+ * it before looking again.
+ * @since 0.1.0.6
+ */
+#define COBALT_TICKET_BACKOFF 32
+
+/**
+ * @brief A ticket lock. Zero-initialize this to get an unlocked lock.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief The next ticket to hand out.
+     * @since 0.1.0.6
+     */
+    atomic_uint next;
+
+    /**
+     * @brief The ticket that holds the lock.
+     * @since 0.1.0.6
+     */
+    atomic_uint owner;
+} cobalt_ticket_lock_t;
+
+/**
+ * @brief A waiter of an MCS lock. Each taker brings its own, usually on
+ * its stack, and it must stay put until the lock is released.
+ * @since 0.1.0.6
+ */
+typedef struct cobalt_mcs_node
+{
+    /**
+     * @brief The waiter that queued up behind this one.
+     * @since 0.1.0.6
+     */
+    alignas(COBALT_CACHE_LINE_SIZE) _Atomic(struct cobalt_mcs_node *)
+        next;
+
+    /**
+     * @brief Whether or not this waiter is still waiting. It's the only
+     * thing the waiter spins on.
+     * @since 0.1.0.6
+     */
+    atomic_bool waiting;
+} cobalt_mcs_node_t;
+
+/**
+ * @brief An MCS queue lock. Zero-initialize this to get an unlocked lock.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief The last waiter in the queue, or nullptr if the lock is
+     * free.
+     * @since 0.1.0.6
+     */
+    _Atomic(cobalt_mcs_node_t *) tail;
+} cobalt_mcs_lock_t;
+
+/**
+ * @brief A sequence lock. Readers don't write to it at all, so they
+ * never contend, but they have to retry if a writer got in during their
+ * read. Zero-initialize this to get an unlocked lock.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief The sequence number, which is odd while a write is under
+     * way.
+     * @since 0.1.0.6
+     */
+    atomic_uint sequence;
+
+    /**
+     * @brief The lock that keeps writers out of each other's way.
+     * @since 0.1.0.6
+     */
+    cobalt_spinlock_t writer;
+} cobalt_seqlock_t;
+
+/**
+ * @brief The bit of a reader-writer lock's state that a writer holds.
+ * @since 0.1.0.6
+ */
+#define COBALT_RWLOCK_WRITER (1U << 31)
+
+/**
+ * @brief The bit of a reader-writer lock's state that a waiting writer
+ * sets, which keeps new readers out until it's had its turn.
+ * @since 0.1.0.6
+ */
+#define COBALT_RWLOCK_WRITER_WAITING (1U << 30)
+
+/**
+ * @brief A reader-writer lock. Waiting writers are let in before new
+ * readers, so that a stream of readers can't starve them. Zero-initialize
+ * this to get an unlocked lock.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief The number of readers holding the lock, along with the
+     * writer bits.
+     * @since 0.1.0.6
+     */
+    atomic_uint state;
+} cobalt_rwlock_t;
+
+/**
+ * @brief Take a ticket lock, waiting for every taker ahead of us.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param lock The lock to take.
+ */
+static inline void Cobalt_TicketLock(cobalt_ticket_lock_t *lock)
+{
+    const cobalt_u32_t ticket =
+        atomic_fetch_add_explicit(&lock->next, 1, memory_order_relaxed);
+    for (;;)
+    {
+        const cobalt_u32_t owner =
+            atomic_load_explicit(&lock->owner, memory_order_acquire);
+        if (owner == ticket) return;
+
+        // Every waiter ahead of us will hold the lock for a while, so
+        // there's no use looking again sooner.
+        const cobalt_u32_t backoff =
+            (ticket - owner) * COBALT_TICKET_BACKOFF;
+        for (cobalt_u32_t i = 0; i < backoff; i++) Cobalt_Pause();
+    }
+}
+
+/**
+ * @brief Take a ticket lock if it's free, without waiting.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param lock The lock to take.
+ * @return Whether or not the lock was taken.
+ */
+static inline bool Cobalt_TicketTryLock(cobalt_ticket_lock_t *lock)
+{
+    cobalt_u32_t owner =
+        atomic_load_explicit(&lock->owner, memory_order_relaxed);
+    return atomic_compare_exchange_strong_explicit(
+        &lock->next, &owner, owner + 1, memory_order_acquire,
+        memory_order_relaxed);
+}
+
+/**
+ * @brief Release a ticket lock to the next taker in line.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param lock The lock to release.
+ */
+static inline void Cobalt_TicketUnlock(cobalt_ticket_lock_t *lock)
+{
+    const cobalt_u32_t owner =
+        atomic_load_explicit(&lock->owner, memory_order_relaxed);
+    atomic_store_explicit(&lock->owner, owner + 1, memory_order_release);
+}
+
+/**
+ * @brief Take an MCS lock, queueing behind whoever holds it.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param lock The lock to take.
+ * @param node The waiter to queue. It must be passed to Cobalt_MCSUnlock
+ * along with the lock.
+ */
+static inline void Cobalt_MCSLock(cobalt_mcs_lock_t *lock,
+                                  cobalt_mcs_node_t *node)
+{
+    atomic_store_explicit(&node->next, nullptr, memory_order_relaxed);
+    atomic_store_explicit(&node->waiting, true, memory_order_relaxed);
+
+    cobalt_mcs_node_t *previous =
+        atomic_exchange_explicit(&lock->tail, node, memory_order_acq_rel);
+    if (previous == nullptr) return;
+
+    atomic_store_explicit(&previous->next, node, memory_order_release);
+    while (atomic_load_explicit(&node->waiting, memory_order_acquire))
+        Cobalt_Pause();
+}
+
+/**
+ * @brief Release an MCS lock to the next waiter in the queue.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param lock The lock to release.
+ * @param node The waiter the lock was taken with.
+ */
+static inline void Cobalt_MCSUnlock(cobalt_mcs_lock_t *lock,
+                                    cobalt_mcs_node_t *node)
+{
+    cobalt_mcs_node_t *next =
+        atomic_load_explicit(&node->next, memory_order_acquire);
+    if (next == nullptr)
+    {
+        cobalt_mcs_node_t *expected = node;
+        if (atomic_compare_exchange_strong_explicit(
+                &lock->tail, &expected, nullptr, memory_order_release,
+                memory_order_relaxed))
+            return;
+
+        // Someone has swapped themselves in as the tail, but hasn't
+        // linked themselves behind us yet.
+        while ((next = atomic_load_explicit(&node->next,
+                                            memory_order_acquire)) ==
+               nullptr)
+            Cobalt_Pause();
+    }
+    atomic_store_explicit(&next->waiting, false, memory_order_release);
+}
+
+/**
+ * @brief Start writing data a seqlock guards, waiting for any other
+ * writer to finish first.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param lock The lock.
+ */
+static inline void Cobalt_SeqWriteBegin(cobalt_seqlock_t *lock)
+{
+    Cobalt_SpinLock(&lock->writer);
+    const cobalt_u32_t sequence =
+        atomic_load_explicit(&lock->sequence, memory_order_relaxed);
+    atomic_store_explicit(&lock->sequence, sequence + 1,
+                          memory_order_relaxed);
+    // The odd sequence number has to be visible before any of the
+    // writes it covers.
+    atomic_thread_fence(memory_order_release);
+}
+
+/**
+ * @brief Finish writing data a seqlock guards.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param lock The lock.
+ */
+static inline void Cobalt_SeqWriteEnd(cobalt_seqlock_t *lock)
+{
+    const cobalt_u32_t sequence =
+        atomic_load_explicit(&lock->sequence, memory_order_relaxed);
+    atomic_store_explicit(&lock->sequence, sequence + 1,
+                          memory_order_release);
+    Cobalt_SpinUnlock(&lock->writer);
+}
+
+/**
+ * @brief Start reading data a seqlock guards, waiting out any write
+ * that's under way. The data should be copied out, and only used once
+ * Cobalt_SeqReadRetry says the copy is whole.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param lock The lock.
+ * @return The sequence number to pass to Cobalt_SeqReadRetry.
+ */
+static inline cobalt_u32_t
+Cobalt_SeqReadBegin(const cobalt_seqlock_t *lock)
+{
+    cobalt_u32_t sequence;
+    while ((sequence = atomic_load_explicit(&lock->sequence,
+                                            memory_order_acquire)) &
+           1)
+        Cobalt_Pause();
+    return sequence;
+}
+
+/**
+ * @brief Check whether a read of data a seqlock guards raced a write,
+ * and so has to be done again.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param lock The lock.
+ * @param sequence The sequence number Cobalt_SeqReadBegin returned.
+ * @return Whether or not the read has to be retried.
+ */
+static inline bool Cobalt_SeqReadRetry(const cobalt_seqlock_t *lock,
+                                       cobalt_u32_t sequence)
+{
+    // The reads of the data have to be done before the sequence number
+    // is looked at again.
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&lock->sequence, memory_order_relaxed) !=
+           sequence;
+}
+
+/**
+ * @brief Take a reader-writer lock for reading, alongside any other
+ * readers.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param lock The lock to take.
+ */
+static inline void Cobalt_ReadLock(cobalt_rwlock_t *lock)
+{
+    cobalt_u32_t state =
+        atomic_load_explicit(&lock->state, memory_order_relaxed);
+    for (;;)
+    {
+        if (state & (COBALT_RWLOCK_WRITER | COBALT_RWLOCK_WRITER_WAITING))
+        {
+            Cobalt_Pause();
+            state = atomic_load_explicit(&lock->state,
+                                         memory_order_relaxed);
+            continue;
+        }
+        if (atomic_compare_exchange_weak_explicit(
+                &lock->state, &state, state + 1, memory_order_acquire,
+                memory_order_relaxed))
+            return;
+    }
+}
+
+/**
+ * @brief Release a reader-writer lock taken for reading.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param lock The lock to release.
+ */
+static inline void Cobalt_ReadUnlock(cobalt_rwlock_t *lock)
+{
+    atomic_fetch_sub_explicit(&lock->state, 1, memory_order_release);
+}
+
+/**
+ * @brief Take a reader-writer lock for writing, once every reader and
+ * writer ahead of us has left.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param lock The lock to take.
+ */
+static inline void Cobalt_WriteLock(cobalt_rwlock_t *lock)
+{
+    cobalt_u32_t state =
+        atomic_load_explicit(&lock->state, memory_order_relaxed);
+    for (;;)
+    {
+        // Taking the lock clears the waiting bit, which any other waiting
+        // writer sets again the next time it looks.
+        if ((state & ~COBALT_RWLOCK_WRITER_WAITING) == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(
+                    &lock->state, &state, COBALT_RWLOCK_WRITER,
+                    memory_order_acquire, memory_order_relaxed))
+                return;
+            continue;
+        }
+        if (!(state & COBALT_RWLOCK_WRITER_WAITING))
+            atomic_fetch_or_explicit(&lock->state,
+                                     COBALT_RWLOCK_WRITER_WAITING,
+                                     memory_order_relaxed);
+        Cobalt_Pause();
+        state = atomic_load_explicit(&lock->state, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Release a reader-writer lock taken for writing.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param lock The lock to release.
+ */
+static inline void Cobalt_WriteUnlock(cobalt_rwlock_t *lock)
+{
+    atomic_fetch_and_explicit(&lock->state, ~COBALT_RWLOCK_WRITER,
+                              memory_order_release);
+}
+
+/**
+ * @brief Hammer each kind of lock with one thread, then twice as many,
+ * and so on up to one per processor online, and report the acquisitions
+ * per millisecond of each over serial. This blocks the calling thread
+ * until every round is done.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param ticksPerMicrosecond The rate of the timestamp counter.
+ */
+void Cobalt_BenchmarkLocks(cobalt_u64_t ticksPerMicrosecond);
+
+#endif // COBALT_KERNEL_LOCKS_H
@@ -0,0 +1,146 @@
+/**
+ * @file Physical.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the interface of the kernel's physical page
+ * allocator. Blocks of 2^order pages come from a binary buddy allocator,
+ * and single pages come from a small cache kept by each processor in
+ * front of it, so that the common case never takes the buddy allocator's
+ * lock. Every address here is physical; reach the memory itself through
+ * the direct map.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_KERNEL_PHYSICAL_H
+#define COBALT_KERNEL_PHYSICAL_H
+
+#include <Bootloader/Types.h>
+#include <Types.h>
+
+/**
+ * @brief The largest block the buddy allocator hands out is 2^this pages,
+ * or 4 MiB.
+ * @since 0.1.0.6
+ */
+#define COBALT_PHYSICAL_MAXIMUM_ORDER 10
+
+/**
+ * @brief The most single pages each processor's cache holds.
+ * @since 0.1.0.6
+ */
+#define COBALT_PAGE_CACHE_SIZE 64
+
+/**
+ * @brief The number of pages moved between a processor's cache and the
+ * buddy allocator at once, when the cache runs empty or full.
+ * @since 0.1.0.6
+ */
+#define COBALT_PAGE_CACHE_BATCH 32
+
+/**
+ * @brief Memory below this address is never handed out, since it's the
+ * only memory a processor starting up in real mode can reach.
+ * @since 0.1.0.6
+ */
+#define COBALT_PHYSICAL_LOW_LIMIT 0x100000
+
+/**
+ * @brief A snapshot of the physical allocator's counters.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief The number of pages the allocator manages.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t totalPages;
+
+    /**
+     * @brief The number of pages that are free, whether in the buddy
+     * allocator or in a processor's cache.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t freePages;
+
+    /**
+     * @brief The number of free pages in each processor's cache.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t cachedPages;
+} cobalt_physical_stats_t;
+
+/**
+ * @brief Set up the physical allocator from the loader's memory map. Only
+ * usable memory is added; the kernel image and the allocator's own frame
+ * table are left out. Memory the firmware's boot services used is left
+ * for Cobalt_AddPhysicalMemory once the kernel no longer depends on it.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param efiInfo The information the loader handed to the kernel.
+ * @return Whether or not the allocator could be set up. This fails only
+ * if no usable region can hold the frame table.
+ */
+bool Cobalt_InitializePhysicalMemory(const cobalt_efi_info_t *efiInfo);
+
+/**
+ * @brief Hand a range of memory to the physical allocator. The range must
+ * lie within the span of the memory map the allocator was set up from,
+ * and is shrunk to whole pages.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param base The physical address of the range.
+ * @param pageCount The number of pages in the range.
+ */
+void Cobalt_AddPhysicalMemory(cobalt_u64_t base, cobalt_u64_t pageCount);
+
+/**
+ * @brief Allocate a block of 2^order physically contiguous pages, aligned
+ * to its own size. Single pages come from this processor's cache.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param order The order of the block.
+ * @return The physical address of the block, or zero if there's no block
+ * that large free.
+ */
+cobalt_u64_t Cobalt_AllocatePages(cobalt_u32_t order);
+
+/**
+ * @brief Free a block of pages from Cobalt_AllocatePages.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param address The physical address of the block.
+ * @param order The order the block was allocated with.
+ */
+void Cobalt_FreePages(cobalt_u64_t address, cobalt_u32_t order);
+
+/**
+ * @brief Take a snapshot of the physical allocator's counters.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param stats The snapshot to fill.
+ */
+void Cobalt_GetPhysicalStats(cobalt_physical_stats_t *stats);
+
+/**
+ * @brief Hammer the physical allocator from every processor at once and
+ * report each one's allocations per second over serial. Every page is
+ * returned afterwards. This needs the scheduler, and should come after
+ * the application processors are up.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param ticksPerMicrosecond The rate of the timestamp counter.
+ */
+void Cobalt_BenchmarkPhysicalMemory(cobalt_u64_t ticksPerMicrosecond);
+
+#endif // COBALT_KERNEL_PHYSICAL_H
@@ -0,0 +1,182 @@
+/**
+ * @file RCU.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the interface of the kernel's read-copy-update
+ * mechanism, for structures that are read far more often than they're
+ * changed. Readers take no lock and write nothing shared; writers publish
+ * a new version of what they change, and free the old one only once
+ * every processor has passed through a quiescent state, a point at which
+ * it can't be reading anything.
+ *
+ * Context switches and timer ticks that land outside a read section are
+ * the quiescent states, so a read section is just one with preemption
+ * disabled. An idle processor, whose timer may not tick at all, is
+ * quiescent for as long as it's idle. Pointers readers follow should be
+ * atomic, loaded with acquire ordering and stored with release ordering.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_KERNEL_RCU_H
+#define COBALT_KERNEL_RCU_H
+
+#include <Kernel/CPU.h>
+#include <Types.h>
+
+/**
+ * @brief The most callbacks a processor's RCU thread runs before giving
+ * other threads of its priority a turn.
+ * @since 0.1.0.6
+ */
+#define COBALT_RCU_BATCH 64
+
+/**
+ * @brief A callback waiting on a grace period. This is meant to be
+ * embedded at the start of whatever the callback frees.
+ * @since 0.1.0.6
+ */
+typedef struct cobalt_rcu_head
+{
+    /**
+     * @brief The next callback queued on the same processor.
+     * @since 0.1.0.6
+     */
+    struct cobalt_rcu_head *next;
+
+    /**
+     * @brief The function to call once the grace period is over. It's
+     * called from a thread with interrupts enabled, so it may free memory
+     * and take locks, but every callback behind it waits while it runs.
+     * @since 0.1.0.6
+     */
+    void (*function)(struct cobalt_rcu_head *head);
+} cobalt_rcu_head_t;
+
+/**
+ * @brief A snapshot of the mechanism's counters.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief The number of grace periods that have ended.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t gracePeriods;
+
+    /**
+     * @brief The number of callbacks that have been run.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t callbacks;
+} cobalt_rcu_stats_t;
+
+/**
+ * @brief Start a read section. Anything read through an RCU-protected
+ * pointer stays valid until the section ends. Sections can nest, and
+ * mustn't block.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+static inline void Cobalt_RCUReadLock(void) { Cobalt_DisablePreemption(); }
+
+/**
+ * @brief End a read section.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+static inline void Cobalt_RCUReadUnlock(void)
+{
+    Cobalt_EnablePreemption();
+}
+
+/**
+ * @brief Queue a callback to run once every read section that might have
+ * seen what it frees has ended. The callback runs in this processor's
+ * RCU thread, which isn't bound to this processor.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param head The callback's head, which must stay put until it runs.
+ * @param function The callback.
+ */
+void Cobalt_CallRCU(cobalt_rcu_head_t *head,
+                    void (*function)(cobalt_rcu_head_t *head));
+
+/**
+ * @brief Block until every read section that was under way when this was
+ * called has ended. This mustn't be called from a read section.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+void Cobalt_SynchronizeRCU(void);
+
+/**
+ * @brief Note that this processor is in a quiescent state. The scheduler
+ * calls this on every context switch, with interrupts disabled.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+void Cobalt_RCUQuiescentState(void);
+
+/**
+ * @brief Note that this processor is going idle, and is quiescent until
+ * it calls Cobalt_RCUExitIdle. Grace periods don't wait on it meanwhile,
+ * so nothing it runs until then may enter a read section, interrupt
+ * handlers included. Interrupts must be disabled.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return Whether or not this processor has callbacks of its own waiting,
+ * which only move along while its timer keeps ticking.
+ */
+bool Cobalt_RCUEnterIdle(void);
+
+/**
+ * @brief Note that this processor is no longer idle. This may be called
+ * when it isn't idle, in which case it does nothing. Interrupts must be
+ * disabled.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+void Cobalt_RCUExitIdle(void);
+
+/**
+ * @brief Create the thread that runs a processor's callbacks. Until it
+ * exists, that processor's callbacks pile up. This needs the scheduler,
+ * and must be called for each processor before it comes online.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param index The index of the processor.
+ * @return Whether or not the thread could be created.
+ */
+bool Cobalt_StartRCU(cobalt_u32_t index);
+
+/**
+ * @brief Move this processor's callbacks along: note a quiescent state if
+ * the tick didn't land in a read section, wake the processor's RCU
+ * thread if a grace period its callbacks were waiting on is over, and
+ * ask for a grace period for those that were queued since. The
+ * scheduler calls this on every timer interrupt, which comes at least
+ * once a time slice while there's a thread running or a callback
+ * waiting.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+void Cobalt_RCUTick(void);
+
+/**
+ * @brief Take a snapshot of the mechanism's counters.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param stats The snapshot to fill.
+ */
+void Cobalt_GetRCUStats(cobalt_rcu_stats_t *stats);
+
+#endif // COBALT_KERNEL_RCU_H
@@ -0,0 +1,53 @@
+/**
+ * @file SMP.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the kernel's interface for bringing up the
+ * application processors. They're found through the ACPI MADT and started
+ * one at a time with the INIT-SIPI-SIPI sequence, through a trampoline
+ * copied below 1 MiB that takes them straight from real mode to long
+ * mode.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_KERNEL_SMP_H
+#define COBALT_KERNEL_SMP_H
+
+#include <Bootloader/Types.h>
+#include <Types.h>
+
+/**
+ * @brief The order of the block of pages each application processor gets
+ * for its kernel stack.
+ * @since 0.1.0.6
+ */
+#define COBALT_STACK_ORDER 2
+
+/**
+ * @brief How long to wait for an application processor to come up after
+ * its second startup IPI before giving up on it, in microseconds.
+ * @since 0.1.0.6
+ */
+#define COBALT_STARTUP_TIMEOUT 100000
+
+/**
+ * @brief Start every enabled processor in the MADT, logging how long each
+ * took over serial. Each comes up with its own stack, descriptor tables
+ * and per-processor block, with the interrupt table, the kernel's address
+ * space and its local APIC loaded, and then joins the scheduler. The
+ * bootstrap processor must have all of those set up already, as well as
+ * ACPI and the scheduler.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param efiInfo The information the loader handed to the kernel.
+ * @return The number of processors online, the bootstrap processor
+ * included.
+ */
+cobalt_u32_t Cobalt_StartProcessors(const cobalt_efi_info_t *efiInfo);
+
+#endif // COBALT_KERNEL_SMP_H
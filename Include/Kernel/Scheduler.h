@@ -0,0 +1,278 @@
+/**
+ * @file Scheduler.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the interface of the kernel's thread
+ * scheduler. Each processor keeps a run queue per priority, which only it
+ * pushes to and which idle processors steal from. Threads are preempted
+ * when their time slice runs out, and woken threads are queued on the
+ * processor that woke them, whose cache is likely to hold what they'll
+ * look at first.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_KERNEL_SCHEDULER_H
+#define COBALT_KERNEL_SCHEDULER_H
+
+#include <Types.h>
+#include <stdatomic.h>
+
+/**
+ * @brief The length of a time slice in microseconds. A processor's timer
+ * only ticks at this rate while it has a thread to run; an idle one's
+ * stays quiet.
+ * @since 0.1.0.6
+ */
+#define COBALT_TIME_SLICE 4000
+
+/**
+ * @brief The number of threads each of a processor's run queues holds.
+ * Threads past this wait in a shared queue instead.
+ * @since 0.1.0.6
+ */
+#define COBALT_RUN_QUEUE_SIZE 256
+
+/**
+ * @brief The priority of a thread. A thread only runs when no thread of a
+ * higher priority is ready on its processor.
+ * @since 0.1.0.6
+ */
+typedef enum : cobalt_u32_t
+{
+    /**
+     * @brief Background work.
+     * @since 0.1.0.6
+     */
+    COBALT_PRIORITY_LOW,
+    /**
+     * @brief Most threads.
+     * @since 0.1.0.6
+     */
+    COBALT_PRIORITY_NORMAL,
+    /**
+     * @brief Threads that something is waiting on.
+     * @since 0.1.0.6
+     */
+    COBALT_PRIORITY_HIGH,
+    /**
+     * @brief The number of priorities.
+     * @since 0.1.0.6
+     */
+    COBALT_PRIORITY_COUNT
+} cobalt_priority_t;
+
+/**
+ * @brief A kernel thread.
+ * @since 0.1.0.6
+ */
+typedef struct cobalt_thread cobalt_thread_t;
+
+/**
+ * @brief The function a thread runs. Returning from it exits the thread.
+ * @since 0.1.0.6
+ *
+ * @param argument The argument the thread was created with.
+ */
+typedef void (*cobalt_thread_function_t)(void *argument);
+
+/**
+ * @brief A count of events one thread waits on, such as the workers it
+ * has fanned work out to or a callback it has queued. Each event signals
+ * the completion once, and the last to do so wakes the waiter.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief The number of events that have yet to signal.
+     * @since 0.1.0.6
+     */
+    atomic_ulong remaining;
+
+    /**
+     * @brief The thread that waits, which is the one that set the
+     * completion up.
+     * @since 0.1.0.6
+     */
+    cobalt_thread_t *waiter;
+} cobalt_completion_t;
+
+/**
+ * @brief A snapshot of the scheduler's counters, summed over every
+ * processor.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief The number of times a processor switched threads.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t contextSwitches;
+
+    /**
+     * @brief The timestamp counter ticks spent switching, from deciding
+     * to switch to running the next thread. Over the number of switches,
+     * this is the latency of a switch.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t switchTicks;
+
+    /**
+     * @brief The number of switches that were forced by a time slice
+     * running out.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t preemptions;
+
+    /**
+     * @brief The number of threads taken from another processor's run
+     * queue.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t steals;
+
+    /**
+     * @brief The number of times a thread ran on a different processor
+     * than it last did.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t migrations;
+} cobalt_scheduler_stats_t;
+
+/**
+ * @brief Set up the scheduler, turning the code that's running into the
+ * bootstrap processor's first thread, and start its time slice.
+ * Interrupts are enabled on return. The physical allocator, the slab
+ * allocator, and this processor's timers must already be set up.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param ticksPerMicrosecond The rate of the timestamp counter.
+ * @return Whether or not the scheduler could be set up.
+ */
+bool Cobalt_InitializeScheduler(cobalt_u64_t ticksPerMicrosecond);
+
+/**
+ * @brief Turn the code that's running into this processor's idle thread,
+ * set up its timers, and start running threads. Every processor but the
+ * first calls this once it's up.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+[[noreturn]] void Cobalt_RunScheduler(void);
+
+/**
+ * @brief Create a thread, and queue it on this processor.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param function The function the thread runs.
+ * @param argument The argument to pass it.
+ * @param priority The priority of the thread.
+ * @return The thread, or nullptr if memory has run out.
+ */
+cobalt_thread_t *Cobalt_CreateThread(cobalt_thread_function_t function,
+                                     void *argument,
+                                     cobalt_priority_t priority);
+
+/**
+ * @brief Get the thread that's running.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return The thread.
+ */
+cobalt_thread_t *Cobalt_CurrentThread(void);
+
+/**
+ * @brief Give up the rest of this thread's time slice to any thread of
+ * the same or a higher priority that's ready.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+void Cobalt_Yield(void);
+
+/**
+ * @brief Stop running this thread until it's woken. If it was woken
+ * since it last blocked, this returns straight away instead, so that a
+ * wakeup that comes before the block isn't lost.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+void Cobalt_BlockThread(void);
+
+/**
+ * @brief Wake a thread, queueing it on this processor if it's blocked.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param thread The thread. It must not have exited.
+ */
+void Cobalt_WakeThread(cobalt_thread_t *thread);
+
+/**
+ * @brief Exit this thread. Its stack is freed once another thread is
+ * running, so nothing may wake it after this.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+[[noreturn]] void Cobalt_ExitThread(void);
+
+/**
+ * @brief Set up a completion for this thread to wait on.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param completion The completion.
+ * @param count The number of signals to wait for.
+ */
+void Cobalt_InitializeCompletion(cobalt_completion_t *completion,
+                                 cobalt_u64_t count);
+
+/**
+ * @brief Signal a completion, waking its waiter if this was the last
+ * signal it was waiting for. The waiter may return, and the completion
+ * go out of scope, as soon as the count reaches zero, so it's never
+ * touched after that. This may be called with interrupts disabled.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param completion The completion.
+ */
+void Cobalt_SignalCompletion(cobalt_completion_t *completion);
+
+/**
+ * @brief Block until every signal a completion was set up for has come.
+ * This must be called by the thread that set it up.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param completion The completion.
+ */
+void Cobalt_WaitForCompletion(cobalt_completion_t *completion);
+
+/**
+ * @brief Take a snapshot of the scheduler's counters.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param stats The snapshot to fill.
+ */
+void Cobalt_GetSchedulerStats(cobalt_scheduler_stats_t *stats);
+
+/**
+ * @brief Run a CPU-bound workload on one thread, then on twice as many,
+ * and so on up to one per processor online, and report the throughput of
+ * each over serial along with the scheduler's counters. This blocks the
+ * calling thread until every round is done.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+void Cobalt_BenchmarkScheduler(void);
+
+#endif // COBALT_KERNEL_SCHEDULER_H
@@ -0,0 +1,67 @@
+/**
+ * @file Serial.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the kernel's interface to the first serial
+ * port. With the firmware's console gone after ExitBootServices, this is
+ * the simplest way for the kernel to say anything at all.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_KERNEL_SERIAL_H
+#define COBALT_KERNEL_SERIAL_H
+
+#include <Types.h>
+#include <stdarg.h>
+
+/**
+ * @brief Set up the first serial port (COM1) for 115200 baud, 8N1
+ * output.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+void Cobalt_SerialInitialize(void);
+
+/**
+ * @brief Write a string to the serial port, without any sort of extra
+ * processing.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param string The ASCII string to write.
+ */
+void Cobalt_SerialPuts(const char *string);
+
+/**
+ * @brief A primitive formatted string printer using a libc-style format
+ * string, mirroring the bootloader's. As follows, the allowed formatters
+ * are: `s`: string, `c`: character, `L`: integer, `U`: unsigned integer,
+ * `X`: hexadecimal unsigned integer.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param format The format string to interleave with the arguments.
+ * @param args The arguments to interleave with the format string.
+ *
+ * @see Cobalt_SerialPrintf
+ */
+void Cobalt_SerialPrintfv(const char *format, va_list args);
+
+/**
+ * @brief A primitive formatted string printer. See Cobalt_SerialPrintfv
+ * for the allowed formatters.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param format The format string to interleave with the arguments.
+ * @param ... The arguments to interleave with the format string.
+ *
+ * @see Cobalt_SerialPrintfv
+ */
+void Cobalt_SerialPrintf(const char *format, ...);
+
+#endif // COBALT_KERNEL_SERIAL_H
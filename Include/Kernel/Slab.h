@@ -0,0 +1,174 @@
+/**
+ * @file Slab.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the interface of the kernel's slab allocator,
+ * which hands out fixed-size objects from caches of one type each. Each
+ * cache carves blocks from the physical allocator into slabs of objects,
+ * and keeps a magazine of free objects per processor in front of them, so
+ * that most allocations are a handful of instructions and touch nothing
+ * shared. Objects are constructed once, when their slab is made, and are
+ * expected back in their constructed state.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_KERNEL_SLAB_H
+#define COBALT_KERNEL_SLAB_H
+
+#include <Types.h>
+
+/**
+ * @brief The most free objects each processor's magazine holds.
+ * @since 0.1.0.6
+ */
+#define COBALT_MAGAZINE_SIZE 16
+
+/**
+ * @brief The number of objects moved between a magazine and the cache's
+ * slabs at once, when the magazine runs empty or full.
+ * @since 0.1.0.6
+ */
+#define COBALT_MAGAZINE_BATCH 8
+
+/**
+ * @brief The largest slab a cache will use is 2^this pages. Objects too
+ * large to fit a few to a slab this size should come from the physical
+ * allocator directly.
+ * @since 0.1.0.6
+ */
+#define COBALT_SLAB_MAXIMUM_ORDER 4
+
+/**
+ * @brief A cache of objects of one size.
+ * @since 0.1.0.6
+ */
+typedef struct cobalt_slab_cache cobalt_slab_cache_t;
+
+/**
+ * @brief A function run on every object of a new slab, before any of them
+ * are handed out.
+ * @since 0.1.0.6
+ *
+ * @param object The object to construct.
+ */
+typedef void (*cobalt_slab_constructor_t)(void *object);
+
+/**
+ * @brief A snapshot of a cache's counters.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief The name the cache was created with.
+     * @since 0.1.0.6
+     */
+    const char *name;
+
+    /**
+     * @brief The size of each object, including its padding out to the
+     * cache's alignment.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t objectSize;
+
+    /**
+     * @brief The number of objects handed out and not yet freed.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t activeObjects;
+
+    /**
+     * @brief The number of objects across all of the cache's slabs.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t totalObjects;
+
+    /**
+     * @brief The number of slabs the cache holds.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t slabs;
+
+    /**
+     * @brief The number of allocations served straight from a magazine.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t hits;
+
+    /**
+     * @brief The number of allocations that had to refill a magazine
+     * first.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t misses;
+} cobalt_slab_stats_t;
+
+/**
+ * @brief Create a cache of objects. The cache itself is allocated from
+ * the physical allocator, which must already be set up.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param name The name of the cache, as reported in its statistics. This
+ * must outlive the cache.
+ * @param objectSize The size of each object in bytes.
+ * @param alignment The alignment of each object in bytes. This must be a
+ * power of two, or zero for the default of eight.
+ * @param constructor The constructor of each object, or nullptr.
+ * @return The new cache, or nullptr if it couldn't be allocated or the
+ * objects are too large.
+ */
+cobalt_slab_cache_t *
+Cobalt_CreateSlabCache(const char *name, cobalt_u64_t objectSize,
+                       cobalt_u64_t alignment,
+                       cobalt_slab_constructor_t constructor);
+
+/**
+ * @brief Allocate an object from a cache.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param cache The cache to allocate from.
+ * @return The object, or nullptr if physical memory has run out.
+ */
+void *Cobalt_SlabAllocate(cobalt_slab_cache_t *cache);
+
+/**
+ * @brief Return an object to the cache it came from.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param cache The cache the object was allocated from.
+ * @param object The object, in its constructed state.
+ */
+void Cobalt_SlabFree(cobalt_slab_cache_t *cache, void *object);
+
+/**
+ * @brief Step through every cache that has been created.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param previous The cache returned by the last call, or nullptr to
+ * start from the first cache.
+ * @return The next cache, or nullptr after the last.
+ */
+cobalt_slab_cache_t *
+Cobalt_NextSlabCache(const cobalt_slab_cache_t *previous);
+
+/**
+ * @brief Take a snapshot of a cache's counters.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param cache The cache to query.
+ * @param stats The snapshot to fill.
+ */
+void Cobalt_GetSlabStats(cobalt_slab_cache_t *cache,
+                         cobalt_slab_stats_t *stats);
+
+#endif // COBALT_KERNEL_SLAB_H
@@ -0,0 +1,76 @@
+/**
+ * @file Spinlock.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the kernel's basic spinlock. It spins on a
+ * plain load rather than on the exchange itself, so that waiters share
+ * the lock's cache line until it's actually released.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_KERNEL_SPINLOCK_H
+#define COBALT_KERNEL_SPINLOCK_H
+
+#include <CPU.h>
+#include <stdatomic.h>
+
+/**
+ * @brief A spinlock. Zero-initialize this to get an unlocked lock.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief Whether or not the lock is held.
+     * @since 0.1.0.6
+     */
+    atomic_bool locked;
+} cobalt_spinlock_t;
+
+/**
+ * @brief Take a spinlock, spinning until it's free.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param lock The lock to take.
+ */
+static inline void Cobalt_SpinLock(cobalt_spinlock_t *lock)
+{
+    while (atomic_exchange_explicit(&lock->locked, true,
+                                    memory_order_acquire))
+        while (atomic_load_explicit(&lock->locked, memory_order_relaxed))
+            Cobalt_Pause();
+}
+
+/**
+ * @brief Take a spinlock if it's free, without spinning.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param lock The lock to take.
+ * @return Whether or not the lock was taken.
+ */
+static inline bool Cobalt_SpinTryLock(cobalt_spinlock_t *lock)
+{
+    return !atomic_load_explicit(&lock->locked, memory_order_relaxed) &&
+           !atomic_exchange_explicit(&lock->locked, true,
+                                     memory_order_acquire);
+}
+
+/**
+ * @brief Release a spinlock.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param lock The lock to release.
+ */
+static inline void Cobalt_SpinUnlock(cobalt_spinlock_t *lock)
+{
+    atomic_store_explicit(&lock->locked, false, memory_order_release);
+}
+
+#endif // COBALT_KERNEL_SPINLOCK_H
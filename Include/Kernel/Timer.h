@@ -0,0 +1,174 @@
+/**
+ * @file Timer.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the interface of the kernel's timers. Each
+ * processor keeps its pending timers in a hierarchical wheel, whose
+ * levels of slots each cover eight times the span of the one below at an
+ * eighth of the precision, so that setting and cancelling a timer takes
+ * the same time however many are pending. The local APIC timer is armed
+ * for the earliest of them alone; a processor with no timers pending
+ * takes no timer interrupts at all.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_KERNEL_TIMER_H
+#define COBALT_KERNEL_TIMER_H
+
+#include <Types.h>
+#include <stdatomic.h>
+
+/**
+ * @brief A timer. This is meant to be embedded in whatever the timer's
+ * callback works on, and must be zeroed before it's first set.
+ * @since 0.1.0.6
+ */
+typedef struct cobalt_timer
+{
+    /**
+     * @brief The next timer in the same slot of the wheel.
+     * @since 0.1.0.6
+     */
+    struct cobalt_timer *next;
+
+    /**
+     * @brief The link that points at this timer, which is what lets it be
+     * taken out of its slot without walking it.
+     * @since 0.1.0.6
+     */
+    struct cobalt_timer **link;
+
+    /**
+     * @brief When the timer is due, in the wheel's units.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t expires;
+
+    /**
+     * @brief The function to call once the timer is due. It's called from
+     * the timer interrupt, on the processor that set the timer, so it
+     * mustn't block.
+     * @since 0.1.0.6
+     */
+    void (*function)(struct cobalt_timer *timer);
+
+    /**
+     * @brief One more than the index of the processor whose wheel holds
+     * the timer, or zero if it isn't pending.
+     * @since 0.1.0.6
+     */
+    atomic_uint wheel;
+} cobalt_timer_t;
+
+/**
+ * @brief A snapshot of the timers' counters, summed over every processor.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief The number of timer interrupts taken.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t interrupts;
+
+    /**
+     * @brief The number of timers that have fired.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t expired;
+} cobalt_timer_stats_t;
+
+/**
+ * @brief Set up this processor's wheel and local APIC timer, which raises
+ * COBALT_VECTOR_TIMER. The clock must already be started.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return Whether or not the local APIC timer is in TSC-deadline mode.
+ */
+bool Cobalt_InitializeTimers(void);
+
+/**
+ * @brief Set a timer on this processor, cancelling it first if it's
+ * pending. The timer may fire late, by up to about an eighth of the time
+ * until it's due, but never early.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param timer The timer.
+ * @param deadline When the timer is due, as Cobalt_MonotonicNanoseconds
+ * gives it. A deadline that's passed fires straight away.
+ * @param function The function to call once the timer is due.
+ */
+void Cobalt_SetTimer(cobalt_timer_t *timer, cobalt_u64_t deadline,
+                     void (*function)(cobalt_timer_t *timer));
+
+/**
+ * @brief Cancel a timer. This can be called from any processor, but
+ * doesn't wait for the timer's function if it's already running.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param timer The timer.
+ * @return Whether or not the timer was pending.
+ */
+bool Cobalt_CancelTimer(cobalt_timer_t *timer);
+
+/**
+ * @brief Get whether a timer is pending.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param timer The timer.
+ * @return Whether or not the timer is pending. This may be out of date by
+ * the time it's returned, unless the timer is only ever set, cancelled,
+ * and run on this processor with interrupts disabled.
+ */
+static inline bool Cobalt_TimerPending(cobalt_timer_t *timer)
+{
+    return atomic_load_explicit(&timer->wheel, memory_order_relaxed) != 0;
+}
+
+/**
+ * @brief Fire every timer on this processor that's due, and arm the local
+ * APIC timer for the next. The scheduler calls this on every timer
+ * interrupt, with interrupts disabled.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+void Cobalt_RunTimers(void);
+
+/**
+ * @brief Block this thread for a while.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param nanoseconds How long to block for, at least.
+ */
+void Cobalt_Sleep(cobalt_u64_t nanoseconds);
+
+/**
+ * @brief Take a snapshot of the timers' counters.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param stats The snapshot to fill.
+ */
+void Cobalt_GetTimerStats(cobalt_timer_stats_t *stats);
+
+/**
+ * @brief Time setting and cancelling timers, and how late sleeps of a
+ * range of lengths wake, and count the timer interrupts taken while every
+ * processor sits idle. Each is reported over serial. This blocks the
+ * calling thread until it's done.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+void Cobalt_BenchmarkTimers(void);
+
+#endif // COBALT_KERNEL_TIMER_H
@@ -0,0 +1,32 @@
+/**
+ * @file Trace.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the kernel's interface for reporting the boot
+ * trace handed to it by the bootloader.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_KERNEL_TRACE_H
+#define COBALT_KERNEL_TRACE_H
+
+#include <Trace.h>
+
+/**
+ * @brief Write a trace to the serial port in the Chrome trace event JSON
+ * format, which chrome://tracing and Perfetto can load directly. Each
+ * phase becomes a complete ("X") event, with timestamps in microseconds
+ * relative to the start of the first phase. Counters become counter
+ * ("C") events.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param trace The trace to write.
+ */
+void Cobalt_DumpTrace(const cobalt_trace_t *trace);
+
+#endif // COBALT_KERNEL_TRACE_H
@@ -0,0 +1,235 @@
+/**
+ * @file Virtual.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the interface of the kernel's virtual memory
+ * manager. Each address space owns the lower half of its page tables and
+ * shares the kernel's upper half, and keeps the regions mapped into it in
+ * a balanced tree. Regions are only reserved when mapped; their pages are
+ * filled in by the page fault handler as they're first touched.
+ *
+ * Address spaces are tagged with a PCID where the processor supports it,
+ * so switching between them keeps their TLB entries. Unmapping gathers
+ * every page it takes down into one flush, which reaches every other
+ * processor running the space with a single round of IPIs.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_KERNEL_VIRTUAL_H
+#define COBALT_KERNEL_VIRTUAL_H
+
+#include <Bootloader/Types.h>
+#include <Types.h>
+
+/**
+ * @brief The end of the lower half, which each address space owns.
+ * Everything from COBALT_DIRECT_MAP_BASE up belongs to the kernel.
+ * @since 0.1.0.6
+ */
+#define COBALT_USER_SPACE_END 0x0000800000000000ULL
+
+/**
+ * @brief The most pages a flush names one by one. A flush of more than
+ * this drops the whole address space's TLB entries instead.
+ * @since 0.1.0.6
+ */
+#define COBALT_FLUSH_BATCH_SIZE 32
+
+/**
+ * @brief The base of the window that devices and buffers too large for
+ * the heap are mapped into, which sits just above the direct map.
+ * @since 0.1.0.6
+ */
+#define COBALT_DEVICE_MAP_BASE 0xFFFFC00000000000ULL
+
+/**
+ * @brief The size of the device window in bytes.
+ * @since 0.1.0.6
+ */
+#define COBALT_DEVICE_MAP_SIZE 0x100000000000ULL
+
+/**
+ * @brief The access a region allows. Every region can be read.
+ * @since 0.1.0.6
+ */
+typedef enum : cobalt_u32_t
+{
+    /**
+     * @brief The region can be written.
+     * @since 0.1.0.6
+     */
+    COBALT_REGION_WRITABLE = 1 << 0,
+    /**
+     * @brief Code in the region can be run.
+     * @since 0.1.0.6
+     */
+    COBALT_REGION_EXECUTABLE = 1 << 1,
+    /**
+     * @brief The region can be reached from user mode.
+     * @since 0.1.0.6
+     */
+    COBALT_REGION_USER = 1 << 2,
+    /**
+     * @brief Writes to the region are gathered into whole lines before
+     * they're sent out, and reads of it aren't cached. This is meant for
+     * framebuffers. Without the page attribute table, writes go straight
+     * through the cache instead.
+     * @since 0.1.0.6
+     */
+    COBALT_REGION_WRITE_COMBINING = 1 << 3
+} cobalt_region_flags_t;
+
+/**
+ * @brief An address space.
+ * @since 0.1.0.6
+ */
+typedef struct cobalt_address_space cobalt_address_space_t;
+
+/**
+ * @brief Take over the page tables the loader built as the kernel's
+ * address space, and start handling page faults. The physical allocator
+ * and the interrupt table must already be set up.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param efiInfo The information the loader handed to the kernel.
+ * @return Whether or not the manager could be set up.
+ */
+bool Cobalt_InitializeVirtualMemory(const cobalt_efi_info_t *efiInfo);
+
+/**
+ * @brief Turn on global pages and PCIDs on this processor, program its
+ * page attribute table, and load the kernel's address space. Every
+ * processor but the first calls this as it comes up.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ */
+void Cobalt_StartVirtualMemory(void);
+
+/**
+ * @brief Get the kernel's address space.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return The kernel's address space.
+ */
+cobalt_address_space_t *Cobalt_KernelAddressSpace(void);
+
+/**
+ * @brief Create an empty address space. Its upper half is the kernel's.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return The address space, or nullptr if memory has run out.
+ */
+cobalt_address_space_t *Cobalt_CreateAddressSpace(void);
+
+/**
+ * @brief Destroy an address space, freeing every page mapped into it. It
+ * must not be loaded on any processor.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param space The address space.
+ */
+void Cobalt_DestroyAddressSpace(cobalt_address_space_t *space);
+
+/**
+ * @brief Load an address space on this processor.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param space The address space.
+ */
+void Cobalt_SwitchAddressSpace(cobalt_address_space_t *space);
+
+/**
+ * @brief Reserve a region of zero-filled memory. Pages are allocated as
+ * they're first touched.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param space The address space. Regions of the kernel's address space
+ * must lie in the upper half, and those of any other in the lower.
+ * @param base The page-aligned address of the region.
+ * @param size The page-aligned size of the region in bytes.
+ * @param flags The access the region allows.
+ * @return Whether or not the region could be reserved. This fails if it
+ * overlaps another region.
+ */
+bool Cobalt_MapRegion(cobalt_address_space_t *space, cobalt_u64_t base,
+                      cobalt_u64_t size, cobalt_region_flags_t flags);
+
+/**
+ * @brief Reserve a region backed by a fixed range of physical memory,
+ * such as a device's registers. Pages are mapped as they're first
+ * touched, and the memory is never freed by the manager.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param space The address space, as for Cobalt_MapRegion.
+ * @param base The page-aligned address of the region.
+ * @param physical The page-aligned physical address base maps to.
+ * @param size The page-aligned size of the region in bytes.
+ * @param flags The access the region allows.
+ * @return Whether or not the region could be reserved.
+ */
+bool Cobalt_MapPhysicalRegion(cobalt_address_space_t *space,
+                              cobalt_u64_t base, cobalt_u64_t physical,
+                              cobalt_u64_t size,
+                              cobalt_region_flags_t flags);
+
+/**
+ * @brief Map a range of physical memory, such as a device's registers or
+ * a framebuffer, into the kernel's device window. The mapping lasts as
+ * long as the kernel does.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param physical The physical address of the range, which needn't be
+ * page-aligned.
+ * @param size The size of the range in bytes.
+ * @param flags The access the mapping allows.
+ * @return The address physical is mapped at, or nullptr if the window or
+ * memory has run out.
+ */
+void *Cobalt_MapDevice(cobalt_u64_t physical, cobalt_u64_t size,
+                       cobalt_region_flags_t flags);
+
+/**
+ * @brief Reserve a region of zero-filled memory in the kernel's device
+ * window, for buffers too large to come from the heap. Pages are
+ * allocated as they're first touched.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param size The size of the region in bytes.
+ * @param flags The access the region allows.
+ * @return The region, or nullptr if the window or memory has run out.
+ * It's given back with Cobalt_UnmapRegion, though its addresses aren't.
+ */
+void *Cobalt_MapKernelMemory(cobalt_u64_t size,
+                             cobalt_region_flags_t flags);
+
+/**
+ * @brief Unmap a range from an address space, trimming or splitting the
+ * regions it covers, and flush it from every processor's TLB. This sends
+ * IPIs, so it must not be called with a spinlock held that an interrupt
+ * handler might want.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param space The address space.
+ * @param base The page-aligned address of the range.
+ * @param size The page-aligned size of the range in bytes.
+ * @return Whether or not the range could be unmapped. This fails only if
+ * a region had to be split and memory has run out.
+ */
+bool Cobalt_UnmapRegion(cobalt_address_space_t *space, cobalt_u64_t base,
+                        cobalt_u64_t size);
+
+#endif // COBALT_KERNEL_VIRTUAL_H
@@ -0,0 +1,91 @@
+/**
+ * @file Memory.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the memory primitives shared by the bootloader
+ * and the kernel. These stick to general purpose registers and string
+ * instructions, so they are safe to call from anywhere.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_MEMORY_H
+#define COBALT_MEMORY_H
+
+#include <Types.h>
+#include <stddef.h>
+
+/**
+ * @brief Fills and copies at least this large bypass the cache with
+ * non-temporal stores. Anything this big would only evict the whole cache
+ * for data nobody is about to read.
+ * @since 0.1.0.6
+ */
+#define COBALT_MEMORY_NONTEMPORAL_THRESHOLD (4 * 1024 * 1024)
+
+/**
+ * @brief Fill a buffer with a byte value.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param destination The buffer to fill.
+ * @param value The value to fill the buffer with.
+ * @param size The size of the buffer in bytes. This may be zero.
+ * @return The destination buffer.
+ */
+void *Cobalt_SetMemory(void *destination, cobalt_u8_t value, size_t size);
+
+/**
+ * @brief Fill a buffer with zeroes.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param destination The buffer to fill.
+ * @param size The size of the buffer in bytes. This may be zero.
+ */
+void Cobalt_ZeroMemory(void *destination, size_t size);
+
+/**
+ * @brief Copy one buffer into another. The buffers must not overlap.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param destination The buffer to copy into.
+ * @param source The buffer to copy from.
+ * @param size The number of bytes to copy. This may be zero.
+ * @return The destination buffer.
+ */
+void *Cobalt_CopyMemory(void *destination, const void *source,
+                        size_t size);
+
+/**
+ * @brief Copy one buffer into another, where the two may overlap.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param destination The buffer to copy into.
+ * @param source The buffer to copy from.
+ * @param size The number of bytes to copy. This may be zero.
+ * @return The destination buffer.
+ */
+void *Cobalt_MoveMemory(void *destination, const void *source,
+                        size_t size);
+
+/**
+ * @brief Compare two buffers bytewise, as unsigned values.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param left The first buffer.
+ * @param right The second buffer.
+ * @param size The number of bytes to compare. This may be zero.
+ * @return Zero if the buffers match, and otherwise a negative or positive
+ * value as the first differing byte of the left buffer is less or greater
+ * than that of the right.
+ */
+int Cobalt_CompareMemory(const void *left, const void *right, size_t size);
+
+#endif // COBALT_MEMORY_H
@@ -0,0 +1,128 @@
+/**
+ * @file MemoryMap.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the memory map the loader hands the kernel.
+ * Unlike the firmware's, this is a dense array of fixed-size regions,
+ * sorted by address, with neighbouring regions of the same type merged,
+ * so that the kernel can take it in with a single linear pass.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_MEMORY_MAP_H
+#define COBALT_MEMORY_MAP_H
+
+#include <Types.h>
+
+/**
+ * @brief What a region of physical memory holds, and so what the kernel
+ * may do with it.
+ * @since 0.1.0.6
+ */
+typedef enum : cobalt_u32_t
+{
+    /**
+     * @brief Free memory.
+     * @since 0.1.0.6
+     */
+    COBALT_MEMORY_USABLE,
+    /**
+     * @brief Memory the firmware's boot services used, which is free
+     * now that they've been exited.
+     * @since 0.1.0.6
+     */
+    COBALT_MEMORY_RECLAIMABLE,
+    /**
+     * @brief Memory the loader allocated. This holds the kernel image,
+     * its page tables, and the handoff structures, including this map.
+     * @since 0.1.0.6
+     */
+    COBALT_MEMORY_LOADER,
+    /**
+     * @brief ACPI tables, which are free once the kernel has read them.
+     * @since 0.1.0.6
+     */
+    COBALT_MEMORY_ACPI_RECLAIMABLE,
+    /**
+     * @brief Memory the firmware keeps for ACPI across sleep states.
+     * @since 0.1.0.6
+     */
+    COBALT_MEMORY_ACPI_NVS,
+    /**
+     * @brief The code and data of the firmware's runtime services.
+     * @since 0.1.0.6
+     */
+    COBALT_MEMORY_RUNTIME,
+    /**
+     * @brief Memory-mapped device registers.
+     * @since 0.1.0.6
+     */
+    COBALT_MEMORY_MMIO,
+    /**
+     * @brief Persistent memory.
+     * @since 0.1.0.6
+     */
+    COBALT_MEMORY_PERSISTENT,
+    /**
+     * @brief Memory that's reported faulty.
+     * @since 0.1.0.6
+     */
+    COBALT_MEMORY_UNUSABLE,
+    /**
+     * @brief Memory that's off-limits for any other reason.
+     * @since 0.1.0.6
+     */
+    COBALT_MEMORY_RESERVED
+} cobalt_memory_type_t;
+
+/**
+ * @brief A contiguous region of physical memory.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief The physical address of the region. This is always page
+     * aligned.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t base;
+
+    /**
+     * @brief The number of 4 KiB pages in the region.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t pageCount;
+
+    /**
+     * @brief What the region holds.
+     * @since 0.1.0.6
+     */
+    cobalt_memory_type_t type;
+} cobalt_memory_region_t;
+
+/**
+ * @brief The memory map handed to the kernel.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief The number of regions in the map.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t count;
+
+    /**
+     * @brief The regions of the map, sorted by address. No two regions
+     * overlap, and no two neighbouring regions share a type.
+     * @since 0.1.0.6
+     */
+    cobalt_memory_region_t *regions;
+} cobalt_memory_regions_t;
+
+#endif // COBALT_MEMORY_MAP_H
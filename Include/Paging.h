@@ -0,0 +1,189 @@
+/**
+ * @file Paging.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the layout of Cobalt's virtual address space
+ * and the format of the x86_64 page tables that describe it. The loader
+ * builds these tables before it enters the kernel, and the kernel keeps
+ * using them from there.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_PAGING_H
+#define COBALT_PAGING_H
+
+#include <Types.h>
+
+/**
+ * @brief The size of a page mapped by a page table entry.
+ * @since 0.1.0.6
+ */
+#define COBALT_PAGE_SIZE 0x1000ULL
+
+/**
+ * @brief The size of a page mapped by a page directory entry.
+ * @since 0.1.0.6
+ */
+#define COBALT_LARGE_PAGE_SIZE 0x200000ULL
+
+/**
+ * @brief The size of a page mapped by a page directory pointer table
+ * entry.
+ * @since 0.1.0.6
+ */
+#define COBALT_HUGE_PAGE_SIZE 0x40000000ULL
+
+/**
+ * @brief The number of entries in a table at any level.
+ * @since 0.1.0.6
+ */
+#define COBALT_PAGE_TABLE_ENTRIES 512
+
+/**
+ * @brief The virtual address at which all of physical memory is mapped,
+ * so that physical address P can always be reached at this plus P. This
+ * is the first address of the upper half.
+ * @since 0.1.0.6
+ */
+#define COBALT_DIRECT_MAP_BASE 0xFFFF800000000000ULL
+
+/**
+ * @brief The amount of physical memory the direct map can cover. This is
+ * the first quarter of the upper half, which leaves the rest of it free
+ * for the kernel's own mappings.
+ * @since 0.1.0.6
+ */
+#define COBALT_DIRECT_MAP_SIZE 0x400000000000ULL
+
+/**
+ * @brief The virtual address the kernel image is mapped at. This is the
+ * last 2 GiB of the address space, so that the kernel's code can reach
+ * any of its symbols with a sign-extended 32-bit address.
+ * @since 0.1.0.6
+ */
+#define COBALT_KERNEL_VIRTUAL_BASE 0xFFFFFFFF80000000ULL
+
+/**
+ * @brief The largest kernel image that can be mapped, which is whatever
+ * a single page directory covers.
+ * @since 0.1.0.6
+ */
+#define COBALT_KERNEL_MAXIMUM_SIZE COBALT_HUGE_PAGE_SIZE
+
+/**
+ * @brief The bits of a page table entry that hold the physical address
+ * of the next table or of the page itself.
+ * @since 0.1.0.6
+ */
+#define COBALT_PAGE_ADDRESS_MASK 0x000FFFFFFFFFF000ULL
+
+/**
+ * @brief The flags of a page table entry at any level.
+ * @since 0.1.0.6
+ */
+typedef enum : cobalt_u64_t
+{
+    /**
+     * @brief The entry is in use.
+     * @since 0.1.0.6
+     */
+    COBALT_PAGE_PRESENT = 1ULL << 0,
+    /**
+     * @brief The memory the entry covers can be written to.
+     * @since 0.1.0.6
+     */
+    COBALT_PAGE_WRITABLE = 1ULL << 1,
+    /**
+     * @brief The memory the entry covers can be reached from usermode.
+     * @since 0.1.0.6
+     */
+    COBALT_PAGE_USER = 1ULL << 2,
+    /**
+     * @brief Writes to the memory the entry covers go straight through
+     * the cache.
+     * @since 0.1.0.6
+     */
+    COBALT_PAGE_WRITE_THROUGH = 1ULL << 3,
+    /**
+     * @brief The memory the entry covers isn't cached.
+     * @since 0.1.0.6
+     */
+    COBALT_PAGE_CACHE_DISABLE = 1ULL << 4,
+    /**
+     * @brief Set by the processor when the entry is used.
+     * @since 0.1.0.6
+     */
+    COBALT_PAGE_ACCESSED = 1ULL << 5,
+    /**
+     * @brief Set by the processor when the page is written to.
+     * @since 0.1.0.6
+     */
+    COBALT_PAGE_DIRTY = 1ULL << 6,
+    /**
+     * @brief The entry maps a 2 MiB or 1 GiB page rather than pointing to
+     * another table. This is only valid in the directory and directory
+     * pointer tables.
+     * @since 0.1.0.6
+     */
+    COBALT_PAGE_LARGE = 1ULL << 7,
+    /**
+     * @brief The entry isn't flushed from the TLB when CR3 changes.
+     * @since 0.1.0.6
+     */
+    COBALT_PAGE_GLOBAL = 1ULL << 8,
+    /**
+     * @brief The memory the entry covers can't be executed. This needs
+     * EFER.NXE set, and is reserved otherwise.
+     * @since 0.1.0.6
+     */
+    COBALT_PAGE_NO_EXECUTE = 1ULL << 63
+} cobalt_page_flags_t;
+
+/**
+ * @brief Get the index into the table of a given level that a virtual
+ * address falls under. Level 0 is the page table, and level 3 is the
+ * PML4.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param address The virtual address.
+ * @param level The level of the table.
+ * @return The index into the table.
+ */
+static inline cobalt_u64_t Cobalt_PageTableIndex(cobalt_u64_t address,
+                                                 cobalt_u32_t level)
+{
+    return (address >> (12 + 9 * level)) & (COBALT_PAGE_TABLE_ENTRIES - 1);
+}
+
+/**
+ * @brief Get the direct map address of a physical address.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param physical The physical address.
+ * @return A pointer through which the physical address can be reached.
+ */
+static inline void *Cobalt_PhysicalToVirtual(cobalt_u64_t physical)
+{
+    return (void *)(physical + COBALT_DIRECT_MAP_BASE);
+}
+
+/**
+ * @brief Get the physical address of a direct map address.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param virtual A pointer within the direct map.
+ * @return The physical address the pointer refers to.
+ */
+static inline cobalt_u64_t Cobalt_VirtualToPhysical(const void *virtual)
+{
+    return (cobalt_u64_t)virtual - COBALT_DIRECT_MAP_BASE;
+}
+
+#endif // COBALT_PAGING_H
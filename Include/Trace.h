@@ -0,0 +1,138 @@
+/**
+ * @file Trace.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the boot trace structure, a fixed buffer of
+ * timestamp counter-stamped events recorded by the bootloader around each
+ * phase of the boot and handed to the kernel for reporting.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_TRACE_H
+#define COBALT_TRACE_H
+
+#include <Types.h>
+
+/**
+ * @brief The most events a trace can hold. Events recorded past this are
+ * counted, but otherwise dropped.
+ * @since 0.1.0.6
+ */
+#define COBALT_TRACE_CAPACITY 64
+
+/**
+ * @brief The longest name an event can have, including its terminator.
+ * @since 0.1.0.6
+ */
+#define COBALT_TRACE_NAME_LENGTH 24
+
+/**
+ * @brief The most counters a trace can hold. Counters recorded past this
+ * are dropped along with events.
+ * @since 0.1.0.6
+ */
+#define COBALT_TRACE_COUNTER_CAPACITY 16
+
+/**
+ * @brief A single traced phase of the boot.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief The ASCII name of the phase. This is stored inline so the
+     * kernel doesn't need the loader's image to read it.
+     * @since 0.1.0.6
+     */
+    char name[COBALT_TRACE_NAME_LENGTH];
+
+    /**
+     * @brief The timestamp counter value at the start of the phase.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t start;
+
+    /**
+     * @brief The timestamp counter value at the end of the phase. This is
+     * zero for a phase that never ended.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t end;
+} cobalt_trace_event_t;
+
+/**
+ * @brief A single value sampled during the boot, like the number of bytes
+ * some phase moved.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief The ASCII name of the counter.
+     * @since 0.1.0.6
+     */
+    char name[COBALT_TRACE_NAME_LENGTH];
+
+    /**
+     * @brief The timestamp counter value when the value was recorded.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t timestamp;
+
+    /**
+     * @brief The recorded value.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t value;
+} cobalt_trace_counter_t;
+
+/**
+ * @brief A fixed buffer of traced boot phases.
+ * @since 0.1.0.6
+ */
+typedef struct
+{
+    /**
+     * @brief The number of timestamp counter ticks per microsecond, as
+     * measured by the bootloader.
+     * @since 0.1.0.6
+     */
+    cobalt_u64_t ticksPerMicrosecond;
+
+    /**
+     * @brief The number of events recorded in the buffer.
+     * @since 0.1.0.6
+     */
+    cobalt_u32_t count;
+
+    /**
+     * @brief The number of events and counters that didn't fit in the
+     * buffer.
+     * @since 0.1.0.6
+     */
+    cobalt_u32_t dropped;
+
+    /**
+     * @brief The number of counters recorded in the buffer.
+     * @since 0.1.0.6
+     */
+    cobalt_u32_t counterCount;
+
+    /**
+     * @brief The recorded events, in the order they began.
+     * @since 0.1.0.6
+     */
+    cobalt_trace_event_t events[COBALT_TRACE_CAPACITY];
+
+    /**
+     * @brief The recorded counters, in the order they were recorded.
+     * @since 0.1.0.6
+     */
+    cobalt_trace_counter_t counters[COBALT_TRACE_COUNTER_CAPACITY];
+} cobalt_trace_t;
+
+#endif // COBALT_TRACE_H
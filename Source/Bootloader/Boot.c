@@ -5,7 +5,7 @@
  * tbe most basic of setup before exiting the UEFI environment and entering
  * kernelmode.
  * @since 0.1.0.0
- * @updated 0.1.0.2
+ * @updated 0.1.0.6
  *
  * @copyright (c) 2025 Israfil Argos
  * This file is under the AGPLv3. For information on what that entails, see
@@ -13,13 +13,17 @@
  * https://www.gnu.org/licenses/agpl-3.0.en.html.
  */
 
+#include <Bootloader/Config.h>
 #include <Bootloader/EFI/Files.h>
 #include <Bootloader/EFI/Graphics.h>
 #include <Bootloader/EFI/Print.h>
-#include <Bootloader/Memory.h>
-
-#include <Headers/DOS.h>
-#include <Headers/PE.h>
+#include <Bootloader/Image.h>
+#include <Bootloader/MemoryMap.h>
+#include <Bootloader/Paging.h>
+#include <Bootloader/Relocate.h>
+#include <Bootloader/Trace.h>
+#include <CPU.h>
+#include <Memory.h>
 
 #include <efi.h>
 
@@ -27,38 +31,68 @@
 // maybe flatten into kernel structure?
 COBALT_OUTPUT_STREAM cobalt_conOut = nullptr;
 COBALT_INPUT_STREAM cobalt_conIn = nullptr;
+cobalt_efi_info_t cobalt_efiInfo;
+
+// How much of the kernel file to read up front when its sections are to
+// be streamed in later. This comfortably covers the headers of any image
+// our toolchain produces.
+#define KERNEL_HEADER_READ 0x1000
+
+// Returned by waitKey when the user asks to exit into the firmware.
+#define FIRMWARE_KEY_STATUS ((EFI_STATUS)-8008)
 
-static EFI_STATUS waitKey(uint8_t timeOut, EFI_BOOT_SERVICES *services)
+// Check for a key without blocking. This is the whole of the wait when
+// the timeout is zero, so anything typed before the loader started is
+// deliberately not flushed.
+static EFI_STATUS checkKey(void)
 {
+    EFI_INPUT_KEY key;
+    EFI_STATUS keyGrabStatus;
+    while ((keyGrabStatus = cobalt_conIn->ReadKeyStroke(
+                cobalt_conIn, &key)) == EFI_SUCCESS)
+        if (key.UnicodeChar == L'f') return FIRMWARE_KEY_STATUS;
+    return keyGrabStatus;
+}
+
+static EFI_STATUS waitKey(cobalt_u64_t timeOut,
+                          EFI_BOOT_SERVICES *services)
+{
+    if (timeOut == 0) return checkKey();
+
     EFI_STATUS resetStatus = cobalt_conIn->Reset(cobalt_conIn, false);
     if (EFI_ERROR(resetStatus)) return resetStatus;
 
-    EFI_EVENT timerEvent;
-    services->CreateEvent(EVT_TIMER, TPL_APPLICATION, nullptr, nullptr,
-                          &timerEvent);
-    services->SetTimer(timerEvent, 1, 10000000);
+    // Rather than waking on a timer tick to poll the keyboard, sleep on
+    // the key event and a single timeout together, so that a keypress is
+    // acted upon as soon as the firmware sees it.
+    EFI_EVENT events[2] = {cobalt_conIn->WaitForKey, nullptr};
+    EFI_STATUS keyGrabStatus = services->CreateEvent(
+        EVT_TIMER, TPL_APPLICATION, nullptr, nullptr, &events[1]);
+    if (EFI_ERROR(keyGrabStatus)) return keyGrabStatus;
+    services->SetTimer(events[1], TimerRelative, timeOut * 10000000);
 
-    EFI_INPUT_KEY key;
-    EFI_STATUS keyGrabStatus;
-    for (uint64_t timeOutSpent = 0; timeOutSpent < timeOut; timeOutSpent++)
+    for (;;)
     {
         UINTN index;
-        services->WaitForEvent(1, &timerEvent, &index);
+        keyGrabStatus = services->WaitForEvent(2, events, &index);
+        if (EFI_ERROR(keyGrabStatus) || index == 1) break;
 
+        EFI_INPUT_KEY key;
         keyGrabStatus = cobalt_conIn->ReadKeyStroke(cobalt_conIn, &key);
         if (keyGrabStatus == EFI_NOT_READY) continue;
+        // The key is left unwritten by any other failure.
+        if (EFI_ERROR(keyGrabStatus)) break;
 
         if (key.UnicodeChar == L'f')
         {
-            services->SetTimer(timerEvent, 0, 0);
-            services->CloseEvent(timerEvent);
-            return (EFI_STATUS)-8008;
+            keyGrabStatus = FIRMWARE_KEY_STATUS;
+            break;
         }
         if (key.UnicodeChar == L'c') break;
     }
 
-    services->SetTimer(timerEvent, 0, 0);
-    services->CloseEvent(timerEvent);
+    services->SetTimer(events[1], TimerCancel, 0);
+    services->CloseEvent(events[1]);
     return keyGrabStatus;
 }
 
@@ -80,31 +114,26 @@ EFI_STATUS EFIAPI efi_main(EFI_HANDLE ImageHandle,
     cobalt_conOut = SystemTable->ConOut;
     cobalt_conIn = SystemTable->ConIn;
 
+    Cobalt_TraceInitialize(SystemTable->BootServices);
+    const cobalt_u32_t loaderTrace = Cobalt_TraceBegin("loader");
+
     cobalt_efiInfo = (cobalt_efi_info_t){0};
     cobalt_efiInfo.runtimeServices = SystemTable->RuntimeServices;
 
+    // The firmware's clock is slow to read, so it's read just this once.
+    // The kernel carries it forward with the timestamp counter, which a
+    // zero timestamp tells it not to bother with.
+    if (!EFI_ERROR(cobalt_efiInfo.runtimeServices->GetTime(
+            &cobalt_efiInfo.bootTime, nullptr)))
+        cobalt_efiInfo.bootTimestamp = Cobalt_ReadTimestamp();
+
     // Clear the screen of any text the UEFI environment may have splurged
     // out, and replace it with a nice friendly greeting.
     (void)Cobalt_PrimitiveClear();
     (void)Cobalt_PrimitivePuts(L"Hi! CobaltOS now booting. :) ");
     (void)Cobalt_PrimitiveTimestamp(L"Boot Time: ");
 
-    const uint8_t firmwareTimeout = 5;
-    Cobalt_PrimitivePrintf(L"Exit into firmware with 'f', continue with "
-                           L"'c'. Continuing in %U seconds." NL,
-                           firmwareTimeout);
-    EFI_STATUS keyStatus =
-        waitKey(firmwareTimeout, SystemTable->BootServices);
-    if (keyStatus == (EFI_STATUS)-8008) return 0;
-    Cobalt_PrimitivePuts(L"Continuing kernel load." NL NL);
-
-    EFI_GRAPHICS_OUTPUT_PROTOCOL_MODE graphicsMode = {0};
-    EFI_STATUS graphicsStatus = Cobalt_InitializeGraphics(
-        &graphicsMode, ImageHandle, SystemTable->BootServices);
-    if (EFI_ERROR(graphicsStatus)) return graphicsStatus;
-    SystemTable->ConOut->SetCursorPosition(cobalt_conOut, 0, 0);
-    Cobalt_PrimitivePuts(L"Setup graphics mode." NL);
-
+    const cobalt_u32_t openTrace = Cobalt_TraceBegin("filesystem open");
     EFI_LOADED_IMAGE_PROTOCOL *kernelImage;
     EFI_GUID loadedImageProtocol = EFI_LOADED_IMAGE_PROTOCOL_GUID;
     EFI_STATUS openProtocolStatus =
@@ -129,188 +158,288 @@ EFI_STATUS EFIAPI efi_main(EFI_HANDLE ImageHandle,
         waitKey(10, SystemTable->BootServices);
         return filesystemStatus;
     }
+    Cobalt_TraceEnd(openTrace);
+
+    const cobalt_u32_t configTrace = Cobalt_TraceBegin("config");
+    cobalt_boot_config_t config;
+    EFI_STATUS configStatus =
+        Cobalt_ReadConfig(root, SystemTable->BootServices, &config);
+    Cobalt_TraceEnd(configTrace);
+    if (EFI_ERROR(configStatus))
+    {
+        waitKey(10, SystemTable->BootServices);
+        return configStatus;
+    }
+
+    if (config.timeout != 0)
+        Cobalt_PrimitivePrintf(
+            L"Exit into firmware with 'f', continue with 'c'. Continuing "
+            L"in %U seconds." NL,
+            config.timeout);
+    const cobalt_u32_t keyTrace = Cobalt_TraceBegin("key wait");
+    EFI_STATUS keyStatus =
+        waitKey(config.timeout, SystemTable->BootServices);
+    Cobalt_TraceEnd(keyTrace);
+    if (keyStatus == FIRMWARE_KEY_STATUS) return 0;
+    Cobalt_PrimitivePuts(L"Continuing kernel load." NL NL);
+
+    EFI_GRAPHICS_OUTPUT_PROTOCOL_MODE graphicsMode = {0};
+    const cobalt_u32_t graphicsTrace = Cobalt_TraceBegin("graphics");
+    EFI_STATUS graphicsStatus = Cobalt_InitializeGraphics(
+        &graphicsMode, ImageHandle, SystemTable->BootServices,
+        SystemTable->RuntimeServices, config.graphicsWidth,
+        config.graphicsHeight, config.graphicsFormat);
+    Cobalt_TraceEnd(graphicsTrace);
+    if (EFI_ERROR(graphicsStatus)) return graphicsStatus;
+    SystemTable->ConOut->SetCursorPosition(cobalt_conOut, 0, 0);
+    Cobalt_PrimitivePuts(L"Setup graphics mode." NL);
 
     cobalt_efi_file_t *kernelFile;
     EFI_STATUS kernelFileStatus =
-        Cobalt_OpenFile(root, L"\\KERNEL.efi", &kernelFile);
+        Cobalt_OpenFile(root, config.kernelPath, &kernelFile);
     if (EFI_ERROR(kernelFileStatus))
     {
         waitKey(10, SystemTable->BootServices);
         return kernelFileStatus;
     }
-    cobalt_dos_header_t kernelHeader;
-    EFI_STATUS dosHeaderStatus =
-        Cobalt_ReadDOSHeader(kernelFile, &kernelHeader);
-    if (EFI_ERROR(dosHeaderStatus))
+
+    // Pull the kernel into memory with as few reads as possible. Each read
+    // through the filesystem protocol is a full trip through the
+    // firmware's FAT driver, so parsing out of memory is far cheaper than
+    // seeking around the file for every header. Where the firmware can
+    // read asynchronously, only the headers are read up front, and the
+    // sections are streamed straight into place later on.
+    void *kernelFileBuffer;
+    UINT64 kernelFileSize;
+    const cobalt_u32_t readTrace = Cobalt_TraceBegin("kernel read");
+    EFI_STATUS readStatus = Cobalt_GetFileSize(
+        kernelFile, SystemTable->BootServices, &kernelFileSize);
+    bool streamKernel = Cobalt_FileSupportsAsync(kernelFile) &&
+                        kernelFileSize > KERNEL_HEADER_READ;
+    UINT64 kernelBufferSize =
+        streamKernel ? KERNEL_HEADER_READ : kernelFileSize;
+    if (!EFI_ERROR(readStatus))
+        readStatus = Cobalt_ReadFileRange(
+            kernelFile, SystemTable->BootServices, 0, kernelBufferSize,
+            &kernelFileBuffer);
+    Cobalt_TraceEnd(readTrace);
+    if (EFI_ERROR(readStatus))
     {
+        (void)Cobalt_CloseFile(kernelFile);
         waitKey(10, SystemTable->BootServices);
-        return dosHeaderStatus;
+        return readStatus;
     }
 
-    UINTN size = sizeof(cobalt_pe_header_t);
-    cobalt_pe_header_t kernelPEHeader;
-    kernelFile->Read(kernelFile, &size, &kernelPEHeader);
-
-    uint64_t i,
-        virt_size = 0,
-        sectionCount = (uint64_t)kernelPEHeader.coffHeader.sectionCount;
-    size = 40 * sectionCount;
-
-    cobalt_image_section_header_t *sectionHeaderTable;
-    SystemTable->BootServices->AllocatePool(EfiBootServicesData, size,
-                                            (void **)&sectionHeaderTable);
-    kernelFile->Read(kernelFile, &size, &sectionHeaderTable[0]);
+    const cobalt_u32_t parseTrace = Cobalt_TraceBegin("header parse");
+    cobalt_image_t kernel;
+    EFI_STATUS parseStatus = EFI_SUCCESS;
+    if (streamKernel)
+    {
+        parseStatus = Cobalt_ParseImageHeaders(
+            kernelFileBuffer, kernelBufferSize, kernelFileSize, &kernel);
 
-    for (i = 0; i < sectionCount; ++i)
+        // A packed kernel (or one with unusually large headers) needs the
+        // whole file in memory anyway, so read the rest of it after all.
+        if (parseStatus == EFI_BUFFER_TOO_SMALL)
+        {
+            SystemTable->BootServices->FreePages(
+                (EFI_PHYSICAL_ADDRESS)kernelFileBuffer,
+                EFI_SIZE_TO_PAGES(kernelBufferSize));
+            streamKernel = false;
+            kernelBufferSize = kernelFileSize;
+            readStatus = Cobalt_ReadFileRange(
+                kernelFile, SystemTable->BootServices, 0, kernelBufferSize,
+                &kernelFileBuffer);
+            if (EFI_ERROR(readStatus))
+            {
+                (void)Cobalt_CloseFile(kernelFile);
+                waitKey(10, SystemTable->BootServices);
+                return readStatus;
+            }
+        }
+    }
+    if (!streamKernel)
+    {
+        (void)Cobalt_CloseFile(kernelFile);
+        parseStatus =
+            Cobalt_ParseImage(kernelFileBuffer, kernelFileSize, &kernel);
+    }
+    Cobalt_TraceEnd(parseTrace);
+    if (EFI_ERROR(parseStatus))
+    {
+        if (streamKernel) (void)Cobalt_CloseFile(kernelFile);
+        SystemTable->BootServices->FreePages(
+            (EFI_PHYSICAL_ADDRESS)kernelFileBuffer,
+            EFI_SIZE_TO_PAGES(kernelBufferSize));
+        waitKey(10, SystemTable->BootServices);
+        return parseStatus;
+    }
+    Cobalt_PrimitivePrintf(
+        L"Read %U of %U kernel bytes in %U us, parsed in %U us." NL,
+        kernelBufferSize, kernelFileSize,
+        Cobalt_TraceMicroseconds(readTrace),
+        Cobalt_TraceMicroseconds(parseTrace));
+
+    const cobalt_pe_header_t *kernelPEHeader = kernel.peHeader;
+    for (uint64_t i = 0; i < kernel.sectionCount; ++i)
     {
-        cobalt_image_section_header_t sectionHeader =
-            sectionHeaderTable[i];
+        const cobalt_image_section_header_t *sectionHeader =
+            &kernel.sections[i];
         Cobalt_PrimitivePrintf(
-            L"current section address: %U, size: %U\r\n",
-            sectionHeader.VirtualAddress, sectionHeader.Misc.VirtualSize);
-        Cobalt_PrimitivePrintf(L"current section address + size %U\r\n",
-                               sectionHeader.VirtualAddress +
-                                   sectionHeader.Misc.VirtualSize);
-
-        virt_size = (virt_size > (UINT64)(sectionHeader.VirtualAddress +
-                                          sectionHeader.Misc.VirtualSize)
-                         ? virt_size
-                         : (UINT64)(sectionHeader.VirtualAddress +
-                                    sectionHeader.Misc.VirtualSize));
+            L"Section %U at 0x%08X to 0x%08X, %U bytes." NL, i,
+            (uint64_t)sectionHeader->VirtualAddress,
+            (uint64_t)sectionHeader->VirtualAddress +
+                sectionHeader->Misc.VirtualSize,
+            (uint64_t)sectionHeader->Misc.VirtualSize);
     }
-    Cobalt_PrimitivePrintf(L"Virtual size: %U." NL, virt_size);
+    Cobalt_PrimitivePrintf(L"Virtual size: %U." NL, kernel.virtualSize);
 
-    UINTN kernelHeaderSize =
-        (UINTN)kernelPEHeader.optionalHeader.headerSize;
-    UINT64 kernelPages = EFI_SIZE_TO_PAGES(virt_size);
+    const cobalt_u32_t sectionTrace = Cobalt_TraceBegin("section load");
+    UINT64 kernelPages = EFI_SIZE_TO_PAGES(kernel.virtualSize);
     EFI_PHYSICAL_ADDRESS kernelAllocatedMemory =
-        kernelPEHeader.optionalHeader.imageBase;
-
-    SystemTable->BootServices->AllocatePages(AllocateAnyPages,
-                                             EfiLoaderData, kernelPages,
-                                             &kernelAllocatedMemory);
-    Cobalt_ZeroMemory((void *)kernelAllocatedMemory,
-                      (kernelPages << EFI_PAGE_SHIFT));
-
-    kernelFile->SetPosition(kernelFile, 0);
-    // Cast the memory to a pointer rather than taking its address--we want
-    // the memory at the location it describes, not the stack address it
-    // takes up.
-    kernelFile->Read(kernelFile, &kernelHeaderSize,
-                     (EFI_PHYSICAL_ADDRESS *)kernelAllocatedMemory);
-
-    for (i = 0; i < sectionCount; i++)
+        kernelPEHeader->optionalHeader.imageBase;
+
+    // Both allocations are made before any read is queued, so a failure
+    // never leaves the firmware writing into memory we don't own.
+    cobalt_efi_info_t *efiInfo;
+    EFI_STATUS allocateStatus = SystemTable->BootServices->AllocatePages(
+        AllocateAnyPages, EfiLoaderData, kernelPages,
+        &kernelAllocatedMemory);
+    if (EFI_ERROR(allocateStatus))
+        Cobalt_PrimitivePrintf(
+            L"Failed to allocate %U pages for the kernel. Code: %U." NL,
+            kernelPages, allocateStatus);
+    else
+    {
+        allocateStatus = SystemTable->BootServices->AllocatePool(
+            EfiLoaderData, sizeof(cobalt_efi_info_t), (void **)&efiInfo);
+        if (EFI_ERROR(allocateStatus))
+        {
+            Cobalt_PrimitivePrintf(
+                L"Failed to allocate EFI info pool. Code: %U." NL,
+                allocateStatus);
+            SystemTable->BootServices->FreePages(kernelAllocatedMemory,
+                                                 kernelPages);
+        }
+    }
+    if (EFI_ERROR(allocateStatus))
+    {
+        if (streamKernel) (void)Cobalt_CloseFile(kernelFile);
+        SystemTable->BootServices->FreePages(
+            (EFI_PHYSICAL_ADDRESS)kernelFileBuffer,
+            EFI_SIZE_TO_PAGES(kernelBufferSize));
+        waitKey(10, SystemTable->BootServices);
+        return allocateStatus;
+    }
+
+    // Queue every section read at once, if we can. Either way, only the
+    // gaps around the sections' file data are zeroed, so every byte of
+    // the image is written exactly once.
+    cobalt_image_reads_t kernelReads = {0};
+    EFI_STATUS loadStatus = EFI_SUCCESS;
+    if (streamKernel)
+        loadStatus = Cobalt_BeginImageReads(
+            &kernel, kernelFile, SystemTable->BootServices,
+            kernelAllocatedMemory, &kernelReads);
+    const cobalt_u64_t kernelZeroed = Cobalt_ZeroImageGaps(
+        &kernel, kernelAllocatedMemory, kernelPages << EFI_PAGE_SHIFT);
+
+    // The handoff structure depends on none of the kernel's data, so it
+    // too is prepared while any reads are still in flight.
+    *efiInfo = (cobalt_efi_info_t){0};
+
+    if (streamKernel)
     {
-        cobalt_image_section_header_t sectionHeader =
-            sectionHeaderTable[i];
-        UINTN rawDataSize = sectionHeader.SizeOfRawData;
-        EFI_PHYSICAL_ADDRESS sectionAddress =
-            kernelAllocatedMemory + (UINT64)sectionHeader.VirtualAddress;
-
-        kernelFile->SetPosition(kernelFile,
-                                sectionHeader.PointerToRawData);
-
-        if (rawDataSize == 0) continue;
-        kernelFile->Read(kernelFile, &rawDataSize,
-                         (EFI_PHYSICAL_ADDRESS *)sectionAddress);
+        const cobalt_u32_t waitTrace = Cobalt_TraceBegin("section wait");
+        EFI_STATUS finishStatus = Cobalt_FinishImageReads(
+            SystemTable->BootServices, &kernelReads);
+        Cobalt_TraceEnd(waitTrace);
+        (void)Cobalt_CloseFile(kernelFile);
+        if (!EFI_ERROR(loadStatus)) loadStatus = finishStatus;
+    }
+    else
+        loadStatus =
+            Cobalt_LoadImageSections(&kernel, kernelAllocatedMemory);
+    if (EFI_ERROR(loadStatus))
+    {
+        waitKey(10, SystemTable->BootServices);
+        return loadStatus;
     }
-    SystemTable->BootServices->FreePool(sectionHeaderTable);
-    // if (EFI_ERROR(Cobalt_CloseFile(kernelFile))) return -1;
+    Cobalt_TraceEnd(sectionTrace);
+    Cobalt_TraceCounter("image bytes zeroed", kernelZeroed);
+    Cobalt_TraceCounter("image bytes loaded", kernel.loadedSize);
+    Cobalt_PrimitivePrintf(
+        L"Loaded %U kernel bytes and zeroed %U in %U us." NL,
+        kernel.loadedSize, kernelZeroed,
+        Cobalt_TraceMicroseconds(sectionTrace));
     // if (EFI_ERROR(Cobalt_CloseFilesystem(
     //         ImageHandle, SystemTable->BootServices, filesystem, root)))
     //     return -1;
 
-#define IMAGE_DIRECTORY_ENTRY_BASERELOC 5
-    if ((kernelAllocatedMemory |=
-         kernelPEHeader.optionalHeader.imageBase) &&
-        (kernelPEHeader.optionalHeader.dataDirectoryLength >
-         IMAGE_DIRECTORY_ENTRY_BASERELOC))
+    const cobalt_u32_t relocationTrace = Cobalt_TraceBegin("relocation");
+    if (kernelPEHeader->optionalHeader.dataDirectoryLength >
+        COBALT_DIRECTORY_BASE_RELOCATION)
     {
-        cobalt_image_base_relocation_t *relocationDirectoryBase;
-        cobalt_image_base_relocation_t *relocTableEnd;
-
-        relocationDirectoryBase =
-            (cobalt_image_base_relocation_t
-                 *)(kernelAllocatedMemory +
-                    (UINT64)kernelPEHeader.optionalHeader
-                        .dataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC]
-                        .virtualAddress);
-        relocTableEnd =
-            (cobalt_image_base_relocation_t
-                 *)(relocationDirectoryBase +
-                    (UINT64)kernelPEHeader.optionalHeader
-                        .dataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC]
-                        .size);
-
-        UINT64 delta;
-        if (kernelAllocatedMemory >
-            kernelPEHeader.optionalHeader.imageBase)
-            delta = kernelAllocatedMemory -
-                    kernelPEHeader.optionalHeader.imageBase;
-        else
-            delta = kernelPEHeader.optionalHeader.imageBase -
-                    kernelAllocatedMemory;
-
-        UINT64 relocationCountPerChunk;
-        for (; relocationDirectoryBase->SizeOfBlock &&
-               (relocationDirectoryBase < relocTableEnd);)
+        // The image is relocated for where it will run, not where it
+        // sits now; it's only ever entered through the higher half.
+        const cobalt_i64_t delta =
+            (cobalt_i64_t)(COBALT_KERNEL_VIRTUAL_BASE -
+                           kernelPEHeader->optionalHeader.imageBase);
+        const cobalt_u32_t relocationTable =
+            kernelPEHeader->optionalHeader
+                .dataDirectory[COBALT_DIRECTORY_BASE_RELOCATION]
+                .virtualAddress;
+        const cobalt_u32_t relocationTableSize =
+            kernelPEHeader->optionalHeader
+                .dataDirectory[COBALT_DIRECTORY_BASE_RELOCATION]
+                .size;
+
+        cobalt_u64_t failureOffset;
+        cobalt_relocate_status_t relocateStatus = Cobalt_Relocate(
+            (cobalt_u8_t *)kernelAllocatedMemory, kernel.virtualSize,
+            relocationTable, relocationTableSize, delta, &failureOffset);
+        if (relocateStatus != COBALT_RELOCATE_SUCCESS)
         {
-            EFI_PHYSICAL_ADDRESS page =
-                kernelAllocatedMemory +
-                (UINT64)relocationDirectoryBase
-                    ->VirtualAddress; // This virtual address is
-                                      // page-specific, and needs to be
-                                      // offset by Header_memory
-            UINT16 *dataToFix =
-                (UINT16 *)((UINT8 *)relocationDirectoryBase +
-                           8); // The base
-                               // relocation size
-                               // is 8 bytes (64
-                               // bits)
-            relocationCountPerChunk =
-                (relocationDirectoryBase->SizeOfBlock - 8) /
-                sizeof(UINT16);
-
-            for (i = 0; i < relocationCountPerChunk; i++)
-            {
-                UINT64 currentData = dataToFix[i] >> EFI_PAGE_SHIFT;
-                if (currentData == 0) continue;
-
-                if (currentData == 10)
-                {
-                    // evil
-                    if (kernelAllocatedMemory >
-                        kernelPEHeader.optionalHeader.imageBase)
-                        *((UINT64 *)((UINT8 *)page +
-                                     (currentData & EFI_PAGE_MASK))) +=
-                            delta;
-                    else
-                        *((UINT64 *)((UINT8 *)page +
-                                     (currentData & EFI_PAGE_MASK))) +=
-                            delta;
-                }
-                else
-                { // err
-                }
-            }
-            relocationDirectoryBase =
-                (cobalt_image_base_relocation_t
-                     *)((UINT8 *)relocationDirectoryBase +
-                        relocationDirectoryBase->SizeOfBlock);
+            Cobalt_PrimitivePrintf(
+                L"Failed to relocate kernel (reason %U) at relocation "
+                L"table offset %U." NL,
+                (cobalt_u64_t)relocateStatus, failureOffset);
+            waitKey(10, SystemTable->BootServices);
+            return EFI_LOAD_ERROR;
         }
     }
+    Cobalt_TraceEnd(relocationTrace);
+
+    // The kernel's half of the tables is built now, while its section
+    // table is still in the file buffer. Physical memory can only be
+    // mapped once the final memory map is in hand.
+    const cobalt_u32_t pagingTrace = Cobalt_TraceBegin("page tables");
+    cobalt_page_tables_t pageTables;
+    EFI_STATUS pagingStatus = Cobalt_ReservePageTables(
+        SystemTable->BootServices, &kernel, &graphicsMode, &pageTables);
+    if (!EFI_ERROR(pagingStatus))
+        pagingStatus =
+            Cobalt_MapKernel(&pageTables, &kernel, kernelAllocatedMemory);
+    Cobalt_TraceEnd(pagingTrace);
+    if (EFI_ERROR(pagingStatus))
+    {
+        waitKey(10, SystemTable->BootServices);
+        return pagingStatus;
+    }
 
     EFI_PHYSICAL_ADDRESS kernelBaseAddress = kernelAllocatedMemory;
-    EFI_PHYSICAL_ADDRESS kernelHeaderMemory =
-        kernelAllocatedMemory +
-        (UINT64)kernelPEHeader.optionalHeader.entrypointAddress;
+    EFI_VIRTUAL_ADDRESS kernelHeaderMemory =
+        COBALT_KERNEL_VIRTUAL_BASE +
+        (UINT64)kernelPEHeader->optionalHeader.entrypointAddress;
+    SystemTable->BootServices->FreePages(
+        (EFI_PHYSICAL_ADDRESS)kernelFileBuffer,
+        EFI_SIZE_TO_PAGES(kernelBufferSize));
 
-    cobalt_efi_info_t *efiInfo;
-    SystemTable->BootServices->AllocatePool(
-        EfiLoaderData, sizeof(cobalt_efi_info_t), (void **)&efiInfo);
     efiInfo->kernelBase = kernelBaseAddress;
     efiInfo->kernelPageCount = kernelPages;
+    efiInfo->kernelVirtualBase = COBALT_KERNEL_VIRTUAL_BASE;
 
+    const cobalt_u32_t memoryMapTrace = Cobalt_TraceBegin("memory map");
     uint64_t memoryMapSize = 0, memoryMapKey, memoryMapDescriptorSize;
     uint32_t memoryMapDescriptorVersion;
     EFI_MEMORY_DESCRIPTOR *memoryMap = nullptr;
@@ -335,7 +464,22 @@ EFI_STATUS EFIAPI efi_main(EFI_HANDLE ImageHandle,
             &memoryMapDescriptorSize, &memoryMapDescriptorVersion);
     }
 
+    Cobalt_TraceEnd(memoryMapTrace);
+
+    const cobalt_u32_t directMapTrace = Cobalt_TraceBegin("direct map");
+    cobalt_memory_map_t finalMemoryMap = {memoryMapDescriptorSize,
+                                          memoryMapSize, memoryMap};
+    EFI_STATUS directMapStatus = Cobalt_MapPhysicalMemory(
+        &pageTables, &finalMemoryMap, &graphicsMode);
+    Cobalt_TraceEnd(directMapTrace);
+    if (EFI_ERROR(directMapStatus))
+    {
+        waitKey(10, SystemTable->BootServices);
+        return directMapStatus;
+    }
+
     Cobalt_PrimitivePuts(L"Jumping to kernel...");
+    const cobalt_u32_t exitTrace = Cobalt_TraceBegin("exit boot services");
     EFI_STATUS exitStatus = SystemTable->BootServices->ExitBootServices(
         ImageHandle, memoryMapKey);
     if (EFI_ERROR(exitStatus))
@@ -373,8 +517,15 @@ EFI_STATUS EFIAPI efi_main(EFI_HANDLE ImageHandle,
                 &memoryMapDescriptorSize, &memoryMapDescriptorVersion);
         }
 
-        exitStatus = SystemTable->BootServices->ExitBootServices(
-            ImageHandle, memoryMapKey);
+        // Anything new in the map still needs to be in the direct map.
+        finalMemoryMap = (cobalt_memory_map_t){
+            memoryMapDescriptorSize, memoryMapSize, memoryMap};
+        if (!EFI_ERROR(exitStatus))
+            exitStatus = Cobalt_MapPhysicalMemory(
+                &pageTables, &finalMemoryMap, &graphicsMode);
+        if (!EFI_ERROR(exitStatus))
+            exitStatus = SystemTable->BootServices->ExitBootServices(
+                ImageHandle, memoryMapKey);
     }
 
     // This applies to both the simple and larger versions of the above.
@@ -387,15 +538,25 @@ EFI_STATUS EFIAPI efi_main(EFI_HANDLE ImageHandle,
         return exitStatus;
     }
 
-    efiInfo->memoryMap = (cobalt_memory_map_t){memoryMapDescriptorSize,
-                                               memoryMapSize, memoryMap};
+    efiInfo->memoryMap = Cobalt_CompactMemoryMap(&finalMemoryMap);
     efiInfo->configurationTables =
         (cobalt_efi_tables_t){SystemTable->NumberOfTableEntries,
                               SystemTable->ConfigurationTable};
     efiInfo->runtimeServices = SystemTable->RuntimeServices;
     efiInfo->graphicsMode = graphicsMode;
-
-    Cobalt_PrimitivePuts(L"Jumping to kernel...");
+    efiInfo->pageTableRoot = pageTables.root;
+    efiInfo->pageTableBase = pageTables.poolBase;
+    efiInfo->pageTablePageCount = pageTables.poolPages;
+
+    Cobalt_TraceEnd(exitTrace);
+    Cobalt_TraceCounter("memory regions", efiInfo->memoryMap.count);
+    Cobalt_TraceEnd(loaderTrace);
+    Cobalt_CopyMemory(&efiInfo->bootTrace, &cobalt_bootTrace,
+                      sizeof(cobalt_trace_t));
+
+    // From here on only the identity map keeps the loader running, and
+    // the kernel is reached through the higher half.
+    Cobalt_EnablePageTables(&pageTables);
     typedef void (*entrypointJump)(cobalt_efi_info_t *loaderParameters);
     entrypointJump jump = (entrypointJump)(kernelHeaderMemory);
     jump(efiInfo);
@@ -0,0 +1,197 @@
+/**
+ * @file Config.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the boot configuration reader outlined in
+ * the Config.h file.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <Bootloader/Config.h>
+#include <Bootloader/EFI/Print.h>
+
+// A span of the configuration text.
+typedef struct
+{
+    const char *start;
+    const char *end;
+} span_t;
+
+static bool isSpace(char character)
+{
+    return character == ' ' || character == '\t' || character == '\r';
+}
+
+static span_t trim(span_t span)
+{
+    while (span.start < span.end && isSpace(*span.start)) span.start++;
+    while (span.end > span.start && isSpace(span.end[-1])) span.end--;
+    return span;
+}
+
+static bool matches(span_t span, const char *word)
+{
+    for (; span.start < span.end; span.start++, word++)
+        if (*word == 0 || *span.start != *word) return false;
+    return *word == 0;
+}
+
+// Parse a decimal number up to the given limit, stopping at the first
+// character that isn't a digit.
+static bool parseNumber(span_t *span, cobalt_u64_t limit,
+                        cobalt_u64_t *value)
+{
+    const char *const start = span->start;
+    *value = 0;
+    for (; span->start < span->end && *span->start >= '0' &&
+           *span->start <= '9';
+         span->start++)
+    {
+        *value = *value * 10 + (cobalt_u64_t)(*span->start - '0');
+        if (*value > limit) return false;
+    }
+    return span->start != start;
+}
+
+static bool parseLine(span_t key, span_t value,
+                      cobalt_boot_config_t *config)
+{
+    if (matches(key, "timeout"))
+    {
+        cobalt_u64_t timeout;
+        if (!parseNumber(&value, COBALT_CONFIG_MAXIMUM_TIMEOUT,
+                         &timeout) ||
+            value.start != value.end)
+            return false;
+        config->timeout = timeout;
+        return true;
+    }
+
+    if (matches(key, "kernel"))
+    {
+        const cobalt_u64_t length = value.end - value.start;
+        if (length == 0 || length >= COBALT_CONFIG_PATH_LENGTH)
+            return false;
+        for (cobalt_u64_t i = 0; i < length; i++)
+            config->kernelPath[i] = (cobalt_u8_t)value.start[i];
+        config->kernelPath[length] = 0;
+        return true;
+    }
+
+    if (matches(key, "graphics"))
+    {
+        cobalt_u64_t width, height;
+        if (!parseNumber(&value, 0xFFFF, &width) ||
+            value.start == value.end || *value.start++ != 'x' ||
+            !parseNumber(&value, 0xFFFF, &height) ||
+            value.start != value.end)
+            return false;
+        config->graphicsWidth = (cobalt_u32_t)width;
+        config->graphicsHeight = (cobalt_u32_t)height;
+        return true;
+    }
+
+    if (matches(key, "format"))
+    {
+        // These are in the order EFI_GRAPHICS_PIXEL_FORMAT gives them.
+        static const char *const formats[] = {"rgb", "bgr", "bitmask"};
+        for (cobalt_u32_t i = 0; i < sizeof(formats) / sizeof(*formats);
+             i++)
+            if (matches(value, formats[i]))
+            {
+                config->graphicsFormat = (EFI_GRAPHICS_PIXEL_FORMAT)i;
+                return true;
+            }
+        if (!matches(value, "any")) return false;
+        config->graphicsFormat = PixelFormatMax;
+        return true;
+    }
+
+    return false;
+}
+
+void Cobalt_DefaultConfig(cobalt_boot_config_t *config)
+{
+    static const COBALT_WIDECHAR defaultPath[] = L"\\KERNEL.efi";
+
+    config->timeout = 5;
+    for (cobalt_u64_t i = 0; i < sizeof(defaultPath) / 2; i++)
+        config->kernelPath[i] = defaultPath[i];
+    config->graphicsWidth = 0;
+    config->graphicsHeight = 0;
+    config->graphicsFormat = PixelFormatMax;
+}
+
+cobalt_u64_t Cobalt_ParseConfig(const char *text, cobalt_u64_t size,
+                                cobalt_boot_config_t *config)
+{
+    const char *const textEnd = text + size;
+    cobalt_u64_t badLine = 0;
+
+    for (cobalt_u64_t lineNumber = 1; text < textEnd; lineNumber++)
+    {
+        span_t line = {text, text};
+        while (line.end < textEnd && *line.end != '\n') line.end++;
+        text = line.end < textEnd ? line.end + 1 : line.end;
+
+        line = trim(line);
+        if (line.start == line.end || *line.start == '#') continue;
+
+        const char *equals = line.start;
+        while (equals < line.end && *equals != '=') equals++;
+
+        if ((equals == line.end ||
+             !parseLine(trim((span_t){line.start, equals}),
+                        trim((span_t){equals + 1, line.end}), config)) &&
+            badLine == 0)
+            badLine = lineNumber;
+    }
+
+    return badLine;
+}
+
+EFI_STATUS Cobalt_ReadConfig(cobalt_efi_root_volume_t *root,
+                             EFI_BOOT_SERVICES *bootServices,
+                             cobalt_boot_config_t *config)
+{
+    Cobalt_DefaultConfig(config);
+
+    // Open the file directly rather than through Cobalt_OpenFile; a
+    // missing configuration is perfectly normal, and not worth an error.
+    cobalt_efi_file_t *file;
+    EFI_STATUS status = root->Open(root, &file, COBALT_CONFIG_PATH,
+                                   EFI_FILE_MODE_READ, EFI_FILE_READ_ONLY);
+    if (status == EFI_NOT_FOUND) return EFI_SUCCESS;
+    if (EFI_ERROR(status))
+    {
+        Cobalt_PrimitivePrintf(
+            L"Failed to open configuration file. Code: %U." NL, status);
+        return status;
+    }
+
+    // An empty file is as good as a missing one, and firmware won't
+    // allocate the zero pages it'd be read into.
+    void *buffer;
+    UINT64 size;
+    status = Cobalt_GetFileSize(file, bootServices, &size);
+    if (!EFI_ERROR(status) && size != 0)
+        status =
+            Cobalt_ReadFileRange(file, bootServices, 0, size, &buffer);
+    (void)Cobalt_CloseFile(file);
+    if (EFI_ERROR(status) || size == 0) return status;
+
+    const cobalt_u64_t badLine = Cobalt_ParseConfig(buffer, size, config);
+    if (badLine != 0)
+        Cobalt_PrimitivePrintf(
+            L"Ignoring malformed line %U of the configuration file." NL,
+            badLine);
+
+    (void)bootServices->FreePages((EFI_PHYSICAL_ADDRESS)buffer,
+                                  EFI_SIZE_TO_PAGES(size));
+    return EFI_SUCCESS;
+}
@@ -0,0 +1,121 @@
+/**
+ * @file Decompress.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the LZ4 block decompressor outlined in the
+ * Decompress.h file. For the format itself, see the LZ4 block format
+ * reference in CREDITS.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <Bootloader/Decompress.h>
+
+// Every match is at least this long; the token stores the length minus
+// this value.
+#define MINIMUM_MATCH 4
+
+// Copy a single unaligned word. The compiler lowers this to one load and
+// one store.
+static inline void copyWord(cobalt_u8_t *destination,
+                            const cobalt_u8_t *source)
+{
+    __builtin_memcpy(destination, source, 8);
+}
+
+// Read a length extension, which is a run of 255s terminated by any other
+// byte, each added onto the length.
+static inline bool readLength(const cobalt_u8_t **in,
+                              const cobalt_u8_t *sourceEnd,
+                              cobalt_u64_t *length)
+{
+    cobalt_u8_t byte;
+    do {
+        if (*in >= sourceEnd) return false;
+        byte = *(*in)++;
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+bool Cobalt_Decompress(const void *source, cobalt_u64_t sourceSize,
+                       void *destination, cobalt_u64_t destinationSize)
+{
+    const cobalt_u8_t *in = source;
+    const cobalt_u8_t *const sourceEnd = in + sourceSize;
+    cobalt_u8_t *out = destination;
+    cobalt_u8_t *const destinationStart = out;
+    cobalt_u8_t *const destinationEnd = out + destinationSize;
+
+    while (in < sourceEnd)
+    {
+        const cobalt_u8_t token = *in++;
+
+        cobalt_u64_t literalLength = token >> 4;
+        if (literalLength == 15 &&
+            !readLength(&in, sourceEnd, &literalLength))
+            return false;
+        if (literalLength > (cobalt_u64_t)(sourceEnd - in) ||
+            literalLength > (cobalt_u64_t)(destinationEnd - out))
+            return false;
+
+        // Most literal runs are short, so when there's slack on both ends
+        // copy a fixed 16 bytes and let the next sequence overwrite the
+        // excess.
+        if (literalLength <= 16 && sourceEnd - in >= 16 &&
+            destinationEnd - out >= 16)
+        {
+            copyWord(out, in);
+            copyWord(out + 8, in + 8);
+        }
+        else
+        {
+            cobalt_u64_t i = 0;
+            for (; i + 8 <= literalLength; i += 8)
+                copyWord(out + i, in + i);
+            for (; i < literalLength; i++) out[i] = in[i];
+        }
+        in += literalLength;
+        out += literalLength;
+
+        // The final sequence of a block is literals alone.
+        if (in == sourceEnd) break;
+        if (sourceEnd - in < 2) return false;
+
+        const cobalt_u64_t offset = (cobalt_u64_t)in[0] | (in[1] << 8);
+        in += 2;
+        if (offset == 0 || offset > (cobalt_u64_t)(out - destinationStart))
+            return false;
+
+        cobalt_u64_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(&in, sourceEnd, &matchLength))
+            return false;
+        matchLength += MINIMUM_MATCH;
+        if (matchLength > (cobalt_u64_t)(destinationEnd - out))
+            return false;
+
+        // Matches at least a word behind the output can be copied a word
+        // at a time, since every word read has already been written.
+        // Closer matches repeat a short pattern and must go bytewise.
+        const cobalt_u8_t *match = out - offset;
+        if (offset >= 8 &&
+            (cobalt_u64_t)(destinationEnd - out) >= matchLength + 8)
+        {
+            cobalt_u8_t *const matchEnd = out + matchLength;
+            do {
+                copyWord(out, match);
+                out += 8;
+                match += 8;
+            } while (out < matchEnd);
+            out = matchEnd;
+        }
+        else
+            for (; matchLength != 0; matchLength--) *out++ = *match++;
+    }
+
+    return out == destinationEnd;
+}
@@ -78,28 +78,154 @@ EFI_STATUS Cobalt_CloseFile(cobalt_efi_file_t *file)
     return status;
 }
 
-EFI_STATUS Cobalt_ReadDOSHeader(cobalt_efi_file_t *file,
-                                cobalt_dos_header_t *header)
+EFI_STATUS Cobalt_GetFileSize(cobalt_efi_file_t *file,
+                              EFI_BOOT_SERVICES *bootServices,
+                              UINT64 *size)
 {
-    cobalt_u64_t size = sizeof(cobalt_dos_header_t);
-    EFI_STATUS status = file->Read(file, &size, header);
+    EFI_GUID fileInfoGUID = EFI_FILE_INFO_ID;
+    UINTN infoSize = 0;
+    EFI_FILE_INFO *info = nullptr;
+
+    EFI_STATUS status =
+        file->GetInfo(file, &fileInfoGUID, &infoSize, info);
+    if (status != EFI_BUFFER_TOO_SMALL)
+    {
+        Cobalt_PrimitivePrintf(
+            L"Failed to query file information size. Code: %U." NL,
+            status);
+        return EFI_ERROR(status) ? status : EFI_LOAD_ERROR;
+    }
+
+    status = bootServices->AllocatePool(EfiLoaderData, infoSize,
+                                        (void **)&info);
     if (EFI_ERROR(status))
     {
         Cobalt_PrimitivePrintf(
-            L"Failed to read DOS header into memory. Code: %U." NL,
+            L"Failed to allocate file information pool. Code: %U." NL,
             status);
         return status;
     }
 
-    if (header->magicNumber != 0x5A4D)
+    status = file->GetInfo(file, &fileInfoGUID, &infoSize, info);
+    if (EFI_ERROR(status))
+        Cobalt_PrimitivePrintf(
+            L"Failed to query file information. Code: %U." NL, status);
+    else *size = info->FileSize;
+
+    (void)bootServices->FreePool(info);
+    return status;
+}
+
+EFI_STATUS Cobalt_ReadFileRange(cobalt_efi_file_t *file,
+                                EFI_BOOT_SERVICES *bootServices,
+                                UINT64 offset, UINT64 size, void **buffer)
+{
+    EFI_PHYSICAL_ADDRESS bufferAddress;
+    EFI_STATUS status = bootServices->AllocatePages(
+        AllocateAnyPages, EfiLoaderData, EFI_SIZE_TO_PAGES(size),
+        &bufferAddress);
+    if (EFI_ERROR(status))
     {
-        Cobalt_PrimitivePuts(L"Read invalid DOS header into memory." NL);
-        return EFI_UNSUPPORTED;
+        Cobalt_PrimitivePrintf(
+            L"Failed to allocate %U byte file buffer. Code: %U." NL, size,
+            status);
+        return status;
+    }
+
+    UINTN readSize = size;
+    status = file->SetPosition(file, offset);
+    if (!EFI_ERROR(status))
+        status = file->Read(file, &readSize, (void *)bufferAddress);
+    if (EFI_ERROR(status) || readSize != size)
+    {
+        Cobalt_PrimitivePrintf(
+            L"Failed to read file into memory (%U of %U bytes). "
+            L"Code: %U." NL,
+            readSize, size, status);
+        (void)bootServices->FreePages(bufferAddress,
+                                      EFI_SIZE_TO_PAGES(size));
+        return EFI_ERROR(status) ? status : EFI_END_OF_FILE;
     }
-    status = file->SetPosition(file, header->peHeaderOffset);
+
+    *buffer = (void *)bufferAddress;
+    return status;
+}
+
+EFI_STATUS Cobalt_ReadFile(cobalt_efi_file_t *file,
+                           EFI_BOOT_SERVICES *bootServices, void **buffer,
+                           UINT64 *size)
+{
+    EFI_STATUS status = Cobalt_GetFileSize(file, bootServices, size);
+    if (EFI_ERROR(status)) return status;
+    return Cobalt_ReadFileRange(file, bootServices, 0, *size, buffer);
+}
+
+bool Cobalt_FileSupportsAsync(cobalt_efi_file_t *file)
+{
+    return file->Revision >= EFI_FILE_PROTOCOL_REVISION2;
+}
+
+EFI_STATUS Cobalt_BeginFileRead(cobalt_efi_file_t *file,
+                                EFI_BOOT_SERVICES *bootServices,
+                                UINT64 offset, UINT64 size, void *buffer,
+                                cobalt_file_request_t *request)
+{
+    *request = (cobalt_file_request_t){
+        .token = {.BufferSize = size, .Buffer = buffer},
+        .offset = offset,
+        .size = size};
+
+    // The firmware takes the position at the time the read is queued, so
+    // many reads can be in flight on the one file.
+    EFI_STATUS status = file->SetPosition(file, offset);
     if (EFI_ERROR(status))
-        Cobalt_PrimitivePrintf(L"Failed to set the file position to the "
-                               L"DOS header's PE offset. Code: %U.",
-                               status);
+    {
+        Cobalt_PrimitivePrintf(
+            L"Failed to seek to file offset %U. Code: %U." NL, offset,
+            status);
+        return status;
+    }
+
+    if (Cobalt_FileSupportsAsync(file) &&
+        !EFI_ERROR(bootServices->CreateEvent(0, TPL_APPLICATION, nullptr,
+                                             nullptr,
+                                             &request->token.Event)))
+    {
+        if (!EFI_ERROR(file->ReadEx(file, &request->token)))
+            return EFI_SUCCESS;
+
+        (void)bootServices->CloseEvent(request->token.Event);
+        request->token.Event = nullptr;
+        request->token.BufferSize = size;
+    }
+
+    request->token.Status =
+        file->Read(file, &request->token.BufferSize, buffer);
+    return EFI_SUCCESS;
+}
+
+EFI_STATUS Cobalt_FinishFileRead(EFI_BOOT_SERVICES *bootServices,
+                                 cobalt_file_request_t *request)
+{
+    if (request->token.Event != nullptr)
+    {
+        UINTN index;
+        EFI_STATUS status =
+            bootServices->WaitForEvent(1, &request->token.Event, &index);
+        if (EFI_ERROR(status)) request->token.Status = status;
+        (void)bootServices->CloseEvent(request->token.Event);
+        request->token.Event = nullptr;
+    }
+
+    EFI_STATUS status = request->token.Status;
+    if (EFI_ERROR(status) || request->token.BufferSize != request->size)
+    {
+        Cobalt_PrimitivePrintf(
+            L"Failed to read %U bytes at file offset %U (got %U). "
+            L"Code: %U." NL,
+            request->size, request->offset, request->token.BufferSize,
+            status);
+        return EFI_ERROR(status) ? status : EFI_END_OF_FILE;
+    }
     return status;
 }
@@ -1,38 +1,264 @@
 #include <Bootloader/EFI/Graphics.h>
 #include <Bootloader/EFI/Print.h>
+#include <Bootloader/Trace.h>
+
+// The chosen mode is cached in a variable under the loader's own GUID, so
+// that later boots can go straight to it without asking after every mode.
+#define CACHE_GUID                                                        \
+    {0x5A3C9E71,                                                          \
+     0x2B84,                                                              \
+     0x4F0D,                                                              \
+     {0x9C, 0x61, 0x7E, 0x23, 0xD4, 0x58, 0xA1, 0x0B}}
+#define CACHE_ATTRIBUTES                                                  \
+    (EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS)
+
+// No mode at all, since mode numbers run from zero.
+#define NO_MODE 0xFFFFFFFF
+
+// The request a mode was chosen for, and the mode that was chosen. A
+// cached mode is only trusted if both still agree.
+typedef struct
+{
+    UINT32 device;
+    UINT32 preferredWidth;
+    UINT32 preferredHeight;
+    UINT32 preferredFormat;
+    UINT32 mode;
+    UINT32 width;
+    UINT32 height;
+    UINT32 format;
+} cached_mode_t;
+
+static CHAR16 cacheName[] = L"CobaltGraphicsMode";
+
+static bool usable(const EFI_GRAPHICS_OUTPUT_MODE_INFORMATION *info,
+                   EFI_GRAPHICS_PIXEL_FORMAT format)
+{
+    // A mode without a framebuffer is no use once boot services are gone.
+    if (info->PixelFormat >= PixelBltOnly) return false;
+    return format == PixelFormatMax || info->PixelFormat == format;
+}
+
+// Rank a mode against the requested resolution, higher being better. An
+// exact match beats everything; after that comes the largest mode that
+// fits inside the request, then the smallest that doesn't. With no
+// request, bigger is better.
+static UINT64 score(const EFI_GRAPHICS_OUTPUT_MODE_INFORMATION *info,
+                    UINT32 width, UINT32 height)
+{
+    const UINT64 area =
+        (UINT64)info->HorizontalResolution * info->VerticalResolution;
+    if (width == 0) return area;
+    if (info->HorizontalResolution == width &&
+        info->VerticalResolution == height)
+        return ~0ULL;
+    if (info->HorizontalResolution <= width &&
+        info->VerticalResolution <= height)
+        return (1ULL << 62) + area;
+    return (1ULL << 62) - area;
+}
+
+// Try the cached mode, if there is one for this request.
+static UINT32 cachedMode(EFI_GRAPHICS_OUTPUT_PROTOCOL *gopProtocol,
+                         EFI_BOOT_SERVICES *services,
+                         EFI_RUNTIME_SERVICES *runtime,
+                         const cached_mode_t *request,
+                         cached_mode_t *cache)
+{
+    EFI_GUID cacheGUID = CACHE_GUID;
+    UINT32 attributes;
+    UINTN size = sizeof(*cache);
+    if (EFI_ERROR(runtime->GetVariable(cacheName, &cacheGUID, &attributes,
+                                       &size, cache)) ||
+        size != sizeof(*cache) || cache->device != request->device ||
+        cache->preferredWidth != request->preferredWidth ||
+        cache->preferredHeight != request->preferredHeight ||
+        cache->preferredFormat != request->preferredFormat ||
+        cache->mode >= gopProtocol->Mode->MaxMode)
+        return NO_MODE;
+
+    // The firmware or the display may have changed since, so the mode has
+    // to still be what it was.
+    UINTN infoSize;
+    EFI_GRAPHICS_OUTPUT_MODE_INFORMATION *info;
+    if (EFI_ERROR(gopProtocol->QueryMode(gopProtocol, cache->mode,
+                                         &infoSize, &info)))
+        return NO_MODE;
+    const bool same = info->HorizontalResolution == cache->width &&
+                      info->VerticalResolution == cache->height &&
+                      (UINT32)info->PixelFormat == cache->format &&
+                      usable(info, request->preferredFormat);
+    (void)services->FreePool(info);
+    return same ? cache->mode : NO_MODE;
+}
+
+// Ask after every mode, and pick the best for the request. The active
+// mode wins any tie, since choosing it needs no modeset.
+static UINT32 bestMode(EFI_GRAPHICS_OUTPUT_PROTOCOL *gopProtocol,
+                       EFI_BOOT_SERVICES *services,
+                       const cached_mode_t *request, cached_mode_t *chosen)
+{
+    const EFI_GRAPHICS_OUTPUT_PROTOCOL_MODE *active = gopProtocol->Mode;
+    UINT32 best = NO_MODE;
+    UINT64 bestScore = 0;
+    if (active->Mode < active->MaxMode &&
+        usable(active->Info, request->preferredFormat))
+    {
+        best = active->Mode;
+        // Without a requested resolution, the firmware's choice is as good
+        // as any, and is usually the display's native one.
+        bestScore = request->preferredWidth == 0
+                        ? ~0ULL
+                        : score(active->Info, request->preferredWidth,
+                                request->preferredHeight);
+        chosen->width = active->Info->HorizontalResolution;
+        chosen->height = active->Info->VerticalResolution;
+        chosen->format = active->Info->PixelFormat;
+    }
+
+    UINT64 queried = 0;
+    for (UINT32 mode = 0; bestScore != ~0ULL && mode < active->MaxMode;
+         mode++)
+    {
+        if (mode == active->Mode) continue;
+        UINTN infoSize;
+        EFI_GRAPHICS_OUTPUT_MODE_INFORMATION *info;
+        queried++;
+        if (EFI_ERROR(gopProtocol->QueryMode(gopProtocol, mode, &infoSize,
+                                             &info)))
+            continue;
+
+        const UINT64 modeScore = score(info, request->preferredWidth,
+                                       request->preferredHeight);
+        if (usable(info, request->preferredFormat) &&
+            (best == NO_MODE || modeScore > bestScore))
+        {
+            best = mode;
+            bestScore = modeScore;
+            chosen->width = info->HorizontalResolution;
+            chosen->height = info->VerticalResolution;
+            chosen->format = info->PixelFormat;
+        }
+        (void)services->FreePool(info);
+    }
+    Cobalt_TraceCounter("graphics modes queried", queried);
+    return best;
+}
+
+static EFI_STATUS
+configure(EFI_GRAPHICS_OUTPUT_PROTOCOL *gopProtocol,
+          EFI_BOOT_SERVICES *services, EFI_RUNTIME_SERVICES *runtime,
+          const cached_mode_t *request,
+          EFI_GRAPHICS_OUTPUT_PROTOCOL_MODE *graphicsMode)
+{
+    // With no resolution asked for, a usable active mode is picked
+    // without a single query, so the cache has nothing to save and isn't
+    // worth the variable accesses.
+    const EFI_GRAPHICS_OUTPUT_PROTOCOL_MODE *active = gopProtocol->Mode;
+    const bool native = request->preferredWidth == 0 &&
+                        active->Mode < active->MaxMode &&
+                        usable(active->Info, request->preferredFormat);
+
+    cached_mode_t cache, chosen = *request;
+    chosen.mode = native ? NO_MODE
+                         : cachedMode(gopProtocol, services, runtime,
+                                      request, &cache);
+    if (chosen.mode != NO_MODE)
+    {
+        chosen = cache;
+        Cobalt_TraceCounter("graphics modes queried", 0);
+    }
+    else
+    {
+        chosen.mode = bestMode(gopProtocol, services, request, &chosen);
+        if (chosen.mode == NO_MODE) return EFI_UNSUPPORTED;
+
+        // Failing to cache the mode only costs the next boot some time.
+        EFI_GUID cacheGUID = CACHE_GUID;
+        if (!native)
+            (void)runtime->SetVariable(cacheName, &cacheGUID,
+                                       CACHE_ATTRIBUTES, sizeof(chosen),
+                                       &chosen);
+    }
+
+    if (chosen.mode != gopProtocol->Mode->Mode)
+    {
+        const cobalt_u32_t modesetTrace = Cobalt_TraceBegin("modeset");
+        const EFI_STATUS status =
+            gopProtocol->SetMode(gopProtocol, chosen.mode);
+        Cobalt_TraceEnd(modesetTrace);
+        if (EFI_ERROR(status))
+        {
+            Cobalt_PrimitivePrintf(
+                L"Failed to set graphics mode %U. Code: %U." NL,
+                (UINT64)chosen.mode, status);
+            return status;
+        }
+    }
+
+    const EFI_STATUS status = services->AllocatePool(
+        EfiLoaderData, gopProtocol->Mode->SizeOfInfo,
+        (void **)&graphicsMode->Info);
+    if (EFI_ERROR(status)) return status;
+    graphicsMode->MaxMode = gopProtocol->Mode->MaxMode;
+    graphicsMode->Mode = gopProtocol->Mode->Mode;
+    graphicsMode->SizeOfInfo = gopProtocol->Mode->SizeOfInfo;
+
+    graphicsMode->FrameBufferBase = gopProtocol->Mode->FrameBufferBase;
+    graphicsMode->FrameBufferSize = gopProtocol->Mode->FrameBufferSize;
+    *(graphicsMode->Info) = *(gopProtocol->Mode->Info);
+    return EFI_SUCCESS;
+}
 
 EFI_STATUS
 Cobalt_InitializeGraphics(EFI_GRAPHICS_OUTPUT_PROTOCOL_MODE *graphicsMode,
                           EFI_HANDLE *imageHandle,
-                          EFI_BOOT_SERVICES *services)
+                          EFI_BOOT_SERVICES *services,
+                          EFI_RUNTIME_SERVICES *runtime,
+                          UINT32 preferredWidth, UINT32 preferredHeight,
+                          EFI_GRAPHICS_PIXEL_FORMAT preferredFormat)
 {
     EFI_GUID graphicsGUID = EFI_GRAPHICS_OUTPUT_PROTOCOL_GUID;
 
     UINTN graphicsDeviceCount;
     EFI_HANDLE *graphicsDevices;
-    services->LocateHandleBuffer(ByProtocol, &graphicsGUID, nullptr,
-                                 &graphicsDeviceCount, &graphicsDevices);
+    EFI_STATUS status = services->LocateHandleBuffer(
+        ByProtocol, &graphicsGUID, nullptr, &graphicsDeviceCount,
+        &graphicsDevices);
+    if (EFI_ERROR(status))
+    {
+        Cobalt_PrimitivePrintf(
+            L"Failed to find a graphics device. Code: %U." NL, status);
+        return status;
+    }
     Cobalt_PrimitivePrintf(L"Found %U graphics device(s).",
                            graphicsDeviceCount);
 
-    // We just configure the first graphics device. Cobalt has absolutely
-    // no business running more than that T-T
-    EFI_GRAPHICS_OUTPUT_PROTOCOL *gopProtocol;
-    services->OpenProtocol(graphicsDevices[0], &graphicsGUID,
-                           (void **)&gopProtocol, imageHandle, nullptr,
-                           EFI_OPEN_PROTOCOL_GET_PROTOCOL);
-    gopProtocol->SetMode(gopProtocol, 0);
-
-    services->AllocatePool(EfiLoaderData, gopProtocol->Mode->SizeOfInfo,
-                           (void **)&graphicsMode->Info);
-    graphicsMode->MaxMode = gopProtocol->Mode->MaxMode;
-    graphicsMode->Mode = gopProtocol->Mode->Mode;
-    graphicsMode->SizeOfInfo = gopProtocol->Mode->SizeOfInfo;
+    // Cobalt has absolutely no business running more than one display, so
+    // the first device that has a usable mode is the one.
+    status = EFI_NOT_FOUND;
+    for (UINTN device = 0;
+         EFI_ERROR(status) && device < graphicsDeviceCount; device++)
+    {
+        EFI_GRAPHICS_OUTPUT_PROTOCOL *gopProtocol;
+        status = services->OpenProtocol(
+            graphicsDevices[device], &graphicsGUID, (void **)&gopProtocol,
+            imageHandle, nullptr, EFI_OPEN_PROTOCOL_GET_PROTOCOL);
+        if (EFI_ERROR(status)) continue;
 
-    graphicsMode->FrameBufferBase = gopProtocol->Mode->FrameBufferBase;
-    graphicsMode->FrameBufferSize = gopProtocol->Mode->FrameBufferSize;
-    *(graphicsMode->Info) = *(gopProtocol->Mode->Info);
+        const cached_mode_t request = {
+            .device = (UINT32)device,
+            .preferredWidth = preferredWidth,
+            .preferredHeight = preferredHeight,
+            .preferredFormat = preferredFormat};
+        status = configure(gopProtocol, services, runtime, &request,
+                           graphicsMode);
+    }
+    (void)services->FreePool(graphicsDevices);
 
-    services->FreePool(graphicsDevices);
-    return 0;
+    if (EFI_ERROR(status))
+        Cobalt_PrimitivePrintf(
+            L"Failed to find a usable graphics mode. Code: %U." NL,
+            status);
+    return status;
 }
@@ -4,7 +4,7 @@
  * @brief The implementation of the primitive EFI printing routines
  * outlined in the EFI/Print.h file.
  * @since 0.1.0.0
- * @updated 0.1.0.1
+ * @updated 0.1.0.6
  *
  * @copyright (c) 2025 Israfil Argos
  * This file is under the AGPLv3. For information on what that entails, see
@@ -13,7 +13,71 @@
  */
 
 #include <Bootloader/EFI/Print.h>
-#include <Bootloader/Math.h>
+
+// The characters a formatted print gathers before handing them to the
+// firmware, which is slow enough per call that most lines should go in
+// one.
+#define BUFFER_LENGTH 256
+
+// Wide enough for a 64-bit integer in any base we print.
+#define DIGITS_LENGTH 24
+
+typedef struct
+{
+    COBALT_WIDECHAR characters[BUFFER_LENGTH];
+    uint64_t length;
+    // The first failure, if any, so later output still goes out.
+    EFI_STATUS status;
+} buffer_t;
+
+static void flush(buffer_t *buffer)
+{
+    if (buffer->length == 0) return;
+    buffer->characters[buffer->length] = 0;
+    buffer->length = 0;
+
+    const EFI_STATUS status =
+        cobalt_conOut->OutputString(cobalt_conOut, buffer->characters);
+    if (EFI_ERROR(status) && !EFI_ERROR(buffer->status))
+        buffer->status = status;
+}
+
+static void put(buffer_t *buffer, COBALT_WIDECHAR character)
+{
+    // Leave room for the terminator.
+    if (buffer->length == BUFFER_LENGTH - 1) flush(buffer);
+    buffer->characters[buffer->length++] = character;
+}
+
+static void putRepeated(buffer_t *buffer, COBALT_WIDECHAR character,
+                        uint64_t count)
+{
+    for (uint64_t i = 0; i < count; i++) put(buffer, character);
+}
+
+// Print an integer right-aligned in a field. Zero padding goes between
+// the sign and the digits, as it does in C's printf.
+static void putInteger(buffer_t *buffer, uint64_t value, bool negative,
+                       unsigned int base, bool upper, uint64_t width,
+                       bool zeroPad)
+{
+    const COBALT_WIDECHAR *const digits =
+        upper ? L"0123456789ABCDEF" : L"0123456789abcdef";
+    COBALT_WIDECHAR reversed[DIGITS_LENGTH];
+    uint64_t length = 0;
+    do
+    {
+        reversed[length++] = digits[value % base];
+        value /= base;
+    } while (value != 0);
+
+    const uint64_t used = length + negative;
+    const uint64_t padding = width > used ? width - used : 0;
+    if (!zeroPad) putRepeated(buffer, L' ', padding);
+    if (negative) put(buffer, L'-');
+    if (zeroPad) putRepeated(buffer, L'0', padding);
+    while (length > 0) put(buffer, reversed[--length]);
+}
 
 EFI_STATUS Cobalt_PrimitiveClear(void)
 {
@@ -22,41 +86,71 @@ EFI_STATUS Cobalt_PrimitiveClear(void)
 
 EFI_STATUS Cobalt_PrimitivePrintfv(COBALT_WIDESTR format, va_list args)
 {
-    EFI_STATUS returnStatus = 0;
+    buffer_t buffer;
+    buffer.length = 0;
+    buffer.status = EFI_SUCCESS;
 
-    int64_t i = -1;
-    unsigned short currentCharacter = 1;
-    while (currentCharacter != 0)
+    for (; *format != 0; format++)
     {
-        currentCharacter = format[++i];
-        if (currentCharacter == L'%')
+        if (*format != L'%')
+        {
+            put(&buffer, *format);
+            continue;
+        }
+
+        // Anything we can't make sense of is printed as it stands.
+        const COBALT_WIDESTR specifier = format;
+        const bool zeroPad = *++format == L'0';
+        uint64_t width = 0;
+        for (; *format >= L'0' && *format <= L'9'; format++)
+            width = width * 10 + (*format - L'0');
+
+        switch (*format)
         {
-            unsigned short iString[64];
-            switch (format[i + 1])
+            case L's':
             {
-                case L's':
-                    returnStatus = Cobalt_PrimitivePuts(
-                        va_arg(args, unsigned short *));
-                    i++;
-                    continue;
-                case L'L':
-                    itoa_wide(va_arg(args, int64_t), iString, 10);
-                    returnStatus = Cobalt_PrimitivePuts(iString);
-                    i++;
-                    continue;
-                case L'U':
-                    uitoa_wide(va_arg(args, uint64_t), iString, 10);
-                    returnStatus = Cobalt_PrimitivePuts(iString);
-                    i++;
-                    continue;
+                COBALT_WIDESTR string = va_arg(args, COBALT_WIDESTR);
+                uint64_t length = 0;
+                while (string[length] != 0) length++;
+                if (width > length)
+                    putRepeated(&buffer, L' ', width - length);
+                for (uint64_t i = 0; i < length; i++)
+                    put(&buffer, string[i]);
+                break;
             }
+            case L'L':
+            {
+                const int64_t value = va_arg(args, int64_t);
+                putInteger(&buffer,
+                           value < 0 ? -(uint64_t)value : (uint64_t)value,
+                           value < 0, 10, false, width, zeroPad);
+                break;
+            }
+            case L'U':
+                putInteger(&buffer, va_arg(args, uint64_t), false, 10,
+                           false, width, zeroPad);
+                break;
+            case L'X':
+            case L'x':
+                putInteger(&buffer, va_arg(args, uint64_t), false, 16,
+                           *format == L'X', width, zeroPad);
+                break;
+            case L'p':
+                put(&buffer, L'0');
+                put(&buffer, L'x');
+                putInteger(&buffer, (uint64_t)va_arg(args, void *), false,
+                           16, true, 16, true);
+                break;
+            case L'%': put(&buffer, L'%'); break;
+            default:
+                put(&buffer, L'%');
+                format = specifier;
+                break;
         }
-
-        unsigned short strprint[2] = {currentCharacter, 0};
-        Cobalt_PrimitivePuts(strprint);
     }
 
-    return returnStatus;
+    flush(&buffer);
+    return buffer.status;
 }
 
 EFI_STATUS Cobalt_PrimitivePrintf(unsigned short *format, ...)
@@ -79,17 +173,15 @@ EFI_STATUS Cobalt_PrimitiveTimestamp(COBALT_WIDESTR messageFormat, ...)
 {
     va_list args;
     va_start(args, messageFormat);
-
     EFI_STATUS status = Cobalt_PrimitivePrintfv(messageFormat, args);
-    if (EFI_ERROR(status)) return status;
-
     va_end(args);
+    if (EFI_ERROR(status)) return status;
 
-    EFI_TIME time;
-    cobalt_efiInfo.runtimeServices->GetTime(&time, nullptr);
-
+    const EFI_TIME *time = &cobalt_efiInfo.bootTime;
+    if (cobalt_efiInfo.bootTimestamp == 0)
+        return Cobalt_PrimitivePuts(L"unknown" NL);
     return Cobalt_PrimitivePrintf(
-        L"%U/%U/%U @ %U:%U:%U" NL, (uint64_t)time.Day,
-        (uint64_t)time.Month, (uint64_t)time.Year, (uint64_t)time.Hour,
-        (uint64_t)time.Minute, (uint64_t)time.Second);
+        L"%U/%U/%U @ %U:%U:%U" NL, (uint64_t)time->Day,
+        (uint64_t)time->Month, (uint64_t)time->Year, (uint64_t)time->Hour,
+        (uint64_t)time->Minute, (uint64_t)time->Second);
 }
@@ -0,0 +1,380 @@
+/**
+ * @file Image.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the in-memory PE image parser outlined in
+ * the Image.h file.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <Bootloader/Decompress.h>
+#include <Bootloader/EFI/Print.h>
+#include <Bootloader/Image.h>
+#include <Memory.h>
+
+#include <stddef.h>
+
+#define DOS_MAGIC 0x5A4D
+#define PE_MAGIC 0x00004550
+#define PE32PLUS_MAGIC 0x020B
+
+// The raw data of a section past its virtual size is just file alignment
+// padding, and must not be loaded over whatever comes next.
+static cobalt_u64_t
+sectionLoadSize(const cobalt_image_section_header_t *section)
+{
+    cobalt_u64_t size = section->SizeOfRawData;
+    if (section->Misc.VirtualSize != 0 && section->Misc.VirtualSize < size)
+        size = section->Misc.VirtualSize;
+    return size;
+}
+
+// Parse the PE headers of an image. The raw data of sections is checked
+// against the given raw size, which is zero for the headers of a packed
+// container, since there's no raw data to check.
+static EFI_STATUS parseHeaders(const void *file, cobalt_u64_t fileSize,
+                               cobalt_u64_t rawSize, cobalt_image_t *image)
+{
+    const cobalt_u8_t *bytes = file;
+    if (fileSize < sizeof(cobalt_dos_header_t))
+    {
+        Cobalt_PrimitivePuts(L"Image is too small for a DOS header." NL);
+        return EFI_LOAD_ERROR;
+    }
+
+    const cobalt_dos_header_t *dosHeader = file;
+    if (dosHeader->magicNumber != DOS_MAGIC)
+    {
+        Cobalt_PrimitivePuts(L"Image has an invalid DOS header." NL);
+        return EFI_UNSUPPORTED;
+    }
+
+    // Everything up to the optional header is fixed-size, and the optional
+    // header's size is given to us by the COFF header.
+    const cobalt_u64_t peOffset = dosHeader->peHeaderOffset;
+    const cobalt_u64_t optionalOffset =
+        peOffset + offsetof(cobalt_pe_header_t, optionalHeader);
+    if (optionalOffset > fileSize)
+    {
+        Cobalt_PrimitivePuts(L"Image PE header is out of bounds." NL);
+        return EFI_LOAD_ERROR;
+    }
+
+    const cobalt_pe_header_t *peHeader =
+        (const cobalt_pe_header_t *)(bytes + peOffset);
+    if (peHeader->coffHeader.magicNumber != PE_MAGIC)
+    {
+        Cobalt_PrimitivePuts(L"Image has an invalid PE header." NL);
+        return EFI_UNSUPPORTED;
+    }
+
+    const cobalt_u64_t optionalSize =
+        peHeader->coffHeader.optionalHeaderSize;
+    const cobalt_u64_t directoryOffset =
+        offsetof(cobalt_pe_header_t, optionalHeader.dataDirectory) -
+        offsetof(cobalt_pe_header_t, optionalHeader);
+    if (optionalSize < directoryOffset ||
+        optionalSize > fileSize - optionalOffset)
+    {
+        Cobalt_PrimitivePrintf(
+            L"Image optional header size %U is invalid." NL, optionalSize);
+        return EFI_LOAD_ERROR;
+    }
+
+    if (peHeader->optionalHeader.magicNumber != PE32PLUS_MAGIC)
+    {
+        Cobalt_PrimitivePuts(L"Image is not a PE32+ executable." NL);
+        return EFI_UNSUPPORTED;
+    }
+
+    // Directories past those the optional header actually holds would be
+    // read out of whatever follows it.
+    const cobalt_u64_t directoryLength =
+        peHeader->optionalHeader.dataDirectoryLength;
+    if (directoryLength > 16 ||
+        directoryOffset + directoryLength * 8 > optionalSize)
+    {
+        Cobalt_PrimitivePrintf(
+            L"Image data directory length %U is invalid." NL,
+            directoryLength);
+        return EFI_LOAD_ERROR;
+    }
+
+    const cobalt_u64_t sectionOffset = optionalOffset + optionalSize;
+    const cobalt_u64_t sectionCount = peHeader->coffHeader.sectionCount;
+    if (sectionCount * sizeof(cobalt_image_section_header_t) >
+        fileSize - sectionOffset)
+    {
+        Cobalt_PrimitivePuts(L"Image section table is out of bounds." NL);
+        return EFI_LOAD_ERROR;
+    }
+
+    const cobalt_image_section_header_t *sections =
+        (const cobalt_image_section_header_t *)(bytes + sectionOffset);
+    cobalt_u64_t virtualSize = peHeader->optionalHeader.headerSize;
+    cobalt_u64_t loadedSize = virtualSize;
+    if (virtualSize > fileSize)
+    {
+        Cobalt_PrimitivePuts(L"Image header size is out of bounds." NL);
+        return EFI_LOAD_ERROR;
+    }
+
+    // Sections must be in ascending order without overlap, as the PE
+    // specification requires. Loading relies on this to know the gaps
+    // between them.
+    for (cobalt_u64_t i = 0; i < sectionCount; i++)
+    {
+        const cobalt_image_section_header_t *section = &sections[i];
+        const cobalt_u64_t loadSize = sectionLoadSize(section);
+        const cobalt_u64_t rawOffset = section->PointerToRawData;
+        if (rawSize != 0 && loadSize != 0 &&
+            (rawOffset > rawSize || loadSize > rawSize - rawOffset))
+        {
+            Cobalt_PrimitivePrintf(
+                L"Image section %U raw data is out of bounds." NL, i);
+            return EFI_LOAD_ERROR;
+        }
+
+        if (section->VirtualAddress < virtualSize)
+        {
+            Cobalt_PrimitivePrintf(
+                L"Image section %U overlaps what precedes it." NL, i);
+            return EFI_LOAD_ERROR;
+        }
+
+        cobalt_u64_t memorySize = section->Misc.VirtualSize;
+        if (memorySize < loadSize) memorySize = loadSize;
+        virtualSize = (cobalt_u64_t)section->VirtualAddress + memorySize;
+        loadedSize += loadSize;
+    }
+
+    *image = (cobalt_image_t){.file = bytes,
+                              .fileSize = fileSize,
+                              .peHeader = peHeader,
+                              .sections = sections,
+                              .sectionCount = (cobalt_u16_t)sectionCount,
+                              .virtualSize = virtualSize,
+                              .loadedSize = loadedSize};
+    return EFI_SUCCESS;
+}
+
+static EFI_STATUS parsePack(const void *file, cobalt_u64_t fileSize,
+                            cobalt_image_t *image)
+{
+    const cobalt_u8_t *bytes = file;
+    const cobalt_pack_header_t *header = file;
+    if (header->version != COBALT_PACK_VERSION)
+    {
+        Cobalt_PrimitivePrintf(L"Unsupported pack version %U." NL,
+                               (cobalt_u64_t)header->version);
+        return EFI_UNSUPPORTED;
+    }
+
+    const cobalt_u64_t tableSize =
+        (cobalt_u64_t)header->sectionCount * sizeof(cobalt_pack_section_t);
+    const cobalt_u64_t headerOffset = sizeof(*header) + tableSize;
+    if (headerOffset > fileSize ||
+        header->headerSize > fileSize - headerOffset)
+    {
+        Cobalt_PrimitivePuts(L"Pack headers are out of bounds." NL);
+        return EFI_LOAD_ERROR;
+    }
+
+    EFI_STATUS status = parseHeaders(bytes + headerOffset,
+                                     header->headerSize, 0, image);
+    if (EFI_ERROR(status)) return status;
+    if (image->sectionCount != header->sectionCount)
+    {
+        Cobalt_PrimitivePuts(L"Pack section count mismatches image." NL);
+        return EFI_LOAD_ERROR;
+    }
+
+    const cobalt_pack_section_t *entries =
+        (const cobalt_pack_section_t *)(bytes + sizeof(*header));
+    for (cobalt_u64_t i = 0; i < header->sectionCount; i++)
+    {
+        const cobalt_pack_section_t *entry = &entries[i];
+        const cobalt_u64_t loadSize = sectionLoadSize(&image->sections[i]);
+        if (entry->decompressedSize != loadSize ||
+            entry->offset > fileSize ||
+            entry->compressedSize > fileSize - entry->offset)
+        {
+            Cobalt_PrimitivePrintf(L"Pack section %U is invalid." NL, i);
+            return EFI_LOAD_ERROR;
+        }
+    }
+
+    image->pack = bytes;
+    image->packedSections = entries;
+    return EFI_SUCCESS;
+}
+
+EFI_STATUS Cobalt_ParseImage(const void *file, cobalt_u64_t fileSize,
+                             cobalt_image_t *image)
+{
+    if (fileSize >= sizeof(cobalt_pack_header_t) &&
+        ((const cobalt_pack_header_t *)file)->magicNumber ==
+            COBALT_PACK_MAGIC)
+        return parsePack(file, fileSize, image);
+    return parseHeaders(file, fileSize, fileSize, image);
+}
+
+EFI_STATUS Cobalt_ParseImageHeaders(const void *headers,
+                                    cobalt_u64_t headersSize,
+                                    cobalt_u64_t fileSize,
+                                    cobalt_image_t *image)
+{
+    if (headersSize >= sizeof(cobalt_pack_header_t) &&
+        ((const cobalt_pack_header_t *)headers)->magicNumber ==
+            COBALT_PACK_MAGIC)
+        return EFI_BUFFER_TOO_SMALL;
+
+    // Peek at the header size before parsing, so that a buffer that just
+    // isn't big enough doesn't get reported as a broken image.
+    const cobalt_dos_header_t *dosHeader = headers;
+    if (headersSize >= sizeof(cobalt_dos_header_t))
+    {
+        const cobalt_u64_t headerSizeOffset =
+            (cobalt_u64_t)dosHeader->peHeaderOffset +
+            offsetof(cobalt_pe_header_t, optionalHeader.headerSize);
+        if (headerSizeOffset + sizeof(cobalt_u32_t) > headersSize)
+            return EFI_BUFFER_TOO_SMALL;
+
+        cobalt_u32_t headerSize;
+        __builtin_memcpy(&headerSize,
+                         (const cobalt_u8_t *)headers + headerSizeOffset,
+                         sizeof(headerSize));
+        if (headerSize > headersSize) return EFI_BUFFER_TOO_SMALL;
+    }
+
+    return parseHeaders(headers, headersSize, fileSize, image);
+}
+
+EFI_STATUS Cobalt_LoadImageSections(const cobalt_image_t *image,
+                                    EFI_PHYSICAL_ADDRESS base)
+{
+    Cobalt_CopyMemory((void *)base, image->file,
+                      image->peHeader->optionalHeader.headerSize);
+
+    for (cobalt_u64_t i = 0; i < image->sectionCount; i++)
+    {
+        const cobalt_image_section_header_t *section = &image->sections[i];
+        const cobalt_u64_t loadSize = sectionLoadSize(section);
+        void *destination = (void *)(base + section->VirtualAddress);
+        if (loadSize == 0) continue;
+
+        if (image->packedSections == nullptr)
+        {
+            Cobalt_CopyMemory(destination,
+                              image->file + section->PointerToRawData,
+                              loadSize);
+            continue;
+        }
+
+        const cobalt_pack_section_t *entry = &image->packedSections[i];
+        if (!Cobalt_Decompress(image->pack + entry->offset,
+                               entry->compressedSize, destination,
+                               loadSize))
+        {
+            Cobalt_PrimitivePrintf(
+                L"Failed to decompress image section %U." NL, i);
+            return EFI_VOLUME_CORRUPTED;
+        }
+    }
+
+    return EFI_SUCCESS;
+}
+
+EFI_STATUS Cobalt_BeginImageReads(const cobalt_image_t *image,
+                                  cobalt_efi_file_t *file,
+                                  EFI_BOOT_SERVICES *bootServices,
+                                  EFI_PHYSICAL_ADDRESS base,
+                                  cobalt_image_reads_t *reads)
+{
+    *reads = (cobalt_image_reads_t){0};
+    Cobalt_CopyMemory((void *)base, image->file,
+                      image->peHeader->optionalHeader.headerSize);
+
+    EFI_STATUS status = bootServices->AllocatePool(
+        EfiLoaderData,
+        (image->sectionCount + 1) * sizeof(cobalt_file_request_t),
+        (void **)&reads->requests);
+    if (EFI_ERROR(status))
+    {
+        Cobalt_PrimitivePrintf(
+            L"Failed to allocate section read requests. Code: %U." NL,
+            status);
+        reads->requests = nullptr;
+        return status;
+    }
+
+    for (cobalt_u64_t i = 0; i < image->sectionCount; i++)
+    {
+        const cobalt_image_section_header_t *section = &image->sections[i];
+        const cobalt_u64_t loadSize = sectionLoadSize(section);
+        if (loadSize == 0) continue;
+
+        status = Cobalt_BeginFileRead(
+            file, bootServices, section->PointerToRawData, loadSize,
+            (void *)(base + section->VirtualAddress),
+            &reads->requests[reads->count]);
+        if (EFI_ERROR(status)) return status;
+        reads->count++;
+    }
+
+    return EFI_SUCCESS;
+}
+
+EFI_STATUS Cobalt_FinishImageReads(EFI_BOOT_SERVICES *bootServices,
+                                   cobalt_image_reads_t *reads)
+{
+    // Every read has to be waited on, even after one fails; the firmware
+    // is still writing into the image for the others.
+    EFI_STATUS result = EFI_SUCCESS;
+    for (cobalt_u64_t i = 0; i < reads->count; i++)
+    {
+        EFI_STATUS status =
+            Cobalt_FinishFileRead(bootServices, &reads->requests[i]);
+        if (EFI_ERROR(status) && !EFI_ERROR(result)) result = status;
+    }
+
+    if (reads->requests != nullptr)
+        (void)bootServices->FreePool(reads->requests);
+    *reads = (cobalt_image_reads_t){0};
+    return result;
+}
+
+cobalt_u64_t Cobalt_ZeroImageGaps(const cobalt_image_t *image,
+                                  EFI_PHYSICAL_ADDRESS base,
+                                  cobalt_u64_t size)
+{
+    cobalt_u8_t *const bytes = (cobalt_u8_t *)base;
+
+    // Sections are known to be in order, so everything between the end of
+    // one's data and the start of the next is a gap.
+    cobalt_u64_t cursor = image->peHeader->optionalHeader.headerSize;
+    cobalt_u64_t zeroed = 0;
+    for (cobalt_u64_t i = 0; i < image->sectionCount; i++)
+    {
+        const cobalt_image_section_header_t *section = &image->sections[i];
+        if (section->VirtualAddress > cursor)
+        {
+            Cobalt_ZeroMemory(bytes + cursor,
+                              section->VirtualAddress - cursor);
+            zeroed += section->VirtualAddress - cursor;
+        }
+        cursor = section->VirtualAddress + sectionLoadSize(section);
+    }
+
+    if (size > cursor)
+    {
+        Cobalt_ZeroMemory(bytes + cursor, size - cursor);
+        zeroed += size - cursor;
+    }
+    return zeroed;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file MemoryMap.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the memory map compaction outlined in the
+ * Bootloader/MemoryMap.h file.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <Bootloader/MemoryMap.h>
+
+static cobalt_memory_type_t regionType(UINT32 type)
+{
+    switch (type)
+    {
+        case EfiConventionalMemory: return COBALT_MEMORY_USABLE;
+        case EfiBootServicesCode:
+        case EfiBootServicesData: return COBALT_MEMORY_RECLAIMABLE;
+        case EfiLoaderCode:
+        case EfiLoaderData: return COBALT_MEMORY_LOADER;
+        case EfiACPIReclaimMemory: return COBALT_MEMORY_ACPI_RECLAIMABLE;
+        case EfiACPIMemoryNVS: return COBALT_MEMORY_ACPI_NVS;
+        case EfiRuntimeServicesCode:
+        case EfiRuntimeServicesData: return COBALT_MEMORY_RUNTIME;
+        case EfiMemoryMappedIO:
+        case EfiMemoryMappedIOPortSpace: return COBALT_MEMORY_MMIO;
+        case EfiPersistentMemory: return COBALT_MEMORY_PERSISTENT;
+        case EfiUnusableMemory: return COBALT_MEMORY_UNUSABLE;
+        default: return COBALT_MEMORY_RESERVED;
+    }
+}
+
+cobalt_memory_regions_t
+Cobalt_CompactMemoryMap(const cobalt_memory_map_t *memoryMap)
+{
+    cobalt_memory_region_t *regions =
+        (cobalt_memory_region_t *)memoryMap->map;
+    const cobalt_u64_t descriptorCount =
+        memoryMap->size / memoryMap->descriptorSize;
+
+    // Region i never reaches past the end of descriptor i, so reading
+    // each descriptor out before writing its region is enough to keep
+    // the two from trampling one another.
+    cobalt_u64_t count = 0;
+    for (cobalt_u64_t i = 0; i < descriptorCount; i++)
+    {
+        const EFI_MEMORY_DESCRIPTOR *descriptor =
+            (const EFI_MEMORY_DESCRIPTOR *)((const cobalt_u8_t *)
+                                                memoryMap->map +
+                                            i * memoryMap->descriptorSize);
+        const cobalt_memory_region_t region = {
+            .base = descriptor->PhysicalStart,
+            .pageCount = descriptor->NumberOfPages,
+            .type = regionType(descriptor->Type)};
+        if (region.pageCount != 0) regions[count++] = region;
+    }
+
+    // Firmware almost always hands out a sorted map already, which makes
+    // an insertion sort a single pass in practice.
+    for (cobalt_u64_t i = 1; i < count; i++)
+    {
+        const cobalt_memory_region_t region = regions[i];
+        cobalt_u64_t j = i;
+        for (; j > 0 && regions[j - 1].base > region.base; j--)
+            regions[j] = regions[j - 1];
+        regions[j] = region;
+    }
+
+    cobalt_u64_t merged = 0;
+    for (cobalt_u64_t i = 0; i < count; i++)
+    {
+        if (merged != 0)
+        {
+            cobalt_memory_region_t *last = &regions[merged - 1];
+            if (last->type == regions[i].type &&
+                last->base + (last->pageCount << EFI_PAGE_SHIFT) ==
+                    regions[i].base)
+            {
+                last->pageCount += regions[i].pageCount;
+                continue;
+            }
+        }
+        regions[merged++] = regions[i];
+    }
+
+    return (cobalt_memory_regions_t){merged, regions};
+}
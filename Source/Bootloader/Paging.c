@@ -0,0 +1,388 @@
+/**
+ * @file Paging.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the page table builder outlined in the
+ * Bootloader/Paging.h file.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <Bootloader/EFI/Print.h>
+#include <Bootloader/Paging.h>
+#include <CPU.h>
+#include <Memory.h>
+
+// The feature bits of CPUID leaf 0x80000001's EDX that matter here.
+#define NO_EXECUTE_FEATURE (1U << 20)
+#define GIGABYTE_PAGES_FEATURE (1U << 26)
+
+#define EFER_MSR 0xC0000080
+#define EFER_NO_EXECUTE_ENABLE (1ULL << 11)
+#define CR0_WRITE_PROTECT (1ULL << 16)
+
+// The first 4 GiB are always mapped, memory map or not, since that's
+// where the firmware's tables and the processor's MMIO live.
+#define LOW_MEMORY_SIZE 0x100000000ULL
+
+// Extra tables to reserve on top of the estimate, since the memory map
+// can grow a few entries between the estimate and the final map.
+#define POOL_SLACK 16
+
+// Intermediate entries grant everything, so that a mapping's permissions
+// are decided by its leaf alone.
+#define TABLE_FLAGS (COBALT_PAGE_PRESENT | COBALT_PAGE_WRITABLE)
+#define DIRECT_MAP_FLAGS                                                  \
+    (COBALT_PAGE_PRESENT | COBALT_PAGE_WRITABLE | COBALT_PAGE_LARGE)
+
+static bool processorHas(cobalt_u32_t feature)
+{
+    cobalt_u32_t registers[4];
+    Cobalt_CPUID(0x80000000, 0, registers);
+    if (registers[0] < 0x80000001) return false;
+    Cobalt_CPUID(0x80000001, 0, registers);
+    return (registers[3] & feature) != 0;
+}
+
+static const EFI_MEMORY_DESCRIPTOR *
+descriptorAt(const EFI_MEMORY_DESCRIPTOR *map, cobalt_u64_t descriptorSize,
+             cobalt_u64_t index)
+{
+    return (const EFI_MEMORY_DESCRIPTOR *)((const cobalt_u8_t *)map +
+                                           index * descriptorSize);
+}
+
+static cobalt_u64_t *allocateTable(cobalt_page_tables_t *tables)
+{
+    if (tables->poolUsed == tables->poolPages) return nullptr;
+    cobalt_u64_t *table =
+        (cobalt_u64_t *)(tables->poolBase +
+                         tables->poolUsed++ * COBALT_PAGE_SIZE);
+    Cobalt_ZeroMemory(table, COBALT_PAGE_SIZE);
+    return table;
+}
+
+// Get the table an entry points to, creating it if the entry is empty.
+// The entry must not map a large page.
+static cobalt_u64_t *nextTable(cobalt_page_tables_t *tables,
+                               cobalt_u64_t *entry)
+{
+    if (*entry & COBALT_PAGE_PRESENT)
+        return (cobalt_u64_t *)(*entry & COBALT_PAGE_ADDRESS_MASK);
+
+    cobalt_u64_t *table = allocateTable(tables);
+    if (table != nullptr) *entry = (cobalt_u64_t)table | TABLE_FLAGS;
+    return table;
+}
+
+// Map [start, end) into the direct map, rounded out to 2 MiB. Gigabytes
+// that the range covers entirely, and that nothing has yet split into
+// 2 MiB pages, become a single 1 GiB page.
+static EFI_STATUS mapRange(cobalt_page_tables_t *tables,
+                           cobalt_u64_t start, cobalt_u64_t end,
+                           bool gigabytePages)
+{
+    start &= ~(COBALT_LARGE_PAGE_SIZE - 1);
+    end = (end + COBALT_LARGE_PAGE_SIZE - 1) &
+          ~(COBALT_LARGE_PAGE_SIZE - 1);
+    if (end > COBALT_DIRECT_MAP_SIZE)
+    {
+        Cobalt_PrimitivePrintf(
+            L"Physical memory at %U is past the end of the direct map." NL,
+            end);
+        return EFI_UNSUPPORTED;
+    }
+
+    cobalt_u64_t *root = (cobalt_u64_t *)tables->root;
+    for (cobalt_u64_t address = start; address < end;)
+    {
+        const cobalt_u64_t virtual = address + COBALT_DIRECT_MAP_BASE;
+        cobalt_u64_t *pointerTable =
+            nextTable(tables, &root[Cobalt_PageTableIndex(virtual, 3)]);
+        if (pointerTable == nullptr) return EFI_OUT_OF_RESOURCES;
+
+        cobalt_u64_t *pointerEntry =
+            &pointerTable[Cobalt_PageTableIndex(virtual, 2)];
+        if (gigabytePages && !(*pointerEntry & COBALT_PAGE_PRESENT) &&
+            (address & (COBALT_HUGE_PAGE_SIZE - 1)) == 0 &&
+            end - address >= COBALT_HUGE_PAGE_SIZE)
+        {
+            *pointerEntry = address | DIRECT_MAP_FLAGS;
+            address += COBALT_HUGE_PAGE_SIZE;
+            continue;
+        }
+        if (*pointerEntry & COBALT_PAGE_LARGE)
+        {
+            address = (address | (COBALT_HUGE_PAGE_SIZE - 1)) + 1;
+            continue;
+        }
+
+        cobalt_u64_t *directory = nextTable(tables, pointerEntry);
+        if (directory == nullptr) return EFI_OUT_OF_RESOURCES;
+
+        cobalt_u64_t *entry =
+            &directory[Cobalt_PageTableIndex(virtual, 1)];
+        if (!(*entry & COBALT_PAGE_PRESENT))
+            *entry = address | DIRECT_MAP_FLAGS;
+        address += COBALT_LARGE_PAGE_SIZE;
+    }
+
+    return EFI_SUCCESS;
+}
+
+// Map [start, end) into the direct map, less the hole [holeStart,
+// holeEnd), which must be 2 MiB aligned.
+static EFI_STATUS mapAround(cobalt_page_tables_t *tables,
+                            cobalt_u64_t start, cobalt_u64_t end,
+                            cobalt_u64_t holeStart, cobalt_u64_t holeEnd,
+                            bool gigabytePages)
+{
+    if (holeEnd <= start || holeStart >= end)
+        return mapRange(tables, start, end, gigabytePages);
+
+    EFI_STATUS status = EFI_SUCCESS;
+    if (start < holeStart)
+        status = mapRange(tables, start, holeStart, gigabytePages);
+    if (!EFI_ERROR(status) && holeEnd < end)
+        status = mapRange(tables, holeEnd, end, gigabytePages);
+    return status;
+}
+
+EFI_STATUS Cobalt_ReservePageTables(
+    EFI_BOOT_SERVICES *bootServices, const cobalt_image_t *kernel,
+    const EFI_GRAPHICS_OUTPUT_PROTOCOL_MODE *graphicsMode,
+    cobalt_page_tables_t *tables)
+{
+    UINTN mapSize = 0, mapKey, descriptorSize;
+    UINT32 descriptorVersion;
+    EFI_MEMORY_DESCRIPTOR *map = nullptr;
+    EFI_STATUS status = bootServices->GetMemoryMap(
+        &mapSize, map, &mapKey, &descriptorSize, &descriptorVersion);
+    if (status == EFI_BUFFER_TOO_SMALL)
+    {
+        // Allocating the buffer may itself split a descriptor or two.
+        mapSize += 2 * descriptorSize;
+        status = bootServices->AllocatePool(EfiLoaderData, mapSize,
+                                            (void **)&map);
+        if (!EFI_ERROR(status))
+            status = bootServices->GetMemoryMap(&mapSize, map, &mapKey,
+                                                &descriptorSize,
+                                                &descriptorVersion);
+    }
+    if (EFI_ERROR(status))
+    {
+        if (map != nullptr) bootServices->FreePool(map);
+        Cobalt_PrimitivePrintf(
+            L"Failed to get memory map for page tables. Code: %U." NL,
+            status);
+        return status;
+    }
+
+    const cobalt_u64_t descriptorCount = mapSize / descriptorSize;
+    cobalt_u64_t top = LOW_MEMORY_SIZE;
+    for (cobalt_u64_t i = 0; i < descriptorCount; i++)
+    {
+        const EFI_MEMORY_DESCRIPTOR *descriptor =
+            descriptorAt(map, descriptorSize, i);
+        const cobalt_u64_t end =
+            descriptor->PhysicalStart +
+            (descriptor->NumberOfPages << EFI_PAGE_SHIFT);
+        if (end > top) top = end;
+    }
+    bootServices->FreePool(map);
+
+    const cobalt_u64_t framebufferEnd =
+        graphicsMode->FrameBufferBase + graphicsMode->FrameBufferSize;
+    if (framebufferEnd > top) top = framebufferEnd;
+    if (top > COBALT_DIRECT_MAP_SIZE) top = COBALT_DIRECT_MAP_SIZE;
+
+    // At worst every gigabyte up to the top of memory needs a directory.
+    // With 1 GiB pages, only the partial gigabytes at either end of each
+    // range do, and there are at most two per descriptor, the first 4
+    // GiB, and the hole left for the framebuffer.
+    cobalt_u64_t directories =
+        (top + COBALT_HUGE_PAGE_SIZE - 1) / COBALT_HUGE_PAGE_SIZE;
+    if (processorHas(GIGABYTE_PAGES_FEATURE) &&
+        2 * (descriptorCount + 2) < directories)
+        directories = 2 * (descriptorCount + 2);
+    const cobalt_u64_t pointerTables =
+        (top + COBALT_HUGE_PAGE_SIZE * COBALT_PAGE_TABLE_ENTRIES - 1) /
+        (COBALT_HUGE_PAGE_SIZE * COBALT_PAGE_TABLE_ENTRIES);
+    const cobalt_u64_t kernelTables =
+        2 + (EFI_SIZE_TO_PAGES(kernel->virtualSize) +
+             COBALT_PAGE_TABLE_ENTRIES - 1) /
+                COBALT_PAGE_TABLE_ENTRIES;
+
+    *tables = (cobalt_page_tables_t){0};
+    tables->poolPages =
+        1 + pointerTables + directories + kernelTables + POOL_SLACK;
+    status = bootServices->AllocatePages(AllocateAnyPages, EfiLoaderData,
+                                         tables->poolPages,
+                                         &tables->poolBase);
+    if (EFI_ERROR(status))
+    {
+        Cobalt_PrimitivePrintf(
+            L"Failed to allocate %U pages for page tables. Code: %U." NL,
+            tables->poolPages, status);
+        return status;
+    }
+
+    tables->root = (EFI_PHYSICAL_ADDRESS)allocateTable(tables);
+    return EFI_SUCCESS;
+}
+
+EFI_STATUS Cobalt_MapKernel(cobalt_page_tables_t *tables,
+                            const cobalt_image_t *kernel,
+                            EFI_PHYSICAL_ADDRESS base)
+{
+    if (kernel->virtualSize > COBALT_KERNEL_MAXIMUM_SIZE)
+    {
+        Cobalt_PrimitivePrintf(L"Kernel image size %U is too large." NL,
+                               kernel->virtualSize);
+        return EFI_UNSUPPORTED;
+    }
+
+    const cobalt_u64_t pageCount = EFI_SIZE_TO_PAGES(kernel->virtualSize);
+    const cobalt_u64_t virtual = COBALT_KERNEL_VIRTUAL_BASE;
+    cobalt_u64_t *root = (cobalt_u64_t *)tables->root;
+    cobalt_u64_t *pointerTable =
+        nextTable(tables, &root[Cobalt_PageTableIndex(virtual, 3)]);
+    if (pointerTable == nullptr) return EFI_OUT_OF_RESOURCES;
+    cobalt_u64_t *directory = nextTable(
+        tables, &pointerTable[Cobalt_PageTableIndex(virtual, 2)]);
+    if (directory == nullptr) return EFI_OUT_OF_RESOURCES;
+
+    // Start every page off as read-only data, which covers the headers
+    // and anything between sections, then open pages up section by
+    // section.
+    const cobalt_u64_t noExecute =
+        processorHas(NO_EXECUTE_FEATURE) ? COBALT_PAGE_NO_EXECUTE : 0;
+    cobalt_u64_t *pageTable = nullptr;
+    for (cobalt_u64_t i = 0; i < pageCount; i++)
+    {
+        if (i % COBALT_PAGE_TABLE_ENTRIES == 0)
+        {
+            pageTable = nextTable(
+                tables, &directory[i / COBALT_PAGE_TABLE_ENTRIES]);
+            if (pageTable == nullptr) return EFI_OUT_OF_RESOURCES;
+        }
+        pageTable[i % COBALT_PAGE_TABLE_ENTRIES] =
+            (base + i * COBALT_PAGE_SIZE) | COBALT_PAGE_PRESENT |
+            COBALT_PAGE_GLOBAL | noExecute;
+    }
+
+    for (cobalt_u64_t i = 0; i < kernel->sectionCount; i++)
+    {
+        const cobalt_image_section_header_t *section =
+            &kernel->sections[i];
+        const cobalt_u32_t flags = section->Characteristics;
+        if (!(flags & (COBALT_SECTION_WRITE | COBALT_SECTION_EXECUTE)))
+            continue;
+
+        cobalt_u64_t size = section->Misc.VirtualSize;
+        if (size == 0) size = section->SizeOfRawData;
+        cobalt_u64_t last =
+            EFI_SIZE_TO_PAGES(section->VirtualAddress + size);
+        if (last > pageCount) last = pageCount;
+
+        for (cobalt_u64_t page = section->VirtualAddress >> EFI_PAGE_SHIFT;
+             page < last; page++)
+        {
+            pageTable =
+                (cobalt_u64_t *)(directory[page /
+                                           COBALT_PAGE_TABLE_ENTRIES] &
+                                 COBALT_PAGE_ADDRESS_MASK);
+            cobalt_u64_t *entry =
+                &pageTable[page % COBALT_PAGE_TABLE_ENTRIES];
+            if (flags & COBALT_SECTION_WRITE)
+                *entry |= COBALT_PAGE_WRITABLE;
+            if (flags & COBALT_SECTION_EXECUTE) *entry &= ~noExecute;
+        }
+    }
+
+    return EFI_SUCCESS;
+}
+
+EFI_STATUS Cobalt_MapPhysicalMemory(
+    cobalt_page_tables_t *tables, const cobalt_memory_map_t *memoryMap,
+    const EFI_GRAPHICS_OUTPUT_PROTOCOL_MODE *graphicsMode)
+{
+    // The framebuffer is left out, rounded out to 2 MiB, since the kernel
+    // maps it write-combining, and a second mapping as write-back would
+    // make its memory type undefined. Every range goes around it, or a
+    // later run could fill the hole back in.
+    const bool gigabytePages = processorHas(GIGABYTE_PAGES_FEATURE);
+    const cobalt_u64_t holeStart =
+        graphicsMode->FrameBufferBase & ~(COBALT_LARGE_PAGE_SIZE - 1);
+    const cobalt_u64_t holeEnd =
+        graphicsMode->FrameBufferSize == 0
+            ? holeStart
+            : (graphicsMode->FrameBufferBase +
+               graphicsMode->FrameBufferSize + COBALT_LARGE_PAGE_SIZE -
+               1) & ~(COBALT_LARGE_PAGE_SIZE - 1);
+    EFI_STATUS status = mapAround(tables, 0, LOW_MEMORY_SIZE, holeStart,
+                                  holeEnd, gigabytePages);
+
+    // Firmware usually hands out the map sorted, so neighbouring
+    // descriptors are merged first, letting a gigabyte split across them
+    // still get a single page.
+    cobalt_u64_t runStart = 0, runEnd = 0;
+    const cobalt_u64_t descriptorCount =
+        memoryMap->size / memoryMap->descriptorSize;
+    for (cobalt_u64_t i = 0; i < descriptorCount && !EFI_ERROR(status);
+         i++)
+    {
+        const EFI_MEMORY_DESCRIPTOR *descriptor =
+            descriptorAt(memoryMap->map, memoryMap->descriptorSize, i);
+        const cobalt_u64_t start = descriptor->PhysicalStart;
+        const cobalt_u64_t end =
+            start + (descriptor->NumberOfPages << EFI_PAGE_SHIFT);
+        if (start == runEnd)
+        {
+            runEnd = end;
+            continue;
+        }
+
+        if (runEnd > runStart)
+            status = mapAround(tables, runStart, runEnd, holeStart,
+                               holeEnd, gigabytePages);
+        runStart = start;
+        runEnd = end;
+    }
+    if (!EFI_ERROR(status) && runEnd > runStart)
+        status = mapAround(tables, runStart, runEnd, holeStart, holeEnd,
+                           gigabytePages);
+    if (status == EFI_OUT_OF_RESOURCES)
+        Cobalt_PrimitivePrintf(
+            L"Ran out of memory for page tables after %U pages." NL,
+            tables->poolUsed);
+    if (EFI_ERROR(status)) return status;
+
+    // The identity map shares every table below the PML4 with the direct
+    // map, so it costs nothing but the top-level entries.
+    cobalt_u64_t *root = (cobalt_u64_t *)tables->root;
+    const cobalt_u64_t directMapIndex =
+        Cobalt_PageTableIndex(COBALT_DIRECT_MAP_BASE, 3);
+    for (cobalt_u64_t i = 0;
+         i < COBALT_DIRECT_MAP_SIZE /
+                 (COBALT_HUGE_PAGE_SIZE * COBALT_PAGE_TABLE_ENTRIES);
+         i++)
+        root[i] = root[directMapIndex + i];
+
+    return EFI_SUCCESS;
+}
+
+void Cobalt_EnablePageTables(const cobalt_page_tables_t *tables)
+{
+    // The no-execute bit is reserved until EFER.NXE is set, so this must
+    // come before the tables that use it are loaded.
+    if (processorHas(NO_EXECUTE_FEATURE))
+        Cobalt_WriteMSR(EFER_MSR,
+                        Cobalt_ReadMSR(EFER_MSR) | EFER_NO_EXECUTE_ENABLE);
+    Cobalt_WriteCR0(Cobalt_ReadCR0() | CR0_WRITE_PROTECT);
+    Cobalt_WriteCR3(tables->root);
+}
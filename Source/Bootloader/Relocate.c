@@ -0,0 +1,126 @@
+/**
+ * @file Relocate.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the base relocation engine outlined in the
+ * Relocate.h file. For the table format, see the PE format reference in
+ * CREDITS and go to the ".reloc section" subsection.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <Bootloader/Relocate.h>
+
+// Fields to fix up carry no alignment guarantee, so they're loaded and
+// stored through memcpy, which the compiler lowers to plain moves.
+#define ADD_FIELD(type, field, value)                                     \
+    do {                                                                  \
+        type fieldValue;                                                  \
+        __builtin_memcpy(&fieldValue, (field), sizeof(type));             \
+        fieldValue += (type)(value);                                      \
+        __builtin_memcpy((field), &fieldValue, sizeof(type));             \
+    } while (0)
+
+static cobalt_relocate_status_t outOfBounds(cobalt_u64_t *failureOffset,
+                                            cobalt_u64_t entryOffset)
+{
+    *failureOffset = entryOffset;
+    return COBALT_RELOCATE_ENTRY_OUT_OF_BOUNDS;
+}
+
+cobalt_relocate_status_t Cobalt_Relocate(cobalt_u8_t *image,
+                                         cobalt_u64_t imageSize,
+                                         cobalt_u32_t tableOffset,
+                                         cobalt_u32_t tableSize,
+                                         cobalt_i64_t delta,
+                                         cobalt_u64_t *failureOffset)
+{
+    if (tableOffset > imageSize || tableSize > imageSize - tableOffset)
+    {
+        *failureOffset = 0;
+        return COBALT_RELOCATE_TABLE_OUT_OF_BOUNDS;
+    }
+    // An image loaded at its preferred base needs no fixing up at all.
+    if (delta == 0) return COBALT_RELOCATE_SUCCESS;
+
+    // Two's complement addition handles a negative delta for free.
+    const cobalt_u64_t addend = (cobalt_u64_t)delta;
+    const cobalt_u8_t *const table = image + tableOffset;
+
+    cobalt_u64_t blockOffset = 0;
+    while (tableSize - blockOffset >=
+           sizeof(cobalt_image_base_relocation_t))
+    {
+        const cobalt_image_base_relocation_t *block =
+            (const cobalt_image_base_relocation_t *)(table + blockOffset);
+        const cobalt_u64_t blockSize = block->SizeOfBlock;
+        // Linkers are free to pad the end of the table with zeroes.
+        if (blockSize == 0) break;
+        if (blockSize < sizeof(*block) || (blockSize & 1) != 0 ||
+            blockSize > tableSize - blockOffset)
+        {
+            *failureOffset = blockOffset;
+            return COBALT_RELOCATE_MALFORMED_BLOCK;
+        }
+
+        // Work out how far into the image each field of this block may
+        // reach once, rather than per entry.
+        const cobalt_u64_t pageAddress = block->VirtualAddress;
+        const cobalt_u64_t pageLimit =
+            pageAddress < imageSize ? imageSize - pageAddress : 0;
+        cobalt_u8_t *const page = image + pageAddress;
+        // Any field of a page that lies wholly inside the image is too.
+        const bool inside = pageLimit >= 0xFFF + sizeof(cobalt_u64_t);
+
+        const cobalt_u8_t *const end = table + blockOffset + blockSize;
+        for (const cobalt_u8_t *cursor = (const cobalt_u8_t *)(block + 1);
+             cursor < end; cursor += 2)
+        {
+            // The table is little-endian, as is everything we run on.
+            cobalt_u16_t entry;
+            __builtin_memcpy(&entry, cursor, sizeof(entry));
+            const cobalt_u64_t offset = entry & 0xFFF;
+            cobalt_u8_t *const field = page + offset;
+
+            // Nearly every entry of a 64-bit image is DIR64, so it's
+            // tested for first, and the bounds are only checked for pages
+            // that run off the end of the image.
+            const cobalt_u32_t type = entry >> 12;
+            if (type == COBALT_RELOCATION_DIR64)
+            {
+                if (!inside && offset + 8 > pageLimit)
+                    return outOfBounds(failureOffset, cursor - table);
+                ADD_FIELD(cobalt_u64_t, field, addend);
+            }
+            else if (type == COBALT_RELOCATION_ABSOLUTE) continue;
+            else if (type == COBALT_RELOCATION_HIGHLOW)
+            {
+                if (offset + 4 > pageLimit)
+                    return outOfBounds(failureOffset, cursor - table);
+                ADD_FIELD(cobalt_u32_t, field, addend);
+            }
+            else if (type == COBALT_RELOCATION_HIGH ||
+                     type == COBALT_RELOCATION_LOW)
+            {
+                if (offset + 2 > pageLimit)
+                    return outOfBounds(failureOffset, cursor - table);
+                ADD_FIELD(cobalt_u16_t, field,
+                          type == COBALT_RELOCATION_HIGH ? addend >> 16
+                                                         : addend);
+            }
+            else
+            {
+                *failureOffset = cursor - table;
+                return COBALT_RELOCATE_UNKNOWN_TYPE;
+            }
+        }
+
+        blockOffset += blockSize;
+    }
+
+    return COBALT_RELOCATE_SUCCESS;
+}
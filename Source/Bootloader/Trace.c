@@ -0,0 +1,110 @@
+/**
+ * @file Trace.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the boot trace recorder outlined in the
+ * Bootloader/Trace.h file.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <Bootloader/Trace.h>
+#include <CPU.h>
+
+cobalt_trace_t cobalt_bootTrace;
+
+static cobalt_u64_t measureTimestampRate(EFI_BOOT_SERVICES *services)
+{
+    cobalt_u32_t registers[4];
+    Cobalt_CPUID(0, 0, registers);
+    const cobalt_u32_t maximumLeaf = registers[0];
+
+    // Leaf 0x15 gives the TSC as a ratio of the core crystal clock, when
+    // the processor bothers to report the crystal's frequency.
+    if (maximumLeaf >= 0x15)
+    {
+        Cobalt_CPUID(0x15, 0, registers);
+        if (registers[0] != 0 && registers[1] != 0 && registers[2] != 0)
+            return (cobalt_u64_t)registers[2] * registers[1] /
+                   registers[0] / 1000000;
+    }
+
+    // Leaf 0x16 gives the base frequency in MHz, which is the TSC rate on
+    // every processor with an invariant TSC.
+    if (maximumLeaf >= 0x16)
+    {
+        Cobalt_CPUID(0x16, 0, registers);
+        if (registers[0] != 0) return registers[0];
+    }
+
+    const cobalt_u64_t start = Cobalt_ReadTimestamp();
+    services->Stall(1000);
+    const cobalt_u64_t rate = (Cobalt_ReadTimestamp() - start) / 1000;
+    return rate != 0 ? rate : 1;
+}
+
+void Cobalt_TraceInitialize(EFI_BOOT_SERVICES *services)
+{
+    cobalt_bootTrace.count = 0;
+    cobalt_bootTrace.dropped = 0;
+    cobalt_bootTrace.counterCount = 0;
+    cobalt_bootTrace.ticksPerMicrosecond = measureTimestampRate(services);
+}
+
+static void copyName(char *destination, const char *name)
+{
+    cobalt_u64_t i = 0;
+    for (; i < COBALT_TRACE_NAME_LENGTH - 1 && name[i] != 0; i++)
+        destination[i] = name[i];
+    destination[i] = 0;
+}
+
+cobalt_u32_t Cobalt_TraceBegin(const char *name)
+{
+    if (cobalt_bootTrace.count == COBALT_TRACE_CAPACITY)
+    {
+        cobalt_bootTrace.dropped++;
+        return COBALT_TRACE_CAPACITY;
+    }
+
+    cobalt_trace_event_t *event =
+        &cobalt_bootTrace.events[cobalt_bootTrace.count];
+    copyName(event->name, name);
+    event->end = 0;
+    event->start = Cobalt_ReadTimestamp();
+    return cobalt_bootTrace.count++;
+}
+
+void Cobalt_TraceEnd(cobalt_u32_t event)
+{
+    if (event >= cobalt_bootTrace.count) return;
+    cobalt_bootTrace.events[event].end = Cobalt_ReadTimestamp();
+}
+
+cobalt_u64_t Cobalt_TraceMicroseconds(cobalt_u32_t event)
+{
+    if (event >= cobalt_bootTrace.count) return 0;
+    const cobalt_trace_event_t *traced = &cobalt_bootTrace.events[event];
+    if (traced->end == 0) return 0;
+    return (traced->end - traced->start) /
+           cobalt_bootTrace.ticksPerMicrosecond;
+}
+
+void Cobalt_TraceCounter(const char *name, cobalt_u64_t value)
+{
+    if (cobalt_bootTrace.counterCount == COBALT_TRACE_COUNTER_CAPACITY)
+    {
+        cobalt_bootTrace.dropped++;
+        return;
+    }
+
+    cobalt_trace_counter_t *counter =
+        &cobalt_bootTrace.counters[cobalt_bootTrace.counterCount++];
+    copyName(counter->name, name);
+    counter->value = value;
+    counter->timestamp = Cobalt_ReadTimestamp();
+}
@@ -0,0 +1,285 @@
+/**
+ * @file Blit.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the scalar drawing primitives outlined in
+ * the Blit.h file, along with the clipping, the choice of path, and the
+ * benchmark. The vector paths live in BlitSIMD.c.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <Blit.h>
+#include <CPU.h>
+#include <Memory.h>
+
+// The compiler recognizes fill loops and replaces them with calls to
+// memset, which the bootloader doesn't have.
+#define NO_LIBRARY_CALLS                                                  \
+    __attribute__((optimize("no-tree-loop-distribute-patterns")))
+
+#define BENCHMARK_PIXELS                                                  \
+    (COBALT_BLIT_BENCHMARK_SIZE * COBALT_BLIT_BENCHMARK_SIZE)
+#define BENCHMARK_ROUNDS 16
+
+typedef void (*fill_t)(cobalt_u32_t *destination, cobalt_u32_t pixel,
+                       cobalt_u64_t count);
+typedef void (*copy_t)(cobalt_u32_t *destination,
+                       const cobalt_u32_t *source, cobalt_u64_t count);
+
+// The primitives of each path, indexed by cobalt_blit_path_t.
+static const fill_t fills[COBALT_BLIT_PATH_COUNT] = {
+    Cobalt_FillPixels, Cobalt_FillPixelsSSE2, Cobalt_FillPixelsAVX2};
+static const copy_t copies[COBALT_BLIT_PATH_COUNT] = {
+    Cobalt_CopyPixels, Cobalt_CopyPixelsSSE2, Cobalt_CopyPixelsAVX2};
+static const copy_t blends[COBALT_BLIT_PATH_COUNT] = {
+    Cobalt_BlendPixels, Cobalt_BlendPixelsSSE2, Cobalt_BlendPixelsAVX2};
+static const copy_t converts[COBALT_BLIT_PATH_COUNT] = {
+    Cobalt_ConvertPixels, Cobalt_ConvertPixelsSSE2,
+    Cobalt_ConvertPixelsAVX2};
+
+static cobalt_blit_path_t path = COBALT_BLIT_SCALAR;
+
+bool Cobalt_BlitPathSupported(cobalt_blit_path_t candidate)
+{
+    // Every x86_64 processor has SSE2.
+    if (candidate != COBALT_BLIT_AVX2) return candidate < COBALT_BLIT_AVX2;
+
+    cobalt_u32_t registers[4];
+    Cobalt_CPUID(0, 0, registers);
+    if (registers[0] < 7) return false;
+
+    // AVX2 is CPUID.7.0:EBX[5], but it's only usable once the operating
+    // system has set OSXSAVE (CPUID.1:ECX[27]) and turned on both the SSE
+    // and AVX state in XCR0.
+    Cobalt_CPUID(7, 0, registers);
+    if (!(registers[1] & (1 << 5))) return false;
+    Cobalt_CPUID(1, 0, registers);
+    if (!(registers[2] & (1 << 27)) || !(registers[2] & (1 << 28)))
+        return false;
+    return (Cobalt_ReadXCR0() & 6) == 6;
+}
+
+cobalt_blit_path_t Cobalt_SelectBlitPath(void)
+{
+    path = Cobalt_BlitPathSupported(COBALT_BLIT_AVX2) ? COBALT_BLIT_AVX2
+                                                      : COBALT_BLIT_SSE2;
+    return path;
+}
+
+void Cobalt_SetBlitPath(cobalt_blit_path_t selected) { path = selected; }
+
+NO_LIBRARY_CALLS void Cobalt_FillPixels(cobalt_u32_t *destination,
+                                        cobalt_u32_t pixel,
+                                        cobalt_u64_t count)
+{
+    // Two pixels to a store.
+    const cobalt_u64_t pair = (cobalt_u64_t)pixel << 32 | pixel;
+    for (cobalt_u64_t i = 0; i + 2 <= count; i += 2)
+        __builtin_memcpy(destination + i, &pair, sizeof(pair));
+    if (count & 1) destination[count - 1] = pixel;
+}
+
+void Cobalt_CopyPixels(cobalt_u32_t *destination,
+                       const cobalt_u32_t *source, cobalt_u64_t count)
+{
+    Cobalt_MoveMemory(destination, source, count * sizeof(cobalt_u32_t));
+}
+
+// Mix two pixels by the top byte of the first. Each pair of channels is
+// worked on at once, a sixteen-bit lane apiece; x * 257 + 257 >> 16 is
+// x / 255 rounded, for every x this can produce. The vector paths do
+// exactly the same arithmetic.
+static inline cobalt_u32_t blend(cobalt_u32_t source,
+                                 cobalt_u32_t destination)
+{
+    const cobalt_u32_t alpha = source >> 24;
+    const cobalt_u32_t inverse = 255 - alpha;
+
+    cobalt_u32_t rb = (source & 0x00FF00FF) * alpha +
+                      (destination & 0x00FF00FF) * inverse + 0x00800080;
+    cobalt_u32_t ga = ((source >> 8) & 0x00FF00FF) * alpha +
+                      ((destination >> 8) & 0x00FF00FF) * inverse +
+                      0x00800080;
+    rb = ((rb + ((rb >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+    ga = ((ga + ((ga >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+    return rb | ga << 8;
+}
+
+void Cobalt_BlendPixels(cobalt_u32_t *destination,
+                        const cobalt_u32_t *source, cobalt_u64_t count)
+{
+    for (cobalt_u64_t i = 0; i < count; i++)
+        destination[i] = blend(source[i], destination[i]);
+}
+
+void Cobalt_ConvertPixels(cobalt_u32_t *destination,
+                          const cobalt_u32_t *source, cobalt_u64_t count)
+{
+    for (cobalt_u64_t i = 0; i < count; i++)
+    {
+        const cobalt_u32_t pixel = source[i];
+        destination[i] = (pixel & 0xFF00FF00) | ((pixel >> 16) & 0xFF) |
+                         ((pixel & 0xFF) << 16);
+    }
+}
+
+// Shrink a length so that it fits on a surface from an offset, along one
+// axis.
+static cobalt_u64_t clip(cobalt_u64_t offset, cobalt_u64_t length,
+                         cobalt_u64_t limit)
+{
+    if (offset >= limit) return 0;
+    return length < limit - offset ? length : limit - offset;
+}
+
+void Cobalt_FillRect(const cobalt_surface_t *surface, cobalt_u64_t x,
+                     cobalt_u64_t y, cobalt_u64_t width,
+                     cobalt_u64_t height, cobalt_u32_t pixel)
+{
+    width = clip(x, width, surface->width);
+    height = clip(y, height, surface->height);
+    if (width == 0) return;
+
+    const fill_t fill = fills[path];
+    cobalt_u32_t *row = surface->pixels + y * surface->pitch + x;
+    for (cobalt_u64_t i = 0; i < height; i++, row += surface->pitch)
+        fill(row, pixel, width);
+}
+
+// Run a primitive over each row of a rectangle in two surfaces, clipped
+// to both. The rows go bottom up if the destination's rows start past
+// the source's, so that a copy within one surface never reads a row it's
+// already written.
+static void eachRow(copy_t operation, const cobalt_surface_t *destination,
+                    cobalt_u64_t x, cobalt_u64_t y,
+                    const cobalt_surface_t *source, cobalt_u64_t sourceX,
+                    cobalt_u64_t sourceY, cobalt_u64_t width,
+                    cobalt_u64_t height)
+{
+    width = clip(sourceX, clip(x, width, destination->width),
+                 source->width);
+    height = clip(sourceY, clip(y, height, destination->height),
+                  source->height);
+    if (width == 0 || height == 0) return;
+
+    cobalt_u32_t *to = destination->pixels + y * destination->pitch + x;
+    const cobalt_u32_t *from =
+        source->pixels + sourceY * source->pitch + sourceX;
+    if (to <= from)
+    {
+        for (cobalt_u64_t i = 0; i < height; i++)
+            operation(to + i * destination->pitch,
+                      from + i * source->pitch, width);
+        return;
+    }
+
+    for (cobalt_u64_t i = height; i-- > 0;)
+        operation(to + i * destination->pitch, from + i * source->pitch,
+                  width);
+}
+
+void Cobalt_CopyRect(const cobalt_surface_t *destination, cobalt_u64_t x,
+                     cobalt_u64_t y, const cobalt_surface_t *source,
+                     cobalt_u64_t sourceX, cobalt_u64_t sourceY,
+                     cobalt_u64_t width, cobalt_u64_t height)
+{
+    eachRow(copies[path], destination, x, y, source, sourceX, sourceY,
+            width, height);
+}
+
+void Cobalt_BlendRect(const cobalt_surface_t *destination, cobalt_u64_t x,
+                      cobalt_u64_t y, const cobalt_surface_t *source,
+                      cobalt_u64_t sourceX, cobalt_u64_t sourceY,
+                      cobalt_u64_t width, cobalt_u64_t height)
+{
+    eachRow(blends[path], destination, x, y, source, sourceX, sourceY,
+            width, height);
+}
+
+void Cobalt_ConvertRect(const cobalt_surface_t *destination,
+                        cobalt_u64_t x, cobalt_u64_t y,
+                        const cobalt_surface_t *source,
+                        cobalt_u64_t sourceX, cobalt_u64_t sourceY,
+                        cobalt_u64_t width, cobalt_u64_t height)
+{
+    eachRow(converts[path], destination, x, y, source, sourceX, sourceY,
+            width, height);
+}
+
+// Run one primitive over the benchmark's surfaces, and give back the
+// ticks it took.
+static cobalt_u64_t timeOperation(cobalt_blit_operation_t operation,
+                                  const cobalt_surface_t *target,
+                                  const cobalt_surface_t *source)
+{
+    const cobalt_u64_t size = COBALT_BLIT_BENCHMARK_SIZE;
+    const cobalt_u64_t start = Cobalt_ReadTimestamp();
+    for (cobalt_u32_t round = 0; round < BENCHMARK_ROUNDS; round++)
+        switch (operation)
+        {
+            case COBALT_BLIT_FILL:
+                Cobalt_FillRect(target, 0, 0, size, size, round);
+                break;
+            // Down and to the right by a pixel, so that the rectangles
+            // overlap and each row has to be copied backward.
+            case COBALT_BLIT_COPY:
+                Cobalt_CopyRect(target, 1, 1, target, 0, 0, size - 1,
+                                size - 1);
+                break;
+            case COBALT_BLIT_BLEND:
+                Cobalt_BlendRect(target, 0, 0, source, 0, 0, size, size);
+                break;
+            default:
+                Cobalt_ConvertRect(target, 0, 0, source, 0, 0, size,
+                                   size);
+                break;
+        }
+    return Cobalt_ReadTimestamp() - start;
+}
+
+void Cobalt_BenchmarkBlit(
+    cobalt_u32_t *scratch, cobalt_u64_t ticksPerMicrosecond,
+    cobalt_u64_t results[COBALT_BLIT_OPERATION_COUNT]
+                        [COBALT_BLIT_PATH_COUNT])
+{
+    const cobalt_surface_t target = {scratch, COBALT_BLIT_BENCHMARK_SIZE,
+                                     COBALT_BLIT_BENCHMARK_SIZE,
+                                     COBALT_BLIT_BENCHMARK_SIZE};
+    const cobalt_surface_t source = {
+        scratch + BENCHMARK_PIXELS, COBALT_BLIT_BENCHMARK_SIZE,
+        COBALT_BLIT_BENCHMARK_SIZE, COBALT_BLIT_BENCHMARK_SIZE};
+
+    // Every alpha turns up in the source, so the blend can't take any
+    // shortcuts.
+    for (cobalt_u64_t i = 0; i < BENCHMARK_PIXELS; i++)
+    {
+        scratch[i] = (cobalt_u32_t)i * 0x9E3779B9;
+        source.pixels[i] = (cobalt_u32_t)i * 0x01030507;
+    }
+
+    const cobalt_blit_path_t previous = path;
+    const cobalt_u64_t pixels = BENCHMARK_PIXELS * BENCHMARK_ROUNDS;
+    for (cobalt_u32_t candidate = 0; candidate < COBALT_BLIT_PATH_COUNT;
+         candidate++)
+    {
+        const bool supported = Cobalt_BlitPathSupported(candidate);
+        path = candidate;
+        for (cobalt_u32_t operation = 0;
+             operation < COBALT_BLIT_OPERATION_COUNT; operation++)
+        {
+            results[operation][candidate] = 0;
+            if (!supported) continue;
+            // Pixels per microsecond are megapixels per second.
+            const cobalt_u64_t ticks =
+                timeOperation(operation, &target, &source);
+            results[operation][candidate] =
+                pixels * ticksPerMicrosecond / (ticks + 1);
+        }
+    }
+    path = previous;
+}
@@ -0,0 +1,248 @@
+/**
+ * @file BlitSIMD.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the SSE2 and AVX2 drawing primitives
+ * outlined in the Blit.h file. This is the one file built with vector
+ * registers enabled; the AVX2 functions turn on AVX2 for
+ * themselves alone, so nothing else here can stray into it.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <Blit.h>
+
+#define AVX2 __attribute__((target("avx2")))
+
+// The intrinsic headers drag in the C library's allocator, which we don't
+// have, so spell the vector types by hand: pixels, and the sixteen-bit
+// lanes the blend works in.
+typedef cobalt_u32_t pixels4_t __attribute__((vector_size(16)));
+typedef cobalt_u16_t lanes8_t __attribute__((vector_size(16)));
+typedef cobalt_u32_t pixels8_t __attribute__((vector_size(32)));
+typedef cobalt_u16_t lanes16_t __attribute__((vector_size(32)));
+
+static inline pixels4_t load4(const cobalt_u32_t *source)
+{
+    pixels4_t vector;
+    __builtin_memcpy(&vector, source, sizeof(vector));
+    return vector;
+}
+
+static inline void store4(cobalt_u32_t *destination, pixels4_t vector)
+{
+    __builtin_memcpy(destination, &vector, sizeof(vector));
+}
+
+AVX2 static inline pixels8_t load8(const cobalt_u32_t *source)
+{
+    pixels8_t vector;
+    __builtin_memcpy(&vector, source, sizeof(vector));
+    return vector;
+}
+
+AVX2 static inline void store8(cobalt_u32_t *destination,
+                               pixels8_t vector)
+{
+    __builtin_memcpy(destination, &vector, sizeof(vector));
+}
+
+// The arithmetic is the scalar path's, written once for both widths. The
+// channel pairs are split into sixteen-bit lanes, mixed, rounded, and put
+// back together; see Blit.c.
+#define DEFINE_BLEND(name, pixels_t, lanes_t)                             \
+    static inline pixels_t name(pixels_t source, pixels_t destination)    \
+    {                                                                     \
+        const pixels_t alpha = source >> 24;                              \
+        const lanes_t weight = (lanes_t)(alpha | alpha << 16);            \
+        const lanes_t inverse = 255 - weight;                             \
+        lanes_t rb = (lanes_t)(source & 0x00FF00FF) * weight +            \
+                     (lanes_t)(destination & 0x00FF00FF) * inverse + 128; \
+        lanes_t ga = (lanes_t)(source >> 8 & 0x00FF00FF) * weight +       \
+                     (lanes_t)(destination >> 8 & 0x00FF00FF) *          \
+                         inverse +                                        \
+                     128;                                                 \
+        rb = (rb + (rb >> 8)) >> 8;                                       \
+        ga = (ga + (ga >> 8)) >> 8;                                       \
+        return (pixels_t)rb | (pixels_t)ga << 8;                          \
+    }
+
+#define DEFINE_CONVERT(name, pixels_t)                                    \
+    static inline pixels_t name(pixels_t pixel)                           \
+    {                                                                     \
+        return (pixel & 0xFF00FF00) | (pixel >> 16 & 0xFF) |              \
+               (pixel & 0xFF) << 16;                                      \
+    }
+
+DEFINE_BLEND(blend4, pixels4_t, lanes8_t)
+DEFINE_CONVERT(convert4, pixels4_t)
+AVX2 DEFINE_BLEND(blend8, pixels8_t, lanes16_t)
+AVX2 DEFINE_CONVERT(convert8, pixels8_t)
+
+void Cobalt_FillPixelsSSE2(cobalt_u32_t *destination, cobalt_u32_t pixel,
+                           cobalt_u64_t count)
+{
+    const pixels4_t vector = {pixel, pixel, pixel, pixel};
+    cobalt_u64_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        store4(destination + i, vector);
+        store4(destination + i + 4, vector);
+        store4(destination + i + 8, vector);
+        store4(destination + i + 12, vector);
+    }
+    for (; i + 4 <= count; i += 4) store4(destination + i, vector);
+    Cobalt_FillPixels(destination + i, pixel, count - i);
+}
+
+// Every vector of a block is loaded before any is stored, so a block
+// never reads what it's just written, and the direction takes care of
+// the blocks after it.
+void Cobalt_CopyPixelsSSE2(cobalt_u32_t *destination,
+                           const cobalt_u32_t *source, cobalt_u64_t count)
+{
+    if (destination <= source || destination >= source + count)
+    {
+        cobalt_u64_t i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            const pixels4_t a = load4(source + i);
+            const pixels4_t b = load4(source + i + 4);
+            const pixels4_t c = load4(source + i + 8);
+            const pixels4_t d = load4(source + i + 12);
+            store4(destination + i, a);
+            store4(destination + i + 4, b);
+            store4(destination + i + 8, c);
+            store4(destination + i + 12, d);
+        }
+        for (; i + 4 <= count; i += 4)
+            store4(destination + i, load4(source + i));
+        Cobalt_CopyPixels(destination + i, source + i, count - i);
+        return;
+    }
+
+    cobalt_u64_t i = count;
+    for (; i >= 16; i -= 16)
+    {
+        const pixels4_t a = load4(source + i - 16);
+        const pixels4_t b = load4(source + i - 12);
+        const pixels4_t c = load4(source + i - 8);
+        const pixels4_t d = load4(source + i - 4);
+        store4(destination + i - 16, a);
+        store4(destination + i - 12, b);
+        store4(destination + i - 8, c);
+        store4(destination + i - 4, d);
+    }
+    for (; i >= 4; i -= 4)
+        store4(destination + i - 4, load4(source + i - 4));
+    Cobalt_CopyPixels(destination, source, i);
+}
+
+void Cobalt_BlendPixelsSSE2(cobalt_u32_t *destination,
+                            const cobalt_u32_t *source, cobalt_u64_t count)
+{
+    cobalt_u64_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const pixels4_t from = load4(source + i);
+        const pixels4_t to = load4(destination + i);
+        store4(destination + i, blend4(from, to));
+    }
+    Cobalt_BlendPixels(destination + i, source + i, count - i);
+}
+
+void Cobalt_ConvertPixelsSSE2(cobalt_u32_t *destination,
+                              const cobalt_u32_t *source,
+                              cobalt_u64_t count)
+{
+    cobalt_u64_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        store4(destination + i, convert4(load4(source + i)));
+    Cobalt_ConvertPixels(destination + i, source + i, count - i);
+}
+
+AVX2 void Cobalt_FillPixelsAVX2(cobalt_u32_t *destination,
+                                cobalt_u32_t pixel, cobalt_u64_t count)
+{
+    const pixels8_t vector = {pixel, pixel, pixel, pixel,
+                              pixel, pixel, pixel, pixel};
+    cobalt_u64_t i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        store8(destination + i, vector);
+        store8(destination + i + 8, vector);
+        store8(destination + i + 16, vector);
+        store8(destination + i + 24, vector);
+    }
+    for (; i + 8 <= count; i += 8) store8(destination + i, vector);
+    Cobalt_FillPixels(destination + i, pixel, count - i);
+}
+
+AVX2 void Cobalt_CopyPixelsAVX2(cobalt_u32_t *destination,
+                                const cobalt_u32_t *source,
+                                cobalt_u64_t count)
+{
+    if (destination <= source || destination >= source + count)
+    {
+        cobalt_u64_t i = 0;
+        for (; i + 32 <= count; i += 32)
+        {
+            const pixels8_t a = load8(source + i);
+            const pixels8_t b = load8(source + i + 8);
+            const pixels8_t c = load8(source + i + 16);
+            const pixels8_t d = load8(source + i + 24);
+            store8(destination + i, a);
+            store8(destination + i + 8, b);
+            store8(destination + i + 16, c);
+            store8(destination + i + 24, d);
+        }
+        for (; i + 8 <= count; i += 8)
+            store8(destination + i, load8(source + i));
+        Cobalt_CopyPixels(destination + i, source + i, count - i);
+        return;
+    }
+
+    cobalt_u64_t i = count;
+    for (; i >= 32; i -= 32)
+    {
+        const pixels8_t a = load8(source + i - 32);
+        const pixels8_t b = load8(source + i - 24);
+        const pixels8_t c = load8(source + i - 16);
+        const pixels8_t d = load8(source + i - 8);
+        store8(destination + i - 32, a);
+        store8(destination + i - 24, b);
+        store8(destination + i - 16, c);
+        store8(destination + i - 8, d);
+    }
+    for (; i >= 8; i -= 8)
+        store8(destination + i - 8, load8(source + i - 8));
+    Cobalt_CopyPixels(destination, source, i);
+}
+
+AVX2 void Cobalt_BlendPixelsAVX2(cobalt_u32_t *destination,
+                                 const cobalt_u32_t *source,
+                                 cobalt_u64_t count)
+{
+    cobalt_u64_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const pixels8_t from = load8(source + i);
+        const pixels8_t to = load8(destination + i);
+        store8(destination + i, blend8(from, to));
+    }
+    Cobalt_BlendPixels(destination + i, source + i, count - i);
+}
+
+AVX2 void Cobalt_ConvertPixelsAVX2(cobalt_u32_t *destination,
+                                   const cobalt_u32_t *source,
+                                   cobalt_u64_t count)
+{
+    cobalt_u64_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        store8(destination + i, convert8(load8(source + i)));
+    Cobalt_ConvertPixels(destination + i, source + i, count - i);
+}
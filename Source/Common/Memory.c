@@ -0,0 +1,304 @@
+/**
+ * @file Memory.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the general purpose memory primitives
+ * outlined in the Memory.h file, along with the handful of C library
+ * symbols the compiler expects to exist even in freestanding code.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <CPU.h>
+#include <Memory.h>
+
+// The compiler recognizes fill and copy loops and replaces them with calls
+// to memset and memcpy, which would recurse straight back in here.
+#define NO_LIBRARY_CALLS                                                  \
+    __attribute__((optimize("no-tree-loop-distribute-patterns")))
+
+// Below this size the startup cost of a string instruction outweighs its
+// throughput, and a few word moves win.
+#define SMALL_SIZE 64
+
+static inline cobalt_u64_t loadWord(const cobalt_u8_t *source)
+{
+    cobalt_u64_t word;
+    __builtin_memcpy(&word, source, sizeof(word));
+    return word;
+}
+
+static inline void storeWord(cobalt_u8_t *destination, cobalt_u64_t word)
+{
+    __builtin_memcpy(destination, &word, sizeof(word));
+}
+
+// Whether the processor has enhanced rep movsb/stosb (CPUID.7.0:EBX[9]),
+// under which byte string instructions move whole cache lines at a time.
+static bool hasFastStrings(void)
+{
+    static int fastStrings = -1;
+    if (fastStrings < 0)
+    {
+        cobalt_u32_t registers[4];
+        Cobalt_CPUID(0, 0, registers);
+        fastStrings = 0;
+        if (registers[0] >= 7)
+        {
+            Cobalt_CPUID(7, 0, registers);
+            fastStrings = (registers[1] >> 9) & 1;
+        }
+    }
+    return fastStrings;
+}
+
+NO_LIBRARY_CALLS static void setNonTemporal(cobalt_u8_t *destination,
+                                            cobalt_u64_t pattern,
+                                            size_t size)
+{
+    cobalt_u8_t *const end = destination + size;
+
+    // Write-combining only pays off for whole cache lines, so ordinary
+    // stores run up to the first line boundary (overshooting it by a few
+    // bytes is harmless, since they're all the same value).
+    cobalt_u8_t *cursor =
+        (cobalt_u8_t *)(((cobalt_u64_t)destination + 63) & ~63UL);
+    for (cobalt_u8_t *head = destination; head < cursor; head += 8)
+        storeWord(head, pattern);
+
+    for (; cursor + 64 <= end; cursor += 64)
+        __asm__ volatile("movnti %1, 0(%0)\n\t"
+                         "movnti %1, 8(%0)\n\t"
+                         "movnti %1, 16(%0)\n\t"
+                         "movnti %1, 24(%0)\n\t"
+                         "movnti %1, 32(%0)\n\t"
+                         "movnti %1, 40(%0)\n\t"
+                         "movnti %1, 48(%0)\n\t"
+                         "movnti %1, 56(%0)"
+                         :
+                         : "r"(cursor), "r"(pattern)
+                         : "memory");
+    for (; cursor + 8 <= end; cursor += 8) storeWord(cursor, pattern);
+    storeWord(end - 8, pattern);
+
+    // Non-temporal stores are weakly ordered; fence them so the fill is
+    // visible before anything that follows.
+    __asm__ volatile("sfence" : : : "memory");
+}
+
+NO_LIBRARY_CALLS void *Cobalt_SetMemory(void *destination,
+                                        cobalt_u8_t value, size_t size)
+{
+    cobalt_u8_t *bytes = destination;
+    if (size < 8)
+    {
+        for (size_t i = 0; i < size; i++) bytes[i] = value;
+        return destination;
+    }
+
+    const cobalt_u64_t pattern = 0x0101010101010101UL * value;
+    if (size <= SMALL_SIZE)
+    {
+        // The last word overlaps whatever the loop leaves over.
+        for (size_t i = 0; i < size - 8; i += 8)
+            storeWord(bytes + i, pattern);
+        storeWord(bytes + size - 8, pattern);
+        return destination;
+    }
+
+    if (size >= COBALT_MEMORY_NONTEMPORAL_THRESHOLD)
+    {
+        setNonTemporal(bytes, pattern, size);
+        return destination;
+    }
+
+    if (hasFastStrings())
+    {
+        __asm__ volatile("rep stosb"
+                         : "+D"(bytes), "+c"(size)
+                         : "a"(value)
+                         : "memory");
+        return destination;
+    }
+
+    storeWord(bytes + size - 8, pattern);
+    size /= 8;
+    __asm__ volatile("rep stosq"
+                     : "+D"(bytes), "+c"(size)
+                     : "a"(pattern)
+                     : "memory");
+    return destination;
+}
+
+void Cobalt_ZeroMemory(void *destination, size_t size)
+{
+    (void)Cobalt_SetMemory(destination, 0, size);
+}
+
+// Copy front to back. This is also correct for overlapping buffers when
+// the destination is below the source, since every word is read before
+// anything at or above it is written.
+NO_LIBRARY_CALLS static void copyForward(cobalt_u8_t *destination,
+                                         const cobalt_u8_t *source,
+                                         size_t size)
+{
+    if (size < 8)
+    {
+        for (size_t i = 0; i < size; i++) destination[i] = source[i];
+        return;
+    }
+
+    if (size > SMALL_SIZE && hasFastStrings())
+    {
+        __asm__ volatile("rep movsb"
+                         : "+D"(destination), "+S"(source), "+c"(size)
+                         :
+                         : "memory");
+        return;
+    }
+
+    // The tail is read before anything is written, in case the copy
+    // overlaps it.
+    const cobalt_u64_t tail = loadWord(source + size - 8);
+    cobalt_u8_t *const tailDestination = destination + size - 8;
+    if (size > SMALL_SIZE)
+    {
+        size /= 8;
+        __asm__ volatile("rep movsq"
+                         : "+D"(destination), "+S"(source), "+c"(size)
+                         :
+                         : "memory");
+    }
+    else
+        for (size_t i = 0; i + 8 <= size; i += 8)
+            storeWord(destination + i, loadWord(source + i));
+    storeWord(tailDestination, tail);
+}
+
+// Copy back to front, for overlapping buffers where the destination is
+// above the source. Backward string instructions don't get the fast
+// microcode path, so this sticks to words.
+NO_LIBRARY_CALLS static void copyBackward(cobalt_u8_t *destination,
+                                          const cobalt_u8_t *source,
+                                          size_t size)
+{
+    destination += size;
+    source += size;
+    for (; size >= 8; size -= 8)
+    {
+        destination -= 8;
+        source -= 8;
+        storeWord(destination, loadWord(source));
+    }
+    while (size-- != 0) *--destination = *--source;
+}
+
+// Copy around the cache, for copies too large to be worth keeping. The
+// loads stay ordinary; it's the stores that would evict everything.
+static void copyNonTemporal(cobalt_u8_t *destination,
+                            const cobalt_u8_t *source, size_t size)
+{
+    // Ordinary copies take the destination up to its first line boundary
+    // and finish off the tail; only whole lines write-combine.
+    const size_t head = -(cobalt_u64_t)destination & 63;
+    copyForward(destination, source, head);
+    destination += head;
+    source += head;
+    size -= head;
+
+    // Half a line at a time goes through registers; spelling the loads
+    // out keeps the compiler from staging the line on the stack.
+    for (; size >= 64; size -= 64, destination += 64, source += 64)
+    {
+        cobalt_u64_t a, b, c, d;
+        __asm__ volatile("movq 0(%5), %0\n\t"
+                         "movq 8(%5), %1\n\t"
+                         "movq 16(%5), %2\n\t"
+                         "movq 24(%5), %3\n\t"
+                         "movnti %0, 0(%4)\n\t"
+                         "movnti %1, 8(%4)\n\t"
+                         "movnti %2, 16(%4)\n\t"
+                         "movnti %3, 24(%4)\n\t"
+                         "movq 32(%5), %0\n\t"
+                         "movq 40(%5), %1\n\t"
+                         "movq 48(%5), %2\n\t"
+                         "movq 56(%5), %3\n\t"
+                         "movnti %0, 32(%4)\n\t"
+                         "movnti %1, 40(%4)\n\t"
+                         "movnti %2, 48(%4)\n\t"
+                         "movnti %3, 56(%4)"
+                         : "=&r"(a), "=&r"(b), "=&r"(c), "=&r"(d)
+                         : "r"(destination), "r"(source)
+                         : "memory");
+    }
+    __asm__ volatile("sfence" : : : "memory");
+    copyForward(destination, source, size);
+}
+
+void *Cobalt_CopyMemory(void *destination, const void *source, size_t size)
+{
+    if (size >= COBALT_MEMORY_NONTEMPORAL_THRESHOLD)
+        copyNonTemporal(destination, source, size);
+    else copyForward(destination, source, size);
+    return destination;
+}
+
+void *Cobalt_MoveMemory(void *destination, const void *source, size_t size)
+{
+    cobalt_u8_t *to = destination;
+    const cobalt_u8_t *from = source;
+    if (to == from || size == 0) return destination;
+
+    if (to < from || to >= from + size) copyForward(to, from, size);
+    else copyBackward(to, from, size);
+    return destination;
+}
+
+int Cobalt_CompareMemory(const void *left, const void *right, size_t size)
+{
+    const cobalt_u8_t *a = left, *b = right;
+
+    // Compare a word at a time. On a mismatch, swapping both words to big
+    // endian puts their first byte on top, so the first differing byte
+    // decides an ordinary integer comparison.
+    for (; size >= 8; size -= 8, a += 8, b += 8)
+    {
+        const cobalt_u64_t wordA = loadWord(a), wordB = loadWord(b);
+        if (wordA != wordB)
+            return __builtin_bswap64(wordA) < __builtin_bswap64(wordB)
+                       ? -1
+                       : 1;
+    }
+
+    for (; size != 0; size--, a++, b++)
+        if (*a != *b) return *a < *b ? -1 : 1;
+    return 0;
+}
+
+// The compiler is free to emit calls to these four for structure copies,
+// large initializers and the like, even in freestanding code, so both the
+// bootloader and the kernel must provide them.
+
+void *memset(void *destination, int value, size_t size)
+{
+    return Cobalt_SetMemory(destination, (cobalt_u8_t)value, size);
+}
+
+void *memcpy(void *destination, const void *source, size_t size)
+{
+    return Cobalt_CopyMemory(destination, source, size);
+}
+
+void *memmove(void *destination, const void *source, size_t size)
+{
+    return Cobalt_MoveMemory(destination, source, size);
+}
+
+int memcmp(const void *left, const void *right, size_t size)
+{
+    return Cobalt_CompareMemory(left, right, size);
+}
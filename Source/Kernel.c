@@ -1,9 +1,90 @@
-#include <Bootloader/EFI/Print.h>
 #include <Bootloader/Types.h>
+#include <Kernel/ACPI.h>
+#include <Kernel/APIC.h>
+#include <Kernel/CPU.h>
+#include <Kernel/Clock.h>
+#include <Kernel/Console.h>
+#include <Kernel/Framebuffer.h>
+#include <Kernel/HashTable.h>
+#include <Kernel/Interrupts.h>
+#include <Kernel/Locks.h>
+#include <Kernel/Physical.h>
+#include <Kernel/RCU.h>
+#include <Kernel/SMP.h>
+#include <Kernel/Scheduler.h>
+#include <Kernel/Serial.h>
+#include <Kernel/Timer.h>
+#include <Kernel/Trace.h>
+#include <Kernel/Virtual.h>
 
 void kernel_main(cobalt_efi_info_t *efiInfo)
 {
-    Cobalt_PrimitivePuts(L"Hi from kernel!");
-    (void)efiInfo;
-    return;
+    Cobalt_SerialInitialize();
+    Cobalt_DumpTrace(&efiInfo->bootTrace);
+    Cobalt_InitializeCPU(0);
+    Cobalt_InitializeInterrupts();
+
+    if (!Cobalt_InitializePhysicalMemory(efiInfo))
+    {
+        Cobalt_SerialPuts("Failed to set up the physical allocator.\n");
+        return;
+    }
+    cobalt_physical_stats_t physicalStats;
+    Cobalt_GetPhysicalStats(&physicalStats);
+    Cobalt_SerialPrintf("%U of %U pages free.\n", physicalStats.freePages,
+                        physicalStats.totalPages);
+
+    if (!Cobalt_InitializeVirtualMemory(efiInfo))
+    {
+        Cobalt_SerialPuts("Failed to take over the page tables.\n");
+        return;
+    }
+    Cobalt_InitializeLocalAPIC();
+    Cobalt_SetCPUOnline();
+    if (!Cobalt_InitializeFramebuffer(efiInfo) ||
+        !Cobalt_InitializeConsole())
+        Cobalt_SerialPuts("No framebuffer to put a console on.\n");
+
+    const bool acpi = Cobalt_InitializeACPI(efiInfo);
+    static const char *const references[] = {"the loader's estimate",
+                                             "the HPET", "the PM timer"};
+    const cobalt_clock_reference_t reference =
+        Cobalt_InitializeClock(efiInfo);
+    Cobalt_SerialPrintf("Timestamp counter runs at %U kHz, going by %s.\n",
+                        Cobalt_ClockFrequency() / 1000,
+                        references[reference]);
+    if (!Cobalt_ClockInvariant())
+        Cobalt_SerialPuts("The timestamp counter isn't invariant.\n");
+
+    Cobalt_SerialPrintf("Local APIC timer runs %s.\n",
+                        Cobalt_InitializeTimers() ? "on TSC deadlines"
+                                                  : "one-shot");
+    if (!Cobalt_InitializeScheduler(
+            efiInfo->bootTrace.ticksPerMicrosecond) ||
+        !Cobalt_StartRCU(Cobalt_CPUIndex()))
+    {
+        Cobalt_SerialPuts("Failed to set up the scheduler.\n");
+        return;
+    }
+    Cobalt_StartFramebufferFlusher();
+
+    if (!acpi)
+        Cobalt_SerialPuts("No ACPI tables; running on one processor.\n");
+    else
+        Cobalt_SerialPrintf("%U processors online.\n",
+                            Cobalt_StartProcessors(efiInfo));
+
+#ifdef COBALT_BENCHMARKS
+    Cobalt_BenchmarkPhysicalMemory(efiInfo->bootTrace.ticksPerMicrosecond);
+    Cobalt_BenchmarkClock();
+    Cobalt_BenchmarkTimers();
+    Cobalt_BenchmarkScheduler();
+    Cobalt_BenchmarkLocks(efiInfo->bootTrace.ticksPerMicrosecond);
+    Cobalt_BenchmarkHashTable(efiInfo->bootTrace.ticksPerMicrosecond);
+    Cobalt_BenchmarkFramebuffer();
+    Cobalt_BenchmarkConsole();
+#endif
+
+    Cobalt_ConsolePuts("Hi from kernel!\n");
+    Cobalt_ExitThread();
 }
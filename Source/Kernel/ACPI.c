@@ -0,0 +1,126 @@
+/**
+ * @file ACPI.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the ACPI table lookup outlined in the
+ * Kernel/ACPI.h file.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <Kernel/ACPI.h>
+#include <Memory.h>
+#include <Paging.h>
+
+// The size of the part of the root pointer that ACPI 1.0 defined, which
+// its first checksum covers.
+#define ROOT_POINTER_V1_SIZE 20
+
+typedef struct __attribute__((packed))
+{
+    char signature[8];
+    cobalt_u8_t checksum;
+    char oemID[6];
+    cobalt_u8_t revision;
+    cobalt_u32_t rootTable;
+    cobalt_u32_t length;
+    cobalt_u64_t extendedRootTable;
+    cobalt_u8_t extendedChecksum;
+    cobalt_u8_t reserved[3];
+} root_pointer_t;
+
+// The XSDT if there is one, otherwise the RSDT, whose entries are half
+// the size.
+static const cobalt_acpi_header_t *root;
+static cobalt_u64_t entrySize;
+
+static bool checksum(const void *data, cobalt_u64_t size)
+{
+    const cobalt_u8_t *bytes = data;
+    cobalt_u8_t sum = 0;
+    for (cobalt_u64_t i = 0; i < size; i++) sum += bytes[i];
+    return sum == 0;
+}
+
+static const cobalt_acpi_header_t *tableAt(cobalt_u64_t physical)
+{
+    if (physical == 0) return nullptr;
+    return Cobalt_PhysicalToVirtual(physical);
+}
+
+static bool valid(const cobalt_acpi_header_t *table)
+{
+    return table != nullptr &&
+           table->length >= sizeof(cobalt_acpi_header_t) &&
+           checksum(table, table->length);
+}
+
+static const root_pointer_t *
+findRootPointer(const cobalt_efi_info_t *efiInfo)
+{
+    // Firmware that offers both lists the 2.0 pointer under its own GUID,
+    // and that one is preferred since it can reach the XSDT.
+    const EFI_GUID guids[2] = {ACPI_20_TABLE_GUID, ACPI_TABLE_GUID};
+    const EFI_CONFIGURATION_TABLE *tables = Cobalt_PhysicalToVirtual(
+        (cobalt_u64_t)efiInfo->configurationTables.tables);
+
+    for (cobalt_u64_t i = 0; i < 2; i++)
+        for (cobalt_u64_t j = 0; j < efiInfo->configurationTables.count;
+             j++)
+        {
+            if (Cobalt_CompareMemory(&tables[j].VendorGuid, &guids[i],
+                                     sizeof(EFI_GUID)) != 0)
+                continue;
+            const root_pointer_t *pointer = Cobalt_PhysicalToVirtual(
+                (cobalt_u64_t)tables[j].VendorTable);
+            if (Cobalt_CompareMemory(pointer->signature, "RSD PTR ", 8) ==
+                    0 &&
+                checksum(pointer, ROOT_POINTER_V1_SIZE))
+                return pointer;
+        }
+    return nullptr;
+}
+
+bool Cobalt_InitializeACPI(const cobalt_efi_info_t *efiInfo)
+{
+    const root_pointer_t *pointer = findRootPointer(efiInfo);
+    if (pointer == nullptr) return false;
+
+    if (pointer->revision >= 2 && checksum(pointer, pointer->length))
+    {
+        root = tableAt(pointer->extendedRootTable);
+        entrySize = sizeof(cobalt_u64_t);
+        if (valid(root)) return true;
+    }
+    root = tableAt(pointer->rootTable);
+    entrySize = sizeof(cobalt_u32_t);
+    if (valid(root)) return true;
+    root = nullptr;
+    return false;
+}
+
+const cobalt_acpi_header_t *Cobalt_FindACPITable(const char *signature)
+{
+    if (root == nullptr) return nullptr;
+
+    // The XSDT's entries follow a 36-byte header, so they're only 4-byte
+    // aligned and have to be copied out.
+    const cobalt_u8_t *entries = (const cobalt_u8_t *)(root + 1);
+    const cobalt_u64_t count =
+        (root->length - sizeof(cobalt_acpi_header_t)) / entrySize;
+    for (cobalt_u64_t i = 0; i < count; i++)
+    {
+        cobalt_u64_t physical = 0;
+        Cobalt_CopyMemory(&physical, entries + i * entrySize, entrySize);
+        const cobalt_acpi_header_t *table = tableAt(physical);
+        if (table != nullptr &&
+            Cobalt_CompareMemory(table->signature, signature, 4) == 0 &&
+            valid(table))
+            return table;
+    }
+    return nullptr;
+}
@@ -0,0 +1,194 @@
+/**
+ * @file APIC.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the local APIC driver outlined in the
+ * Kernel/APIC.h file.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <CPU.h>
+#include <Kernel/APIC.h>
+#include <Kernel/Interrupts.h>
+#include <Paging.h>
+
+#define APIC_BASE_MSR 0x1B
+#define TSC_DEADLINE_MSR 0x6E0
+#define APIC_ENABLE (1 << 11)
+#define X2APIC_ENABLE (1 << 10)
+#define X2APIC_MSR_BASE 0x800
+
+// Register offsets into the xAPIC's page. The x2APIC has the same
+// registers at MSR 0x800 plus the offset over sixteen, except that its
+// interrupt command register is one 64-bit MSR.
+#define END_OF_INTERRUPT 0xB0
+#define SPURIOUS_VECTOR 0xF0
+#define COMMAND_LOW 0x300
+#define COMMAND_HIGH 0x310
+#define TIMER_VECTOR 0x320
+#define TIMER_INITIAL_COUNT 0x380
+#define TIMER_CURRENT_COUNT 0x390
+#define TIMER_DIVIDE 0x3E0
+
+#define SOFTWARE_ENABLE (1 << 8)
+#define DELIVERY_INIT (5 << 8)
+#define DELIVERY_STARTUP (6 << 8)
+#define DELIVERY_PENDING (1 << 12)
+#define LEVEL_ASSERT (1 << 14)
+#define TIMER_MASKED (1 << 16)
+#define TIMER_TSC_DEADLINE (2 << 17)
+#define DIVIDE_BY_16 0x3
+
+// How long the timer is measured against the timestamp counter for, in
+// microseconds.
+#define CALIBRATION_PERIOD 10000
+
+// One-shot counts are worked out from timestamps this far off at most,
+// which keeps the product in range. A deadline further off than this
+// just fires early.
+#define MAXIMUM_COUNTDOWN (1UL << 40)
+
+static bool x2apic;
+static volatile cobalt_u32_t *registers;
+
+// Whether the timer is given its deadlines as timestamps. Otherwise, it
+// counts down from a count worked out from the timestamp counter's rate.
+static bool deadlineMode;
+static cobalt_u64_t timestampRate;
+
+// The number of timer counts in CALIBRATION_PERIOD, at a divisor of 16.
+static cobalt_u64_t timerRate;
+
+static cobalt_u32_t readRegister(cobalt_u32_t offset)
+{
+    if (x2apic)
+        return (cobalt_u32_t)Cobalt_ReadMSR(X2APIC_MSR_BASE +
+                                            (offset >> 4));
+    return registers[offset / sizeof(cobalt_u32_t)];
+}
+
+static void writeRegister(cobalt_u32_t offset, cobalt_u32_t value)
+{
+    if (x2apic) Cobalt_WriteMSR(X2APIC_MSR_BASE + (offset >> 4), value);
+    else registers[offset / sizeof(cobalt_u32_t)] = value;
+}
+
+// Spurious interrupts are never acknowledged.
+static void handleSpurious(cobalt_interrupt_frame_t *frame)
+{
+    (void)frame;
+}
+
+void Cobalt_InitializeLocalAPIC(void)
+{
+    // CPUID leaf 1 reports the x2APIC in bit 21 of ECX.
+    cobalt_u32_t cpuid[4];
+    Cobalt_CPUID(1, 0, cpuid);
+    x2apic = (cpuid[2] & (1 << 21)) != 0;
+
+    cobalt_u64_t base = Cobalt_ReadMSR(APIC_BASE_MSR) | APIC_ENABLE;
+    if (x2apic) base |= X2APIC_ENABLE;
+    Cobalt_WriteMSR(APIC_BASE_MSR, base);
+    registers = Cobalt_PhysicalToVirtual(base & COBALT_PAGE_ADDRESS_MASK);
+
+    Cobalt_SetInterruptHandler(COBALT_VECTOR_SPURIOUS, handleSpurious);
+    writeRegister(SPURIOUS_VECTOR,
+                  SOFTWARE_ENABLE | COBALT_VECTOR_SPURIOUS);
+}
+
+static void sendCommand(cobalt_u32_t apicID, cobalt_u32_t command)
+{
+    if (x2apic)
+    {
+        Cobalt_WriteMSR(X2APIC_MSR_BASE + (COMMAND_LOW >> 4),
+                        ((cobalt_u64_t)apicID << 32) | command);
+        return;
+    }
+
+    // Writing the low half sends the interrupt, so the destination has
+    // to be in place first.
+    writeRegister(COMMAND_HIGH, apicID << 24);
+    writeRegister(COMMAND_LOW, command);
+    while (readRegister(COMMAND_LOW) & DELIVERY_PENDING) Cobalt_Pause();
+}
+
+void Cobalt_SendIPI(cobalt_u32_t apicID, cobalt_u8_t vector)
+{
+    sendCommand(apicID, vector);
+}
+
+void Cobalt_SendInitIPI(cobalt_u32_t apicID)
+{
+    sendCommand(apicID, DELIVERY_INIT | LEVEL_ASSERT);
+}
+
+void Cobalt_SendStartupIPI(cobalt_u32_t apicID, cobalt_u8_t page)
+{
+    sendCommand(apicID, DELIVERY_STARTUP | LEVEL_ASSERT | page);
+}
+
+bool Cobalt_InitializeLocalTimer(cobalt_u8_t vector,
+                                 cobalt_u64_t ticksPerMicrosecond)
+{
+    // CPUID leaf 1 reports the TSC-deadline timer in bit 24 of ECX.
+    cobalt_u32_t cpuid[4];
+    Cobalt_CPUID(1, 0, cpuid);
+    deadlineMode = (cpuid[2] & (1 << 24)) != 0;
+    timestampRate = ticksPerMicrosecond;
+
+    if (deadlineMode)
+    {
+        writeRegister(TIMER_VECTOR, TIMER_TSC_DEADLINE | vector);
+        // The xAPIC's register write has to land before the deadline is
+        // written, or the deadline is taken in the old mode and lost.
+        __asm__ volatile("mfence" : : : "memory");
+        Cobalt_WriteMSR(TSC_DEADLINE_MSR, 0);
+        return true;
+    }
+
+    writeRegister(TIMER_DIVIDE, DIVIDE_BY_16);
+    if (timerRate == 0)
+    {
+        writeRegister(TIMER_VECTOR, TIMER_MASKED);
+        writeRegister(TIMER_INITIAL_COUNT, ~0U);
+        const cobalt_u64_t end = Cobalt_ReadTimestamp() +
+                                 CALIBRATION_PERIOD * ticksPerMicrosecond;
+        while (Cobalt_ReadTimestamp() < end) Cobalt_Pause();
+        timerRate = ~0U - readRegister(TIMER_CURRENT_COUNT);
+        writeRegister(TIMER_INITIAL_COUNT, 0);
+    }
+    writeRegister(TIMER_VECTOR, vector);
+    return false;
+}
+
+void Cobalt_ArmLocalTimer(cobalt_u64_t deadline)
+{
+    if (deadlineMode)
+    {
+        Cobalt_WriteMSR(TSC_DEADLINE_MSR, deadline);
+        return;
+    }
+
+    // A count of zero stops the timer, so a deadline that's already
+    // passed gets the smallest count there is instead.
+    if (deadline == 0)
+    {
+        writeRegister(TIMER_INITIAL_COUNT, 0);
+        return;
+    }
+    const cobalt_u64_t now = Cobalt_ReadTimestamp();
+    cobalt_u64_t countdown = deadline > now ? deadline - now : 0;
+    if (countdown > MAXIMUM_COUNTDOWN) countdown = MAXIMUM_COUNTDOWN;
+    cobalt_u64_t count =
+        countdown * timerRate / (CALIBRATION_PERIOD * timestampRate);
+    if (count == 0) count = 1;
+    if (count > ~0U) count = ~0U;
+    writeRegister(TIMER_INITIAL_COUNT, (cobalt_u32_t)count);
+}
+
+void Cobalt_EndOfInterrupt(void) { writeRegister(END_OF_INTERRUPT, 0); }
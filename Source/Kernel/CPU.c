@@ -0,0 +1,144 @@
+/**
+ * @file CPU.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the per-processor state outlined in the
+ * Kernel/CPU.h file.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <CPU.h>
+#include <Kernel/CPU.h>
+#include <stdatomic.h>
+
+#define GS_BASE_MSR 0xC0000101
+
+// The null descriptor, the four flat segments, and the two halves of the
+// task state segment's descriptor.
+#define DESCRIPTOR_COUNT 7
+
+// The code, data, and task state segment descriptors' access bytes and
+// flags. Limits and bases are ignored in long mode for everything but the
+// task state segment.
+#define KERNEL_CODE_DESCRIPTOR 0x00AF9A000000FFFFULL
+#define KERNEL_DATA_DESCRIPTOR 0x00CF92000000FFFFULL
+#define USER_DATA_DESCRIPTOR 0x00CFF2000000FFFFULL
+#define USER_CODE_DESCRIPTOR 0x00AFFA000000FFFFULL
+#define TASK_STATE_AVAILABLE 0x89ULL
+
+typedef struct __attribute__((packed))
+{
+    cobalt_u32_t reserved0;
+    cobalt_u64_t stacks[3];
+    cobalt_u64_t reserved1;
+    cobalt_u64_t interruptStacks[7];
+    cobalt_u64_t reserved2;
+    cobalt_u16_t reserved3;
+    cobalt_u16_t ioMapBase;
+} task_state_t;
+
+typedef struct
+{
+    alignas(16) cobalt_u64_t descriptors[DESCRIPTOR_COUNT];
+    task_state_t taskState;
+} descriptor_tables_t;
+
+typedef struct __attribute__((packed))
+{
+    cobalt_u16_t limit;
+    cobalt_u64_t base;
+} descriptor_table_register_t;
+
+static cobalt_cpu_t cpus[COBALT_MAXIMUM_CPUS];
+static descriptor_tables_t tables[COBALT_MAXIMUM_CPUS];
+static atomic_ulong online;
+
+static void loadTables(descriptor_tables_t *cpuTables, cobalt_u64_t stack)
+{
+    task_state_t *taskState = &cpuTables->taskState;
+    *taskState = (task_state_t){.stacks[0] = stack,
+                                .ioMapBase = sizeof(task_state_t)};
+
+    const cobalt_u64_t base = (cobalt_u64_t)taskState;
+    const cobalt_u64_t limit = sizeof(task_state_t) - 1;
+    cobalt_u64_t *descriptors = cpuTables->descriptors;
+    descriptors[0] = 0;
+    descriptors[1] = KERNEL_CODE_DESCRIPTOR;
+    descriptors[2] = KERNEL_DATA_DESCRIPTOR;
+    descriptors[3] = USER_DATA_DESCRIPTOR;
+    descriptors[4] = USER_CODE_DESCRIPTOR;
+    descriptors[5] = (limit & 0xFFFF) | ((base & 0xFFFFFF) << 16) |
+                     (TASK_STATE_AVAILABLE << 40) |
+                     ((limit >> 16) << 48) | ((base >> 24 & 0xFF) << 56);
+    descriptors[6] = base >> 32;
+
+    // CS can only be reloaded by a far transfer, so return to the next
+    // instruction through the new code segment. Loading GS clears its
+    // base, which is why this comes before the base is set.
+    const descriptor_table_register_t descriptor = {
+        .limit = sizeof(cpuTables->descriptors) - 1,
+        .base = (cobalt_u64_t)descriptors};
+    __asm__ volatile("lgdt %0\n"
+                     "pushq %1\n"
+                     "leaq 1f(%%rip), %%rax\n"
+                     "pushq %%rax\n"
+                     "lretq\n"
+                     "1:\n"
+                     "movw %2, %%ax\n"
+                     "movw %%ax, %%ds\n"
+                     "movw %%ax, %%es\n"
+                     "movw %%ax, %%ss\n"
+                     "xorl %%eax, %%eax\n"
+                     "movw %%ax, %%fs\n"
+                     "movw %%ax, %%gs\n"
+                     "ltr %w3\n"
+                     :
+                     : "m"(descriptor), "i"(COBALT_KERNEL_CODE_SELECTOR),
+                       "i"(COBALT_KERNEL_DATA_SELECTOR),
+                       "r"((cobalt_u16_t)COBALT_TASK_STATE_SELECTOR)
+                     : "rax", "memory");
+}
+
+// Neither source of the ID needs the local APIC to be set up yet. Leaf 1
+// only has room for eight bits of it, so the extended topology leaf,
+// which has the whole 32-bit x2APIC ID in EDX, comes first wherever it's
+// there. A processor without it reports zeroes in EBX.
+static cobalt_u32_t initialAPICID(void)
+{
+    cobalt_u32_t registers[4];
+    Cobalt_CPUID(0, 0, registers);
+    if (registers[0] >= 0xB)
+    {
+        Cobalt_CPUID(0xB, 0, registers);
+        if (registers[1] != 0) return registers[3];
+    }
+
+    Cobalt_CPUID(1, 0, registers);
+    return registers[1] >> 24;
+}
+
+void Cobalt_InitializeCPU(cobalt_u32_t index)
+{
+    cobalt_cpu_t *cpu = &cpus[index];
+    cpu->self = cpu;
+    cpu->index = index;
+
+    cpu->apicID = initialAPICID();
+
+    loadTables(&tables[index], cpu->stackTop);
+    Cobalt_WriteMSR(GS_BASE_MSR, (cobalt_u64_t)cpu);
+}
+
+void Cobalt_SetCPUOnline(void)
+{
+    atomic_fetch_or(&online, 1UL << Cobalt_CPUIndex());
+}
+
+cobalt_cpu_t *Cobalt_GetCPU(cobalt_u32_t index) { return &cpus[index]; }
+
+cobalt_u64_t Cobalt_OnlineCPUs(void) { return atomic_load(&online); }
@@ -0,0 +1,386 @@
+/**
+ * @file Clock.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the clock outlined in the Kernel/Clock.h
+ * file.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <CPU.h>
+#include <Kernel/ACPI.h>
+#include <Kernel/Clock.h>
+#include <Kernel/Locks.h>
+#include <Kernel/Serial.h>
+#include <Paging.h>
+
+#define NANOSECONDS_PER_SECOND 1000000000ULL
+#define FEMTOSECONDS_PER_SECOND 1000000000000000ULL
+
+// Ticks are taken to nanoseconds by multiplying by a factor with this
+// many fractional bits, in 128-bit arithmetic. That keeps the drift
+// from rounding the factor to a fraction of a microsecond a day.
+#define SCALE_SHIFT 40
+
+// CPUID leaf 0x80000007 sets this bit of EDX if the timestamp counter is
+// invariant.
+#define INVARIANT_TIMESTAMP (1 << 8)
+
+// The HPET's registers, by offset, and the bits of them we look at. The
+// period in the top half of the capabilities is in femtoseconds, and is
+// never more than 100 nanoseconds.
+#define HPET_CAPABILITIES 0x00
+#define HPET_CONFIGURATION 0x10
+#define HPET_COUNTER 0xF0
+#define HPET_COUNTER_64 (1 << 13)
+#define HPET_ENABLE (1 << 0)
+#define HPET_MAXIMUM_PERIOD 100000000
+
+// The FADT's fields the clock needs, by offset.
+#define FADT_PM_TIMER_BLOCK 76
+#define FADT_FLAGS 112
+#define FADT_EXTENDED_PM_TIMER_BLOCK 208
+#define FADT_TIMER_32_BIT (1 << 8)
+
+#define PM_TIMER_FREQUENCY 3579545
+
+// A calibration round that runs this many times its length, by the
+// loader's estimate of the counter's rate, is taken to mean the reference
+// isn't counting. Without an estimate, the counter is assumed to run at
+// no more than the given number of ticks a microsecond.
+#define CALIBRATION_TIMEOUT 4
+#define CALIBRATION_FASTEST_RATE 10000
+
+// The reads of the clock the benchmark times.
+#define BENCHMARK_READS (1 << 20)
+
+typedef enum : cobalt_u8_t
+{
+    ADDRESS_SPACE_MEMORY,
+    ADDRESS_SPACE_IO
+} address_space_t;
+
+typedef struct __attribute__((packed))
+{
+    address_space_t space;
+    cobalt_u8_t bitWidth;
+    cobalt_u8_t bitOffset;
+    cobalt_u8_t accessSize;
+    cobalt_u64_t address;
+} generic_address_t;
+
+typedef struct __attribute__((packed))
+{
+    cobalt_acpi_header_t header;
+    cobalt_u32_t blockID;
+    generic_address_t base;
+    cobalt_u8_t number;
+    cobalt_u16_t minimumTick;
+    cobalt_u8_t protection;
+} hpet_table_t;
+
+__extension__ typedef unsigned __int128 wide_t;
+
+typedef struct
+{
+    cobalt_u64_t (*read)(void);
+    // The counter wraps at this mask.
+    cobalt_u64_t mask;
+    cobalt_u64_t frequency;
+} reference_t;
+
+static struct
+{
+    cobalt_seqlock_t lock;
+    cobalt_u64_t baseTimestamp;
+    cobalt_u64_t multiplier;
+    cobalt_u64_t wallOffset;
+} parameters;
+
+static cobalt_u64_t frequency;
+static bool invariant;
+static volatile cobalt_u64_t *hpet;
+static cobalt_u16_t pmTimerPort;
+
+static cobalt_u64_t readHPET(void) { return hpet[HPET_COUNTER / 8]; }
+
+static cobalt_u64_t readPMTimer(void)
+{
+    return Cobalt_InLong(pmTimerPort);
+}
+
+// The nanoseconds from one timestamp to a later one, or zero if the
+// later one is read on a processor whose counter lags a little.
+static cobalt_u64_t elapsed(cobalt_u64_t from, cobalt_u64_t to,
+                            cobalt_u64_t multiplier)
+{
+    if (to <= from) return 0;
+    return (cobalt_u64_t)(((wide_t)(to - from) * multiplier) >>
+                          SCALE_SHIFT);
+}
+
+// Divide a 128-bit number by a 64-bit one with a single instruction,
+// since the kernel isn't linked against the compiler's runtime library
+// that would otherwise do it. The quotient must fit in 64 bits.
+static cobalt_u64_t divideWide(wide_t dividend, cobalt_u64_t divisor)
+{
+    cobalt_u64_t quotient, remainder;
+    __asm__("divq %4"
+            : "=a"(quotient), "=d"(remainder)
+            : "a"((cobalt_u64_t)dividend),
+              "d"((cobalt_u64_t)(dividend >> 64)), "rm"(divisor));
+    return quotient;
+}
+
+static bool findHPET(reference_t *reference)
+{
+    const hpet_table_t *table =
+        (const hpet_table_t *)Cobalt_FindACPITable("HPET");
+    if (table != nullptr && table->header.length >= sizeof(hpet_table_t) &&
+        table->base.space == ADDRESS_SPACE_MEMORY &&
+        table->base.address != 0)
+    {
+        hpet = Cobalt_PhysicalToVirtual(table->base.address);
+        const cobalt_u64_t capabilities = hpet[HPET_CAPABILITIES / 8];
+        const cobalt_u64_t period = capabilities >> 32;
+        if (period != 0 && period <= HPET_MAXIMUM_PERIOD)
+        {
+            // The firmware may have left the counter stopped.
+            const cobalt_u64_t configuration =
+                hpet[HPET_CONFIGURATION / 8];
+            if (!(configuration & HPET_ENABLE))
+                hpet[HPET_CONFIGURATION / 8] = configuration | HPET_ENABLE;
+
+            *reference = (reference_t){
+                .read = readHPET,
+                .mask = capabilities & HPET_COUNTER_64 ? ~0UL : 0xFFFFFFFF,
+                .frequency = FEMTOSECONDS_PER_SECOND / period};
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool findPMTimer(reference_t *reference)
+{
+    const cobalt_acpi_header_t *fadt = Cobalt_FindACPITable("FACP");
+    if (fadt == nullptr) return false;
+    const cobalt_u8_t *fields = (const cobalt_u8_t *)fadt;
+
+    // The extended block is only there in later revisions, and even
+    // then may be left empty in favour of the old one.
+    cobalt_u64_t port = 0;
+    if (fadt->length >=
+        FADT_EXTENDED_PM_TIMER_BLOCK + sizeof(generic_address_t))
+    {
+        const generic_address_t *block =
+            (const generic_address_t *)(fields +
+                                        FADT_EXTENDED_PM_TIMER_BLOCK);
+        if (block->space == ADDRESS_SPACE_IO) port = block->address;
+    }
+    if (port == 0 && fadt->length >= FADT_FLAGS + sizeof(cobalt_u32_t))
+        port = *(const cobalt_u32_t *)(fields + FADT_PM_TIMER_BLOCK);
+    if (port == 0 || port > 0xFFFF) return false;
+
+    pmTimerPort = port;
+    const cobalt_u32_t flags =
+        *(const cobalt_u32_t *)(fields + FADT_FLAGS);
+    *reference = (reference_t){
+        .read = readPMTimer,
+        .mask = flags & FADT_TIMER_32_BIT ? 0xFFFFFFFF : 0xFFFFFF,
+        .frequency = PM_TIMER_FREQUENCY};
+    return true;
+}
+
+// Measure the timestamp counter against a reference timer. Each reading
+// of the reference is bracketed by two of the counter, and the round
+// whose brackets are tightest is the one least disturbed by SMIs and the
+// like. A reference that doesn't reach the end of a round in time gives
+// zero, as if there were none.
+static cobalt_u64_t calibrate(const reference_t *reference,
+                              cobalt_u64_t estimate)
+{
+    const cobalt_u64_t length =
+        reference->frequency * COBALT_CALIBRATION_LENGTH / 1000000;
+    const cobalt_u64_t timeout =
+        (estimate != 0 ? estimate : CALIBRATION_FASTEST_RATE) *
+        COBALT_CALIBRATION_LENGTH * CALIBRATION_TIMEOUT;
+    cobalt_u64_t best = 0, bestSpread = ~0UL;
+    for (cobalt_u32_t i = 0; i < COBALT_CALIBRATION_ROUNDS; i++)
+    {
+        const cobalt_u64_t beforeStart = Cobalt_ReadTimestamp();
+        const cobalt_u64_t start = reference->read();
+        const cobalt_u64_t afterStart = Cobalt_ReadTimestamp();
+
+        cobalt_u64_t beforeEnd, afterEnd, ticks;
+        do
+        {
+            beforeEnd = Cobalt_ReadTimestamp();
+            ticks = (reference->read() - start) & reference->mask;
+            afterEnd = Cobalt_ReadTimestamp();
+            if (afterEnd - beforeStart > timeout) return 0;
+        } while (ticks < length);
+
+        const cobalt_u64_t spread =
+            (afterStart - beforeStart) + (afterEnd - beforeEnd);
+        if (spread >= bestSpread) continue;
+        bestSpread = spread;
+        const cobalt_u64_t timestamps = (beforeEnd + afterEnd) / 2 -
+                                        (beforeStart + afterStart) / 2;
+        best = timestamps * reference->frequency / ticks;
+    }
+    return best;
+}
+
+// Days are counted from the first of March, so that the leap day falls
+// at the end of the year, and years in eras of 400, after which the
+// calendar repeats.
+static cobalt_u64_t unixNanoseconds(const EFI_TIME *time)
+{
+    const cobalt_i64_t year =
+        (cobalt_i64_t)time->Year - (time->Month <= 2);
+    const cobalt_i64_t era = year / 400;
+    const cobalt_i64_t yearOfEra = year - era * 400;
+    const cobalt_i64_t month =
+        time->Month > 2 ? time->Month - 3 : time->Month + 9;
+    const cobalt_i64_t dayOfYear = (153 * month + 2) / 5 + time->Day - 1;
+    const cobalt_i64_t dayOfEra =
+        yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    const cobalt_i64_t days = era * 146097 + dayOfEra - 719468;
+
+    cobalt_i64_t seconds = days * 86400 + time->Hour * 3600 +
+                           time->Minute * 60 + time->Second;
+    // The firmware gives local time, which is UTC plus the zone's offset.
+    if (time->TimeZone != EFI_UNSPECIFIED_TIMEZONE)
+        seconds -= (cobalt_i64_t)time->TimeZone * 60;
+    if (seconds < 0) return 0;
+    return (cobalt_u64_t)seconds * NANOSECONDS_PER_SECOND +
+           time->Nanosecond;
+}
+
+cobalt_clock_reference_t
+Cobalt_InitializeClock(const cobalt_efi_info_t *efiInfo)
+{
+    cobalt_u32_t registers[4];
+    Cobalt_CPUID(0x80000000, 0, registers);
+    if (registers[0] >= 0x80000007)
+    {
+        Cobalt_CPUID(0x80000007, 0, registers);
+        invariant = registers[3] & INVARIANT_TIMESTAMP;
+    }
+
+    // An HPET that won't count falls back to the PM timer, and that to
+    // the loader's estimate.
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    const cobalt_u64_t estimate = efiInfo->bootTrace.ticksPerMicrosecond;
+    reference_t reference;
+    cobalt_clock_reference_t kind = COBALT_CLOCK_REFERENCE_HPET;
+    frequency = findHPET(&reference) ? calibrate(&reference, estimate) : 0;
+    if (frequency == 0)
+    {
+        kind = COBALT_CLOCK_REFERENCE_PM_TIMER;
+        frequency =
+            findPMTimer(&reference) ? calibrate(&reference, estimate) : 0;
+    }
+    if (frequency == 0)
+    {
+        kind = COBALT_CLOCK_REFERENCE_NONE;
+        frequency = estimate * 1000000;
+    }
+
+    const cobalt_u64_t multiplier = divideWide(
+        (wide_t)NANOSECONDS_PER_SECOND << SCALE_SHIFT, frequency);
+    const cobalt_u64_t base = Cobalt_ReadTimestamp();
+    Cobalt_SeqWriteBegin(&parameters.lock);
+    parameters.baseTimestamp = base;
+    parameters.multiplier = multiplier;
+    parameters.wallOffset =
+        efiInfo->bootTimestamp != 0
+            ? unixNanoseconds(&efiInfo->bootTime) +
+                  elapsed(efiInfo->bootTimestamp, base, multiplier)
+            : 0;
+    Cobalt_SeqWriteEnd(&parameters.lock);
+    Cobalt_RestoreInterrupts(flags);
+    return kind;
+}
+
+cobalt_u64_t Cobalt_ClockFrequency(void) { return frequency; }
+
+bool Cobalt_ClockInvariant(void) { return invariant; }
+
+cobalt_u64_t Cobalt_MonotonicNanoseconds(void)
+{
+    cobalt_u32_t sequence;
+    cobalt_u64_t base, multiplier;
+    do
+    {
+        sequence = Cobalt_SeqReadBegin(&parameters.lock);
+        base = parameters.baseTimestamp;
+        multiplier = parameters.multiplier;
+    } while (Cobalt_SeqReadRetry(&parameters.lock, sequence));
+    return elapsed(base, Cobalt_ReadTimestamp(), multiplier);
+}
+
+cobalt_u64_t Cobalt_ClockTimestamp(cobalt_u64_t nanoseconds)
+{
+    cobalt_u32_t sequence;
+    cobalt_u64_t base, multiplier;
+    do
+    {
+        sequence = Cobalt_SeqReadBegin(&parameters.lock);
+        base = parameters.baseTimestamp;
+        multiplier = parameters.multiplier;
+    } while (Cobalt_SeqReadRetry(&parameters.lock, sequence));
+    // This undoes what elapsed does, rounding up, so that the clock reads
+    // the time by the timestamp given and a deadline never fires early.
+    return base + divideWide(((wide_t)nanoseconds << SCALE_SHIFT) +
+                                 multiplier - 1,
+                             multiplier);
+}
+
+cobalt_u64_t Cobalt_WallClockNanoseconds(void)
+{
+    cobalt_u32_t sequence;
+    cobalt_u64_t base, multiplier, offset;
+    do
+    {
+        sequence = Cobalt_SeqReadBegin(&parameters.lock);
+        base = parameters.baseTimestamp;
+        multiplier = parameters.multiplier;
+        offset = parameters.wallOffset;
+    } while (Cobalt_SeqReadRetry(&parameters.lock, sequence));
+    return offset + elapsed(base, Cobalt_ReadTimestamp(), multiplier);
+}
+
+void Cobalt_SetWallClock(cobalt_u64_t nanoseconds)
+{
+    // An interrupt handler that read the clock halfway through this would
+    // wait on it forever.
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    Cobalt_SeqWriteBegin(&parameters.lock);
+    parameters.wallOffset =
+        nanoseconds - elapsed(parameters.baseTimestamp,
+                              Cobalt_ReadTimestamp(),
+                              parameters.multiplier);
+    Cobalt_SeqWriteEnd(&parameters.lock);
+    Cobalt_RestoreInterrupts(flags);
+}
+
+void Cobalt_BenchmarkClock(void)
+{
+    const cobalt_u64_t start = Cobalt_MonotonicNanoseconds();
+    cobalt_u64_t last = start, backwards = 0;
+    for (cobalt_u32_t i = 0; i < BENCHMARK_READS; i++)
+    {
+        const cobalt_u64_t now = Cobalt_MonotonicNanoseconds();
+        if (now < last) backwards++;
+        last = now;
+    }
+    Cobalt_SerialPrintf("clock: %U ns per read, %U went backwards\n",
+                        (last - start) / BENCHMARK_READS, backwards);
+}
@@ -0,0 +1,426 @@
+/**
+ * @file Console.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the framebuffer console outlined in the
+ * Kernel/Console.h file.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <CPU.h>
+#include <Kernel/Clock.h>
+#include <Kernel/Console.h>
+#include <Kernel/Framebuffer.h>
+#include <Kernel/Heap.h>
+#include <Kernel/Serial.h>
+#include <Kernel/Spinlock.h>
+#include <Memory.h>
+
+#define FONT_SIZE 8
+#define FIRST_GLYPH 0x20
+#define LAST_GLYPH 0x7E
+#define GLYPH_COUNT 96
+
+// Glyphs are scaled up by a whole factor, one for every this many pixels
+// across the screen.
+#define SCALE_WIDTH 960
+#define MAXIMUM_SCALE 4
+
+#define TAB_WIDTH 8
+
+// Light grey on black, as 0xRRGGBB.
+#define FOREGROUND 0xAAAAAA
+#define BACKGROUND 0x000000
+
+#define BENCHMARK_LINES 1000
+
+// Each glyph is eight rows of eight pixels, with the leftmost pixel of a
+// row in its top bit. The last stands in for every character without one.
+static const cobalt_u8_t font[GLYPH_COUNT][FONT_SIZE] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ' '
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x10, 0x00}, // '!'
+    {0x28, 0x28, 0x28, 0x00, 0x00, 0x00, 0x00, 0x00}, // '"'
+    {0x28, 0x28, 0x7C, 0x28, 0x7C, 0x28, 0x28, 0x00}, // '#'
+    {0x10, 0x3C, 0x50, 0x38, 0x14, 0x78, 0x10, 0x00}, // '$'
+    {0x60, 0x64, 0x08, 0x10, 0x20, 0x4C, 0x0C, 0x00}, // '%'
+    {0x30, 0x48, 0x50, 0x20, 0x54, 0x48, 0x34, 0x00}, // '&'
+    {0x10, 0x10, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00}, // '\''
+    {0x08, 0x10, 0x20, 0x20, 0x20, 0x10, 0x08, 0x00}, // '('
+    {0x20, 0x10, 0x08, 0x08, 0x08, 0x10, 0x20, 0x00}, // ')'
+    {0x00, 0x10, 0x54, 0x38, 0x54, 0x10, 0x00, 0x00}, // '*'
+    {0x00, 0x10, 0x10, 0x7C, 0x10, 0x10, 0x00, 0x00}, // '+'
+    {0x00, 0x00, 0x00, 0x00, 0x30, 0x10, 0x20, 0x00}, // ','
+    {0x00, 0x00, 0x00, 0x7C, 0x00, 0x00, 0x00, 0x00}, // '-'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x30, 0x30, 0x00}, // '.'
+    {0x00, 0x04, 0x08, 0x10, 0x20, 0x40, 0x00, 0x00}, // '/'
+    {0x38, 0x44, 0x4C, 0x54, 0x64, 0x44, 0x38, 0x00}, // '0'
+    {0x10, 0x30, 0x10, 0x10, 0x10, 0x10, 0x38, 0x00}, // '1'
+    {0x38, 0x44, 0x04, 0x08, 0x10, 0x20, 0x7C, 0x00}, // '2'
+    {0x7C, 0x08, 0x10, 0x08, 0x04, 0x44, 0x38, 0x00}, // '3'
+    {0x08, 0x18, 0x28, 0x48, 0x7C, 0x08, 0x08, 0x00}, // '4'
+    {0x7C, 0x40, 0x78, 0x04, 0x04, 0x44, 0x38, 0x00}, // '5'
+    {0x18, 0x20, 0x40, 0x78, 0x44, 0x44, 0x38, 0x00}, // '6'
+    {0x7C, 0x04, 0x08, 0x10, 0x20, 0x20, 0x20, 0x00}, // '7'
+    {0x38, 0x44, 0x44, 0x38, 0x44, 0x44, 0x38, 0x00}, // '8'
+    {0x38, 0x44, 0x44, 0x3C, 0x04, 0x08, 0x30, 0x00}, // '9'
+    {0x00, 0x30, 0x30, 0x00, 0x30, 0x30, 0x00, 0x00}, // ':'
+    {0x00, 0x30, 0x30, 0x00, 0x30, 0x10, 0x20, 0x00}, // ';'
+    {0x08, 0x10, 0x20, 0x40, 0x20, 0x10, 0x08, 0x00}, // '<'
+    {0x00, 0x00, 0x7C, 0x00, 0x7C, 0x00, 0x00, 0x00}, // '='
+    {0x20, 0x10, 0x08, 0x04, 0x08, 0x10, 0x20, 0x00}, // '>'
+    {0x38, 0x44, 0x04, 0x08, 0x10, 0x00, 0x10, 0x00}, // '?'
+    {0x38, 0x44, 0x04, 0x34, 0x54, 0x54, 0x38, 0x00}, // '@'
+    {0x38, 0x44, 0x44, 0x44, 0x7C, 0x44, 0x44, 0x00}, // 'A'
+    {0x78, 0x44, 0x44, 0x78, 0x44, 0x44, 0x78, 0x00}, // 'B'
+    {0x38, 0x44, 0x40, 0x40, 0x40, 0x44, 0x38, 0x00}, // 'C'
+    {0x70, 0x48, 0x44, 0x44, 0x44, 0x48, 0x70, 0x00}, // 'D'
+    {0x7C, 0x40, 0x40, 0x78, 0x40, 0x40, 0x7C, 0x00}, // 'E'
+    {0x7C, 0x40, 0x40, 0x78, 0x40, 0x40, 0x40, 0x00}, // 'F'
+    {0x38, 0x44, 0x40, 0x5C, 0x44, 0x44, 0x3C, 0x00}, // 'G'
+    {0x44, 0x44, 0x44, 0x7C, 0x44, 0x44, 0x44, 0x00}, // 'H'
+    {0x38, 0x10, 0x10, 0x10, 0x10, 0x10, 0x38, 0x00}, // 'I'
+    {0x1C, 0x08, 0x08, 0x08, 0x08, 0x48, 0x30, 0x00}, // 'J'
+    {0x44, 0x48, 0x50, 0x60, 0x50, 0x48, 0x44, 0x00}, // 'K'
+    {0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x7C, 0x00}, // 'L'
+    {0x44, 0x6C, 0x54, 0x54, 0x44, 0x44, 0x44, 0x00}, // 'M'
+    {0x44, 0x44, 0x64, 0x54, 0x4C, 0x44, 0x44, 0x00}, // 'N'
+    {0x38, 0x44, 0x44, 0x44, 0x44, 0x44, 0x38, 0x00}, // 'O'
+    {0x78, 0x44, 0x44, 0x78, 0x40, 0x40, 0x40, 0x00}, // 'P'
+    {0x38, 0x44, 0x44, 0x44, 0x54, 0x48, 0x34, 0x00}, // 'Q'
+    {0x78, 0x44, 0x44, 0x78, 0x50, 0x48, 0x44, 0x00}, // 'R'
+    {0x3C, 0x40, 0x40, 0x38, 0x04, 0x04, 0x78, 0x00}, // 'S'
+    {0x7C, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00}, // 'T'
+    {0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x38, 0x00}, // 'U'
+    {0x44, 0x44, 0x44, 0x44, 0x44, 0x28, 0x10, 0x00}, // 'V'
+    {0x44, 0x44, 0x44, 0x54, 0x54, 0x54, 0x28, 0x00}, // 'W'
+    {0x44, 0x44, 0x28, 0x10, 0x28, 0x44, 0x44, 0x00}, // 'X'
+    {0x44, 0x44, 0x44, 0x28, 0x10, 0x10, 0x10, 0x00}, // 'Y'
+    {0x7C, 0x04, 0x08, 0x10, 0x20, 0x40, 0x7C, 0x00}, // 'Z'
+    {0x38, 0x20, 0x20, 0x20, 0x20, 0x20, 0x38, 0x00}, // '['
+    {0x00, 0x40, 0x20, 0x10, 0x08, 0x04, 0x00, 0x00}, // '\\'
+    {0x38, 0x08, 0x08, 0x08, 0x08, 0x08, 0x38, 0x00}, // ']'
+    {0x10, 0x28, 0x44, 0x00, 0x00, 0x00, 0x00, 0x00}, // '^'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7C, 0x00}, // '_'
+    {0x20, 0x10, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00}, // '`'
+    {0x00, 0x00, 0x38, 0x04, 0x3C, 0x44, 0x3C, 0x00}, // 'a'
+    {0x40, 0x40, 0x58, 0x64, 0x44, 0x44, 0x78, 0x00}, // 'b'
+    {0x00, 0x00, 0x38, 0x40, 0x40, 0x44, 0x38, 0x00}, // 'c'
+    {0x04, 0x04, 0x34, 0x4C, 0x44, 0x44, 0x3C, 0x00}, // 'd'
+    {0x00, 0x00, 0x38, 0x44, 0x7C, 0x40, 0x38, 0x00}, // 'e'
+    {0x18, 0x24, 0x20, 0x70, 0x20, 0x20, 0x20, 0x00}, // 'f'
+    {0x00, 0x3C, 0x44, 0x44, 0x3C, 0x04, 0x38, 0x00}, // 'g'
+    {0x40, 0x40, 0x58, 0x64, 0x44, 0x44, 0x44, 0x00}, // 'h'
+    {0x10, 0x00, 0x30, 0x10, 0x10, 0x10, 0x38, 0x00}, // 'i'
+    {0x08, 0x00, 0x18, 0x08, 0x08, 0x48, 0x30, 0x00}, // 'j'
+    {0x40, 0x40, 0x48, 0x50, 0x60, 0x50, 0x48, 0x00}, // 'k'
+    {0x30, 0x10, 0x10, 0x10, 0x10, 0x10, 0x38, 0x00}, // 'l'
+    {0x00, 0x00, 0x68, 0x54, 0x54, 0x44, 0x44, 0x00}, // 'm'
+    {0x00, 0x00, 0x58, 0x64, 0x44, 0x44, 0x44, 0x00}, // 'n'
+    {0x00, 0x00, 0x38, 0x44, 0x44, 0x44, 0x38, 0x00}, // 'o'
+    {0x00, 0x00, 0x78, 0x44, 0x78, 0x40, 0x40, 0x00}, // 'p'
+    {0x00, 0x00, 0x34, 0x4C, 0x3C, 0x04, 0x04, 0x00}, // 'q'
+    {0x00, 0x00, 0x58, 0x64, 0x40, 0x40, 0x40, 0x00}, // 'r'
+    {0x00, 0x00, 0x38, 0x40, 0x38, 0x04, 0x78, 0x00}, // 's'
+    {0x20, 0x20, 0x70, 0x20, 0x20, 0x24, 0x18, 0x00}, // 't'
+    {0x00, 0x00, 0x44, 0x44, 0x44, 0x4C, 0x34, 0x00}, // 'u'
+    {0x00, 0x00, 0x44, 0x44, 0x44, 0x28, 0x10, 0x00}, // 'v'
+    {0x00, 0x00, 0x44, 0x44, 0x54, 0x54, 0x28, 0x00}, // 'w'
+    {0x00, 0x00, 0x44, 0x28, 0x10, 0x28, 0x44, 0x00}, // 'x'
+    {0x00, 0x00, 0x44, 0x44, 0x3C, 0x04, 0x38, 0x00}, // 'y'
+    {0x00, 0x00, 0x7C, 0x08, 0x10, 0x20, 0x7C, 0x00}, // 'z'
+    {0x08, 0x10, 0x10, 0x20, 0x10, 0x10, 0x08, 0x00}, // '{'
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00}, // '|'
+    {0x20, 0x10, 0x10, 0x08, 0x10, 0x10, 0x20, 0x00}, // '}'
+    {0x00, 0x00, 0x20, 0x54, 0x08, 0x00, 0x00, 0x00}, // '~'
+    {0x7C, 0x44, 0x44, 0x44, 0x44, 0x44, 0x7C, 0x00}, // anything else
+};
+
+static struct
+{
+    cobalt_spinlock_t lock;
+    const cobalt_framebuffer_t *screen;
+    // The side of a cell in pixels.
+    cobalt_u64_t cellSize;
+    cobalt_u64_t columns;
+    cobalt_u64_t rows;
+    cobalt_u64_t column;
+    cobalt_u64_t row;
+    // The text as it should be, and as it was last drawn.
+    char *text;
+    char *shown;
+    // The rows whose text may differ from what was last drawn.
+    bool *dirty;
+    // Every glyph at the screen's scale and in its pixel format, each a
+    // square of cellSize rows.
+    cobalt_u32_t *glyphs;
+    cobalt_u32_t background;
+    cobalt_u64_t cellsDrawn;
+} console;
+
+static void rasterize(cobalt_u32_t foreground, cobalt_u32_t background)
+{
+    const cobalt_u64_t scale = console.cellSize / FONT_SIZE;
+    cobalt_u32_t *pixel = console.glyphs;
+    for (cobalt_u64_t glyph = 0; glyph < GLYPH_COUNT; glyph++)
+        for (cobalt_u64_t y = 0; y < console.cellSize; y++)
+            for (cobalt_u64_t x = 0; x < console.cellSize; x++)
+                *pixel++ = font[glyph][y / scale] & (0x80 >> (x / scale))
+                               ? foreground
+                               : background;
+}
+
+static const cobalt_u32_t *glyphOf(char character)
+{
+    const cobalt_u8_t code = (cobalt_u8_t)character;
+    const cobalt_u64_t glyph = code >= FIRST_GLYPH && code <= LAST_GLYPH
+                                   ? code - FIRST_GLYPH
+                                   : GLYPH_COUNT - 1;
+    return console.glyphs + glyph * console.cellSize * console.cellSize;
+}
+
+// Draw a run of cells along a row into the shadow buffer, and mark them
+// damaged.
+static void drawCells(cobalt_u64_t row, cobalt_u64_t first,
+                      cobalt_u64_t last)
+{
+    const cobalt_framebuffer_t *screen = console.screen;
+    const char *text = console.text + row * console.columns;
+    const cobalt_u64_t width = console.cellSize * sizeof(cobalt_u32_t);
+    cobalt_u32_t *scanline = screen->pixels +
+                             row * console.cellSize * screen->pitch +
+                             first * console.cellSize;
+    for (cobalt_u64_t y = 0; y < console.cellSize;
+         y++, scanline += screen->pitch)
+    {
+        cobalt_u32_t *pixel = scanline;
+        for (cobalt_u64_t column = first; column <= last;
+             column++, pixel += console.cellSize)
+            Cobalt_CopyMemory(pixel,
+                              glyphOf(text[column]) + y * console.cellSize,
+                              width);
+    }
+    Cobalt_DamageFramebuffer(first * console.cellSize,
+                             row * console.cellSize,
+                             (last - first + 1) * console.cellSize,
+                             console.cellSize);
+    console.cellsDrawn += last - first + 1;
+}
+
+// Redraw the cells of each dirty row that differ from what's on screen.
+// The lock must be held.
+static void redraw(void)
+{
+    for (cobalt_u64_t row = 0; row < console.rows; row++)
+    {
+        if (!console.dirty[row]) continue;
+        console.dirty[row] = false;
+
+        const cobalt_u64_t start = row * console.columns;
+        const char *text = console.text + start;
+        char *shown = console.shown + start;
+        cobalt_u64_t first = 0, last = console.columns;
+        while (first < console.columns && text[first] == shown[first])
+            first++;
+        if (first == console.columns) continue;
+        while (text[last - 1] == shown[last - 1]) last--;
+
+        drawCells(row, first, last - 1);
+        Cobalt_CopyMemory(shown + first, text + first, last - first);
+    }
+}
+
+static void newLine(void)
+{
+    console.column = 0;
+    if (console.row + 1 < console.rows)
+    {
+        console.row++;
+        return;
+    }
+
+    // Everything pending is drawn first, so that the shadow buffer
+    // matches the text and the two can move together.
+    redraw();
+    Cobalt_ScrollFramebuffer(console.cellSize, console.background);
+    const cobalt_u64_t kept = (console.rows - 1) * console.columns;
+    Cobalt_MoveMemory(console.text, console.text + console.columns, kept);
+    Cobalt_MoveMemory(console.shown, console.shown + console.columns,
+                      kept);
+    Cobalt_SetMemory(console.text + kept, ' ', console.columns);
+    Cobalt_SetMemory(console.shown + kept, ' ', console.columns);
+}
+
+// Write a character. The lock must be held.
+static void put(char character)
+{
+    switch (character)
+    {
+        case '\n': newLine(); return;
+        case '\r': console.column = 0; return;
+        case '\b':
+            if (console.column != 0) console.column--;
+            return;
+        case '\t':
+            do put(' ');
+            while (console.column % TAB_WIDTH != 0 &&
+                   console.column < console.columns);
+            return;
+        default: break;
+    }
+
+    // Wrapping waits for the next character, so a line that fills the
+    // row exactly isn't followed by an empty one.
+    if (console.column == console.columns) newLine();
+    console.text[console.row * console.columns + console.column] =
+        character;
+    console.dirty[console.row] = true;
+    console.column++;
+}
+
+static void putString(const char *string)
+{
+    for (; *string != 0; string++) put(*string);
+}
+
+static void putUnsigned(cobalt_u64_t value, cobalt_u64_t radix)
+{
+    char buffer[24];
+    char *cursor = buffer + sizeof(buffer);
+    *--cursor = 0;
+    do {
+        const cobalt_u64_t digit = value % radix;
+        *--cursor = (char)(digit < 10 ? '0' + digit : 'A' + digit - 10);
+        value /= radix;
+    } while (value != 0);
+    putString(cursor);
+}
+
+bool Cobalt_InitializeConsole(void)
+{
+    const cobalt_framebuffer_t *screen = Cobalt_GetFramebuffer();
+    if (screen == nullptr) return false;
+
+    cobalt_u64_t scale = screen->width / SCALE_WIDTH;
+    if (scale == 0) scale = 1;
+    if (scale > MAXIMUM_SCALE) scale = MAXIMUM_SCALE;
+    console.cellSize = FONT_SIZE * scale;
+    console.columns = screen->width / console.cellSize;
+    console.rows = screen->height / console.cellSize;
+    if (console.columns == 0 || console.rows == 0) return false;
+
+    const cobalt_u64_t cells = console.columns * console.rows;
+    console.text = Cobalt_Allocate(cells);
+    console.shown = Cobalt_Allocate(cells);
+    console.dirty = Cobalt_Allocate(console.rows * sizeof(bool));
+    console.glyphs =
+        Cobalt_Allocate(GLYPH_COUNT * console.cellSize * console.cellSize *
+                        sizeof(cobalt_u32_t));
+    if (console.text == nullptr || console.shown == nullptr ||
+        console.dirty == nullptr || console.glyphs == nullptr)
+    {
+        Cobalt_Free(console.text);
+        Cobalt_Free(console.shown);
+        Cobalt_Free(console.dirty);
+        Cobalt_Free(console.glyphs);
+        return false;
+    }
+
+    console.background = Cobalt_EncodeColour(BACKGROUND);
+    rasterize(Cobalt_EncodeColour(FOREGROUND), console.background);
+    Cobalt_FillRect(screen, 0, 0, screen->width, screen->height,
+                    console.background);
+    Cobalt_DamageFramebuffer(0, 0, screen->width, screen->height);
+    Cobalt_PresentFramebuffer();
+    Cobalt_SetMemory(console.text, ' ', cells);
+    Cobalt_SetMemory(console.shown, ' ', cells);
+    Cobalt_ZeroMemory(console.dirty, console.rows * sizeof(bool));
+
+    console.screen = screen;
+    return true;
+}
+
+void Cobalt_ConsolePuts(const char *string)
+{
+    if (console.screen == nullptr) return;
+
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    Cobalt_SpinLock(&console.lock);
+    putString(string);
+    redraw();
+    Cobalt_PresentFramebuffer();
+    Cobalt_SpinUnlock(&console.lock);
+    Cobalt_RestoreInterrupts(flags);
+}
+
+void Cobalt_ConsolePrintfv(const char *format, va_list args)
+{
+    if (console.screen == nullptr) return;
+
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    Cobalt_SpinLock(&console.lock);
+    for (; *format != 0; format++)
+    {
+        if (*format != '%')
+        {
+            put(*format);
+            continue;
+        }
+
+        switch (*++format)
+        {
+            case 's': putString(va_arg(args, const char *)); break;
+            case 'c': put((char)va_arg(args, int)); break;
+            case 'U': putUnsigned(va_arg(args, cobalt_u64_t), 10); break;
+            case 'X': putUnsigned(va_arg(args, cobalt_u64_t), 16); break;
+            case 'L':
+            {
+                const cobalt_i64_t value = va_arg(args, cobalt_i64_t);
+                if (value < 0) put('-');
+                putUnsigned(value < 0 ? -(cobalt_u64_t)value
+                                      : (cobalt_u64_t)value,
+                            10);
+                break;
+            }
+            case 0: format--; break;
+            default: put(*format); break;
+        }
+    }
+    redraw();
+    Cobalt_PresentFramebuffer();
+    Cobalt_SpinUnlock(&console.lock);
+    Cobalt_RestoreInterrupts(flags);
+}
+
+void Cobalt_ConsolePrintf(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    Cobalt_ConsolePrintfv(format, args);
+    va_end(args);
+}
+
+void Cobalt_BenchmarkConsole(void)
+{
+    if (console.screen == nullptr) return;
+
+    // Fill the screen first, so that every line after scrolls it.
+    for (cobalt_u64_t row = 0; row < console.rows; row++)
+        Cobalt_ConsolePuts("\n");
+
+    const cobalt_u64_t drawn = console.cellsDrawn;
+    const cobalt_u64_t start = Cobalt_MonotonicNanoseconds();
+    for (cobalt_u64_t line = 0; line < BENCHMARK_LINES; line++)
+        Cobalt_ConsolePrintf("console benchmark line %U of %U\n", line,
+                             (cobalt_u64_t)BENCHMARK_LINES);
+    const cobalt_u64_t elapsed = Cobalt_MonotonicNanoseconds() - start;
+    Cobalt_SerialPrintf("console: %U ns per scrolled line, %U of %U cells "
+                        "redrawn\n",
+                        elapsed / BENCHMARK_LINES,
+                        console.cellsDrawn - drawn,
+                        console.rows * console.columns * BENCHMARK_LINES);
+}
@@ -0,0 +1,395 @@
+/**
+ * @file Framebuffer.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the shadow-buffered framebuffer outlined
+ * in the Kernel/Framebuffer.h file.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <Blit.h>
+#include <CPU.h>
+#include <Kernel/Clock.h>
+#include <Kernel/Framebuffer.h>
+#include <Kernel/Scheduler.h>
+#include <Kernel/Serial.h>
+#include <Kernel/Spinlock.h>
+#include <Kernel/Timer.h>
+#include <Kernel/Virtual.h>
+#include <Memory.h>
+#include <Paging.h>
+#include <stdatomic.h>
+
+#define BENCHMARK_FRAMES 64
+// The rows each benchmarked scroll moves by, about a line of text.
+#define BENCHMARK_SCROLL 16
+
+// The edges of a rectangle, the right and bottom ones exclusive.
+typedef struct
+{
+    cobalt_u64_t left;
+    cobalt_u64_t top;
+    cobalt_u64_t right;
+    cobalt_u64_t bottom;
+} rect_t;
+
+static struct
+{
+    cobalt_framebuffer_t shadow;
+    cobalt_u32_t *device;
+    const EFI_GRAPHICS_OUTPUT_MODE_INFORMATION *info;
+    // This guards the damage alone; the shadow is the drawers' business.
+    cobalt_spinlock_t lock;
+    rect_t damage[COBALT_FRAMEBUFFER_MAXIMUM_DAMAGE];
+    cobalt_u32_t damaged;
+    cobalt_thread_t *flusher;
+    // Set when there's damage the flusher hasn't been told to take.
+    atomic_bool presented;
+} framebuffer;
+
+// Scale an eight-bit channel into the bits of a mask.
+static cobalt_u32_t encodeChannel(cobalt_u32_t value, cobalt_u32_t mask)
+{
+    if (mask == 0) return 0;
+    const cobalt_u32_t shift = (cobalt_u32_t)__builtin_ctz(mask);
+    const cobalt_u32_t bits = mask >> shift;
+    const cobalt_u32_t width =
+        bits == ~0U ? 32 : (cobalt_u32_t)__builtin_ctz(~bits);
+    value = width >= 8 ? value << (width - 8) : value >> (8 - width);
+    return (value << shift) & mask;
+}
+
+static rect_t unite(const rect_t *left, const rect_t *right)
+{
+    return (rect_t){
+        .left = left->left < right->left ? left->left : right->left,
+        .top = left->top < right->top ? left->top : right->top,
+        .right = left->right > right->right ? left->right : right->right,
+        .bottom =
+            left->bottom > right->bottom ? left->bottom : right->bottom};
+}
+
+static cobalt_u64_t area(const rect_t *rect)
+{
+    return (rect->right - rect->left) * (rect->bottom - rect->top);
+}
+
+// Whether two rectangles overlap or share an edge, in which case copying
+// their union costs next to nothing more than copying both.
+static bool touches(const rect_t *left, const rect_t *right)
+{
+    return left->left <= right->right && right->left <= left->right &&
+           left->top <= right->bottom && right->top <= left->bottom;
+}
+
+// Copy a run of pixels out with non-temporal stores, which go out through
+// the write-combining buffers in whole lines without reading anything
+// back, whatever type the framebuffer's memory turned out to be.
+static void streamPixels(cobalt_u32_t *destination,
+                         const cobalt_u32_t *source, cobalt_u64_t count)
+{
+    if (count != 0 && ((cobalt_u64_t)destination & 4) != 0)
+    {
+        __asm__ volatile("movnti %1, %0"
+                         : "=m"(*destination)
+                         : "r"(*source));
+        destination++;
+        source++;
+        count--;
+    }
+    for (; count >= 2; count -= 2, destination += 2, source += 2)
+    {
+        cobalt_u64_t pair;
+        __builtin_memcpy(&pair, source, sizeof(pair));
+        __asm__ volatile("movnti %1, %0"
+                         : "=m"(*(cobalt_u64_t *)destination)
+                         : "r"(pair));
+    }
+    if (count != 0)
+        __asm__ volatile("movnti %1, %0"
+                         : "=m"(*destination)
+                         : "r"(*source));
+}
+
+static void unmapBuffer(void *buffer, cobalt_u64_t size)
+{
+    size = (size + COBALT_PAGE_SIZE - 1) & ~(COBALT_PAGE_SIZE - 1);
+    Cobalt_UnmapRegion(Cobalt_KernelAddressSpace(), (cobalt_u64_t)buffer,
+                       size);
+}
+
+static void runFlusher(void *argument)
+{
+    (void)argument;
+    for (;;)
+    {
+        // A wakeup can be eaten by the sleep below, so the flag is what
+        // says whether there's work.
+        while (!atomic_exchange(&framebuffer.presented, false))
+            Cobalt_BlockThread();
+
+        const cobalt_u64_t start = Cobalt_MonotonicNanoseconds();
+        Cobalt_FlushFramebuffer();
+        // Whatever's presented before the next frame is due waits for
+        // it, and goes out together with everything else presented by
+        // then.
+        const cobalt_u64_t elapsed = Cobalt_MonotonicNanoseconds() - start;
+        if (elapsed < COBALT_FRAMEBUFFER_INTERVAL)
+            Cobalt_Sleep(COBALT_FRAMEBUFFER_INTERVAL - elapsed);
+    }
+}
+
+bool Cobalt_InitializeFramebuffer(const cobalt_efi_info_t *efiInfo)
+{
+    const EFI_GRAPHICS_OUTPUT_PROTOCOL_MODE *mode = &efiInfo->graphicsMode;
+    if (mode->FrameBufferSize == 0 || mode->Info == nullptr) return false;
+    const EFI_GRAPHICS_OUTPUT_MODE_INFORMATION *info =
+        Cobalt_PhysicalToVirtual((cobalt_u64_t)mode->Info);
+    // Without a framebuffer, the screen could only be drawn to through
+    // the firmware, which is long gone.
+    if (info->PixelFormat >= PixelBltOnly) return false;
+
+    const cobalt_u64_t size = (cobalt_u64_t)info->PixelsPerScanLine *
+                              info->VerticalResolution *
+                              sizeof(cobalt_u32_t);
+    if (size == 0 || size > mode->FrameBufferSize) return false;
+    cobalt_u32_t *pixels =
+        Cobalt_MapKernelMemory(size, COBALT_REGION_WRITABLE);
+    if (pixels == nullptr) return false;
+    cobalt_u32_t *device = Cobalt_MapDevice(
+        mode->FrameBufferBase, size,
+        COBALT_REGION_WRITABLE | COBALT_REGION_WRITE_COMBINING);
+    if (device == nullptr)
+    {
+        unmapBuffer(pixels, size);
+        return false;
+    }
+
+    framebuffer.info = info;
+    framebuffer.shadow = (cobalt_framebuffer_t){
+        .pixels = pixels,
+        .width = info->HorizontalResolution,
+        .height = info->VerticalResolution,
+        .pitch = info->PixelsPerScanLine};
+    framebuffer.device = device;
+    return true;
+}
+
+bool Cobalt_StartFramebufferFlusher(void)
+{
+    if (framebuffer.device == nullptr) return false;
+    framebuffer.flusher =
+        Cobalt_CreateThread(runFlusher, nullptr, COBALT_PRIORITY_HIGH);
+    return framebuffer.flusher != nullptr;
+}
+
+const cobalt_framebuffer_t *Cobalt_GetFramebuffer(void)
+{
+    return framebuffer.device != nullptr ? &framebuffer.shadow : nullptr;
+}
+
+cobalt_u32_t Cobalt_EncodeColour(cobalt_u32_t colour)
+{
+    const EFI_GRAPHICS_OUTPUT_MODE_INFORMATION *info = framebuffer.info;
+    const cobalt_u32_t red = (colour >> 16) & 0xFF;
+    const cobalt_u32_t green = (colour >> 8) & 0xFF;
+    const cobalt_u32_t blue = colour & 0xFF;
+    switch (info->PixelFormat)
+    {
+        case PixelRedGreenBlueReserved8BitPerColor:
+            return red | green << 8 | blue << 16;
+        case PixelBlueGreenRedReserved8BitPerColor: return colour;
+        default:
+            return encodeChannel(red, info->PixelInformation.RedMask) |
+                   encodeChannel(green, info->PixelInformation.GreenMask) |
+                   encodeChannel(blue, info->PixelInformation.BlueMask);
+    }
+}
+
+void Cobalt_DamageFramebuffer(cobalt_u64_t x, cobalt_u64_t y,
+                              cobalt_u64_t width, cobalt_u64_t height)
+{
+    const cobalt_framebuffer_t *shadow = &framebuffer.shadow;
+    if (x >= shadow->width || y >= shadow->height) return;
+    if (width > shadow->width - x) width = shadow->width - x;
+    if (height > shadow->height - y) height = shadow->height - y;
+    if (width == 0 || height == 0) return;
+    rect_t rect = {x, y, x + width, y + height};
+
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    Cobalt_SpinLock(&framebuffer.lock);
+    // Swallow every rectangle this one touches. Each merge can make it
+    // touch one it didn't before, so start over after each.
+    for (cobalt_u32_t i = 0; i < framebuffer.damaged;)
+    {
+        if (!touches(&framebuffer.damage[i], &rect))
+        {
+            i++;
+            continue;
+        }
+        rect = unite(&framebuffer.damage[i], &rect);
+        framebuffer.damage[i] = framebuffer.damage[--framebuffer.damaged];
+        i = 0;
+    }
+
+    if (framebuffer.damaged < COBALT_FRAMEBUFFER_MAXIMUM_DAMAGE)
+        framebuffer.damage[framebuffer.damaged++] = rect;
+    else
+    {
+        cobalt_u32_t best = 0;
+        cobalt_u64_t bestGrowth = ~0UL;
+        for (cobalt_u32_t i = 0; i < framebuffer.damaged; i++)
+        {
+            const rect_t merged = unite(&framebuffer.damage[i], &rect);
+            const cobalt_u64_t growth =
+                area(&merged) - area(&framebuffer.damage[i]);
+            if (growth < bestGrowth)
+            {
+                best = i;
+                bestGrowth = growth;
+            }
+        }
+        framebuffer.damage[best] = unite(&framebuffer.damage[best], &rect);
+    }
+    Cobalt_SpinUnlock(&framebuffer.lock);
+    Cobalt_RestoreInterrupts(flags);
+}
+
+void Cobalt_ScrollFramebuffer(cobalt_u64_t lines, cobalt_u32_t colour)
+{
+    const cobalt_framebuffer_t *shadow = &framebuffer.shadow;
+    if (framebuffer.device == nullptr || lines == 0) return;
+    if (lines > shadow->height) lines = shadow->height;
+
+    const cobalt_u64_t kept = shadow->height - lines;
+    Cobalt_MoveMemory(shadow->pixels,
+                      shadow->pixels + lines * shadow->pitch,
+                      kept * shadow->pitch * sizeof(cobalt_u32_t));
+    Cobalt_FillRect(shadow, 0, kept, shadow->width, lines, colour);
+    Cobalt_DamageFramebuffer(0, 0, shadow->width, shadow->height);
+}
+
+void Cobalt_FlushFramebuffer(void)
+{
+    if (framebuffer.device == nullptr) return;
+
+    // The damage is taken whole, so anything drawn while it's being
+    // copied out is marked afresh and caught by the next flush.
+    rect_t damage[COBALT_FRAMEBUFFER_MAXIMUM_DAMAGE];
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    Cobalt_SpinLock(&framebuffer.lock);
+    const cobalt_u32_t damaged = framebuffer.damaged;
+    for (cobalt_u32_t i = 0; i < damaged; i++)
+        damage[i] = framebuffer.damage[i];
+    framebuffer.damaged = 0;
+    Cobalt_SpinUnlock(&framebuffer.lock);
+    Cobalt_RestoreInterrupts(flags);
+
+    const cobalt_u64_t pitch = framebuffer.shadow.pitch;
+    for (cobalt_u32_t i = 0; i < damaged; i++)
+        for (cobalt_u64_t y = damage[i].top; y < damage[i].bottom; y++)
+        {
+            const cobalt_u64_t start = y * pitch + damage[i].left;
+            streamPixels(framebuffer.device + start,
+                         framebuffer.shadow.pixels + start,
+                         damage[i].right - damage[i].left);
+        }
+
+    // Non-temporal stores are weakly ordered; fence them so the frame is
+    // out before anything that follows.
+    __asm__ volatile("sfence" : : : "memory");
+}
+
+void Cobalt_PresentFramebuffer(void)
+{
+    if (framebuffer.flusher == nullptr)
+    {
+        Cobalt_FlushFramebuffer();
+        return;
+    }
+    if (!atomic_exchange(&framebuffer.presented, true))
+        Cobalt_WakeThread(framebuffer.flusher);
+}
+
+void Cobalt_BenchmarkFramebuffer(void)
+{
+    const cobalt_framebuffer_t *shadow = &framebuffer.shadow;
+    if (framebuffer.device == nullptr) return;
+
+    // The shadow is kept aside and put back afterward.
+    const cobalt_u64_t size =
+        shadow->height * shadow->pitch * sizeof(cobalt_u32_t);
+    cobalt_u32_t *saved =
+        Cobalt_MapKernelMemory(size, COBALT_REGION_WRITABLE);
+    if (saved == nullptr) return;
+    Cobalt_CopyMemory(saved, shadow->pixels, size);
+
+    const cobalt_u64_t pixels = shadow->width * shadow->height;
+    cobalt_u64_t start = Cobalt_MonotonicNanoseconds();
+    for (cobalt_u32_t frame = 0; frame < BENCHMARK_FRAMES; frame++)
+    {
+        const cobalt_u32_t colour =
+            Cobalt_EncodeColour(frame & 1 ? 0x202020 : 0x404040);
+        Cobalt_FillRect(shadow, 0, 0, shadow->width, shadow->height,
+                        colour);
+        Cobalt_DamageFramebuffer(0, 0, shadow->width, shadow->height);
+        Cobalt_FlushFramebuffer();
+    }
+    const cobalt_u64_t redraw =
+        (Cobalt_MonotonicNanoseconds() - start) / BENCHMARK_FRAMES;
+
+    cobalt_u64_t scrolling = 0;
+    start = Cobalt_MonotonicNanoseconds();
+    for (cobalt_u32_t frame = 0; frame < BENCHMARK_FRAMES; frame++)
+    {
+        const cobalt_u64_t scrolled = Cobalt_MonotonicNanoseconds();
+        Cobalt_ScrollFramebuffer(BENCHMARK_SCROLL,
+                                 Cobalt_EncodeColour(frame * 0x040404));
+        scrolling += Cobalt_MonotonicNanoseconds() - scrolled;
+        Cobalt_FlushFramebuffer();
+    }
+    const cobalt_u64_t scroll =
+        (Cobalt_MonotonicNanoseconds() - start) / BENCHMARK_FRAMES;
+
+    Cobalt_CopyMemory(shadow->pixels, saved, size);
+    Cobalt_DamageFramebuffer(0, 0, shadow->width, shadow->height);
+    Cobalt_PresentFramebuffer();
+    unmapBuffer(saved, size);
+
+    // Pixels per microsecond are megapixels per second.
+    Cobalt_SerialPrintf("framebuffer: redraw %U us (%U Mpx/s), scroll %U "
+                        "us (%U us of it in the shadow)\n",
+                        redraw / 1000, pixels * 1000 / (redraw + 1),
+                        scroll / 1000,
+                        scrolling / BENCHMARK_FRAMES / 1000);
+
+    // The drawing primitives' vector paths can only run with interrupts
+    // disabled, as nothing saves the vector state across a switch.
+    static const char *const operations[] = {"fill", "copy", "blend",
+                                             "convert"};
+    const cobalt_u64_t scratchSize = 2 * COBALT_BLIT_BENCHMARK_SIZE *
+                                     COBALT_BLIT_BENCHMARK_SIZE *
+                                     sizeof(cobalt_u32_t);
+    cobalt_u32_t *scratch =
+        Cobalt_MapKernelMemory(scratchSize, COBALT_REGION_WRITABLE);
+    if (scratch == nullptr) return;
+
+    cobalt_u64_t results[COBALT_BLIT_OPERATION_COUNT]
+                        [COBALT_BLIT_PATH_COUNT];
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    Cobalt_BenchmarkBlit(scratch, Cobalt_ClockFrequency() / 1000000,
+                         results);
+    Cobalt_RestoreInterrupts(flags);
+    unmapBuffer(scratch, scratchSize);
+
+    for (cobalt_u32_t i = 0; i < COBALT_BLIT_OPERATION_COUNT; i++)
+        Cobalt_SerialPrintf("blit: %s scalar %U, SSE2 %U, AVX2 %U Mpx/s\n",
+                            operations[i], results[i][COBALT_BLIT_SCALAR],
+                            results[i][COBALT_BLIT_SSE2],
+                            results[i][COBALT_BLIT_AVX2]);
+}
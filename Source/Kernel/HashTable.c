@@ -0,0 +1,266 @@
+/**
+ * @file HashTable.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the hash table outlined in the
+ * Kernel/HashTable.h file.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <CPU.h>
+#include <Kernel/CPU.h>
+#include <Kernel/HashTable.h>
+#include <Kernel/Heap.h>
+#include <Kernel/Locks.h>
+#include <Kernel/RCU.h>
+#include <Kernel/Scheduler.h>
+#include <Kernel/Serial.h>
+#include <Kernel/Spinlock.h>
+#include <Memory.h>
+#include <stdatomic.h>
+
+// The order of the benchmark's table, which holds a key per bucket.
+#define BENCHMARK_ORDER 10
+
+// The lookups each of the benchmark's threads makes.
+#define BENCHMARK_LOOKUPS (1 << 18)
+
+typedef struct entry
+{
+    // This must stay first, since the callback that frees the entry is
+    // handed a pointer to it.
+    cobalt_rcu_head_t head;
+    _Atomic(struct entry *) next;
+    cobalt_u64_t key;
+    void *value;
+} entry_t;
+
+struct cobalt_hash_table
+{
+    // Guards every change to the buckets.
+    cobalt_spinlock_t lock;
+    cobalt_u32_t shift;
+    _Atomic(entry_t *) buckets[];
+};
+
+// Fibonacci hashing: the top bits of the key times 2^64 over the golden
+// ratio, which spreads out keys that only differ in their low bits.
+static _Atomic(entry_t *) *bucket(cobalt_hash_table_t *table,
+                                  cobalt_u64_t key)
+{
+    return &table->buckets[(key * 0x9E3779B97F4A7C15ULL) >> table->shift];
+}
+
+// Find the link that points at the entry of a key, or at nullptr if
+// there's none. Outside the table's lock, this must be in a read section.
+static _Atomic(entry_t *) *find(cobalt_hash_table_t *table,
+                                cobalt_u64_t key)
+{
+    _Atomic(entry_t *) *link = bucket(table, key);
+    entry_t *entry;
+    while ((entry = atomic_load_explicit(link, memory_order_acquire)) !=
+               nullptr &&
+           entry->key != key)
+        link = &entry->next;
+    return link;
+}
+
+static void freeEntry(cobalt_rcu_head_t *head) { Cobalt_Free(head); }
+
+cobalt_hash_table_t *Cobalt_CreateHashTable(cobalt_u32_t order)
+{
+    const cobalt_u64_t size = sizeof(cobalt_hash_table_t) +
+                              (sizeof(_Atomic(entry_t *)) << order);
+    cobalt_hash_table_t *table = Cobalt_Allocate(size);
+    if (table == nullptr) return nullptr;
+    Cobalt_ZeroMemory(table, size);
+    table->shift = 64 - order;
+    return table;
+}
+
+void Cobalt_DestroyHashTable(cobalt_hash_table_t *table)
+{
+    // Lookups that started before this might still be walking the
+    // buckets.
+    Cobalt_SynchronizeRCU();
+    for (cobalt_u64_t i = 0; i < 1UL << (64 - table->shift); i++)
+    {
+        entry_t *entry = atomic_load(&table->buckets[i]);
+        while (entry != nullptr)
+        {
+            entry_t *next = atomic_load(&entry->next);
+            Cobalt_Free(entry);
+            entry = next;
+        }
+    }
+    Cobalt_Free(table);
+}
+
+bool Cobalt_HashTableInsert(cobalt_hash_table_t *table, cobalt_u64_t key,
+                            void *value)
+{
+    entry_t *entry = Cobalt_Allocate(sizeof(entry_t));
+    if (entry == nullptr) return false;
+    entry->key = key;
+    entry->value = value;
+
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    Cobalt_SpinLock(&table->lock);
+    _Atomic(entry_t *) *link = find(table, key);
+    entry_t *old = atomic_load_explicit(link, memory_order_relaxed);
+    // A replacement takes the old entry's place, so that lookups of the
+    // key see one or the other; a new key goes at the front of its
+    // bucket.
+    if (old == nullptr) link = bucket(table, key);
+    entry_t *next = atomic_load_explicit(
+        old != nullptr ? &old->next : link, memory_order_relaxed);
+    atomic_store_explicit(&entry->next, next, memory_order_relaxed);
+    atomic_store_explicit(link, entry, memory_order_release);
+    Cobalt_SpinUnlock(&table->lock);
+    Cobalt_RestoreInterrupts(flags);
+
+    if (old != nullptr) Cobalt_CallRCU(&old->head, freeEntry);
+    return true;
+}
+
+void *Cobalt_HashTableLookup(cobalt_hash_table_t *table, cobalt_u64_t key)
+{
+    Cobalt_RCUReadLock();
+    const entry_t *entry =
+        atomic_load_explicit(find(table, key), memory_order_acquire);
+    void *value = entry != nullptr ? entry->value : nullptr;
+    Cobalt_RCUReadUnlock();
+    return value;
+}
+
+bool Cobalt_HashTableRemove(cobalt_hash_table_t *table, cobalt_u64_t key)
+{
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    Cobalt_SpinLock(&table->lock);
+    _Atomic(entry_t *) *link = find(table, key);
+    entry_t *entry = atomic_load_explicit(link, memory_order_relaxed);
+    // Lookups already past the link can still walk on from the entry,
+    // since its own link is left as it is.
+    if (entry != nullptr)
+        atomic_store_explicit(
+            link, atomic_load_explicit(&entry->next, memory_order_relaxed),
+            memory_order_release);
+    Cobalt_SpinUnlock(&table->lock);
+    Cobalt_RestoreInterrupts(flags);
+
+    if (entry == nullptr) return false;
+    Cobalt_CallRCU(&entry->head, freeEntry);
+    return true;
+}
+
+typedef struct
+{
+    cobalt_hash_table_t *table;
+    // Whether lookups take the reader-writer lock instead of going
+    // through RCU.
+    bool locked;
+    cobalt_rwlock_t rwlock;
+    cobalt_completion_t done;
+    atomic_ulong misses;
+} benchmark_t;
+
+static cobalt_u64_t timestampRate;
+
+static void benchmarkWorker(void *argument)
+{
+    benchmark_t *benchmark = argument;
+    const cobalt_u64_t keys = 1UL << BENCHMARK_ORDER;
+    cobalt_u64_t state = Cobalt_ReadTimestamp() | 1;
+    cobalt_u64_t misses = 0;
+
+    for (cobalt_u32_t i = 0; i < BENCHMARK_LOOKUPS; i++)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        const cobalt_u64_t key = state & (keys - 1);
+
+        void *value;
+        if (benchmark->locked)
+        {
+            Cobalt_ReadLock(&benchmark->rwlock);
+            const entry_t *entry = atomic_load_explicit(
+                find(benchmark->table, key), memory_order_acquire);
+            value = entry != nullptr ? entry->value : nullptr;
+            Cobalt_ReadUnlock(&benchmark->rwlock);
+        }
+        else value = Cobalt_HashTableLookup(benchmark->table, key);
+        if (value != (void *)(key + 1)) misses++;
+    }
+
+    atomic_fetch_add(&benchmark->misses, misses);
+    Cobalt_SignalCompletion(&benchmark->done);
+}
+
+// Run one round of the benchmark, and return the lookups per millisecond
+// made.
+static cobalt_u64_t runRound(benchmark_t *benchmark, cobalt_u64_t threads)
+{
+    Cobalt_InitializeCompletion(&benchmark->done, threads);
+
+    cobalt_u64_t started = 0;
+    const cobalt_u64_t start = Cobalt_ReadTimestamp();
+    for (cobalt_u64_t i = 0; i < threads; i++)
+    {
+        if (Cobalt_CreateThread(benchmarkWorker, benchmark,
+                                COBALT_PRIORITY_NORMAL) != nullptr)
+            started++;
+        else Cobalt_SignalCompletion(&benchmark->done);
+    }
+    Cobalt_WaitForCompletion(&benchmark->done);
+    cobalt_u64_t microseconds =
+        (Cobalt_ReadTimestamp() - start) / timestampRate;
+    if (microseconds == 0) microseconds = 1;
+    return started * BENCHMARK_LOOKUPS * 1000 / microseconds;
+}
+
+void Cobalt_BenchmarkHashTable(cobalt_u64_t ticksPerMicrosecond)
+{
+    timestampRate = ticksPerMicrosecond;
+    benchmark_t benchmark = {
+        .table = Cobalt_CreateHashTable(BENCHMARK_ORDER)};
+    if (benchmark.table == nullptr) return;
+
+    // Fill the table, then replace every entry once, so that there's
+    // something for the grace periods to free.
+    const cobalt_u64_t keys = 1UL << BENCHMARK_ORDER;
+    for (cobalt_u64_t pass = 0; pass < 2; pass++)
+        for (cobalt_u64_t key = 0; key < keys; key++)
+            Cobalt_HashTableInsert(benchmark.table, key,
+                                   (void *)(key + 1));
+
+    const cobalt_u64_t processors =
+        (cobalt_u64_t)__builtin_popcountll(Cobalt_OnlineCPUs());
+    for (cobalt_u32_t locked = 0; locked < 2; locked++)
+    {
+        benchmark.locked = locked;
+        for (cobalt_u64_t threads = 1;; threads *= 2)
+        {
+            if (threads > processors) threads = processors;
+            Cobalt_SerialPrintf("hash table: %s, %U threads: %U "
+                                "lookups/ms\n",
+                                locked ? "rwlock" : "RCU", threads,
+                                runRound(&benchmark, threads));
+            if (threads == processors) break;
+        }
+    }
+    if (atomic_load(&benchmark.misses) != 0)
+        Cobalt_SerialPrintf("hash table: %U lookups missed\n",
+                            atomic_load(&benchmark.misses));
+
+    Cobalt_DestroyHashTable(benchmark.table);
+    cobalt_rcu_stats_t stats;
+    Cobalt_GetRCUStats(&stats);
+    Cobalt_SerialPrintf("rcu: %U grace periods, %U callbacks\n",
+                        stats.gracePeriods, stats.callbacks);
+}
@@ -0,0 +1,538 @@
+/**
+ * @file Heap.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the heap outlined in the Kernel/Heap.h
+ * file.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <Kernel/CPU.h>
+#include <Kernel/Heap.h>
+#include <Kernel/Spinlock.h>
+#include <Memory.h>
+#include <Paging.h>
+
+#ifdef COBALT_HOSTED
+#include <stdatomic.h>
+#include <stdlib.h>
+#else
+#include <CPU.h>
+#include <Kernel/Physical.h>
+#endif
+
+#define CHUNK_PAGES (1U << COBALT_HEAP_CHUNK_ORDER)
+#define CHUNK_SIZE (COBALT_PAGE_SIZE << COBALT_HEAP_CHUNK_ORDER)
+#define CLASS_COUNT 28
+
+// The fewest objects a run of any size class holds.
+#define MINIMUM_OBJECTS 8
+
+// Everything the heap needs from its surroundings: blocks of 2^order
+// pages aligned to their size, a way to keep this processor to itself,
+// and the index of its arena.
+#ifdef COBALT_HOSTED
+#define MAXIMUM_BLOCK_ORDER 20
+
+static void *allocateBlock(cobalt_u32_t order)
+{
+    const cobalt_u64_t size = COBALT_PAGE_SIZE << order;
+    return aligned_alloc(size, size);
+}
+
+static void freeBlock(void *block, cobalt_u32_t order)
+{
+    (void)order;
+    free(block);
+}
+
+static cobalt_u64_t enter(void) { return 0; }
+
+static void leave(cobalt_u64_t flags) { (void)flags; }
+
+// Threads take arenas in turn. Past COBALT_MAXIMUM_CPUS threads they
+// start to share, which the arena locks already allow for.
+static cobalt_u32_t arenaIndex(void)
+{
+    static atomic_uint nextIndex;
+    static _Thread_local cobalt_u32_t index = ~0U;
+    if (index == ~0U)
+        index = atomic_fetch_add(&nextIndex, 1) % COBALT_MAXIMUM_CPUS;
+    return index;
+}
+#else
+#define MAXIMUM_BLOCK_ORDER COBALT_PHYSICAL_MAXIMUM_ORDER
+
+static void *allocateBlock(cobalt_u32_t order)
+{
+    const cobalt_u64_t address = Cobalt_AllocatePages(order);
+    return address != 0 ? Cobalt_PhysicalToVirtual(address) : nullptr;
+}
+
+static void freeBlock(void *block, cobalt_u32_t order)
+{
+    Cobalt_FreePages(Cobalt_VirtualToPhysical(block), order);
+}
+
+static cobalt_u64_t enter(void) { return Cobalt_DisableInterrupts(); }
+
+static void leave(cobalt_u64_t flags) { Cobalt_RestoreInterrupts(flags); }
+
+static cobalt_u32_t arenaIndex(void) { return Cobalt_CPUIndex(); }
+#endif
+
+// Sixteen-byte steps up to 128, then four classes to each doubling, which
+// keeps the space lost to rounding under a fifth.
+static const cobalt_u16_t classSizes[CLASS_COUNT] = {
+    16,   32,   48,   64,   80,   96,   112,  128,  160,  192,
+    224,  256,  320,  384,  448,  512,  640,  768,  896,  1024,
+    1280, 1536, 1792, 2048, 2560, 3072, 3584, 4096};
+
+typedef enum : cobalt_u8_t
+{
+    RUN_FREE,
+    RUN_SMALL,
+    RUN_LARGE
+} run_kind_t;
+
+// The descriptor of one page of a chunk. A run is a stretch of pages
+// described by the descriptor of its first page; the rest of its pages
+// only point back to that one.
+typedef struct run
+{
+    // The links of a small run in its arena's bin, while it has objects
+    // free.
+    struct run *next;
+    struct run *previous;
+    // The freed objects of a small run, chained through their first
+    // word. Objects past the carved count have never been handed out.
+    void *free;
+    // The length of the run. A free run keeps this on both its first and
+    // last page, so that a run freed on either side can merge with it.
+    cobalt_u32_t pageCount;
+    // The first page of the run this page belongs to.
+    cobalt_u16_t head;
+    cobalt_u16_t used;
+    cobalt_u16_t carved;
+    cobalt_u16_t capacity;
+    cobalt_u8_t sizeClass;
+    run_kind_t kind;
+} run_t;
+
+typedef struct arena arena_t;
+
+// A chunk is a naturally aligned block from the physical allocator which
+// starts with this header, so a block's chunk is found by rounding its
+// address down. Blocks too large for a chunk get a block of their own
+// with a single page in front, of which only the first two fields are
+// used.
+typedef struct chunk
+{
+    bool huge;
+    cobalt_u32_t order;
+    struct chunk *next;
+    struct chunk *previous;
+    arena_t *arena;
+    cobalt_u32_t freePages;
+    run_t pages[CHUNK_PAGES];
+} chunk_t;
+
+#define HEADER_PAGES                                                      \
+    ((cobalt_u32_t)((sizeof(chunk_t) + COBALT_PAGE_SIZE - 1) /            \
+                    COBALT_PAGE_SIZE))
+
+struct arena
+{
+    alignas(COBALT_CACHE_LINE_SIZE) cobalt_spinlock_t lock;
+    chunk_t *chunks;
+    cobalt_u64_t chunkCount;
+    // The small runs of each class with objects free.
+    run_t *bins[CLASS_COUNT];
+
+    // These are kept per arena, and only mean anything summed, since a
+    // block freed on another processor is counted against the arena it
+    // came from, and a huge block against whichever arena was handy.
+    cobalt_u64_t activeBytes;
+    cobalt_u64_t mappedBytes;
+    cobalt_u64_t allocations;
+    cobalt_u64_t frees;
+};
+
+static arena_t arenas[COBALT_MAXIMUM_CPUS];
+
+static cobalt_u64_t alignUp(cobalt_u64_t value, cobalt_u64_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static cobalt_u32_t sizeClass(cobalt_u64_t size)
+{
+    if (size <= 128) return (cobalt_u32_t)((size + 15) / 16) - 1;
+
+    // The top bit of the last byte picks the doubling, and the two bits
+    // below it pick the quarter.
+    const cobalt_u64_t last = size - 1;
+    const cobalt_u32_t bit = 63 - (cobalt_u32_t)__builtin_clzl(last);
+    return 8 + (bit - 7) * 4 + (cobalt_u32_t)((last >> (bit - 2)) & 3);
+}
+
+static chunk_t *chunkOf(const void *address)
+{
+    return (chunk_t *)((cobalt_u64_t)address & ~(CHUNK_SIZE - 1));
+}
+
+static run_t *runOf(chunk_t *chunk, const void *address)
+{
+    const cobalt_u64_t page =
+        ((cobalt_u64_t)address - (cobalt_u64_t)chunk) / COBALT_PAGE_SIZE;
+    return &chunk->pages[chunk->pages[page].head];
+}
+
+static cobalt_u8_t *runAddress(chunk_t *chunk, const run_t *run)
+{
+    return (cobalt_u8_t *)chunk +
+           (cobalt_u64_t)(run - chunk->pages) * COBALT_PAGE_SIZE;
+}
+
+static void binPush(run_t **bin, run_t *run)
+{
+    run->previous = nullptr;
+    run->next = *bin;
+    if (*bin != nullptr) (*bin)->previous = run;
+    *bin = run;
+}
+
+static void binRemove(run_t **bin, run_t *run)
+{
+    if (run->previous != nullptr) run->previous->next = run->next;
+    else *bin = run->next;
+    if (run->next != nullptr) run->next->previous = run->previous;
+}
+
+static void setFree(chunk_t *chunk, cobalt_u32_t start, cobalt_u32_t count)
+{
+    run_t *first = &chunk->pages[start];
+    run_t *last = &chunk->pages[start + count - 1];
+    first->kind = last->kind = RUN_FREE;
+    first->pageCount = last->pageCount = count;
+    first->head = last->head = (cobalt_u16_t)start;
+}
+
+static chunk_t *newChunk(arena_t *arena)
+{
+    chunk_t *chunk = allocateBlock(COBALT_HEAP_CHUNK_ORDER);
+    if (chunk == nullptr) return nullptr;
+
+    chunk->huge = false;
+    chunk->arena = arena;
+    chunk->freePages = CHUNK_PAGES - HEADER_PAGES;
+    setFree(chunk, HEADER_PAGES, CHUNK_PAGES - HEADER_PAGES);
+
+    chunk->previous = nullptr;
+    chunk->next = arena->chunks;
+    if (arena->chunks != nullptr) arena->chunks->previous = chunk;
+    arena->chunks = chunk;
+    arena->chunkCount++;
+    arena->mappedBytes += CHUNK_SIZE;
+    return chunk;
+}
+
+// Carve a run out of the first free run of a chunk it fits in, with its
+// first page a multiple of alignPages into the chunk.
+static run_t *takeFromChunk(chunk_t *chunk, cobalt_u32_t count,
+                            cobalt_u32_t alignPages, run_kind_t kind)
+{
+    cobalt_u32_t index = HEADER_PAGES;
+    while (index < CHUNK_PAGES)
+    {
+        const run_t *run = &chunk->pages[index];
+        const cobalt_u32_t end = index + run->pageCount;
+        const cobalt_u32_t start =
+            (cobalt_u32_t)alignUp(index, alignPages);
+        if (run->kind != RUN_FREE || start + count > end)
+        {
+            index = end;
+            continue;
+        }
+
+        if (start != index) setFree(chunk, index, start - index);
+        if (start + count != end)
+            setFree(chunk, start + count, end - start - count);
+        for (cobalt_u32_t i = start; i < start + count; i++)
+        {
+            chunk->pages[i].kind = kind;
+            chunk->pages[i].head = (cobalt_u16_t)start;
+        }
+        chunk->pages[start].pageCount = count;
+        chunk->freePages -= count;
+        return &chunk->pages[start];
+    }
+    return nullptr;
+}
+
+static run_t *takeRun(arena_t *arena, cobalt_u32_t count,
+                      cobalt_u32_t alignPages, run_kind_t kind)
+{
+    for (chunk_t *chunk = arena->chunks; chunk != nullptr;
+         chunk = chunk->next)
+    {
+        if (chunk->freePages < count) continue;
+        run_t *run = takeFromChunk(chunk, count, alignPages, kind);
+        if (run != nullptr) return run;
+    }
+
+    chunk_t *chunk = newChunk(arena);
+    if (chunk == nullptr) return nullptr;
+    return takeFromChunk(chunk, count, alignPages, kind);
+}
+
+// Give a run's pages back to its chunk, merging them with the free runs
+// on either side, and the chunk back to the physical allocator if it's
+// empty and not the arena's last.
+static void giveRun(arena_t *arena, chunk_t *chunk, run_t *run)
+{
+    cobalt_u32_t start = (cobalt_u32_t)(run - chunk->pages);
+    cobalt_u32_t end = start + run->pageCount;
+    chunk->freePages += run->pageCount;
+
+    if (start > HEADER_PAGES && chunk->pages[start - 1].kind == RUN_FREE)
+        start = chunk->pages[start - 1].head;
+    if (end < CHUNK_PAGES && chunk->pages[end].kind == RUN_FREE)
+        end += chunk->pages[end].pageCount;
+    setFree(chunk, start, end - start);
+
+    if (chunk->freePages != CHUNK_PAGES - HEADER_PAGES ||
+        arena->chunkCount == 1)
+        return;
+    if (chunk->previous != nullptr) chunk->previous->next = chunk->next;
+    else arena->chunks = chunk->next;
+    if (chunk->next != nullptr) chunk->next->previous = chunk->previous;
+    arena->chunkCount--;
+    arena->mappedBytes -= CHUNK_SIZE;
+    freeBlock(chunk, COBALT_HEAP_CHUNK_ORDER);
+}
+
+static void *allocateSmall(arena_t *arena, cobalt_u32_t class)
+{
+    const cobalt_u64_t size = classSizes[class];
+    run_t *run = arena->bins[class];
+    if (run == nullptr)
+    {
+        const cobalt_u32_t pageCount = (cobalt_u32_t)alignUp(
+            MINIMUM_OBJECTS * size, COBALT_PAGE_SIZE) / COBALT_PAGE_SIZE;
+        run = takeRun(arena, pageCount, 1, RUN_SMALL);
+        if (run == nullptr) return nullptr;
+
+        run->free = nullptr;
+        run->used = run->carved = 0;
+        run->capacity =
+            (cobalt_u16_t)(pageCount * COBALT_PAGE_SIZE / size);
+        run->sizeClass = (cobalt_u8_t)class;
+        binPush(&arena->bins[class], run);
+    }
+
+    void *object;
+    if (run->free != nullptr)
+    {
+        object = run->free;
+        run->free = *(void **)object;
+    }
+    else object = runAddress(chunkOf(run), run) + run->carved++ * size;
+
+    if (++run->used == run->capacity) binRemove(&arena->bins[class], run);
+    arena->activeBytes += size;
+    return object;
+}
+
+static void freeSmall(arena_t *arena, chunk_t *chunk, run_t *run,
+                      void *object)
+{
+    run_t **bin = &arena->bins[run->sizeClass];
+    if (run->used-- == run->capacity) binPush(bin, run);
+    *(void **)object = run->free;
+    run->free = object;
+    arena->activeBytes -= classSizes[run->sizeClass];
+
+    // The last run of a class is kept even when empty, so that a single
+    // object allocated and freed over and over doesn't build and tear
+    // down a run each time.
+    if (run->used != 0) return;
+    if (run->next == nullptr && run->previous == nullptr) return;
+    binRemove(bin, run);
+    giveRun(arena, chunk, run);
+}
+
+static bool fitsInChunk(cobalt_u64_t size, cobalt_u64_t alignment)
+{
+    const cobalt_u64_t alignPages = alignment > COBALT_PAGE_SIZE
+                                        ? alignment / COBALT_PAGE_SIZE
+                                        : 1;
+    return alignUp(HEADER_PAGES, alignPages) +
+               (size + COBALT_PAGE_SIZE - 1) / COBALT_PAGE_SIZE <=
+           CHUNK_PAGES;
+}
+
+static void *allocateLarge(arena_t *arena, cobalt_u64_t size,
+                           cobalt_u64_t alignment)
+{
+    const cobalt_u32_t pageCount =
+        (cobalt_u32_t)((size + COBALT_PAGE_SIZE - 1) / COBALT_PAGE_SIZE);
+    const cobalt_u32_t alignPages =
+        alignment > COBALT_PAGE_SIZE
+            ? (cobalt_u32_t)(alignment / COBALT_PAGE_SIZE)
+            : 1;
+    run_t *run = takeRun(arena, pageCount, alignPages, RUN_LARGE);
+    if (run == nullptr) return nullptr;
+
+    arena->activeBytes += pageCount * COBALT_PAGE_SIZE;
+    return runAddress(chunkOf(run), run);
+}
+
+static void *allocateHuge(arena_t *arena, cobalt_u64_t size)
+{
+    cobalt_u32_t order = COBALT_HEAP_CHUNK_ORDER;
+    while ((COBALT_PAGE_SIZE << order) < size + COBALT_PAGE_SIZE)
+        if (++order > MAXIMUM_BLOCK_ORDER) return nullptr;
+
+    chunk_t *header = allocateBlock(order);
+    if (header == nullptr) return nullptr;
+    header->huge = true;
+    header->order = order;
+
+    arena->activeBytes += (COBALT_PAGE_SIZE << order) - COBALT_PAGE_SIZE;
+    arena->mappedBytes += COBALT_PAGE_SIZE << order;
+    return (cobalt_u8_t *)header + COBALT_PAGE_SIZE;
+}
+
+void *Cobalt_Allocate(cobalt_u64_t size)
+{
+    return Cobalt_AllocateAligned(size, COBALT_HEAP_ALIGNMENT);
+}
+
+void *Cobalt_AllocateAligned(cobalt_u64_t size, cobalt_u64_t alignment)
+{
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+        return nullptr;
+    if (alignment < COBALT_HEAP_ALIGNMENT)
+        alignment = COBALT_HEAP_ALIGNMENT;
+    if (size == 0) size = 1;
+
+    // Objects sit at multiples of their size from the start of a page
+    // aligned run, so any class whose size is a multiple of the alignment
+    // lines every one of its objects up.
+    cobalt_u32_t class = CLASS_COUNT;
+    if (size <= COBALT_HEAP_SMALL_MAXIMUM &&
+        alignment <= COBALT_HEAP_SMALL_MAXIMUM)
+    {
+        class = sizeClass(size);
+        while (classSizes[class] % alignment != 0) class++;
+    }
+
+    // The arena belongs to this processor, but frees from others can
+    // still reach it, hence the lock.
+    const cobalt_u64_t flags = enter();
+    arena_t *arena = &arenas[arenaIndex()];
+    Cobalt_SpinLock(&arena->lock);
+
+    void *block = nullptr;
+    if (class != CLASS_COUNT) block = allocateSmall(arena, class);
+    else if (fitsInChunk(size, alignment))
+        block = allocateLarge(arena, size, alignment);
+    else if (alignment <= COBALT_PAGE_SIZE)
+        block = allocateHuge(arena, size);
+    if (block != nullptr) arena->allocations++;
+
+    Cobalt_SpinUnlock(&arena->lock);
+    leave(flags);
+    return block;
+}
+
+void *Cobalt_Reallocate(void *block, cobalt_u64_t size)
+{
+    if (block == nullptr) return Cobalt_Allocate(size);
+    if (size == 0)
+    {
+        Cobalt_Free(block);
+        return nullptr;
+    }
+
+    // A block stays put as long as it's big enough and wouldn't be more
+    // than half empty.
+    const cobalt_u64_t usable = Cobalt_AllocationSize(block);
+    if (size <= usable && size > usable / 2) return block;
+
+    void *moved = Cobalt_Allocate(size);
+    if (moved == nullptr) return nullptr;
+    Cobalt_CopyMemory(moved, block, size < usable ? size : usable);
+    Cobalt_Free(block);
+    return moved;
+}
+
+void Cobalt_Free(void *block)
+{
+    if (block == nullptr) return;
+    chunk_t *chunk = chunkOf(block);
+    const cobalt_u64_t flags = enter();
+
+    if (chunk->huge)
+    {
+        arena_t *arena = &arenas[arenaIndex()];
+        const cobalt_u64_t blockSize = COBALT_PAGE_SIZE << chunk->order;
+        Cobalt_SpinLock(&arena->lock);
+        arena->activeBytes -= blockSize - COBALT_PAGE_SIZE;
+        arena->mappedBytes -= blockSize;
+        arena->frees++;
+        Cobalt_SpinUnlock(&arena->lock);
+
+        freeBlock(chunk, chunk->order);
+        leave(flags);
+        return;
+    }
+
+    arena_t *arena = chunk->arena;
+    Cobalt_SpinLock(&arena->lock);
+    run_t *run = runOf(chunk, block);
+    if (run->kind == RUN_SMALL) freeSmall(arena, chunk, run, block);
+    else
+    {
+        arena->activeBytes -= run->pageCount * COBALT_PAGE_SIZE;
+        giveRun(arena, chunk, run);
+    }
+    arena->frees++;
+    Cobalt_SpinUnlock(&arena->lock);
+    leave(flags);
+}
+
+cobalt_u64_t Cobalt_AllocationSize(const void *block)
+{
+    // Nothing here changes while the block is handed out, so there's no
+    // need for the lock.
+    chunk_t *chunk = chunkOf(block);
+    if (chunk->huge)
+        return (COBALT_PAGE_SIZE << chunk->order) - COBALT_PAGE_SIZE;
+
+    const run_t *run = runOf(chunk, block);
+    if (run->kind == RUN_SMALL) return classSizes[run->sizeClass];
+    return run->pageCount * COBALT_PAGE_SIZE;
+}
+
+void Cobalt_GetHeapStats(cobalt_heap_stats_t *stats)
+{
+    *stats = (cobalt_heap_stats_t){0};
+    for (cobalt_u32_t i = 0; i < COBALT_MAXIMUM_CPUS; i++)
+    {
+        const cobalt_u64_t flags = enter();
+        Cobalt_SpinLock(&arenas[i].lock);
+        stats->activeBytes += arenas[i].activeBytes;
+        stats->mappedBytes += arenas[i].mappedBytes;
+        stats->allocations += arenas[i].allocations;
+        stats->frees += arenas[i].frees;
+        Cobalt_SpinUnlock(&arenas[i].lock);
+        leave(flags);
+    }
+}
@@ -0,0 +1,166 @@
+/**
+ * @file Interrupts.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the interrupt descriptor table outlined in
+ * the Kernel/Interrupts.h file.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <CPU.h>
+#include <Kernel/CPU.h>
+#include <Kernel/Interrupts.h>
+#include <Kernel/Serial.h>
+
+#define VECTOR_COUNT 256
+#define STUB_SIZE 16
+
+// A present, ring zero, 64-bit interrupt gate. Interrupt gates clear the
+// interrupt flag on entry, which every handler relies on.
+#define INTERRUPT_GATE 0x8E
+
+typedef struct
+{
+    cobalt_u16_t offsetLow;
+    cobalt_u16_t selector;
+    cobalt_u8_t stackTable;
+    cobalt_u8_t attributes;
+    cobalt_u16_t offsetMiddle;
+    cobalt_u32_t offsetHigh;
+    cobalt_u32_t reserved;
+} gate_t;
+
+typedef struct __attribute__((packed))
+{
+    cobalt_u16_t limit;
+    cobalt_u64_t base;
+} descriptor_table_register_t;
+
+static gate_t table[VECTOR_COUNT];
+static cobalt_interrupt_handler_t handlers[VECTOR_COUNT];
+static bool built;
+
+// These are defined in the assembly below. They can't be static, since
+// top-level assembly can't see the names of static symbols once link-time
+// optimization has had its way with them.
+extern const cobalt_u8_t Cobalt_InterruptStubs[]
+    __attribute__((visibility("hidden")));
+void Cobalt_DispatchInterrupt(cobalt_interrupt_frame_t *frame)
+    __attribute__((used, visibility("hidden")));
+
+// One stub per vector, each padded to STUB_SIZE bytes so that the table
+// can find them by arithmetic. Each pushes a zero in place of the error
+// code for vectors the processor doesn't push one for, then the vector,
+// and jumps to the common entry. That saves the general registers and
+// calls the dispatcher under the Microsoft calling convention the kernel
+// is built with, which wants the frame in RCX, a 16-byte aligned stack,
+// and 32 bytes of shadow space.
+__asm__(".pushsection .text\n"
+        ".globl Cobalt_InterruptStubs\n"
+        ".hidden Cobalt_InterruptStubs\n"
+        ".align 16\n"
+        "Cobalt_InterruptStubs:\n"
+        ".set stubVector, 0\n"
+        ".rept 256\n"
+        ".align 16\n"
+        ".if !(stubVector == 8 || "
+        "(stubVector >= 10 && stubVector <= 14) || stubVector == 17 || "
+        "stubVector == 21 || stubVector == 29 || stubVector == 30)\n"
+        "pushq $0\n"
+        ".endif\n"
+        "pushq $stubVector\n"
+        "jmp interruptCommon\n"
+        ".set stubVector, stubVector + 1\n"
+        ".endr\n"
+        "interruptCommon:\n"
+        "pushq %rax\n"
+        "pushq %rbx\n"
+        "pushq %rcx\n"
+        "pushq %rdx\n"
+        "pushq %rsi\n"
+        "pushq %rdi\n"
+        "pushq %rbp\n"
+        "pushq %r8\n"
+        "pushq %r9\n"
+        "pushq %r10\n"
+        "pushq %r11\n"
+        "pushq %r12\n"
+        "pushq %r13\n"
+        "pushq %r14\n"
+        "pushq %r15\n"
+        "cld\n"
+        "movq %rsp, %rcx\n"
+        "movq %rsp, %rbx\n"
+        "andq $-16, %rsp\n"
+        "subq $32, %rsp\n"
+        "call Cobalt_DispatchInterrupt\n"
+        "movq %rbx, %rsp\n"
+        "popq %r15\n"
+        "popq %r14\n"
+        "popq %r13\n"
+        "popq %r12\n"
+        "popq %r11\n"
+        "popq %r10\n"
+        "popq %r9\n"
+        "popq %r8\n"
+        "popq %rbp\n"
+        "popq %rdi\n"
+        "popq %rsi\n"
+        "popq %rdx\n"
+        "popq %rcx\n"
+        "popq %rbx\n"
+        "popq %rax\n"
+        "addq $16, %rsp\n"
+        "iretq\n"
+        ".popsection\n");
+
+void Cobalt_DispatchInterrupt(cobalt_interrupt_frame_t *frame)
+{
+    const cobalt_interrupt_handler_t handler = handlers[frame->vector];
+    if (handler == nullptr) Cobalt_UnhandledInterrupt(frame);
+    handler(frame);
+}
+
+void Cobalt_InitializeInterrupts(void)
+{
+    if (!built)
+    {
+        for (cobalt_u64_t i = 0; i < VECTOR_COUNT; i++)
+        {
+            const cobalt_u64_t stub =
+                (cobalt_u64_t)Cobalt_InterruptStubs + i * STUB_SIZE;
+            table[i] = (gate_t){.offsetLow = (cobalt_u16_t)stub,
+                                .selector = COBALT_KERNEL_CODE_SELECTOR,
+                                .attributes = INTERRUPT_GATE,
+                                .offsetMiddle = (cobalt_u16_t)(stub >> 16),
+                                .offsetHigh = (cobalt_u32_t)(stub >> 32)};
+        }
+        built = true;
+    }
+
+    const descriptor_table_register_t descriptor = {
+        .limit = sizeof(table) - 1, .base = (cobalt_u64_t)table};
+    __asm__ volatile("lidt %0" : : "m"(descriptor));
+}
+
+void Cobalt_SetInterruptHandler(cobalt_u8_t vector,
+                                cobalt_interrupt_handler_t handler)
+{
+    handlers[vector] = handler;
+}
+
+void Cobalt_UnhandledInterrupt(cobalt_interrupt_frame_t *frame)
+{
+    Cobalt_SerialPrintf("Unhandled interrupt %U on processor %U (error "
+                        "%X) at %X.\n",
+                        frame->vector, Cobalt_CPUIndex(), frame->errorCode,
+                        frame->rip);
+    if (frame->vector == COBALT_VECTOR_PAGE_FAULT)
+        Cobalt_SerialPrintf("Faulting address: %X.\n", Cobalt_ReadCR2());
+    Cobalt_Halt();
+}
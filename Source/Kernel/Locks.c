@@ -0,0 +1,199 @@
+/**
+ * @file Locks.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The benchmark of the locks outlined in the Kernel/Locks.h file.
+ * The locks themselves are all inline.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <CPU.h>
+#include <Kernel/CPU.h>
+#include <Kernel/Locks.h>
+#include <Kernel/Scheduler.h>
+#include <Kernel/Serial.h>
+#include <Kernel/Spinlock.h>
+#include <stdatomic.h>
+
+// The acquisitions each of the benchmark's threads makes.
+#define BENCHMARK_ACQUISITIONS (1 << 16)
+
+// One in this many acquisitions of a lock that tells readers from
+// writers is a write.
+#define BENCHMARK_WRITE_RATIO 16
+
+typedef enum : cobalt_u32_t
+{
+    LOCK_SPIN,
+    LOCK_TICKET,
+    LOCK_MCS,
+    LOCK_RW,
+    LOCK_SEQ,
+    LOCK_COUNT
+} lock_kind_t;
+
+static const char *const lockNames[LOCK_COUNT] = {
+    "spinlock", "ticket", "MCS", "rwlock", "seqlock"};
+
+typedef struct
+{
+    lock_kind_t kind;
+    cobalt_completion_t done;
+
+    alignas(COBALT_CACHE_LINE_SIZE) cobalt_spinlock_t spinlock;
+    cobalt_ticket_lock_t ticket;
+    cobalt_mcs_lock_t mcs;
+    cobalt_rwlock_t rwlock;
+    cobalt_seqlock_t seqlock;
+
+    // The data the lock guards. Writers keep both halves equal, so a
+    // reader that sees them differ has seen a torn write. They're only
+    // atomic so that the seqlock's readers can race its writers without
+    // the compiler knowing better; every access is relaxed.
+    alignas(COBALT_CACHE_LINE_SIZE) atomic_ulong counter;
+    atomic_ulong mirror;
+    atomic_ulong tornReads;
+} benchmark_t;
+
+static cobalt_u64_t timestampRate;
+
+static void writeData(benchmark_t *benchmark)
+{
+    const cobalt_u64_t counter =
+        atomic_load_explicit(&benchmark->counter, memory_order_relaxed) +
+        1;
+    atomic_store_explicit(&benchmark->counter, counter,
+                          memory_order_relaxed);
+    atomic_store_explicit(&benchmark->mirror, counter,
+                          memory_order_relaxed);
+}
+
+static bool readData(benchmark_t *benchmark)
+{
+    return atomic_load_explicit(&benchmark->counter,
+                                memory_order_relaxed) ==
+           atomic_load_explicit(&benchmark->mirror, memory_order_relaxed);
+}
+
+static void benchmarkWorker(void *argument)
+{
+    benchmark_t *benchmark = argument;
+    cobalt_mcs_node_t node;
+    cobalt_u64_t tornReads = 0;
+
+    for (cobalt_u32_t i = 0; i < BENCHMARK_ACQUISITIONS; i++)
+    {
+        const bool writing = i % BENCHMARK_WRITE_RATIO == 0;
+        switch (benchmark->kind)
+        {
+            case LOCK_SPIN:
+                Cobalt_SpinLock(&benchmark->spinlock);
+                writeData(benchmark);
+                Cobalt_SpinUnlock(&benchmark->spinlock);
+                break;
+            case LOCK_TICKET:
+                Cobalt_TicketLock(&benchmark->ticket);
+                writeData(benchmark);
+                Cobalt_TicketUnlock(&benchmark->ticket);
+                break;
+            case LOCK_MCS:
+                Cobalt_MCSLock(&benchmark->mcs, &node);
+                writeData(benchmark);
+                Cobalt_MCSUnlock(&benchmark->mcs, &node);
+                break;
+            case LOCK_RW:
+                if (writing)
+                {
+                    Cobalt_WriteLock(&benchmark->rwlock);
+                    writeData(benchmark);
+                    Cobalt_WriteUnlock(&benchmark->rwlock);
+                    break;
+                }
+                Cobalt_ReadLock(&benchmark->rwlock);
+                if (!readData(benchmark)) tornReads++;
+                Cobalt_ReadUnlock(&benchmark->rwlock);
+                break;
+            case LOCK_SEQ:
+                if (writing)
+                {
+                    Cobalt_SeqWriteBegin(&benchmark->seqlock);
+                    writeData(benchmark);
+                    Cobalt_SeqWriteEnd(&benchmark->seqlock);
+                    break;
+                }
+                cobalt_u32_t sequence;
+                bool whole;
+                do
+                {
+                    sequence = Cobalt_SeqReadBegin(&benchmark->seqlock);
+                    whole = readData(benchmark);
+                } while (
+                    Cobalt_SeqReadRetry(&benchmark->seqlock, sequence));
+                if (!whole) tornReads++;
+                break;
+            default: __builtin_unreachable();
+        }
+    }
+
+    atomic_fetch_add(&benchmark->tornReads, tornReads);
+    Cobalt_SignalCompletion(&benchmark->done);
+}
+
+// Run one round of the benchmark, and return the acquisitions per
+// millisecond made.
+static cobalt_u64_t runRound(lock_kind_t kind, cobalt_u64_t threads)
+{
+    benchmark_t benchmark = {.kind = kind};
+    Cobalt_InitializeCompletion(&benchmark.done, threads);
+
+    cobalt_u64_t started = 0;
+    const cobalt_u64_t start = Cobalt_ReadTimestamp();
+    for (cobalt_u64_t i = 0; i < threads; i++)
+    {
+        if (Cobalt_CreateThread(benchmarkWorker, &benchmark,
+                                COBALT_PRIORITY_NORMAL) != nullptr)
+            started++;
+        else Cobalt_SignalCompletion(&benchmark.done);
+    }
+    Cobalt_WaitForCompletion(&benchmark.done);
+    cobalt_u64_t microseconds =
+        (Cobalt_ReadTimestamp() - start) / timestampRate;
+    if (microseconds == 0) microseconds = 1;
+
+    // Every write should have landed, and no read should have seen half
+    // of one.
+    const cobalt_u64_t writes =
+        kind == LOCK_RW || kind == LOCK_SEQ
+            ? BENCHMARK_ACQUISITIONS / BENCHMARK_WRITE_RATIO
+            : BENCHMARK_ACQUISITIONS;
+    const cobalt_u64_t lost = started * writes - benchmark.counter;
+    if (lost != 0 || benchmark.tornReads != 0)
+        Cobalt_SerialPrintf("locks: %s lost %U writes and tore %U reads\n",
+                            lockNames[kind], lost, benchmark.tornReads);
+
+    return started * BENCHMARK_ACQUISITIONS * 1000 / microseconds;
+}
+
+void Cobalt_BenchmarkLocks(cobalt_u64_t ticksPerMicrosecond)
+{
+    timestampRate = ticksPerMicrosecond;
+    const cobalt_u64_t processors =
+        (cobalt_u64_t)__builtin_popcountll(Cobalt_OnlineCPUs());
+    for (lock_kind_t kind = 0; kind < LOCK_COUNT; kind++)
+    {
+        for (cobalt_u64_t threads = 1;; threads *= 2)
+        {
+            if (threads > processors) threads = processors;
+            Cobalt_SerialPrintf("locks: %s, %U threads: %U "
+                                "acquisitions/ms\n",
+                                lockNames[kind], threads,
+                                runRound(kind, threads));
+            if (threads == processors) break;
+        }
+    }
+}
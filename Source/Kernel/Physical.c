@@ -0,0 +1,458 @@
+/**
+ * @file Physical.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the physical page allocator outlined in the
+ * Kernel/Physical.h file.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <CPU.h>
+#include <Kernel/CPU.h>
+#include <Kernel/Physical.h>
+#include <Kernel/Scheduler.h>
+#include <Kernel/Serial.h>
+#include <Kernel/Spinlock.h>
+#include <Memory.h>
+#include <Paging.h>
+
+#define MAXIMUM_ORDER COBALT_PHYSICAL_MAXIMUM_ORDER
+
+// The frame table holds one byte per page. The first page of a free block
+// is marked with this bit and the block's order; every other page, free
+// or not, is zero.
+#define FRAME_FREE 0x80
+
+// A free block keeps its list links in its own first page.
+typedef struct free_block
+{
+    struct free_block *next;
+    struct free_block *previous;
+} free_block_t;
+
+typedef struct
+{
+    alignas(COBALT_CACHE_LINE_SIZE) cobalt_u64_t count;
+    cobalt_u64_t pages[COBALT_PAGE_CACHE_SIZE];
+} page_cache_t;
+
+static struct
+{
+    // Interrupts must be off while this is held. Memory can be freed from
+    // an interrupt handler, which would otherwise spin forever on a lock
+    // its own processor holds.
+    cobalt_spinlock_t lock;
+    // The frame number of the first entry of the frame table. This is
+    // aligned to the largest block, so that buddies found by index are
+    // buddies in physical memory too.
+    cobalt_u64_t firstFrame;
+    cobalt_u64_t frameCount;
+    cobalt_u8_t *frames;
+    // Each list is circular, with its head as the sentinel.
+    free_block_t lists[MAXIMUM_ORDER + 1];
+    cobalt_u64_t totalPages;
+    cobalt_u64_t freePages;
+} buddy;
+
+static page_cache_t caches[COBALT_MAXIMUM_CPUS];
+
+// Ranges that must never be handed out, however the memory map marks
+// them: the kernel image and the frame table.
+static struct
+{
+    cobalt_u64_t start;
+    cobalt_u64_t end;
+} exclusions[2];
+
+static free_block_t *blockAt(cobalt_u64_t frame)
+{
+    return Cobalt_PhysicalToVirtual((buddy.firstFrame + frame)
+                                    << EFI_PAGE_SHIFT);
+}
+
+static cobalt_u64_t frameOf(const free_block_t *block)
+{
+    return (Cobalt_VirtualToPhysical(block) >> EFI_PAGE_SHIFT) -
+           buddy.firstFrame;
+}
+
+static void unlink(free_block_t *block)
+{
+    block->previous->next = block->next;
+    block->next->previous = block->previous;
+}
+
+static void push(cobalt_u64_t frame, cobalt_u32_t order)
+{
+    free_block_t *head = &buddy.lists[order];
+    free_block_t *block = blockAt(frame);
+    block->next = head->next;
+    block->previous = head;
+    head->next->previous = block;
+    head->next = block;
+    buddy.frames[frame] = FRAME_FREE | order;
+}
+
+// Free a block into the buddy allocator, merging it with its buddy for as
+// long as the buddy is free and whole. The lock must be held.
+static void freeBlock(cobalt_u64_t frame, cobalt_u32_t order)
+{
+    while (order < MAXIMUM_ORDER)
+    {
+        const cobalt_u64_t buddyFrame = frame ^ (1ULL << order);
+        if (buddyFrame >= buddy.frameCount ||
+            buddy.frames[buddyFrame] != (FRAME_FREE | order))
+            break;
+
+        unlink(blockAt(buddyFrame));
+        buddy.frames[buddyFrame] = 0;
+        frame &= ~(1ULL << order);
+        order++;
+    }
+    push(frame, order);
+}
+
+// Take a block out of the buddy allocator, splitting a larger one if need
+// be. The lock must be held. This returns the frame count on failure.
+static cobalt_u64_t allocateBlock(cobalt_u32_t order)
+{
+    cobalt_u32_t found = order;
+    while (found <= MAXIMUM_ORDER &&
+           buddy.lists[found].next == &buddy.lists[found])
+        found++;
+    if (found > MAXIMUM_ORDER) return buddy.frameCount;
+
+    free_block_t *block = buddy.lists[found].next;
+    unlink(block);
+    const cobalt_u64_t frame = frameOf(block);
+    buddy.frames[frame] = 0;
+
+    // Hand the upper half back at each step down.
+    while (found > order)
+    {
+        found--;
+        push(frame + (1ULL << found), found);
+    }
+    return frame;
+}
+
+// Free [start, end) into the buddy allocator in the largest aligned blocks
+// that fit. The lock must be held.
+static void freeRange(cobalt_u64_t start, cobalt_u64_t end)
+{
+    cobalt_u64_t frame = (start + COBALT_PAGE_SIZE - 1) >> EFI_PAGE_SHIFT;
+    const cobalt_u64_t endFrame = end >> EFI_PAGE_SHIFT;
+    if (frame < buddy.firstFrame) frame = buddy.firstFrame;
+    if (endFrame <= frame) return;
+
+    frame -= buddy.firstFrame;
+    const cobalt_u64_t last = endFrame - buddy.firstFrame;
+    while (frame < last)
+    {
+        cobalt_u32_t order = 0;
+        while (order < MAXIMUM_ORDER &&
+               (frame & ((2ULL << order) - 1)) == 0 &&
+               frame + (2ULL << order) <= last)
+            order++;
+
+        freeBlock(frame, order);
+        buddy.totalPages += 1ULL << order;
+        buddy.freePages += 1ULL << order;
+        frame += 1ULL << order;
+    }
+}
+
+// Free [start, end) minus every exclusion from the given one onwards.
+static void addRange(cobalt_u64_t start, cobalt_u64_t end,
+                     cobalt_u32_t exclusion)
+{
+    if (start < COBALT_PHYSICAL_LOW_LIMIT)
+        start = COBALT_PHYSICAL_LOW_LIMIT;
+    for (; exclusion < 2; exclusion++)
+    {
+        const cobalt_u64_t excludedStart = exclusions[exclusion].start;
+        const cobalt_u64_t excludedEnd = exclusions[exclusion].end;
+        if (excludedStart >= end || excludedEnd <= start) continue;
+
+        if (start < excludedStart)
+            addRange(start, excludedStart, exclusion + 1);
+        if (excludedEnd < end) addRange(excludedEnd, end, exclusion + 1);
+        return;
+    }
+    if (start < end) freeRange(start, end);
+}
+
+static bool managed(cobalt_memory_type_t type)
+{
+    return type == COBALT_MEMORY_USABLE ||
+           type == COBALT_MEMORY_RECLAIMABLE;
+}
+
+bool Cobalt_InitializePhysicalMemory(const cobalt_efi_info_t *efiInfo)
+{
+    const cobalt_memory_regions_t *map = &efiInfo->memoryMap;
+    for (cobalt_u32_t i = 0; i <= MAXIMUM_ORDER; i++)
+        buddy.lists[i].next = buddy.lists[i].previous = &buddy.lists[i];
+
+    // The frame table spans every region that could ever be handed to
+    // the allocator, reclaimable ones included. The map is sorted, so the
+    // span is a matter of the first and last such region.
+    cobalt_u64_t low = ~0ULL, high = 0;
+    for (cobalt_u64_t i = 0; i < map->count; i++)
+    {
+        const cobalt_memory_region_t *region = &map->regions[i];
+        if (!managed(region->type)) continue;
+        if (low == ~0ULL) low = region->base;
+        high = region->base + (region->pageCount << EFI_PAGE_SHIFT);
+    }
+    if (low < COBALT_PHYSICAL_LOW_LIMIT) low = COBALT_PHYSICAL_LOW_LIMIT;
+    if (high <= low) return false;
+
+    buddy.firstFrame =
+        (low >> EFI_PAGE_SHIFT) & ~((1ULL << MAXIMUM_ORDER) - 1);
+    buddy.frameCount = (high >> EFI_PAGE_SHIFT) - buddy.firstFrame;
+
+    exclusions[0].start = efiInfo->kernelBase;
+    exclusions[0].end = efiInfo->kernelBase +
+                        (efiInfo->kernelPageCount << EFI_PAGE_SHIFT);
+
+    // Carve the frame table out of the first usable region that can hold
+    // it.
+    const cobalt_u64_t tableSize =
+        (buddy.frameCount + COBALT_PAGE_SIZE - 1) &
+        ~(COBALT_PAGE_SIZE - 1);
+    for (cobalt_u64_t i = 0; i < map->count && buddy.frames == nullptr;
+         i++)
+    {
+        const cobalt_memory_region_t *region = &map->regions[i];
+        cobalt_u64_t start = region->base;
+        const cobalt_u64_t end =
+            start + (region->pageCount << EFI_PAGE_SHIFT);
+        if (region->type != COBALT_MEMORY_USABLE) continue;
+        if (start < COBALT_PHYSICAL_LOW_LIMIT)
+            start = COBALT_PHYSICAL_LOW_LIMIT;
+        if (start < exclusions[0].end && exclusions[0].start < end)
+            continue;
+        if (start >= end || end - start < tableSize) continue;
+
+        exclusions[1].start = start;
+        exclusions[1].end = start + tableSize;
+        buddy.frames = Cobalt_PhysicalToVirtual(start);
+    }
+    if (buddy.frames == nullptr) return false;
+    Cobalt_ZeroMemory(buddy.frames, buddy.frameCount);
+
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    Cobalt_SpinLock(&buddy.lock);
+    for (cobalt_u64_t i = 0; i < map->count; i++)
+    {
+        const cobalt_memory_region_t *region = &map->regions[i];
+        if (region->type == COBALT_MEMORY_USABLE)
+            addRange(region->base,
+                     region->base + (region->pageCount << EFI_PAGE_SHIFT),
+                     0);
+    }
+    Cobalt_SpinUnlock(&buddy.lock);
+    Cobalt_RestoreInterrupts(flags);
+    return true;
+}
+
+void Cobalt_AddPhysicalMemory(cobalt_u64_t base, cobalt_u64_t pageCount)
+{
+    cobalt_u64_t end = base + (pageCount << EFI_PAGE_SHIFT);
+    const cobalt_u64_t limit =
+        (buddy.firstFrame + buddy.frameCount) << EFI_PAGE_SHIFT;
+    if (end > limit) end = limit;
+
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    Cobalt_SpinLock(&buddy.lock);
+    addRange(base, end, 0);
+    Cobalt_SpinUnlock(&buddy.lock);
+    Cobalt_RestoreInterrupts(flags);
+}
+
+cobalt_u64_t Cobalt_AllocatePages(cobalt_u32_t order)
+{
+    if (order > MAXIMUM_ORDER) return 0;
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    if (order != 0)
+    {
+        Cobalt_SpinLock(&buddy.lock);
+        const cobalt_u64_t frame = allocateBlock(order);
+        if (frame != buddy.frameCount) buddy.freePages -= 1ULL << order;
+        Cobalt_SpinUnlock(&buddy.lock);
+        Cobalt_RestoreInterrupts(flags);
+        return frame == buddy.frameCount
+                   ? 0
+                   : (buddy.firstFrame + frame) << EFI_PAGE_SHIFT;
+    }
+
+    // The cache belongs to this processor alone, so with interrupts off
+    // nothing else can touch it.
+    page_cache_t *cache = &caches[Cobalt_CPUIndex()];
+    if (cache->count == 0)
+    {
+        Cobalt_SpinLock(&buddy.lock);
+        while (cache->count < COBALT_PAGE_CACHE_BATCH)
+        {
+            const cobalt_u64_t frame = allocateBlock(0);
+            if (frame == buddy.frameCount) break;
+            cache->pages[cache->count++] =
+                (buddy.firstFrame + frame) << EFI_PAGE_SHIFT;
+        }
+        buddy.freePages -= cache->count;
+        Cobalt_SpinUnlock(&buddy.lock);
+    }
+
+    const cobalt_u64_t address =
+        cache->count != 0 ? cache->pages[--cache->count] : 0;
+    Cobalt_RestoreInterrupts(flags);
+    return address;
+}
+
+void Cobalt_FreePages(cobalt_u64_t address, cobalt_u32_t order)
+{
+    const cobalt_u64_t frame =
+        (address >> EFI_PAGE_SHIFT) - buddy.firstFrame;
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    if (order != 0)
+    {
+        Cobalt_SpinLock(&buddy.lock);
+        freeBlock(frame, order);
+        buddy.freePages += 1ULL << order;
+        Cobalt_SpinUnlock(&buddy.lock);
+        Cobalt_RestoreInterrupts(flags);
+        return;
+    }
+
+    page_cache_t *cache = &caches[Cobalt_CPUIndex()];
+    if (cache->count == COBALT_PAGE_CACHE_SIZE)
+    {
+        // The oldest pages are the ones least likely to still be cached,
+        // so they're the ones that go back.
+        Cobalt_SpinLock(&buddy.lock);
+        for (cobalt_u64_t i = 0; i < COBALT_PAGE_CACHE_BATCH; i++)
+            freeBlock((cache->pages[i] >> EFI_PAGE_SHIFT) -
+                          buddy.firstFrame,
+                      0);
+        buddy.freePages += COBALT_PAGE_CACHE_BATCH;
+        Cobalt_SpinUnlock(&buddy.lock);
+
+        cache->count -= COBALT_PAGE_CACHE_BATCH;
+        Cobalt_MoveMemory(cache->pages,
+                          &cache->pages[COBALT_PAGE_CACHE_BATCH],
+                          cache->count * sizeof(cobalt_u64_t));
+    }
+    cache->pages[cache->count++] = address;
+    Cobalt_RestoreInterrupts(flags);
+}
+
+void Cobalt_GetPhysicalStats(cobalt_physical_stats_t *stats)
+{
+    // The caches are read without their owners' say-so, so this is only
+    // a snapshot.
+    cobalt_u64_t cached = 0;
+    for (cobalt_u32_t i = 0; i < COBALT_MAXIMUM_CPUS; i++)
+        cached += caches[i].count;
+
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    Cobalt_SpinLock(&buddy.lock);
+    *stats = (cobalt_physical_stats_t){
+        .totalPages = buddy.totalPages,
+        .freePages = buddy.freePages + cached,
+        .cachedPages = cached};
+    Cobalt_SpinUnlock(&buddy.lock);
+    Cobalt_RestoreInterrupts(flags);
+}
+
+// The number of pages held at once by the burst rounds of the benchmark.
+#define BENCHMARK_BURST 1024
+
+typedef struct
+{
+    cobalt_u64_t ticksPerMicrosecond;
+    cobalt_completion_t done;
+} benchmark_t;
+
+// The pages each processor's worker holds during its burst rounds. A
+// worker can't move while it runs, so it has its processor's row alone.
+static cobalt_u64_t held[COBALT_MAXIMUM_CPUS][BENCHMARK_BURST];
+
+static void reportRate(const char *name, cobalt_u64_t allocations,
+                       cobalt_u64_t ticks, cobalt_u64_t rate)
+{
+    if (ticks == 0) ticks = 1;
+    Cobalt_SerialPrintf("cpu %U: %s: %U allocations/s\n",
+                        (cobalt_u64_t)Cobalt_CPUIndex(), name,
+                        allocations * rate * 1000000 / ticks);
+}
+
+static void benchmarkWorker(void *argument)
+{
+    benchmark_t *benchmark = argument;
+    const cobalt_u64_t rounds = 256;
+    const cobalt_u64_t rate = benchmark->ticksPerMicrosecond;
+
+    // Staying put keeps the per-processor cache, and the rates, this
+    // processor's own.
+    Cobalt_DisablePreemption();
+    cobalt_u64_t *pages = held[Cobalt_CPUIndex()];
+
+    // An allocation freed straight away is the best case: every one is a
+    // hit in this processor's cache.
+    cobalt_u64_t start = Cobalt_ReadTimestamp();
+    for (cobalt_u64_t i = 0; i < rounds * BENCHMARK_BURST; i++)
+        Cobalt_FreePages(Cobalt_AllocatePages(0), 0);
+    reportRate("single page pairs", rounds * BENCHMARK_BURST,
+               Cobalt_ReadTimestamp() - start, rate);
+
+    // Holding many pages at once runs the cache dry and then overflows
+    // it, so this exercises the batches to and from the buddy allocator.
+    start = Cobalt_ReadTimestamp();
+    for (cobalt_u64_t round = 0; round < rounds; round++)
+    {
+        for (cobalt_u64_t i = 0; i < BENCHMARK_BURST; i++)
+            pages[i] = Cobalt_AllocatePages(0);
+        for (cobalt_u64_t i = 0; i < BENCHMARK_BURST; i++)
+            if (pages[i] != 0) Cobalt_FreePages(pages[i], 0);
+    }
+    reportRate("single page bursts", rounds * BENCHMARK_BURST,
+               Cobalt_ReadTimestamp() - start, rate);
+
+    // Mixed orders go straight to the buddy allocator, splitting and
+    // merging all the way.
+    start = Cobalt_ReadTimestamp();
+    for (cobalt_u64_t round = 0; round < rounds; round++)
+    {
+        for (cobalt_u64_t i = 0; i < BENCHMARK_BURST; i++)
+            pages[i] = Cobalt_AllocatePages(1 + i % 4);
+        for (cobalt_u64_t i = 0; i < BENCHMARK_BURST; i++)
+            if (pages[i] != 0) Cobalt_FreePages(pages[i], 1 + i % 4);
+    }
+    reportRate("mixed order bursts", rounds * BENCHMARK_BURST,
+               Cobalt_ReadTimestamp() - start, rate);
+    Cobalt_EnablePreemption();
+
+    Cobalt_SignalCompletion(&benchmark->done);
+}
+
+void Cobalt_BenchmarkPhysicalMemory(cobalt_u64_t ticksPerMicrosecond)
+{
+    // One worker per processor, all at once, so the buddy allocator is
+    // contended the way it would be under load.
+    const cobalt_u64_t processors =
+        (cobalt_u64_t)__builtin_popcountll(Cobalt_OnlineCPUs());
+    benchmark_t benchmark = {.ticksPerMicrosecond = ticksPerMicrosecond};
+    Cobalt_InitializeCompletion(&benchmark.done, processors);
+
+    for (cobalt_u64_t i = 0; i < processors; i++)
+        if (Cobalt_CreateThread(benchmarkWorker, &benchmark,
+                                COBALT_PRIORITY_NORMAL) == nullptr)
+            Cobalt_SignalCompletion(&benchmark.done);
+    Cobalt_WaitForCompletion(&benchmark.done);
+}
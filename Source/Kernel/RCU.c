@@ -0,0 +1,241 @@
+/**
+ * @file RCU.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the read-copy-update mechanism outlined in
+ * the Kernel/RCU.h file.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <CPU.h>
+#include <Kernel/CPU.h>
+#include <Kernel/RCU.h>
+#include <Kernel/Scheduler.h>
+#include <Kernel/Spinlock.h>
+#include <stdatomic.h>
+
+// Each processor's callbacks move through three lists, each of which
+// only takes on more once it's empty: those queued since the last tick,
+// those waiting on a grace period, and those whose grace period is over
+// and are waiting for the processor's thread to run them. Only the
+// processor itself touches the first two, with interrupts disabled. The
+// tick hands the last over to the thread, which may be anywhere, and
+// the thread hands it back empty.
+typedef struct
+{
+    alignas(COBALT_CACHE_LINE_SIZE) cobalt_u64_t seen;
+    cobalt_rcu_head_t *queued;
+    cobalt_rcu_head_t *waiting;
+    cobalt_u64_t waitingFor;
+    _Atomic(cobalt_rcu_head_t *) ready;
+    cobalt_thread_t *thread;
+    cobalt_u64_t callbacks;
+} rcu_cpu_t;
+
+// Grace periods are numbered, and only ever start and end under the lock.
+// Processors report quiescent states without it, by clearing their bit of
+// the pending mask; whoever clears the last ends the grace period. Idle
+// processors, whose timers may not tick, have their bits cleared for them
+// by whoever starts the grace period.
+static struct
+{
+    cobalt_spinlock_t lock;
+    atomic_ulong started;
+    atomic_ulong completed;
+    cobalt_u64_t requested;
+    alignas(COBALT_CACHE_LINE_SIZE) atomic_ulong pending;
+    alignas(COBALT_CACHE_LINE_SIZE) atomic_ulong idle;
+} state;
+
+static rcu_cpu_t cpus[COBALT_MAXIMUM_CPUS];
+
+// The lock must be held. The pending mask has to be filled in before the
+// number is, or a processor could see the new number, find its bit
+// already clear, and never report.
+static void startGracePeriod(void)
+{
+    const cobalt_u64_t next =
+        atomic_load_explicit(&state.started, memory_order_relaxed) + 1;
+    atomic_store_explicit(&state.pending, Cobalt_OnlineCPUs(),
+                          memory_order_relaxed);
+    atomic_store_explicit(&state.started, next, memory_order_release);
+
+    // A processor going idle marks itself before it looks at the number,
+    // so either it sees this grace period and reports for itself or its
+    // mark is seen here. This processor isn't idle, so its own bit keeps
+    // the grace period from ending here.
+    atomic_thread_fence(memory_order_seq_cst);
+    const cobalt_u64_t idle =
+        atomic_load_explicit(&state.idle, memory_order_relaxed);
+    if (idle != 0)
+        atomic_fetch_and_explicit(&state.pending, ~idle,
+                                  memory_order_relaxed);
+}
+
+// Get the number of a grace period that starts after every callback
+// queued so far, starting one if none is under way.
+static cobalt_u64_t requestGracePeriod(void)
+{
+    // Whatever the callbacks free was unlinked before they were queued,
+    // and every processor has to see that before the grace period they
+    // wait on starts.
+    atomic_thread_fence(memory_order_seq_cst);
+
+    Cobalt_SpinLock(&state.lock);
+    const cobalt_u64_t target = atomic_load(&state.started) + 1;
+    if (atomic_load(&state.completed) == target - 1) startGracePeriod();
+    if (state.requested < target) state.requested = target;
+    Cobalt_SpinUnlock(&state.lock);
+    return target;
+}
+
+void Cobalt_CallRCU(cobalt_rcu_head_t *head,
+                    void (*function)(cobalt_rcu_head_t *head))
+{
+    head->function = function;
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    rcu_cpu_t *self = &cpus[Cobalt_CPUIndex()];
+    head->next = self->queued;
+    self->queued = head;
+    Cobalt_RestoreInterrupts(flags);
+}
+
+typedef struct
+{
+    cobalt_rcu_head_t head;
+    cobalt_completion_t done;
+} synchronize_t;
+
+static void wakeSynchronizer(cobalt_rcu_head_t *head)
+{
+    Cobalt_SignalCompletion(&((synchronize_t *)head)->done);
+}
+
+void Cobalt_SynchronizeRCU(void)
+{
+    synchronize_t synchronize;
+    Cobalt_InitializeCompletion(&synchronize.done, 1);
+    Cobalt_CallRCU(&synchronize.head, wakeSynchronizer);
+    Cobalt_WaitForCompletion(&synchronize.done);
+}
+
+void Cobalt_RCUQuiescentState(void)
+{
+    const cobalt_u32_t index = Cobalt_CPUIndex();
+    rcu_cpu_t *self = &cpus[index];
+    const cobalt_u64_t started =
+        atomic_load_explicit(&state.started, memory_order_acquire);
+    if (self->seen == started) return;
+    self->seen = started;
+
+    // The bit may belong to a grace period that's only just being set
+    // up, but the report is as good for it, since we're quiescent now.
+    const cobalt_u64_t bit = 1UL << index;
+    if (atomic_fetch_and_explicit(&state.pending, ~bit,
+                                  memory_order_acq_rel) != bit)
+        return;
+
+    Cobalt_SpinLock(&state.lock);
+    const cobalt_u64_t finished = atomic_load(&state.started);
+    atomic_store_explicit(&state.completed, finished,
+                          memory_order_release);
+    if (state.requested > finished) startGracePeriod();
+    Cobalt_SpinUnlock(&state.lock);
+}
+
+bool Cobalt_RCUEnterIdle(void)
+{
+    const cobalt_u32_t index = Cobalt_CPUIndex();
+    atomic_fetch_or(&state.idle, 1UL << index);
+    atomic_thread_fence(memory_order_seq_cst);
+    Cobalt_RCUQuiescentState();
+
+    rcu_cpu_t *self = &cpus[index];
+    return self->queued != nullptr || self->waiting != nullptr ||
+           atomic_load_explicit(&self->ready, memory_order_relaxed) !=
+               nullptr;
+}
+
+void Cobalt_RCUExitIdle(void)
+{
+    // Whatever was unlinked before a grace period that skipped this
+    // processor has to be out of sight before it reads anything.
+    atomic_fetch_and(&state.idle, ~(1UL << Cobalt_CPUIndex()));
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+void Cobalt_RCUTick(void)
+{
+    if (Cobalt_CurrentCPU()->preemptDepth == 0)
+        Cobalt_RCUQuiescentState();
+
+    // The callbacks free memory and take locks that aren't safe to touch
+    // from an interrupt, so they're left to the processor's thread.
+    rcu_cpu_t *self = &cpus[Cobalt_CPUIndex()];
+    if (self->waiting != nullptr &&
+        atomic_load_explicit(&self->ready, memory_order_relaxed) ==
+            nullptr &&
+        atomic_load_explicit(&state.completed, memory_order_acquire) >=
+            self->waitingFor)
+    {
+        atomic_store_explicit(&self->ready, self->waiting,
+                              memory_order_release);
+        self->waiting = nullptr;
+        if (self->thread != nullptr) Cobalt_WakeThread(self->thread);
+    }
+
+    if (self->waiting == nullptr && self->queued != nullptr)
+    {
+        self->waiting = self->queued;
+        self->queued = nullptr;
+        self->waitingFor = requestGracePeriod();
+    }
+}
+
+// Run the callbacks the tick hands over, a batch at a time, until there
+// are none left, and then wait for more.
+static void runCallbacks(void *argument)
+{
+    rcu_cpu_t *owner = argument;
+    for (;;)
+    {
+        cobalt_rcu_head_t *head = atomic_exchange_explicit(
+            &owner->ready, nullptr, memory_order_acquire);
+        if (head == nullptr)
+        {
+            Cobalt_BlockThread();
+            continue;
+        }
+
+        for (cobalt_u32_t count = 1; head != nullptr; count++)
+        {
+            cobalt_rcu_head_t *next = head->next;
+            head->function(head);
+            owner->callbacks++;
+            head = next;
+            if (count % COBALT_RCU_BATCH == 0) Cobalt_Yield();
+        }
+    }
+}
+
+bool Cobalt_StartRCU(cobalt_u32_t index)
+{
+    rcu_cpu_t *owner = &cpus[index];
+    if (owner->thread != nullptr) return true;
+    owner->thread =
+        Cobalt_CreateThread(runCallbacks, owner, COBALT_PRIORITY_HIGH);
+    return owner->thread != nullptr;
+}
+
+void Cobalt_GetRCUStats(cobalt_rcu_stats_t *stats)
+{
+    *stats = (cobalt_rcu_stats_t){.gracePeriods =
+                                      atomic_load(&state.completed)};
+    for (cobalt_u32_t i = 0; i < COBALT_MAXIMUM_CPUS; i++)
+        stats->callbacks += cpus[i].callbacks;
+}
@@ -0,0 +1,375 @@
+/**
+ * @file SMP.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the processor bring-up outlined in the
+ * Kernel/SMP.h file.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <CPU.h>
+#include <Kernel/ACPI.h>
+#include <Kernel/APIC.h>
+#include <Kernel/CPU.h>
+#include <Kernel/Interrupts.h>
+#include <Kernel/Physical.h>
+#include <Kernel/RCU.h>
+#include <Kernel/SMP.h>
+#include <Kernel/Scheduler.h>
+#include <Kernel/Serial.h>
+#include <Kernel/Virtual.h>
+#include <Memory.h>
+#include <Paging.h>
+#include <stdatomic.h>
+
+#define STACK_SIZE (COBALT_PAGE_SIZE << COBALT_STACK_ORDER)
+
+// The waits the INIT-SIPI-SIPI sequence calls for, in microseconds.
+#define INIT_DELAY 10000
+#define STARTUP_DELAY 200
+
+#define MADT_LOCAL_APIC 0
+#define MADT_LOCAL_X2APIC 9
+#define MADT_ENABLED (1 << 0)
+
+#define EFER_MSR 0xC0000080
+#define EFER_LONG_MODE (1 << 8)
+#define EFER_NO_EXECUTE (1 << 11)
+#define CR4_PCID (1 << 17)
+
+// The trampoline's code page, then the root table it runs on.
+#define TRAMPOLINE_PAGES 2
+
+typedef struct __attribute__((packed))
+{
+    cobalt_acpi_header_t header;
+    cobalt_u32_t localAPIC;
+    cobalt_u32_t flags;
+} madt_t;
+
+typedef struct __attribute__((packed))
+{
+    cobalt_u8_t type;
+    cobalt_u8_t length;
+} madt_entry_t;
+
+typedef struct __attribute__((packed))
+{
+    madt_entry_t entry;
+    cobalt_u8_t processorID;
+    cobalt_u8_t apicID;
+    cobalt_u32_t flags;
+} madt_local_apic_t;
+
+typedef struct __attribute__((packed))
+{
+    madt_entry_t entry;
+    cobalt_u16_t reserved;
+    cobalt_u32_t apicID;
+    cobalt_u32_t flags;
+    cobalt_u32_t processorID;
+} madt_local_x2apic_t;
+
+// What the trampoline reads, at the offsets the assembly below expects.
+// The descriptor table holds the same flat segments as the kernel's, at
+// the same selectors.
+typedef struct __attribute__((packed))
+{
+    cobalt_u64_t descriptors[3];
+    cobalt_u16_t descriptorLimit;
+    cobalt_u32_t descriptorBase;
+    cobalt_u16_t reserved0;
+    cobalt_u32_t longModeOffset;
+    cobalt_u16_t longModeSelector;
+    cobalt_u16_t reserved1;
+    cobalt_u32_t root;
+    cobalt_u32_t efer;
+    cobalt_u32_t cr4;
+    cobalt_u32_t reserved2;
+    cobalt_u64_t stack;
+    cobalt_u64_t entry;
+    cobalt_u64_t index;
+} trampoline_data_t;
+
+static_assert(sizeof(trampoline_data_t) == 0x50,
+              "The trampoline's data doesn't match its assembly.");
+
+extern const cobalt_u8_t Cobalt_TrampolineStart[]
+    __attribute__((visibility("hidden")));
+extern const cobalt_u8_t Cobalt_TrampolineLongMode[]
+    __attribute__((visibility("hidden")));
+extern const cobalt_u8_t Cobalt_TrampolineData[]
+    __attribute__((visibility("hidden")));
+extern const cobalt_u8_t Cobalt_TrampolineEnd[]
+    __attribute__((visibility("hidden")));
+
+// The startup IPI drops the processor into real mode at the start of the
+// page, with CS set to the page's segment. From there it loads the
+// temporary descriptor table, turns on PAE, long mode, and paging all at
+// once, and far jumps into 64-bit code. That calls the kernel under the
+// Microsoft calling convention with the processor's index in RCX. Real
+// mode can only address the page through DS, so everything it reads is
+// at an offset from the start; long mode reads through RIP, which works
+// wherever the page was copied to.
+__asm__(".pushsection .text\n"
+        ".globl Cobalt_TrampolineStart\n"
+        ".hidden Cobalt_TrampolineStart\n"
+        ".globl Cobalt_TrampolineLongMode\n"
+        ".hidden Cobalt_TrampolineLongMode\n"
+        ".globl Cobalt_TrampolineData\n"
+        ".hidden Cobalt_TrampolineData\n"
+        ".globl Cobalt_TrampolineEnd\n"
+        ".hidden Cobalt_TrampolineEnd\n"
+        ".align 16\n"
+        ".code16\n"
+        "Cobalt_TrampolineStart:\n"
+        "cli\n"
+        "cld\n"
+        "movw %cs, %ax\n"
+        "movw %ax, %ds\n"
+        "lgdtl Cobalt_TrampolineData - Cobalt_TrampolineStart + 0x18\n"
+        "movl Cobalt_TrampolineData - Cobalt_TrampolineStart + 0x30, "
+        "%eax\n"
+        "movl %eax, %cr4\n"
+        "movl Cobalt_TrampolineData - Cobalt_TrampolineStart + 0x28, "
+        "%eax\n"
+        "movl %eax, %cr3\n"
+        "movl $0xC0000080, %ecx\n"
+        "movl Cobalt_TrampolineData - Cobalt_TrampolineStart + 0x2C, "
+        "%eax\n"
+        "xorl %edx, %edx\n"
+        "wrmsr\n"
+        // Paging, write protection, and the FPU's error reporting, with
+        // the caches back on; INIT leaves them disabled.
+        "movl $0x80010033, %eax\n"
+        "movl %eax, %cr0\n"
+        "ljmpl *(Cobalt_TrampolineData - Cobalt_TrampolineStart + 0x20)\n"
+        ".code64\n"
+        "Cobalt_TrampolineLongMode:\n"
+        "movw $0x10, %ax\n"
+        "movw %ax, %ds\n"
+        "movw %ax, %es\n"
+        "movw %ax, %ss\n"
+        "movq Cobalt_TrampolineData + 0x38(%rip), %rsp\n"
+        "movq Cobalt_TrampolineData + 0x48(%rip), %rcx\n"
+        "subq $32, %rsp\n"
+        "callq *Cobalt_TrampolineData + 0x40(%rip)\n"
+        "ud2\n"
+        ".align 16\n"
+        "Cobalt_TrampolineData:\n"
+        ".skip 0x50\n"
+        "Cobalt_TrampolineEnd:\n"
+        ".popsection\n");
+
+static atomic_bool started;
+static cobalt_u64_t ticksPerMicrosecond;
+
+static void delay(cobalt_u64_t microseconds)
+{
+    const cobalt_u64_t end =
+        Cobalt_ReadTimestamp() + microseconds * ticksPerMicrosecond;
+    while (Cobalt_ReadTimestamp() < end) Cobalt_Pause();
+}
+
+static bool waitForStart(cobalt_u64_t microseconds)
+{
+    const cobalt_u64_t end =
+        Cobalt_ReadTimestamp() + microseconds * ticksPerMicrosecond;
+    while (!atomic_load(&started))
+    {
+        if (Cobalt_ReadTimestamp() >= end) return false;
+        Cobalt_Pause();
+    }
+    return true;
+}
+
+// Where each application processor picks up once the trampoline has it in
+// long mode, still on the trampoline's root table.
+[[noreturn]] static void runProcessor(cobalt_u64_t index)
+{
+    Cobalt_InitializeCPU((cobalt_u32_t)index);
+    Cobalt_InitializeInterrupts();
+    Cobalt_StartVirtualMemory();
+    Cobalt_InitializeLocalAPIC();
+    Cobalt_SetCPUOnline();
+    atomic_store(&started, true);
+    Cobalt_RunScheduler();
+}
+
+// Find room for the trampoline in usable memory below 1 MiB, which the
+// physical allocator never hands out. The first page is skipped, since
+// its startup vector would be zero.
+static cobalt_u64_t findTrampoline(const cobalt_memory_regions_t *map)
+{
+    for (cobalt_u64_t i = 0; i < map->count; i++)
+    {
+        const cobalt_memory_region_t *region = &map->regions[i];
+        if (region->type != COBALT_MEMORY_USABLE) continue;
+
+        cobalt_u64_t start = region->base;
+        cobalt_u64_t end = start + region->pageCount * COBALT_PAGE_SIZE;
+        if (start < COBALT_PAGE_SIZE) start = COBALT_PAGE_SIZE;
+        if (end > COBALT_PHYSICAL_LOW_LIMIT)
+            end = COBALT_PHYSICAL_LOW_LIMIT;
+        if (start < end &&
+            end - start >= TRAMPOLINE_PAGES * COBALT_PAGE_SIZE)
+            return start;
+    }
+    return 0;
+}
+
+// Copy the trampoline down, and give it a root table of its own. The
+// trampoline can only load a 32-bit CR3, and the kernel's root could be
+// anywhere, so its entries are copied into a page below 1 MiB. The lower
+// half is the loader's identity map, which keeps the trampoline running
+// once paging is on.
+static trampoline_data_t *buildTrampoline(cobalt_u64_t trampoline)
+{
+    const cobalt_u64_t size =
+        (cobalt_u64_t)(Cobalt_TrampolineEnd - Cobalt_TrampolineStart);
+    const cobalt_u64_t dataOffset =
+        (cobalt_u64_t)(Cobalt_TrampolineData - Cobalt_TrampolineStart);
+    Cobalt_CopyMemory(Cobalt_PhysicalToVirtual(trampoline),
+                      Cobalt_TrampolineStart, size);
+
+    const cobalt_u64_t root = trampoline + COBALT_PAGE_SIZE;
+    Cobalt_CopyMemory(
+        Cobalt_PhysicalToVirtual(root),
+        Cobalt_PhysicalToVirtual(Cobalt_ReadCR3() &
+                                 COBALT_PAGE_ADDRESS_MASK),
+        COBALT_PAGE_SIZE);
+
+    trampoline_data_t *data =
+        Cobalt_PhysicalToVirtual(trampoline + dataOffset);
+    *data = (trampoline_data_t){
+        .descriptors = {0, 0x00AF9A000000FFFFULL, 0x00CF92000000FFFFULL},
+        .descriptorLimit = sizeof(data->descriptors) - 1,
+        .descriptorBase = (cobalt_u32_t)(trampoline + dataOffset),
+        .longModeOffset =
+            (cobalt_u32_t)(trampoline + (cobalt_u64_t)(
+                                            Cobalt_TrampolineLongMode -
+                                            Cobalt_TrampolineStart)),
+        .longModeSelector = COBALT_KERNEL_CODE_SELECTOR,
+        .root = (cobalt_u32_t)root,
+        .efer = (cobalt_u32_t)(Cobalt_ReadMSR(EFER_MSR) &
+                               EFER_NO_EXECUTE) |
+                EFER_LONG_MODE,
+        // PCIDs can't be turned on outside of long mode.
+        .cr4 = (cobalt_u32_t)(Cobalt_ReadCR4() & ~CR4_PCID),
+        .entry = (cobalt_u64_t)runProcessor};
+    return data;
+}
+
+static bool startProcessor(trampoline_data_t *data, cobalt_u8_t page,
+                           cobalt_u32_t index, cobalt_u32_t apicID)
+{
+    const cobalt_u64_t stack = Cobalt_AllocatePages(COBALT_STACK_ORDER);
+    if (stack == 0 || !Cobalt_StartRCU(index))
+    {
+        if (stack != 0) Cobalt_FreePages(stack, COBALT_STACK_ORDER);
+        Cobalt_SerialPrintf("No stack or RCU thread for the processor "
+                            "with APIC ID %U.\n",
+                            apicID);
+        return false;
+    }
+    cobalt_cpu_t *cpu = Cobalt_GetCPU(index);
+    cpu->stackTop =
+        (cobalt_u64_t)Cobalt_PhysicalToVirtual(stack) + STACK_SIZE;
+    data->stack = cpu->stackTop;
+    data->index = index;
+    atomic_store(&started, false);
+
+    // The second startup IPI is only for processors that missed the
+    // first, and sending it to one that's running would restart it.
+    const cobalt_u64_t start = Cobalt_ReadTimestamp();
+    Cobalt_SendInitIPI(apicID);
+    delay(INIT_DELAY);
+    Cobalt_SendStartupIPI(apicID, page);
+    if (!waitForStart(STARTUP_DELAY))
+    {
+        Cobalt_SendStartupIPI(apicID, page);
+        if (!waitForStart(COBALT_STARTUP_TIMEOUT))
+        {
+            // Put it back to sleep before its stack goes, in case it
+            // was only slow.
+            Cobalt_SendInitIPI(apicID);
+            Cobalt_FreePages(stack, COBALT_STACK_ORDER);
+            cpu->stackTop = 0;
+            Cobalt_SerialPrintf("The processor with APIC ID %U didn't "
+                                "start.\n",
+                                apicID);
+            return false;
+        }
+    }
+
+    Cobalt_SerialPrintf(
+        "Processor %U (APIC ID %U) started in %U microseconds.\n", index,
+        apicID, (Cobalt_ReadTimestamp() - start) / ticksPerMicrosecond);
+    return true;
+}
+
+cobalt_u32_t Cobalt_StartProcessors(const cobalt_efi_info_t *efiInfo)
+{
+    const madt_t *madt = (const madt_t *)Cobalt_FindACPITable("APIC");
+    if (madt == nullptr)
+    {
+        Cobalt_SerialPuts("No MADT; running on one processor.\n");
+        return 1;
+    }
+
+    const cobalt_u64_t trampoline = findTrampoline(&efiInfo->memoryMap);
+    if (trampoline == 0)
+    {
+        Cobalt_SerialPuts("No room below 1 MiB for the trampoline.\n");
+        return 1;
+    }
+    trampoline_data_t *data = buildTrampoline(trampoline);
+    ticksPerMicrosecond = efiInfo->bootTrace.ticksPerMicrosecond;
+
+    const cobalt_u32_t self = Cobalt_CurrentCPU()->apicID;
+    const cobalt_u8_t *entry = (const cobalt_u8_t *)(madt + 1);
+    const cobalt_u8_t *end =
+        (const cobalt_u8_t *)madt + madt->header.length;
+    cobalt_u32_t count = 1;
+    for (; entry + sizeof(madt_entry_t) <= end;
+         entry += ((const madt_entry_t *)entry)->length)
+    {
+        const madt_entry_t *header = (const madt_entry_t *)entry;
+        if (header->length < sizeof(madt_entry_t)) break;
+
+        cobalt_u32_t apicID, flags;
+        if (header->type == MADT_LOCAL_APIC)
+        {
+            const madt_local_apic_t *local =
+                (const madt_local_apic_t *)entry;
+            apicID = local->apicID;
+            flags = local->flags;
+        }
+        else if (header->type == MADT_LOCAL_X2APIC)
+        {
+            const madt_local_x2apic_t *local =
+                (const madt_local_x2apic_t *)entry;
+            apicID = local->apicID;
+            flags = local->flags;
+        }
+        else continue;
+        if (!(flags & MADT_ENABLED) || apicID == self) continue;
+
+        if (count == COBALT_MAXIMUM_CPUS)
+        {
+            Cobalt_SerialPrintf("Leaving the processor with APIC ID %U "
+                                "off; there are too many.\n",
+                                apicID);
+            continue;
+        }
+        if (startProcessor(data, (cobalt_u8_t)(trampoline >> 12), count,
+                           apicID))
+            count++;
+    }
+    return count;
+}
@@ -0,0 +1,698 @@
+/**
+ * @file Scheduler.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the thread scheduler outlined in the
+ * Kernel/Scheduler.h file.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <CPU.h>
+#include <Kernel/APIC.h>
+#include <Kernel/CPU.h>
+#include <Kernel/Clock.h>
+#include <Kernel/Interrupts.h>
+#include <Kernel/Physical.h>
+#include <Kernel/RCU.h>
+#include <Kernel/SMP.h>
+#include <Kernel/Scheduler.h>
+#include <Kernel/Serial.h>
+#include <Kernel/Slab.h>
+#include <Kernel/Spinlock.h>
+#include <Kernel/Timer.h>
+#include <Memory.h>
+#include <Paging.h>
+#include <stdatomic.h>
+
+#define STACK_SIZE (COBALT_PAGE_SIZE << COBALT_STACK_ORDER)
+
+// The callee-saved registers Cobalt_SwitchContext pushes.
+#define SAVED_REGISTERS 8
+
+// The iterations of the benchmark's workload each of its threads runs.
+#define BENCHMARK_ITERATIONS (1 << 24)
+
+typedef enum : cobalt_u32_t
+{
+    THREAD_RUNNING,
+    THREAD_READY,
+    THREAD_BLOCKED,
+    THREAD_EXITED
+} thread_state_t;
+
+// Why the thread that's switched away from stopped, which decides what
+// becomes of it once it's off its stack.
+typedef enum : cobalt_u32_t
+{
+    SWITCH_REQUEUE,
+    SWITCH_BLOCK,
+    SWITCH_EXIT
+} switch_reason_t;
+
+struct cobalt_thread
+{
+    // Only meaningful while the thread isn't running.
+    cobalt_u64_t stackPointer;
+    // The physical address of the thread's stack, or zero if the stack
+    // isn't the scheduler's to free.
+    cobalt_u64_t stack;
+    cobalt_thread_function_t function;
+    void *argument;
+    cobalt_priority_t priority;
+    cobalt_u32_t lastCPU;
+    // Guards the state and the pending wakeup.
+    cobalt_spinlock_t lock;
+    thread_state_t state;
+    bool woken;
+    // Set from when a processor switches to the thread until its context
+    // has been saved again, so that nobody queues it before then.
+    atomic_bool running;
+    // The link of the shared overflow queue.
+    struct cobalt_thread *next;
+};
+
+// A Chase-Lev deque of ready threads. Only the processor that owns it
+// pushes to the bottom; unlike the original, the owner also takes from
+// the top like the thieves do, so that threads run in turn rather than
+// the last one queued running again straight away.
+typedef struct
+{
+    alignas(COBALT_CACHE_LINE_SIZE) atomic_ulong top;
+    alignas(COBALT_CACHE_LINE_SIZE) atomic_ulong bottom;
+    _Atomic(cobalt_thread_t *) slots[COBALT_RUN_QUEUE_SIZE];
+} run_queue_t;
+
+typedef struct
+{
+    run_queue_t queues[COBALT_PRIORITY_COUNT];
+    alignas(COBALT_CACHE_LINE_SIZE) cobalt_thread_t *current;
+    cobalt_thread_t *idle;
+    // The thread switched away from, which whatever runs next finishes
+    // off once it's on its own stack.
+    cobalt_thread_t *previous;
+    switch_reason_t reason;
+    cobalt_u64_t switchStart;
+    // The processor to try stealing from first.
+    cobalt_u32_t victim;
+    // Fires once the running thread's time slice is over. Idle, it's only
+    // set while RCU has callbacks waiting on the tick.
+    cobalt_timer_t tick;
+    bool sliceOver;
+    cobalt_u64_t contextSwitches;
+    cobalt_u64_t switchTicks;
+    cobalt_u64_t preemptions;
+    cobalt_u64_t steals;
+    cobalt_u64_t migrations;
+} processor_t;
+
+typedef struct
+{
+    cobalt_spinlock_t lock;
+    cobalt_thread_t *head;
+    cobalt_thread_t *tail;
+    atomic_ulong count;
+} overflow_queue_t;
+
+static processor_t processors[COBALT_MAXIMUM_CPUS];
+static cobalt_thread_t idleThreads[COBALT_MAXIMUM_CPUS];
+static overflow_queue_t overflow[COBALT_PRIORITY_COUNT];
+static atomic_ulong idleProcessors;
+static cobalt_slab_cache_t *threadCache;
+static cobalt_u64_t timestampRate;
+
+// Defined in the assembly below.
+void Cobalt_SwitchContext(cobalt_u64_t *save, cobalt_u64_t load)
+    __attribute__((visibility("hidden")));
+
+// Save the callee-saved registers of the Microsoft calling convention on
+// the old stack, store its pointer through RCX, and pop the new thread's
+// off the stack in RDX. The kernel doesn't touch the vector registers, so
+// the general ones are all there is to save.
+__asm__(".pushsection .text\n"
+        ".globl Cobalt_SwitchContext\n"
+        ".hidden Cobalt_SwitchContext\n"
+        "Cobalt_SwitchContext:\n"
+        "pushq %rbx\n"
+        "pushq %rbp\n"
+        "pushq %rdi\n"
+        "pushq %rsi\n"
+        "pushq %r12\n"
+        "pushq %r13\n"
+        "pushq %r14\n"
+        "pushq %r15\n"
+        "movq %rsp, (%rcx)\n"
+        "movq %rdx, %rsp\n"
+        "popq %r15\n"
+        "popq %r14\n"
+        "popq %r13\n"
+        "popq %r12\n"
+        "popq %rsi\n"
+        "popq %rdi\n"
+        "popq %rbp\n"
+        "popq %rbx\n"
+        "ret\n"
+        ".popsection\n");
+
+static bool push(run_queue_t *queue, cobalt_thread_t *thread)
+{
+    const cobalt_u64_t bottom =
+        atomic_load_explicit(&queue->bottom, memory_order_relaxed);
+    const cobalt_u64_t top =
+        atomic_load_explicit(&queue->top, memory_order_acquire);
+    if (bottom - top >= COBALT_RUN_QUEUE_SIZE) return false;
+
+    atomic_store_explicit(&queue->slots[bottom % COBALT_RUN_QUEUE_SIZE],
+                          thread, memory_order_relaxed);
+    atomic_store_explicit(&queue->bottom, bottom + 1,
+                          memory_order_release);
+    return true;
+}
+
+// A slot can only be reused once the top has moved past it, and then the
+// exchange fails, so a thread read here is never one that's been taken.
+static cobalt_thread_t *take(run_queue_t *queue)
+{
+    cobalt_u64_t top =
+        atomic_load_explicit(&queue->top, memory_order_acquire);
+    for (;;)
+    {
+        const cobalt_u64_t bottom =
+            atomic_load_explicit(&queue->bottom, memory_order_acquire);
+        if (top >= bottom) return nullptr;
+
+        cobalt_thread_t *thread = atomic_load_explicit(
+            &queue->slots[top % COBALT_RUN_QUEUE_SIZE],
+            memory_order_relaxed);
+        if (atomic_compare_exchange_weak_explicit(
+                &queue->top, &top, top + 1, memory_order_acq_rel,
+                memory_order_acquire))
+            return thread;
+        Cobalt_Pause();
+    }
+}
+
+static cobalt_thread_t *takeOverflow(overflow_queue_t *queue)
+{
+    if (atomic_load_explicit(&queue->count, memory_order_relaxed) == 0)
+        return nullptr;
+
+    Cobalt_SpinLock(&queue->lock);
+    cobalt_thread_t *thread = queue->head;
+    if (thread != nullptr)
+    {
+        queue->head = thread->next;
+        if (queue->head == nullptr) queue->tail = nullptr;
+        atomic_fetch_sub_explicit(&queue->count, 1, memory_order_relaxed);
+    }
+    Cobalt_SpinUnlock(&queue->lock);
+    return thread;
+}
+
+// Queue a ready thread on this processor, and wake an idle processor to
+// steal it if there is one. Interrupts must be disabled.
+static void enqueue(cobalt_thread_t *thread)
+{
+    const cobalt_u32_t index = Cobalt_CPUIndex();
+    if (!push(&processors[index].queues[thread->priority], thread))
+    {
+        overflow_queue_t *queue = &overflow[thread->priority];
+        thread->next = nullptr;
+        Cobalt_SpinLock(&queue->lock);
+        if (queue->tail != nullptr) queue->tail->next = thread;
+        else queue->head = thread;
+        queue->tail = thread;
+        atomic_fetch_add_explicit(&queue->count, 1, memory_order_relaxed);
+        Cobalt_SpinUnlock(&queue->lock);
+    }
+
+    // An idle processor marks itself before its last look at the queues,
+    // so either it sees this thread or this sees it.
+    atomic_thread_fence(memory_order_seq_cst);
+    const cobalt_u64_t idlers =
+        atomic_load(&idleProcessors) & ~(1UL << index);
+    if (idlers == 0) return;
+    const cobalt_u32_t target = (cobalt_u32_t)__builtin_ctzll(idlers);
+    if (atomic_fetch_and(&idleProcessors, ~(1UL << target)) &
+        (1UL << target))
+        Cobalt_SendIPI(Cobalt_GetCPU(target)->apicID,
+                       COBALT_VECTOR_RESCHEDULE);
+}
+
+// Find the next thread to run of at least the given priority: from this
+// processor's queues first, then the shared overflow, then by stealing
+// from the other processors online.
+static cobalt_thread_t *pick(cobalt_u32_t index,
+                             cobalt_priority_t minimum)
+{
+    processor_t *self = &processors[index];
+    for (cobalt_i32_t priority = COBALT_PRIORITY_HIGH;
+         priority >= (cobalt_i32_t)minimum; priority--)
+    {
+        cobalt_thread_t *thread = take(&self->queues[priority]);
+        if (thread == nullptr) thread = takeOverflow(&overflow[priority]);
+        if (thread != nullptr) return thread;
+    }
+
+    const cobalt_u64_t online = Cobalt_OnlineCPUs() & ~(1UL << index);
+    if (online == 0) return nullptr;
+    for (cobalt_i32_t priority = COBALT_PRIORITY_HIGH;
+         priority >= (cobalt_i32_t)minimum; priority--)
+        for (cobalt_u32_t i = 0; i < COBALT_MAXIMUM_CPUS; i++)
+        {
+            const cobalt_u32_t victim =
+                (self->victim + i) % COBALT_MAXIMUM_CPUS;
+            if (!(online & (1UL << victim))) continue;
+
+            cobalt_thread_t *thread =
+                take(&processors[victim].queues[priority]);
+            if (thread == nullptr) continue;
+            self->victim = victim;
+            self->steals++;
+            return thread;
+        }
+    return nullptr;
+}
+
+// Finish the switch this processor just made, now that the thread
+// switched away from is off its stack.
+static void finishSwitch(void)
+{
+    processor_t *self = &processors[Cobalt_CPUIndex()];
+    cobalt_thread_t *previous = self->previous;
+    self->switchTicks += Cobalt_ReadTimestamp() - self->switchStart;
+
+    switch (self->reason)
+    {
+        case SWITCH_REQUEUE:
+            atomic_store_explicit(&previous->running, false,
+                                  memory_order_release);
+            if (previous == self->idle) break;
+            Cobalt_SpinLock(&previous->lock);
+            previous->state = THREAD_READY;
+            Cobalt_SpinUnlock(&previous->lock);
+            enqueue(previous);
+            break;
+        case SWITCH_BLOCK:
+            atomic_store_explicit(&previous->running, false,
+                                  memory_order_release);
+            break;
+        case SWITCH_EXIT:
+            if (previous->stack != 0)
+                Cobalt_FreePages(previous->stack, COBALT_STACK_ORDER);
+            Cobalt_SlabFree(threadCache, previous);
+            break;
+    }
+}
+
+static void endSlice(cobalt_timer_t *timer)
+{
+    (void)timer;
+    processors[Cobalt_CPUIndex()].sliceOver = true;
+}
+
+// Give the running thread a fresh time slice. Interrupts must be
+// disabled.
+static void startSlice(processor_t *self)
+{
+    self->sliceOver = false;
+    Cobalt_SetTimer(&self->tick,
+                    Cobalt_MonotonicNanoseconds() +
+                        COBALT_TIME_SLICE * 1000UL,
+                    endSlice);
+}
+
+// Switch to another thread. Interrupts must be disabled. This returns
+// once something switches back to the thread that called it, which may
+// be on another processor.
+static void switchTo(cobalt_thread_t *next, switch_reason_t reason)
+{
+    const cobalt_u32_t index = Cobalt_CPUIndex();
+    processor_t *self = &processors[index];
+    cobalt_thread_t *previous = self->current;
+    Cobalt_RCUQuiescentState();
+
+    Cobalt_SpinLock(&next->lock);
+    next->state = THREAD_RUNNING;
+    Cobalt_SpinUnlock(&next->lock);
+    atomic_store_explicit(&next->running, true, memory_order_relaxed);
+    if (next->lastCPU != index && next != self->idle) self->migrations++;
+    next->lastCPU = index;
+
+    // The idle thread decides for itself whether it needs the tick.
+    if (next != self->idle) startSlice(self);
+
+    self->previous = previous;
+    self->reason = reason;
+    self->current = next;
+    self->contextSwitches++;
+    self->switchStart = Cobalt_ReadTimestamp();
+    Cobalt_SwitchContext(&previous->stackPointer, next->stackPointer);
+    finishSwitch();
+}
+
+// Where every new thread starts, as if Cobalt_SwitchContext had returned
+// into it.
+[[noreturn]] static void startThread(void)
+{
+    finishSwitch();
+    __asm__ volatile("sti");
+
+    cobalt_thread_t *thread = processors[Cobalt_CPUIndex()].current;
+    thread->function(thread->argument);
+    Cobalt_ExitThread();
+}
+
+// Lay out a new thread's stack the way Cobalt_SwitchContext leaves an
+// old one: the saved registers, then startThread to return into. Above
+// that sits a null return address for startThread itself and the 32
+// bytes of shadow space the calling convention gives every function.
+static bool setUpThread(cobalt_thread_t *thread,
+                        cobalt_thread_function_t function, void *argument,
+                        cobalt_priority_t priority)
+{
+    const cobalt_u64_t stack = Cobalt_AllocatePages(COBALT_STACK_ORDER);
+    if (stack == 0) return false;
+
+    *thread = (cobalt_thread_t){.stack = stack,
+                                .function = function,
+                                .argument = argument,
+                                .priority = priority,
+                                .lastCPU = Cobalt_CPUIndex(),
+                                .state = THREAD_READY};
+    cobalt_u64_t *top = Cobalt_PhysicalToVirtual(stack + STACK_SIZE);
+    top -= 5;
+    top[0] = 0;
+    *--top = (cobalt_u64_t)startThread;
+    top -= SAVED_REGISTERS;
+    Cobalt_ZeroMemory(top, SAVED_REGISTERS * sizeof(cobalt_u64_t));
+    thread->stackPointer = (cobalt_u64_t)top;
+    return true;
+}
+
+// Each processor's idle thread looks for work, and halts until an
+// interrupt when there's none. Its timer stays quiet unless RCU needs it
+// or a timer's been set, so an idle processor can halt for as long as
+// there's nothing to do.
+[[noreturn]] static void idle(void *argument)
+{
+    (void)argument;
+    for (;;)
+    {
+        Cobalt_DisableInterrupts();
+        processor_t *self = &processors[Cobalt_CPUIndex()];
+        const cobalt_u64_t bit = 1UL << Cobalt_CPUIndex();
+        atomic_fetch_or(&idleProcessors, bit);
+        cobalt_thread_t *next =
+            pick(Cobalt_CPUIndex(), COBALT_PRIORITY_LOW);
+        if (next == nullptr)
+        {
+            if (!Cobalt_RCUEnterIdle()) Cobalt_CancelTimer(&self->tick);
+            else if (!Cobalt_TimerPending(&self->tick)) startSlice(self);
+
+            // STI only takes effect after the next instruction, so
+            // nothing can slip in between it and the halt.
+            __asm__ volatile("sti\n"
+                             "hlt\n"
+                             "cli");
+            Cobalt_RCUExitIdle();
+        }
+        atomic_fetch_and(&idleProcessors, ~bit);
+        if (next != nullptr) switchTo(next, SWITCH_REQUEUE);
+    }
+}
+
+static void handleTimer(cobalt_interrupt_frame_t *frame)
+{
+    (void)frame;
+    Cobalt_EndOfInterrupt();
+    const cobalt_u32_t index = Cobalt_CPUIndex();
+    processor_t *self = &processors[index];
+    // Timers' functions may enter read sections, which RCU has to know
+    // about.
+    if (self->current == self->idle) Cobalt_RCUExitIdle();
+    Cobalt_RunTimers();
+    Cobalt_RCUTick();
+
+    if (!self->sliceOver || self->current == self->idle) return;
+    cobalt_thread_t *next = nullptr;
+    if (Cobalt_CurrentCPU()->preemptDepth == 0)
+        next = pick(index, self->current->priority);
+    if (next == nullptr)
+    {
+        startSlice(self);
+        return;
+    }
+    self->preemptions++;
+    switchTo(next, SWITCH_REQUEUE);
+}
+
+// The interrupt itself is what wakes the idle thread.
+static void handleReschedule(cobalt_interrupt_frame_t *frame)
+{
+    (void)frame;
+    Cobalt_EndOfInterrupt();
+}
+
+bool Cobalt_InitializeScheduler(cobalt_u64_t ticksPerMicrosecond)
+{
+    timestampRate = ticksPerMicrosecond;
+    threadCache = Cobalt_CreateSlabCache("thread", sizeof(cobalt_thread_t),
+                                         0, nullptr);
+    if (threadCache == nullptr) return false;
+
+    // The code that's running keeps the stack the loader gave it, which
+    // isn't the scheduler's to free.
+    cobalt_thread_t *boot = Cobalt_SlabAllocate(threadCache);
+    if (boot == nullptr) return false;
+    *boot = (cobalt_thread_t){.priority = COBALT_PRIORITY_NORMAL,
+                              .lastCPU = Cobalt_CPUIndex(),
+                              .state = THREAD_RUNNING,
+                              .running = true};
+
+    // Unlike the other processors', this one's idle thread needs a stack
+    // of its own.
+    processor_t *self = &processors[Cobalt_CPUIndex()];
+    self->idle = &idleThreads[Cobalt_CPUIndex()];
+    if (!setUpThread(self->idle, idle, nullptr, COBALT_PRIORITY_LOW))
+    {
+        Cobalt_SlabFree(threadCache, boot);
+        return false;
+    }
+    self->current = boot;
+
+    Cobalt_SetInterruptHandler(COBALT_VECTOR_TIMER, handleTimer);
+    Cobalt_SetInterruptHandler(COBALT_VECTOR_RESCHEDULE,
+                               handleReschedule);
+    Cobalt_DisableInterrupts();
+    startSlice(self);
+    __asm__ volatile("sti");
+    return true;
+}
+
+void Cobalt_RunScheduler(void)
+{
+    const cobalt_u32_t index = Cobalt_CPUIndex();
+    processor_t *self = &processors[index];
+    self->idle = self->current = &idleThreads[index];
+    *self->idle = (cobalt_thread_t){.priority = COBALT_PRIORITY_LOW,
+                                    .lastCPU = index,
+                                    .state = THREAD_RUNNING,
+                                    .running = true};
+
+    Cobalt_InitializeTimers();
+    idle(nullptr);
+}
+
+cobalt_thread_t *Cobalt_CreateThread(cobalt_thread_function_t function,
+                                     void *argument,
+                                     cobalt_priority_t priority)
+{
+    cobalt_thread_t *thread = Cobalt_SlabAllocate(threadCache);
+    if (thread == nullptr) return nullptr;
+    if (!setUpThread(thread, function, argument, priority))
+    {
+        Cobalt_SlabFree(threadCache, thread);
+        return nullptr;
+    }
+
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    enqueue(thread);
+    Cobalt_RestoreInterrupts(flags);
+    return thread;
+}
+
+cobalt_thread_t *Cobalt_CurrentThread(void)
+{
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    cobalt_thread_t *thread = processors[Cobalt_CPUIndex()].current;
+    Cobalt_RestoreInterrupts(flags);
+    return thread;
+}
+
+void Cobalt_Yield(void)
+{
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    const cobalt_u32_t index = Cobalt_CPUIndex();
+    cobalt_thread_t *next =
+        pick(index, processors[index].current->priority);
+    if (next != nullptr) switchTo(next, SWITCH_REQUEUE);
+    Cobalt_RestoreInterrupts(flags);
+}
+
+void Cobalt_BlockThread(void)
+{
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    const cobalt_u32_t index = Cobalt_CPUIndex();
+    cobalt_thread_t *thread = processors[index].current;
+
+    Cobalt_SpinLock(&thread->lock);
+    const bool woken = thread->woken;
+    if (woken) thread->woken = false;
+    else thread->state = THREAD_BLOCKED;
+    Cobalt_SpinUnlock(&thread->lock);
+
+    if (!woken)
+    {
+        cobalt_thread_t *next = pick(index, COBALT_PRIORITY_LOW);
+        switchTo(next != nullptr ? next : processors[index].idle,
+                 SWITCH_BLOCK);
+    }
+    Cobalt_RestoreInterrupts(flags);
+}
+
+void Cobalt_WakeThread(cobalt_thread_t *thread)
+{
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    Cobalt_SpinLock(&thread->lock);
+    const bool blocked = thread->state == THREAD_BLOCKED;
+    if (blocked) thread->state = THREAD_READY;
+    else thread->woken = true;
+    Cobalt_SpinUnlock(&thread->lock);
+
+    if (blocked)
+    {
+        // It may still be switching away on another processor.
+        while (atomic_load_explicit(&thread->running,
+                                    memory_order_acquire))
+            Cobalt_Pause();
+        enqueue(thread);
+    }
+    Cobalt_RestoreInterrupts(flags);
+}
+
+void Cobalt_ExitThread(void)
+{
+    Cobalt_DisableInterrupts();
+    const cobalt_u32_t index = Cobalt_CPUIndex();
+    cobalt_thread_t *thread = processors[index].current;
+    Cobalt_SpinLock(&thread->lock);
+    thread->state = THREAD_EXITED;
+    Cobalt_SpinUnlock(&thread->lock);
+
+    cobalt_thread_t *next = pick(index, COBALT_PRIORITY_LOW);
+    switchTo(next != nullptr ? next : processors[index].idle,
+             SWITCH_EXIT);
+    __builtin_unreachable();
+}
+
+void Cobalt_InitializeCompletion(cobalt_completion_t *completion,
+                                 cobalt_u64_t count)
+{
+    completion->waiter = Cobalt_CurrentThread();
+    atomic_store(&completion->remaining, count);
+}
+
+void Cobalt_SignalCompletion(cobalt_completion_t *completion)
+{
+    // Once the count is zero, the waiter can return and take the
+    // completion with it.
+    cobalt_thread_t *waiter = completion->waiter;
+    if (atomic_fetch_sub(&completion->remaining, 1) == 1)
+        Cobalt_WakeThread(waiter);
+}
+
+void Cobalt_WaitForCompletion(cobalt_completion_t *completion)
+{
+    // A wakeup meant for something else just means another look.
+    while (atomic_load(&completion->remaining) != 0) Cobalt_BlockThread();
+}
+
+void Cobalt_GetSchedulerStats(cobalt_scheduler_stats_t *stats)
+{
+    *stats = (cobalt_scheduler_stats_t){0};
+    for (cobalt_u32_t i = 0; i < COBALT_MAXIMUM_CPUS; i++)
+    {
+        const processor_t *processor = &processors[i];
+        stats->contextSwitches += processor->contextSwitches;
+        stats->switchTicks += processor->switchTicks;
+        stats->preemptions += processor->preemptions;
+        stats->steals += processor->steals;
+        stats->migrations += processor->migrations;
+    }
+}
+
+static void benchmarkWorker(void *argument)
+{
+    cobalt_completion_t *completion = argument;
+
+    // A xorshift generator, which the compiler can't fold away.
+    cobalt_u64_t state = Cobalt_ReadTimestamp() | 1;
+    for (cobalt_u64_t i = 0; i < BENCHMARK_ITERATIONS; i++)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+    }
+    __asm__ volatile("" : : "r"(state));
+
+    Cobalt_SignalCompletion(completion);
+}
+
+void Cobalt_BenchmarkScheduler(void)
+{
+    const cobalt_u64_t processors =
+        (cobalt_u64_t)__builtin_popcountll(Cobalt_OnlineCPUs());
+    cobalt_u64_t baseline = 0;
+    for (cobalt_u64_t threads = 1;; threads *= 2)
+    {
+        if (threads > processors) threads = processors;
+        cobalt_completion_t completion;
+        Cobalt_InitializeCompletion(&completion, threads);
+
+        const cobalt_u64_t start = Cobalt_ReadTimestamp();
+        for (cobalt_u64_t i = 0; i < threads; i++)
+            if (Cobalt_CreateThread(benchmarkWorker, &completion,
+                                    COBALT_PRIORITY_NORMAL) == nullptr)
+                Cobalt_SignalCompletion(&completion);
+        Cobalt_WaitForCompletion(&completion);
+
+        cobalt_u64_t microseconds =
+            (Cobalt_ReadTimestamp() - start) / timestampRate;
+        if (microseconds == 0) microseconds = 1;
+        const cobalt_u64_t rate =
+            threads * BENCHMARK_ITERATIONS / microseconds;
+        if (baseline == 0) baseline = rate != 0 ? rate : 1;
+        const cobalt_u64_t speedup = rate * 10 / baseline;
+        Cobalt_SerialPrintf("scheduler: %U threads: %U iterations/us, "
+                            "%U.%U times one thread\n",
+                            threads, rate, speedup / 10, speedup % 10);
+        if (threads == processors) break;
+    }
+
+    cobalt_scheduler_stats_t stats;
+    Cobalt_GetSchedulerStats(&stats);
+    const cobalt_u64_t switches =
+        stats.contextSwitches != 0 ? stats.contextSwitches : 1;
+    Cobalt_SerialPrintf("scheduler: %U switches averaging %U ns, %U "
+                        "preemptions, %U steals, %U migrations\n",
+                        stats.contextSwitches,
+                        stats.switchTicks * 1000 / timestampRate /
+                            switches,
+                        stats.preemptions, stats.steals,
+                        stats.migrations);
+}
@@ -0,0 +1,109 @@
+/**
+ * @file Serial.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the serial port routines outlined in the
+ * Kernel/Serial.h file.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <CPU.h>
+#include <Kernel/Serial.h>
+
+#define COM1 0x3F8
+
+// Register offsets from the port's base, per the 16550 UART.
+#define DATA 0
+#define INTERRUPT_ENABLE 1
+#define FIFO_CONTROL 2
+#define LINE_CONTROL 3
+#define MODEM_CONTROL 4
+#define LINE_STATUS 5
+
+#define TRANSMIT_EMPTY 0x20
+
+void Cobalt_SerialInitialize(void)
+{
+    Cobalt_OutByte(COM1 + INTERRUPT_ENABLE, 0x00);
+    // Set the divisor latch, and divide the 115200 Hz clock by one.
+    Cobalt_OutByte(COM1 + LINE_CONTROL, 0x80);
+    Cobalt_OutByte(COM1 + DATA, 0x01);
+    Cobalt_OutByte(COM1 + INTERRUPT_ENABLE, 0x00);
+    // 8 data bits, no parity, one stop bit.
+    Cobalt_OutByte(COM1 + LINE_CONTROL, 0x03);
+    Cobalt_OutByte(COM1 + FIFO_CONTROL, 0xC7);
+    Cobalt_OutByte(COM1 + MODEM_CONTROL, 0x03);
+}
+
+static void putCharacter(char character)
+{
+    while ((Cobalt_InByte(COM1 + LINE_STATUS) & TRANSMIT_EMPTY) == 0);
+    Cobalt_OutByte(COM1 + DATA, (cobalt_u8_t)character);
+}
+
+void Cobalt_SerialPuts(const char *string)
+{
+    for (; *string != 0; string++)
+    {
+        if (*string == '\n') putCharacter('\r');
+        putCharacter(*string);
+    }
+}
+
+static void putUnsigned(cobalt_u64_t value, cobalt_u64_t radix)
+{
+    char buffer[24];
+    char *cursor = buffer + sizeof(buffer);
+    *--cursor = 0;
+    do {
+        const cobalt_u64_t digit = value % radix;
+        *--cursor = (char)(digit < 10 ? '0' + digit : 'A' + digit - 10);
+        value /= radix;
+    } while (value != 0);
+    Cobalt_SerialPuts(cursor);
+}
+
+void Cobalt_SerialPrintfv(const char *format, va_list args)
+{
+    for (; *format != 0; format++)
+    {
+        if (*format != '%')
+        {
+            if (*format == '\n') putCharacter('\r');
+            putCharacter(*format);
+            continue;
+        }
+
+        switch (*++format)
+        {
+            case 's': Cobalt_SerialPuts(va_arg(args, const char *)); break;
+            case 'c': putCharacter((char)va_arg(args, int)); break;
+            case 'U': putUnsigned(va_arg(args, cobalt_u64_t), 10); break;
+            case 'X': putUnsigned(va_arg(args, cobalt_u64_t), 16); break;
+            case 'L':
+            {
+                const cobalt_i64_t value = va_arg(args, cobalt_i64_t);
+                if (value < 0) putCharacter('-');
+                putUnsigned(value < 0 ? -(cobalt_u64_t)value
+                                      : (cobalt_u64_t)value,
+                            10);
+                break;
+            }
+            case 0: return;
+            default: putCharacter(*format); break;
+        }
+    }
+}
+
+void Cobalt_SerialPrintf(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    Cobalt_SerialPrintfv(format, args);
+    va_end(args);
+}
@@ -0,0 +1,348 @@
+/**
+ * @file Slab.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the slab allocator outlined in the
+ * Kernel/Slab.h file.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <CPU.h>
+#include <Kernel/CPU.h>
+#include <Kernel/Physical.h>
+#include <Kernel/Slab.h>
+#include <Kernel/Spinlock.h>
+#include <Memory.h>
+#include <Paging.h>
+
+// The fewest objects a slab should hold. Caches use the smallest slab
+// that fits this many, so that the header's share stays small.
+#define MINIMUM_OBJECTS 8
+
+#define DEFAULT_ALIGNMENT 8
+
+typedef struct slab_link
+{
+    struct slab_link *next;
+    struct slab_link *previous;
+} slab_link_t;
+
+// A slab is a naturally aligned block from the physical allocator, which
+// starts with this header. Freeing an object finds its slab by rounding
+// its address down to the slab size.
+typedef struct
+{
+    slab_link_t link;
+    cobalt_u8_t *objects;
+    cobalt_u32_t freeCount;
+    // A stack of the indices of every free object. Keeping these out of
+    // the objects themselves leaves free objects constructed.
+    cobalt_u16_t free[];
+} slab_t;
+
+typedef struct
+{
+    alignas(COBALT_CACHE_LINE_SIZE) cobalt_u64_t count;
+    cobalt_u64_t hits;
+    cobalt_u64_t misses;
+    void *objects[COBALT_MAGAZINE_SIZE];
+} magazine_t;
+
+struct cobalt_slab_cache
+{
+    const char *name;
+    cobalt_u64_t objectSize;
+    cobalt_slab_constructor_t constructor;
+    cobalt_u32_t order;
+    cobalt_u32_t capacity;
+    // The bytes of each slab left over after the header and objects. New
+    // slabs start their objects at successive multiples of the colour
+    // step within this space, so that the same object of different slabs
+    // lands in different cache sets.
+    cobalt_u64_t colourSpace;
+    cobalt_u64_t colourStep;
+    cobalt_u64_t nextColour;
+    cobalt_u64_t headerSize;
+
+    cobalt_spinlock_t lock;
+    slab_link_t partial;
+    slab_link_t full;
+    slab_link_t empty;
+    cobalt_u64_t slabCount;
+    cobalt_u64_t emptyCount;
+    // Objects out of their slabs, whether handed out or in a magazine.
+    cobalt_u64_t taken;
+
+    struct cobalt_slab_cache *nextCache;
+    magazine_t magazines[COBALT_MAXIMUM_CPUS];
+};
+
+static cobalt_spinlock_t cachesLock;
+static cobalt_slab_cache_t *caches;
+
+static void listInitialize(slab_link_t *head)
+{
+    head->next = head->previous = head;
+}
+
+static bool listEmpty(const slab_link_t *head)
+{
+    return head->next == head;
+}
+
+static void listRemove(slab_link_t *link)
+{
+    link->previous->next = link->next;
+    link->next->previous = link->previous;
+}
+
+static void listPush(slab_link_t *head, slab_link_t *link)
+{
+    link->next = head->next;
+    link->previous = head;
+    head->next->previous = link;
+    head->next = link;
+}
+
+static cobalt_u64_t alignUp(cobalt_u64_t value, cobalt_u64_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static cobalt_u64_t headerSize(cobalt_u64_t capacity,
+                               cobalt_u64_t alignment)
+{
+    return alignUp(sizeof(slab_t) + capacity * sizeof(cobalt_u16_t),
+                   alignment);
+}
+
+// Make a new slab, constructing every object in it. The lock must be
+// held.
+static slab_t *grow(cobalt_slab_cache_t *cache)
+{
+    const cobalt_u64_t address = Cobalt_AllocatePages(cache->order);
+    if (address == 0) return nullptr;
+
+    slab_t *slab = Cobalt_PhysicalToVirtual(address);
+    slab->objects = (cobalt_u8_t *)slab + cache->headerSize +
+                    cache->nextColour;
+    slab->freeCount = cache->capacity;
+    for (cobalt_u32_t i = 0; i < cache->capacity; i++)
+        slab->free[i] = (cobalt_u16_t)(cache->capacity - 1 - i);
+    if (cache->constructor != nullptr)
+        for (cobalt_u32_t i = 0; i < cache->capacity; i++)
+            cache->constructor(slab->objects + i * cache->objectSize);
+
+    cache->nextColour += cache->colourStep;
+    if (cache->nextColour > cache->colourSpace) cache->nextColour = 0;
+
+    listPush(&cache->partial, &slab->link);
+    cache->slabCount++;
+    return slab;
+}
+
+// Move up to count objects from the slabs into a magazine. The lock must
+// be held.
+static void refill(cobalt_slab_cache_t *cache, magazine_t *magazine,
+                   cobalt_u64_t count)
+{
+    while (magazine->count < count)
+    {
+        slab_t *slab;
+        if (!listEmpty(&cache->partial))
+            slab = (slab_t *)cache->partial.next;
+        else if (!listEmpty(&cache->empty))
+        {
+            slab = (slab_t *)cache->empty.next;
+            listRemove(&slab->link);
+            listPush(&cache->partial, &slab->link);
+            cache->emptyCount--;
+        }
+        else if ((slab = grow(cache)) == nullptr)
+            return;
+
+        while (slab->freeCount != 0 && magazine->count < count)
+        {
+            magazine->objects[magazine->count++] =
+                slab->objects +
+                slab->free[--slab->freeCount] * cache->objectSize;
+            cache->taken++;
+        }
+        if (slab->freeCount == 0)
+        {
+            listRemove(&slab->link);
+            listPush(&cache->full, &slab->link);
+        }
+    }
+}
+
+// Put an object back into its slab. The lock must be held.
+static void release(cobalt_slab_cache_t *cache, void *object)
+{
+    const cobalt_u64_t slabSize = COBALT_PAGE_SIZE << cache->order;
+    slab_t *slab = (slab_t *)((cobalt_u64_t)object & ~(slabSize - 1));
+    const cobalt_u64_t index =
+        ((cobalt_u8_t *)object - slab->objects) / cache->objectSize;
+
+    if (slab->freeCount++ == 0)
+    {
+        listRemove(&slab->link);
+        listPush(&cache->partial, &slab->link);
+    }
+    slab->free[slab->freeCount - 1] = (cobalt_u16_t)index;
+    cache->taken--;
+
+    if (slab->freeCount != cache->capacity) return;
+    listRemove(&slab->link);
+
+    // One empty slab is kept around so that a cache hovering at a slab
+    // boundary doesn't go back and forth to the physical allocator.
+    if (cache->emptyCount != 0)
+    {
+        cache->slabCount--;
+        Cobalt_FreePages(Cobalt_VirtualToPhysical(slab), cache->order);
+        return;
+    }
+    listPush(&cache->empty, &slab->link);
+    cache->emptyCount++;
+}
+
+cobalt_slab_cache_t *
+Cobalt_CreateSlabCache(const char *name, cobalt_u64_t objectSize,
+                       cobalt_u64_t alignment,
+                       cobalt_slab_constructor_t constructor)
+{
+    if (alignment == 0) alignment = DEFAULT_ALIGNMENT;
+    objectSize = alignUp(objectSize != 0 ? objectSize : 1, alignment);
+
+    // Pick the smallest slab that holds enough objects, falling back on
+    // the largest one for anything big.
+    cobalt_u32_t order = 0;
+    cobalt_u64_t capacity = 0;
+    for (; order <= COBALT_SLAB_MAXIMUM_ORDER; order++)
+    {
+        const cobalt_u64_t slabSize = COBALT_PAGE_SIZE << order;
+        capacity = slabSize / objectSize;
+        while (capacity != 0 &&
+               headerSize(capacity, alignment) + capacity * objectSize >
+                   slabSize)
+            capacity--;
+        if (capacity >= MINIMUM_OBJECTS) break;
+    }
+    if (order > COBALT_SLAB_MAXIMUM_ORDER) order--;
+    if (capacity == 0) return nullptr;
+
+    cobalt_u32_t cacheOrder = 0;
+    while ((COBALT_PAGE_SIZE << cacheOrder) < sizeof(cobalt_slab_cache_t))
+        cacheOrder++;
+    const cobalt_u64_t address = Cobalt_AllocatePages(cacheOrder);
+    if (address == 0) return nullptr;
+
+    cobalt_slab_cache_t *cache = Cobalt_PhysicalToVirtual(address);
+    Cobalt_ZeroMemory(cache, sizeof(cobalt_slab_cache_t));
+    cache->name = name;
+    cache->objectSize = objectSize;
+    cache->constructor = constructor;
+    cache->order = order;
+    cache->capacity = (cobalt_u32_t)capacity;
+    cache->headerSize = headerSize(capacity, alignment);
+    cache->colourSpace = (COBALT_PAGE_SIZE << order) - cache->headerSize -
+                         capacity * objectSize;
+    cache->colourStep = alignment > COBALT_CACHE_LINE_SIZE
+                            ? alignment
+                            : COBALT_CACHE_LINE_SIZE;
+    listInitialize(&cache->partial);
+    listInitialize(&cache->full);
+    listInitialize(&cache->empty);
+
+    Cobalt_SpinLock(&cachesLock);
+    cache->nextCache = caches;
+    caches = cache;
+    Cobalt_SpinUnlock(&cachesLock);
+    return cache;
+}
+
+void *Cobalt_SlabAllocate(cobalt_slab_cache_t *cache)
+{
+    // The magazine belongs to this processor alone, so with interrupts
+    // off nothing else can touch it.
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    magazine_t *magazine = &cache->magazines[Cobalt_CPUIndex()];
+    if (magazine->count != 0)
+        magazine->hits++;
+    else
+    {
+        magazine->misses++;
+        Cobalt_SpinLock(&cache->lock);
+        refill(cache, magazine, COBALT_MAGAZINE_BATCH);
+        Cobalt_SpinUnlock(&cache->lock);
+    }
+
+    void *object = magazine->count != 0
+                       ? magazine->objects[--magazine->count]
+                       : nullptr;
+    Cobalt_RestoreInterrupts(flags);
+    return object;
+}
+
+void Cobalt_SlabFree(cobalt_slab_cache_t *cache, void *object)
+{
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    magazine_t *magazine = &cache->magazines[Cobalt_CPUIndex()];
+    if (magazine->count == COBALT_MAGAZINE_SIZE)
+    {
+        // The oldest objects are the ones least likely to still be
+        // cached, so they're the ones that go back.
+        Cobalt_SpinLock(&cache->lock);
+        for (cobalt_u64_t i = 0; i < COBALT_MAGAZINE_BATCH; i++)
+            release(cache, magazine->objects[i]);
+        Cobalt_SpinUnlock(&cache->lock);
+
+        magazine->count -= COBALT_MAGAZINE_BATCH;
+        Cobalt_MoveMemory(magazine->objects,
+                          &magazine->objects[COBALT_MAGAZINE_BATCH],
+                          magazine->count * sizeof(void *));
+    }
+    magazine->objects[magazine->count++] = object;
+    Cobalt_RestoreInterrupts(flags);
+}
+
+cobalt_slab_cache_t *
+Cobalt_NextSlabCache(const cobalt_slab_cache_t *previous)
+{
+    Cobalt_SpinLock(&cachesLock);
+    cobalt_slab_cache_t *next =
+        previous == nullptr ? caches : previous->nextCache;
+    Cobalt_SpinUnlock(&cachesLock);
+    return next;
+}
+
+void Cobalt_GetSlabStats(cobalt_slab_cache_t *cache,
+                         cobalt_slab_stats_t *stats)
+{
+    // The magazines are read without their owners' say-so, so this is
+    // only a snapshot.
+    cobalt_u64_t cached = 0, hits = 0, misses = 0;
+    for (cobalt_u32_t i = 0; i < COBALT_MAXIMUM_CPUS; i++)
+    {
+        cached += cache->magazines[i].count;
+        hits += cache->magazines[i].hits;
+        misses += cache->magazines[i].misses;
+    }
+
+    Cobalt_SpinLock(&cache->lock);
+    *stats = (cobalt_slab_stats_t){
+        .name = cache->name,
+        .objectSize = cache->objectSize,
+        .activeObjects = cache->taken > cached ? cache->taken - cached : 0,
+        .totalObjects = cache->slabCount * cache->capacity,
+        .slabs = cache->slabCount,
+        .hits = hits,
+        .misses = misses};
+    Cobalt_SpinUnlock(&cache->lock);
+}
@@ -0,0 +1,386 @@
+/**
+ * @file Timer.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the timers outlined in the Kernel/Timer.h
+ * file.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <CPU.h>
+#include <Kernel/APIC.h>
+#include <Kernel/CPU.h>
+#include <Kernel/Clock.h>
+#include <Kernel/Interrupts.h>
+#include <Kernel/Scheduler.h>
+#include <Kernel/Serial.h>
+#include <Kernel/Spinlock.h>
+#include <Kernel/Timer.h>
+
+// The wheel counts in units of 2^UNIT_SHIFT nanoseconds, which is about a
+// microsecond.
+#define UNIT_SHIFT 10
+
+// Each level has SLOTS slots, each 2^LEVEL_SHIFT times as long as those
+// of the level below. A timer goes in the lowest level that reaches it,
+// so it's rounded to at most an eighth of the time until it's due. With
+// these, the top level reaches a little over two minutes.
+#define SLOTS 64
+#define LEVEL_SHIFT 3
+#define LEVELS 8
+
+#define NEVER (~0UL)
+
+// The timers the benchmark sets and cancels in each round.
+#define BENCHMARK_TIMERS 4096
+#define BENCHMARK_ROUNDS 16
+
+// The sleeps of each length the benchmark times.
+#define BENCHMARK_SLEEPS 16
+
+// How long the benchmark counts timer interrupts for, in nanoseconds.
+#define BENCHMARK_IDLE 100000000
+
+// A slot at a level only comes around when the clock is a multiple of
+// the level's span of a slot, so its timers are run then; whoever finds
+// a timer that isn't due yet, because it was too far off for the top
+// level, just puts it back. Only the processor that owns a wheel adds
+// to it, but anyone may take from it under its lock.
+typedef struct
+{
+    alignas(COBALT_CACHE_LINE_SIZE) cobalt_spinlock_t lock;
+    // The first unit whose timers haven't been run.
+    cobalt_u64_t clock;
+    // The first unit at which an occupied slot comes around, or NEVER. A
+    // cancel can leave this early, which only costs a wasted interrupt.
+    cobalt_u64_t next;
+    // The unit the local APIC timer is armed for, or NEVER.
+    cobalt_u64_t armed;
+    cobalt_u64_t occupied[LEVELS];
+    cobalt_timer_t *slots[LEVELS][SLOTS];
+    cobalt_u64_t interrupts;
+    cobalt_u64_t expired;
+} wheel_t;
+
+static wheel_t wheels[COBALT_MAXIMUM_CPUS];
+
+static cobalt_u64_t currentUnit(void)
+{
+    return Cobalt_MonotonicNanoseconds() >> UNIT_SHIFT;
+}
+
+// The wheel's lock must be held.
+static void unlink(wheel_t *wheel, cobalt_timer_t *timer)
+{
+    *timer->link = timer->next;
+    if (timer->next != nullptr) timer->next->link = timer->link;
+
+    // If that emptied a slot, its bit goes too. Timers that are about to
+    // be run have been taken out of the slots already.
+    const cobalt_u64_t offset =
+        (cobalt_u64_t)timer->link - (cobalt_u64_t)wheel->slots;
+    if (offset < sizeof(wheel->slots) && *timer->link == nullptr)
+    {
+        const cobalt_u64_t slot = offset / sizeof(cobalt_timer_t *);
+        wheel->occupied[slot / SLOTS] &= ~(1UL << (slot % SLOTS));
+    }
+}
+
+// Put a timer in the slot it's due in, and return the unit at which that
+// slot comes around. The wheel's lock must be held.
+static cobalt_u64_t enqueue(wheel_t *wheel, cobalt_timer_t *timer)
+{
+    cobalt_u64_t expires =
+        timer->expires > wheel->clock ? timer->expires : wheel->clock;
+    const cobalt_u64_t delta = expires - wheel->clock;
+    cobalt_u32_t level = 0;
+    while (level < LEVELS - 1 &&
+           delta >= (SLOTS - 1UL) << (level * LEVEL_SHIFT))
+        level++;
+
+    // A timer further off than the top level reaches waits in its last
+    // slot. Otherwise, rounding up keeps it from firing early.
+    const cobalt_u32_t shift = level * LEVEL_SHIFT;
+    if (delta >= (SLOTS - 1UL) << shift)
+        expires = wheel->clock + ((SLOTS - 1UL) << shift) - 1;
+    const cobalt_u64_t position = (expires + (1UL << shift) - 1) >> shift;
+    const cobalt_u32_t index = position % SLOTS;
+
+    cobalt_timer_t **slot = &wheel->slots[level][index];
+    timer->next = *slot;
+    if (timer->next != nullptr) timer->next->link = &timer->next;
+    timer->link = slot;
+    *slot = timer;
+    wheel->occupied[level] |= 1UL << index;
+    return position << shift;
+}
+
+// Find the first unit at which an occupied slot comes around, from the
+// first slot of each level that hasn't come around yet. The wheel's lock
+// must be held.
+static cobalt_u64_t nextDue(const wheel_t *wheel)
+{
+    cobalt_u64_t next = NEVER;
+    for (cobalt_u32_t level = 0; level < LEVELS; level++)
+    {
+        const cobalt_u64_t occupied = wheel->occupied[level];
+        if (occupied == 0) continue;
+
+        const cobalt_u32_t shift = level * LEVEL_SHIFT;
+        const cobalt_u64_t position =
+            (wheel->clock + (1UL << shift) - 1) >> shift;
+        const cobalt_u32_t rotation = position % SLOTS;
+        const cobalt_u64_t rotated =
+            rotation != 0
+                ? occupied >> rotation | occupied << (SLOTS - rotation)
+                : occupied;
+        const cobalt_u64_t due =
+            (position + (cobalt_u64_t)__builtin_ctzll(rotated)) << shift;
+        if (due < next) next = due;
+    }
+    return next;
+}
+
+// Arm the local APIC timer for the wheel's next slot, unless it already
+// is. The wheel's lock must be held, and the wheel must be this
+// processor's.
+static void arm(wheel_t *wheel)
+{
+    if (wheel->next == wheel->armed) return;
+    wheel->armed = wheel->next;
+    Cobalt_ArmLocalTimer(wheel->next != NEVER
+                             ? Cobalt_ClockTimestamp(wheel->next
+                                                     << UNIT_SHIFT)
+                             : 0);
+}
+
+// Run the slots that come around at the wheel's clock, and move the clock
+// on. The wheel's lock must be held, but is let go of while each timer's
+// function runs; a timer cancelled meanwhile is taken out of the list
+// being run like any other.
+static void runSlots(wheel_t *wheel)
+{
+    const cobalt_u64_t clock = wheel->clock++;
+    for (cobalt_u32_t level = 0; level < LEVELS; level++)
+    {
+        const cobalt_u32_t shift = level * LEVEL_SHIFT;
+        if (clock & ((1UL << shift) - 1)) break;
+        const cobalt_u32_t index = (clock >> shift) % SLOTS;
+        cobalt_timer_t *list = wheel->slots[level][index];
+        if (list == nullptr) continue;
+        wheel->slots[level][index] = nullptr;
+        wheel->occupied[level] &= ~(1UL << index);
+        list->link = &list;
+
+        while (list != nullptr)
+        {
+            cobalt_timer_t *timer = list;
+            unlink(wheel, timer);
+            if (timer->expires > clock)
+            {
+                enqueue(wheel, timer);
+                continue;
+            }
+
+            void (*function)(cobalt_timer_t *timer) = timer->function;
+            atomic_store_explicit(&timer->wheel, 0, memory_order_release);
+            wheel->expired++;
+            Cobalt_SpinUnlock(&wheel->lock);
+            function(timer);
+            Cobalt_SpinLock(&wheel->lock);
+        }
+    }
+}
+
+bool Cobalt_InitializeTimers(void)
+{
+    wheel_t *wheel = &wheels[Cobalt_CPUIndex()];
+    wheel->clock = currentUnit();
+    wheel->next = wheel->armed = NEVER;
+    return Cobalt_InitializeLocalTimer(COBALT_VECTOR_TIMER,
+                                       Cobalt_ClockFrequency() / 1000000);
+}
+
+void Cobalt_SetTimer(cobalt_timer_t *timer, cobalt_u64_t deadline,
+                     void (*function)(cobalt_timer_t *timer))
+{
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    Cobalt_CancelTimer(timer);
+    const cobalt_u32_t index = Cobalt_CPUIndex();
+    wheel_t *wheel = &wheels[index];
+    const cobalt_u64_t present = currentUnit();
+
+    Cobalt_SpinLock(&wheel->lock);
+    // A wheel that's sat idle has a clock that's fallen behind, which
+    // would put the timer in a coarser level than it needs.
+    if (present > wheel->clock)
+        wheel->clock = present < wheel->next ? present : wheel->next;
+
+    timer->function = function;
+    timer->expires = (deadline >> UNIT_SHIFT) +
+                     ((deadline & ((1UL << UNIT_SHIFT) - 1)) != 0);
+    const cobalt_u64_t due = enqueue(wheel, timer);
+    atomic_store_explicit(&timer->wheel, index + 1, memory_order_release);
+    if (due < wheel->next) wheel->next = due;
+    arm(wheel);
+    Cobalt_SpinUnlock(&wheel->lock);
+    Cobalt_RestoreInterrupts(flags);
+}
+
+bool Cobalt_CancelTimer(cobalt_timer_t *timer)
+{
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    // The timer can fire or be set elsewhere until its wheel's lock is
+    // held, so the wheel has to be checked again once it is.
+    cobalt_u32_t owner;
+    bool cancelled = false;
+    while (!cancelled && (owner = atomic_load_explicit(
+                              &timer->wheel, memory_order_acquire)) != 0)
+    {
+        wheel_t *wheel = &wheels[owner - 1];
+        Cobalt_SpinLock(&wheel->lock);
+        if (atomic_load_explicit(&timer->wheel, memory_order_relaxed) ==
+            owner)
+        {
+            unlink(wheel, timer);
+            atomic_store_explicit(&timer->wheel, 0, memory_order_relaxed);
+            cancelled = true;
+        }
+        Cobalt_SpinUnlock(&wheel->lock);
+    }
+    Cobalt_RestoreInterrupts(flags);
+    return cancelled;
+}
+
+void Cobalt_RunTimers(void)
+{
+    wheel_t *wheel = &wheels[Cobalt_CPUIndex()];
+    const cobalt_u64_t present = currentUnit();
+
+    Cobalt_SpinLock(&wheel->lock);
+    wheel->interrupts++;
+    // Whatever the timer was armed for has fired, and it's disarmed now.
+    wheel->armed = NEVER;
+    // Nothing comes around between the clock and the next occupied slot,
+    // so the clock can skip straight there, however long it's been idle.
+    while (wheel->next <= present)
+    {
+        wheel->clock = wheel->next;
+        runSlots(wheel);
+        wheel->next = nextDue(wheel);
+    }
+    if (present >= wheel->clock) wheel->clock = present + 1;
+    arm(wheel);
+    Cobalt_SpinUnlock(&wheel->lock);
+}
+
+typedef struct
+{
+    cobalt_timer_t timer;
+    cobalt_completion_t done;
+} sleeper_t;
+
+static void wakeSleeper(cobalt_timer_t *timer)
+{
+    Cobalt_SignalCompletion(&((sleeper_t *)timer)->done);
+}
+
+void Cobalt_Sleep(cobalt_u64_t nanoseconds)
+{
+    sleeper_t sleeper = {0};
+    Cobalt_InitializeCompletion(&sleeper.done, 1);
+    Cobalt_SetTimer(&sleeper.timer,
+                    Cobalt_MonotonicNanoseconds() + nanoseconds,
+                    wakeSleeper);
+    Cobalt_WaitForCompletion(&sleeper.done);
+}
+
+void Cobalt_GetTimerStats(cobalt_timer_stats_t *stats)
+{
+    *stats = (cobalt_timer_stats_t){0};
+    for (cobalt_u32_t i = 0; i < COBALT_MAXIMUM_CPUS; i++)
+    {
+        stats->interrupts += wheels[i].interrupts;
+        stats->expired += wheels[i].expired;
+    }
+}
+
+static cobalt_timer_t benchmarkTimers[BENCHMARK_TIMERS];
+
+static void benchmarkExpired(cobalt_timer_t *timer) { (void)timer; }
+
+void Cobalt_BenchmarkTimers(void)
+{
+    // The deadlines are spread over every level but the bottom, and are
+    // far enough off that none fires before it's cancelled.
+    const cobalt_u64_t ticksPerMicrosecond =
+        Cobalt_ClockFrequency() / 1000000;
+    cobalt_u64_t state = Cobalt_ReadTimestamp() | 1;
+    cobalt_u64_t setTicks = 0, cancelTicks = 0;
+    for (cobalt_u32_t round = 0; round < BENCHMARK_ROUNDS; round++)
+    {
+        const cobalt_u64_t base = Cobalt_MonotonicNanoseconds() +
+                                  BENCHMARK_IDLE;
+        cobalt_u64_t start = Cobalt_ReadTimestamp();
+        for (cobalt_u32_t i = 0; i < BENCHMARK_TIMERS; i++)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            Cobalt_SetTimer(&benchmarkTimers[i],
+                            base + (state & ((1UL << 36) - 1)),
+                            benchmarkExpired);
+        }
+        setTicks += Cobalt_ReadTimestamp() - start;
+
+        start = Cobalt_ReadTimestamp();
+        for (cobalt_u32_t i = 0; i < BENCHMARK_TIMERS; i++)
+            Cobalt_CancelTimer(&benchmarkTimers[i]);
+        cancelTicks += Cobalt_ReadTimestamp() - start;
+    }
+    const cobalt_u64_t operations = BENCHMARK_TIMERS * BENCHMARK_ROUNDS;
+    Cobalt_SerialPrintf("timers: %U ns per set, %U ns per cancel\n",
+                        setTicks * 1000 / ticksPerMicrosecond / operations,
+                        cancelTicks * 1000 / ticksPerMicrosecond /
+                            operations);
+
+    static const cobalt_u64_t lengths[] = {10000, 100000, 1000000,
+                                           10000000};
+    for (cobalt_u32_t i = 0; i < sizeof(lengths) / sizeof(*lengths); i++)
+    {
+        cobalt_u64_t total = 0, worst = 0;
+        for (cobalt_u32_t j = 0; j < BENCHMARK_SLEEPS; j++)
+        {
+            const cobalt_u64_t start = Cobalt_MonotonicNanoseconds();
+            Cobalt_Sleep(lengths[i]);
+            const cobalt_u64_t late =
+                Cobalt_MonotonicNanoseconds() - start - lengths[i];
+            total += late;
+            if (late > worst) worst = late;
+        }
+        Cobalt_SerialPrintf("timers: %U us sleeps woke %U ns late on "
+                            "average, %U ns at worst\n",
+                            lengths[i] / 1000, total / BENCHMARK_SLEEPS,
+                            worst);
+    }
+
+    // With the other processors idle and this thread asleep, the only
+    // interrupts should be this thread's wakeup and whatever RCU needs.
+    const cobalt_u64_t processors =
+        (cobalt_u64_t)__builtin_popcountll(Cobalt_OnlineCPUs());
+    cobalt_timer_stats_t before, after;
+    Cobalt_GetTimerStats(&before);
+    Cobalt_Sleep(BENCHMARK_IDLE);
+    Cobalt_GetTimerStats(&after);
+    Cobalt_SerialPrintf("timers: %U interrupts across %U processors in "
+                        "%U ms idle, against %U for a periodic tick\n",
+                        after.interrupts - before.interrupts, processors,
+                        BENCHMARK_IDLE / 1000000,
+                        processors * (BENCHMARK_IDLE / 1000) /
+                            COBALT_TIME_SLICE);
+}
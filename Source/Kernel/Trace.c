@@ -0,0 +1,70 @@
+/**
+ * @file Trace.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the boot trace reporter outlined in the
+ * Kernel/Trace.h file.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <Kernel/Serial.h>
+#include <Kernel/Trace.h>
+
+// Print a tick count as microseconds to three decimal places, without
+// touching the floating point unit.
+static void printMicroseconds(cobalt_u64_t ticks, cobalt_u64_t rate)
+{
+    const cobalt_u64_t fraction = (ticks % rate) * 1000 / rate;
+    Cobalt_SerialPrintf("%U.%c%c%c", ticks / rate,
+                        (int)('0' + fraction / 100),
+                        (int)('0' + fraction / 10 % 10),
+                        (int)('0' + fraction % 10));
+}
+
+void Cobalt_DumpTrace(const cobalt_trace_t *trace)
+{
+    const cobalt_u64_t rate =
+        trace->ticksPerMicrosecond != 0 ? trace->ticksPerMicrosecond : 1;
+    const cobalt_u64_t base =
+        trace->count != 0 ? trace->events[0].start : 0;
+
+    Cobalt_SerialPuts("{\"traceEvents\":[");
+    bool first = true;
+    for (cobalt_u32_t i = 0; i < trace->count; i++)
+    {
+        const cobalt_trace_event_t *event = &trace->events[i];
+        if (event->end == 0) continue;
+
+        Cobalt_SerialPrintf("%s\n{\"name\":\"%s\",\"cat\":\"boot\","
+                            "\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":",
+                            first ? "" : ",", event->name);
+        printMicroseconds(event->start - base, rate);
+        Cobalt_SerialPuts(",\"dur\":");
+        printMicroseconds(event->end - event->start, rate);
+        Cobalt_SerialPuts("}");
+        first = false;
+    }
+
+    // Counters become counter ("C") events, which the viewers draw as a
+    // graph of their own.
+    for (cobalt_u32_t i = 0; i < trace->counterCount; i++)
+    {
+        const cobalt_trace_counter_t *counter = &trace->counters[i];
+        Cobalt_SerialPrintf("%s\n{\"name\":\"%s\",\"cat\":\"boot\","
+                            "\"ph\":\"C\",\"pid\":0,\"tid\":0,\"ts\":",
+                            first ? "" : ",", counter->name);
+        const cobalt_u64_t timestamp =
+            counter->timestamp > base ? counter->timestamp - base : 0;
+        printMicroseconds(timestamp, rate);
+        Cobalt_SerialPrintf(",\"args\":{\"value\":%U}}", counter->value);
+        first = false;
+    }
+    Cobalt_SerialPrintf("\n],\"displayTimeUnit\":\"ms\",\"otherData\":"
+                        "{\"ticksPerMicrosecond\":%U,\"dropped\":%U}}\n",
+                        rate, (cobalt_u64_t)trace->dropped);
+}
@@ -0,0 +1,768 @@
+/**
+ * @file Virtual.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the virtual memory manager outlined in the
+ * Kernel/Virtual.h file.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <CPU.h>
+#include <Kernel/APIC.h>
+#include <Kernel/CPU.h>
+#include <Kernel/Heap.h>
+#include <Kernel/Interrupts.h>
+#include <Kernel/Physical.h>
+#include <Kernel/Slab.h>
+#include <Kernel/Spinlock.h>
+#include <Kernel/Virtual.h>
+#include <Memory.h>
+#include <Paging.h>
+#include <stdatomic.h>
+
+#define EFER_MSR 0xC0000080
+#define EFER_NO_EXECUTE (1 << 11)
+
+// The power-on page attribute table, but for entry one, which the
+// write-through bit alone selects, being write-combining rather than
+// write-through.
+#define PAT_MSR 0x277
+#define PAT_WRITE_COMBINING 0x0007040600070106ULL
+
+#define CR4_GLOBAL_PAGES (1 << 7)
+#define CR4_PCID (1 << 17)
+
+// Bit 63 of a value written to CR3 keeps the new PCID's TLB entries.
+#define CR3_NO_FLUSH (1ULL << 63)
+#define PCID_COUNT 4096
+
+// The bits of a page fault's error code.
+#define FAULT_PRESENT (1 << 0)
+#define FAULT_WRITE (1 << 1)
+#define FAULT_USER (1 << 2)
+#define FAULT_FETCH (1 << 4)
+
+// Set on regions backed by a fixed physical range.
+#define REGION_PHYSICAL (1U << 31)
+
+typedef struct region
+{
+    struct region *left;
+    struct region *right;
+    cobalt_u64_t base;
+    cobalt_u64_t end;
+    // The physical address base maps to, for physical regions.
+    cobalt_u64_t physical;
+    cobalt_u32_t flags;
+    cobalt_i32_t height;
+} region_t;
+
+struct cobalt_address_space
+{
+    // This guards the region tree and the page tables. It's only ever
+    // taken with interrupts disabled, since the page fault handler takes
+    // it too.
+    cobalt_spinlock_t lock;
+    cobalt_u64_t root;
+    cobalt_u64_t pcid;
+    region_t *regions;
+    // The processors that have the space loaded.
+    atomic_ulong active;
+    // The processors whose TLBs may hold outdated entries under the
+    // space's PCID, which must flush them when they next load it.
+    atomic_ulong stale;
+};
+
+// A set of pages to flush from the TLBs together.
+typedef struct
+{
+    cobalt_address_space_t *space;
+    cobalt_u64_t count;
+    cobalt_u64_t addresses[COBALT_FLUSH_BATCH_SIZE];
+    bool overflowed;
+    // The frames the pages held, chained through their first word. They
+    // can only be freed once no TLB can reach them.
+    cobalt_u64_t frames;
+} flush_t;
+
+static cobalt_address_space_t kernelSpace;
+static cobalt_slab_cache_t *regionCache;
+static cobalt_u64_t noExecute;
+static bool pcids;
+static bool pat;
+static atomic_ulong deviceCursor;
+
+static cobalt_spinlock_t pcidLock;
+static cobalt_u64_t pcidsUsed[PCID_COUNT / 64];
+
+// Only one flush is in flight at a time. The processors it's aimed at
+// clear their bit of pending once they've done it.
+static struct
+{
+    cobalt_spinlock_t lock;
+    const flush_t *flush;
+    atomic_ulong pending;
+} shootdown;
+
+static cobalt_i32_t height(const region_t *node)
+{
+    return node != nullptr ? node->height : 0;
+}
+
+static void updateHeight(region_t *node)
+{
+    const cobalt_i32_t left = height(node->left);
+    const cobalt_i32_t right = height(node->right);
+    node->height = 1 + (left > right ? left : right);
+}
+
+static region_t *rotateRight(region_t *node)
+{
+    region_t *left = node->left;
+    node->left = left->right;
+    left->right = node;
+    updateHeight(node);
+    updateHeight(left);
+    return left;
+}
+
+static region_t *rotateLeft(region_t *node)
+{
+    region_t *right = node->right;
+    node->right = right->left;
+    right->left = node;
+    updateHeight(node);
+    updateHeight(right);
+    return right;
+}
+
+static region_t *rebalance(region_t *node)
+{
+    updateHeight(node);
+    const cobalt_i32_t balance = height(node->left) - height(node->right);
+    if (balance > 1)
+    {
+        if (height(node->left->left) < height(node->left->right))
+            node->left = rotateLeft(node->left);
+        return rotateRight(node);
+    }
+    if (balance < -1)
+    {
+        if (height(node->right->right) < height(node->right->left))
+            node->right = rotateRight(node->right);
+        return rotateLeft(node);
+    }
+    return node;
+}
+
+static region_t *insertRegion(region_t *node, region_t *region)
+{
+    if (node == nullptr)
+    {
+        region->left = region->right = nullptr;
+        region->height = 1;
+        return region;
+    }
+
+    if (region->base < node->base)
+        node->left = insertRegion(node->left, region);
+    else node->right = insertRegion(node->right, region);
+    return rebalance(node);
+}
+
+static region_t *removeMinimum(region_t *node, region_t **minimum)
+{
+    if (node->left == nullptr)
+    {
+        *minimum = node;
+        return node->right;
+    }
+    node->left = removeMinimum(node->left, minimum);
+    return rebalance(node);
+}
+
+static region_t *removeRegion(region_t *node, const region_t *region)
+{
+    if (node == region)
+    {
+        if (node->right == nullptr) return node->left;
+        region_t *successor;
+        region_t *right = removeMinimum(node->right, &successor);
+        successor->left = node->left;
+        successor->right = right;
+        return rebalance(successor);
+    }
+
+    if (region->base < node->base)
+        node->left = removeRegion(node->left, region);
+    else node->right = removeRegion(node->right, region);
+    return rebalance(node);
+}
+
+// Find any region that overlaps [base, end).
+static region_t *findRegion(region_t *node, cobalt_u64_t base,
+                            cobalt_u64_t end)
+{
+    while (node != nullptr)
+    {
+        if (end <= node->base) node = node->left;
+        else if (base >= node->end) node = node->right;
+        else return node;
+    }
+    return nullptr;
+}
+
+static cobalt_u64_t allocateZeroedPage(void)
+{
+    const cobalt_u64_t page = Cobalt_AllocatePages(0);
+    if (page == 0) return 0;
+    Cobalt_ZeroMemory(Cobalt_PhysicalToVirtual(page), COBALT_PAGE_SIZE);
+    return page;
+}
+
+// Find the last-level entry of an address, making the tables above it if
+// asked to. This gives up at large pages, which only the loader's direct
+// map uses.
+static cobalt_u64_t *walk(cobalt_u64_t root, cobalt_u64_t address,
+                          bool create)
+{
+    const cobalt_u64_t tableFlags =
+        COBALT_PAGE_PRESENT | COBALT_PAGE_WRITABLE |
+        (address < COBALT_USER_SPACE_END ? COBALT_PAGE_USER : 0);
+
+    cobalt_u64_t *table = Cobalt_PhysicalToVirtual(root);
+    for (cobalt_u32_t level = 3; level > 0; level--)
+    {
+        cobalt_u64_t *entry =
+            &table[Cobalt_PageTableIndex(address, level)];
+        if ((*entry & COBALT_PAGE_PRESENT) == 0)
+        {
+            if (!create) return nullptr;
+            const cobalt_u64_t page = allocateZeroedPage();
+            if (page == 0) return nullptr;
+            *entry = page | tableFlags;
+        }
+        else if (*entry & COBALT_PAGE_LARGE) return nullptr;
+        table =
+            Cobalt_PhysicalToVirtual(*entry & COBALT_PAGE_ADDRESS_MASK);
+    }
+    return &table[Cobalt_PageTableIndex(address, 0)];
+}
+
+static void freeTable(cobalt_u64_t table, cobalt_u32_t level)
+{
+    const cobalt_u64_t *entries = Cobalt_PhysicalToVirtual(table);
+    for (cobalt_u64_t i = 0; level != 0 && i < COBALT_PAGE_TABLE_ENTRIES;
+         i++)
+        if ((entries[i] & COBALT_PAGE_PRESENT) &&
+            !(entries[i] & COBALT_PAGE_LARGE))
+            freeTable(entries[i] & COBALT_PAGE_ADDRESS_MASK, level - 1);
+    Cobalt_FreePages(table, 0);
+}
+
+static cobalt_u64_t entryFlags(const region_t *region)
+{
+    cobalt_u64_t flags = COBALT_PAGE_PRESENT;
+    if (region->flags & COBALT_REGION_WRITABLE)
+        flags |= COBALT_PAGE_WRITABLE;
+    if (!(region->flags & COBALT_REGION_EXECUTABLE)) flags |= noExecute;
+    // The kernel's half is the same in every address space, so its
+    // entries can outlive a switch.
+    if (region->flags & COBALT_REGION_USER) flags |= COBALT_PAGE_USER;
+    else flags |= COBALT_PAGE_GLOBAL;
+    // This picks entry one of the page attribute table, which is
+    // write-combining once it's been programmed.
+    if (region->flags & COBALT_REGION_WRITE_COMBINING)
+        flags |= COBALT_PAGE_WRITE_THROUGH;
+    return flags;
+}
+
+static void addToFlush(flush_t *flush, cobalt_u64_t address,
+                       cobalt_u64_t frame)
+{
+    if (flush->count < COBALT_FLUSH_BATCH_SIZE)
+        flush->addresses[flush->count++] = address;
+    else flush->overflowed = true;
+
+    if (frame == 0) return;
+    *(cobalt_u64_t *)Cobalt_PhysicalToVirtual(frame) = flush->frames;
+    flush->frames = frame;
+}
+
+static void freeFrames(flush_t *flush)
+{
+    while (flush->frames != 0)
+    {
+        const cobalt_u64_t frame = flush->frames;
+        flush->frames = *(cobalt_u64_t *)Cobalt_PhysicalToVirtual(frame);
+        Cobalt_FreePages(frame, 0);
+    }
+}
+
+static void flushLocal(const flush_t *flush)
+{
+    if (!flush->overflowed)
+    {
+        for (cobalt_u64_t i = 0; i < flush->count; i++)
+            Cobalt_InvalidatePage(flush->addresses[i]);
+        return;
+    }
+
+    // The kernel's entries are global, which only toggling global pages
+    // off and on again drops wholesale.
+    if (flush->space == &kernelSpace)
+    {
+        const cobalt_u64_t cr4 = Cobalt_ReadCR4();
+        Cobalt_WriteCR4(cr4 & ~CR4_GLOBAL_PAGES);
+        Cobalt_WriteCR4(cr4);
+    }
+    else Cobalt_WriteCR3(Cobalt_ReadCR3());
+}
+
+static void serviceShootdown(void)
+{
+    const cobalt_u64_t self = 1UL << Cobalt_CPUIndex();
+    if ((atomic_load(&shootdown.pending) & self) == 0) return;
+    flushLocal(shootdown.flush);
+    atomic_fetch_and(&shootdown.pending, ~self);
+}
+
+static void handleShootdown(cobalt_interrupt_frame_t *frame)
+{
+    (void)frame;
+    serviceShootdown();
+    Cobalt_EndOfInterrupt();
+}
+
+// Flush a set of pages from every TLB that might hold them, then free
+// their frames. No address space lock may be held, since a processor
+// waiting on one has interrupts off and would never answer.
+static void flushPages(flush_t *flush)
+{
+    if (flush->count == 0) return;
+
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    const cobalt_u64_t self = 1UL << Cobalt_CPUIndex();
+    cobalt_u64_t targets = Cobalt_OnlineCPUs();
+    if (flush->space != &kernelSpace)
+    {
+        // A processor that loads the space after this sees itself marked
+        // stale; one that loaded it before is among the targets.
+        atomic_fetch_or(&flush->space->stale, ~0UL);
+        targets = atomic_load(&flush->space->active);
+    }
+
+    if (targets & self) flushLocal(flush);
+    targets &= ~self;
+    if (targets != 0)
+    {
+        // Whoever holds the lock may be waiting on us, so keep answering
+        // while we wait for it.
+        while (!Cobalt_SpinTryLock(&shootdown.lock))
+        {
+            serviceShootdown();
+            Cobalt_Pause();
+        }
+
+        shootdown.flush = flush;
+        atomic_store(&shootdown.pending, targets);
+        for (cobalt_u32_t i = 0; i < COBALT_MAXIMUM_CPUS; i++)
+            if (targets & (1UL << i))
+                Cobalt_SendIPI(Cobalt_GetCPU(i)->apicID,
+                               COBALT_VECTOR_TLB_SHOOTDOWN);
+        while (atomic_load(&shootdown.pending) != 0) Cobalt_Pause();
+        Cobalt_SpinUnlock(&shootdown.lock);
+    }
+
+    Cobalt_RestoreInterrupts(flags);
+    freeFrames(flush);
+}
+
+// Clear the entries of [start, end) within a region. The lock must be
+// held.
+static void unmapPages(cobalt_address_space_t *space,
+                       const region_t *region, cobalt_u64_t start,
+                       cobalt_u64_t end, flush_t *flush)
+{
+    for (cobalt_u64_t address = start; address < end;
+         address += COBALT_PAGE_SIZE)
+    {
+        cobalt_u64_t *entry = walk(space->root, address, false);
+        if (entry == nullptr || (*entry & COBALT_PAGE_PRESENT) == 0)
+            continue;
+
+        const cobalt_u64_t frame = *entry & COBALT_PAGE_ADDRESS_MASK;
+        *entry = 0;
+        addToFlush(flush, address,
+                   region->flags & REGION_PHYSICAL ? 0 : frame);
+    }
+}
+
+static bool faultIn(cobalt_address_space_t *space, cobalt_u64_t address,
+                    cobalt_u64_t error)
+{
+    // A fault on a present page broke its permissions, which no amount
+    // of mapping will fix.
+    if (error & FAULT_PRESENT) return false;
+
+    Cobalt_SpinLock(&space->lock);
+    const region_t *region =
+        findRegion(space->regions, address, address + 1);
+    bool handled = region != nullptr;
+    if (handled)
+    {
+        if ((error & FAULT_WRITE) &&
+            !(region->flags & COBALT_REGION_WRITABLE))
+            handled = false;
+        if ((error & FAULT_USER) && !(region->flags & COBALT_REGION_USER))
+            handled = false;
+        if ((error & FAULT_FETCH) &&
+            !(region->flags & COBALT_REGION_EXECUTABLE))
+            handled = false;
+    }
+
+    cobalt_u64_t *entry = nullptr;
+    if (handled) entry = walk(space->root, address, true);
+    // Another processor may have faulted the page in first.
+    if (entry != nullptr && (*entry & COBALT_PAGE_PRESENT) == 0)
+    {
+        const cobalt_u64_t page = address & ~(COBALT_PAGE_SIZE - 1);
+        const cobalt_u64_t frame =
+            region->flags & REGION_PHYSICAL
+                ? region->physical + (page - region->base)
+                : allocateZeroedPage();
+        if (frame != 0) *entry = frame | entryFlags(region);
+        else entry = nullptr;
+    }
+    Cobalt_SpinUnlock(&space->lock);
+    return entry != nullptr;
+}
+
+static void handlePageFault(cobalt_interrupt_frame_t *frame)
+{
+    const cobalt_u64_t address = Cobalt_ReadCR2();
+    cobalt_address_space_t *space = &kernelSpace;
+    if (address < COBALT_USER_SPACE_END &&
+        Cobalt_CurrentCPU()->addressSpace != nullptr)
+        space = Cobalt_CurrentCPU()->addressSpace;
+
+    if (!faultIn(space, address, frame->errorCode))
+        Cobalt_UnhandledInterrupt(frame);
+}
+
+static cobalt_u64_t allocatePCID(void)
+{
+    if (!pcids) return 0;
+
+    // PCID zero is the kernel's, and is handed out again only once the
+    // rest are gone. Spaces that share it are flushed on every switch.
+    cobalt_u64_t pcid = 0;
+    Cobalt_SpinLock(&pcidLock);
+    for (cobalt_u64_t i = 1; i < PCID_COUNT && pcid == 0; i++)
+        if ((pcidsUsed[i / 64] & (1UL << (i % 64))) == 0)
+        {
+            pcidsUsed[i / 64] |= 1UL << (i % 64);
+            pcid = i;
+        }
+    Cobalt_SpinUnlock(&pcidLock);
+    return pcid;
+}
+
+static void freePCID(cobalt_u64_t pcid)
+{
+    if (pcid == 0) return;
+    Cobalt_SpinLock(&pcidLock);
+    pcidsUsed[pcid / 64] &= ~(1UL << (pcid % 64));
+    Cobalt_SpinUnlock(&pcidLock);
+}
+
+static bool reserve(cobalt_address_space_t *space, cobalt_u64_t base,
+                    cobalt_u64_t physical, cobalt_u64_t size,
+                    cobalt_u32_t flags)
+{
+    const cobalt_u64_t end = base + size;
+    if (((base | size | physical) & (COBALT_PAGE_SIZE - 1)) != 0 ||
+        size == 0 || end < base)
+        return false;
+    if (space == &kernelSpace ? base < COBALT_DIRECT_MAP_BASE
+                              : end > COBALT_USER_SPACE_END)
+        return false;
+
+    region_t *region = Cobalt_SlabAllocate(regionCache);
+    if (region == nullptr) return false;
+    region->base = base;
+    region->end = end;
+    region->physical = physical;
+    region->flags = flags;
+
+    const cobalt_u64_t interruptFlags = Cobalt_DisableInterrupts();
+    Cobalt_SpinLock(&space->lock);
+    const bool available =
+        findRegion(space->regions, base, end) == nullptr;
+    if (available) space->regions = insertRegion(space->regions, region);
+    Cobalt_SpinUnlock(&space->lock);
+    Cobalt_RestoreInterrupts(interruptFlags);
+
+    if (!available) Cobalt_SlabFree(regionCache, region);
+    return available;
+}
+
+bool Cobalt_InitializeVirtualMemory(const cobalt_efi_info_t *efiInfo)
+{
+    regionCache = Cobalt_CreateSlabCache("region", sizeof(region_t), 0,
+                                         nullptr);
+    if (regionCache == nullptr) return false;
+
+    // CPUID leaf 1 reports PCIDs in bit 17 of ECX, and the page
+    // attribute table in bit 16 of EDX.
+    cobalt_u32_t cpuid[4];
+    Cobalt_CPUID(1, 0, cpuid);
+    pcids = (cpuid[2] & (1 << 17)) != 0;
+    pat = (cpuid[3] & (1 << 16)) != 0;
+    if (Cobalt_ReadMSR(EFER_MSR) & EFER_NO_EXECUTE)
+        noExecute = COBALT_PAGE_NO_EXECUTE;
+
+    // Every other address space copies the kernel's half of the root
+    // table when it's made, so every entry of that half has to exist up
+    // front for them to stay in step.
+    kernelSpace.root = efiInfo->pageTableRoot;
+    cobalt_u64_t *root = Cobalt_PhysicalToVirtual(kernelSpace.root);
+    for (cobalt_u64_t i = COBALT_PAGE_TABLE_ENTRIES / 2;
+         i < COBALT_PAGE_TABLE_ENTRIES; i++)
+    {
+        if (root[i] & COBALT_PAGE_PRESENT) continue;
+        const cobalt_u64_t table = allocateZeroedPage();
+        if (table == 0) return false;
+        root[i] = table | COBALT_PAGE_PRESENT | COBALT_PAGE_WRITABLE;
+    }
+
+    // The loader mapped the kernel image and the direct map already.
+    // Recording them keeps anything else from being mapped over them,
+    // and lets the direct map fill its holes on demand.
+    if (!reserve(&kernelSpace, efiInfo->kernelVirtualBase,
+                 efiInfo->kernelBase,
+                 efiInfo->kernelPageCount * COBALT_PAGE_SIZE,
+                 REGION_PHYSICAL | COBALT_REGION_WRITABLE |
+                     COBALT_REGION_EXECUTABLE) ||
+        !reserve(&kernelSpace, COBALT_DIRECT_MAP_BASE, 0,
+                 COBALT_DIRECT_MAP_SIZE,
+                 REGION_PHYSICAL | COBALT_REGION_WRITABLE))
+        return false;
+
+    Cobalt_SetInterruptHandler(COBALT_VECTOR_PAGE_FAULT, handlePageFault);
+    Cobalt_SetInterruptHandler(COBALT_VECTOR_TLB_SHOOTDOWN,
+                               handleShootdown);
+    Cobalt_StartVirtualMemory();
+    return true;
+}
+
+void Cobalt_StartVirtualMemory(void)
+{
+    // PCIDs can only be turned on while the PCID in CR3 is zero, which
+    // the kernel's is.
+    Cobalt_WriteCR3(kernelSpace.root);
+    cobalt_u64_t cr4 = Cobalt_ReadCR4() | CR4_GLOBAL_PAGES;
+    if (pcids) cr4 |= CR4_PCID;
+    Cobalt_WriteCR4(cr4);
+    // Nothing is mapped through entry one before this, so there are no
+    // cached lines under the old type to flush. Every processor has to
+    // agree on the table, so each programs its own.
+    if (pat) Cobalt_WriteMSR(PAT_MSR, PAT_WRITE_COMBINING);
+
+    cobalt_cpu_t *cpu = Cobalt_CurrentCPU();
+    cpu->addressSpace = &kernelSpace;
+    atomic_fetch_or(&kernelSpace.active, 1UL << cpu->index);
+}
+
+cobalt_address_space_t *Cobalt_KernelAddressSpace(void)
+{
+    return &kernelSpace;
+}
+
+cobalt_address_space_t *Cobalt_CreateAddressSpace(void)
+{
+    cobalt_address_space_t *space = Cobalt_Allocate(sizeof(*space));
+    if (space == nullptr) return nullptr;
+    Cobalt_ZeroMemory(space, sizeof(*space));
+
+    space->root = allocateZeroedPage();
+    if (space->root == 0)
+    {
+        Cobalt_Free(space);
+        return nullptr;
+    }
+    const cobalt_u64_t *kernelRoot =
+        Cobalt_PhysicalToVirtual(kernelSpace.root);
+    cobalt_u64_t *root = Cobalt_PhysicalToVirtual(space->root);
+    for (cobalt_u64_t i = COBALT_PAGE_TABLE_ENTRIES / 2;
+         i < COBALT_PAGE_TABLE_ENTRIES; i++)
+        root[i] = kernelRoot[i];
+
+    // The PCID may have been another space's, whose entries could still
+    // be in any processor's TLB.
+    space->pcid = allocatePCID();
+    atomic_init(&space->active, 0);
+    atomic_init(&space->stale, ~0UL);
+    return space;
+}
+
+void Cobalt_DestroyAddressSpace(cobalt_address_space_t *space)
+{
+    // Nothing has the space loaded, and any TLB entries left under its
+    // PCID are flushed before the PCID is next used, so its frames can
+    // go straight back.
+    flush_t flush = {.space = space};
+    while (space->regions != nullptr)
+    {
+        region_t *region = space->regions;
+        unmapPages(space, region, region->base, region->end, &flush);
+        space->regions = removeRegion(space->regions, region);
+        Cobalt_SlabFree(regionCache, region);
+    }
+    freeFrames(&flush);
+
+    const cobalt_u64_t *root = Cobalt_PhysicalToVirtual(space->root);
+    for (cobalt_u64_t i = 0; i < COBALT_PAGE_TABLE_ENTRIES / 2; i++)
+        if (root[i] & COBALT_PAGE_PRESENT)
+            freeTable(root[i] & COBALT_PAGE_ADDRESS_MASK, 2);
+    Cobalt_FreePages(space->root, 0);
+    freePCID(space->pcid);
+    Cobalt_Free(space);
+}
+
+void Cobalt_SwitchAddressSpace(cobalt_address_space_t *space)
+{
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    cobalt_cpu_t *cpu = Cobalt_CurrentCPU();
+    cobalt_address_space_t *previous = cpu->addressSpace;
+    if (previous == space)
+    {
+        Cobalt_RestoreInterrupts(flags);
+        return;
+    }
+
+    // This must be marked active before the stale bit is checked; see
+    // flushPages for the other half.
+    const cobalt_u64_t self = 1UL << cpu->index;
+    atomic_fetch_or(&space->active, self);
+    const bool stale = (atomic_fetch_and(&space->stale, ~self) & self);
+
+    cobalt_u64_t cr3 = space->root | space->pcid;
+    if (space->pcid != 0 && !stale) cr3 |= CR3_NO_FLUSH;
+    Cobalt_WriteCR3(cr3);
+
+    if (previous != nullptr) atomic_fetch_and(&previous->active, ~self);
+    cpu->addressSpace = space;
+    Cobalt_RestoreInterrupts(flags);
+}
+
+bool Cobalt_MapRegion(cobalt_address_space_t *space, cobalt_u64_t base,
+                      cobalt_u64_t size, cobalt_region_flags_t flags)
+{
+    return reserve(space, base, 0, size, flags);
+}
+
+bool Cobalt_MapPhysicalRegion(cobalt_address_space_t *space,
+                              cobalt_u64_t base, cobalt_u64_t physical,
+                              cobalt_u64_t size,
+                              cobalt_region_flags_t flags)
+{
+    return reserve(space, base, physical, size, flags | REGION_PHYSICAL);
+}
+
+// Claim a page-aligned run of the device window. The window is never
+// given back, so it's handed out in order.
+static cobalt_u64_t claimWindow(cobalt_u64_t size)
+{
+    if (size == 0 || size > COBALT_DEVICE_MAP_SIZE) return 0;
+    const cobalt_u64_t start = atomic_fetch_add(&deviceCursor, size);
+    if (start + size > COBALT_DEVICE_MAP_SIZE) return 0;
+    return COBALT_DEVICE_MAP_BASE + start;
+}
+
+void *Cobalt_MapDevice(cobalt_u64_t physical, cobalt_u64_t size,
+                       cobalt_region_flags_t flags)
+{
+    const cobalt_u64_t offset = physical & (COBALT_PAGE_SIZE - 1);
+    if (size > COBALT_DEVICE_MAP_SIZE) return nullptr;
+    size = (size + offset + COBALT_PAGE_SIZE - 1) &
+           ~(COBALT_PAGE_SIZE - 1);
+    const cobalt_u64_t base = claimWindow(size);
+    if (base == 0 || !reserve(&kernelSpace, base, physical - offset, size,
+                              flags | REGION_PHYSICAL))
+        return nullptr;
+    return (void *)(base + offset);
+}
+
+void *Cobalt_MapKernelMemory(cobalt_u64_t size,
+                             cobalt_region_flags_t flags)
+{
+    if (size > COBALT_DEVICE_MAP_SIZE) return nullptr;
+    size = (size + COBALT_PAGE_SIZE - 1) & ~(COBALT_PAGE_SIZE - 1);
+    const cobalt_u64_t base = claimWindow(size);
+    if (base == 0 || !reserve(&kernelSpace, base, 0, size, flags))
+        return nullptr;
+    return (void *)base;
+}
+
+bool Cobalt_UnmapRegion(cobalt_address_space_t *space, cobalt_u64_t base,
+                        cobalt_u64_t size)
+{
+    const cobalt_u64_t end = base + size;
+    if (((base | size) & (COBALT_PAGE_SIZE - 1)) != 0 || end < base)
+        return false;
+
+    // At most one region can need splitting, so one spare is enough, and
+    // allocating it up front means running out is found out before
+    // anything has changed.
+    region_t *spare = Cobalt_SlabAllocate(regionCache);
+    flush_t flush = {.space = space};
+
+    const cobalt_u64_t flags = Cobalt_DisableInterrupts();
+    Cobalt_SpinLock(&space->lock);
+    const region_t *inner = findRegion(space->regions, base, base + 1);
+    const bool possible = spare != nullptr || inner == nullptr ||
+                          inner->base >= base || inner->end <= end;
+    region_t *region;
+    while (possible &&
+           (region = findRegion(space->regions, base, end)) != nullptr)
+    {
+        const cobalt_u64_t start =
+            region->base > base ? region->base : base;
+        const cobalt_u64_t stop = region->end < end ? region->end : end;
+        unmapPages(space, region, start, stop, &flush);
+
+        if (start == region->base && stop == region->end)
+        {
+            space->regions = removeRegion(space->regions, region);
+            Cobalt_SlabFree(regionCache, region);
+        }
+        else if (start == region->base)
+        {
+            region->physical += stop - region->base;
+            region->base = stop;
+        }
+        else if (stop == region->end) region->end = start;
+        else
+        {
+            *spare = *region;
+            spare->base = stop;
+            spare->physical += stop - region->base;
+            region->end = start;
+            space->regions = insertRegion(space->regions, spare);
+            spare = nullptr;
+            break;
+        }
+    }
+    Cobalt_SpinUnlock(&space->lock);
+    Cobalt_RestoreInterrupts(flags);
+
+    flushPages(&flush);
+    if (spare != nullptr) Cobalt_SlabFree(regionCache, spare);
+    return possible;
+}
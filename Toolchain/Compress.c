@@ -0,0 +1,134 @@
+/**
+ * @file Compress.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The implementation of the host-side LZ4 block compressor
+ * outlined in the Compress.h file.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <Compress.h>
+
+#include <string.h>
+
+// The compressor's hash table is indexed by this many bits of a hashed
+// four-byte sequence.
+#define HASH_BITS 16
+
+// The LZ4 block format requires that the last match start at least this
+// many bytes before the end of the block...
+#define MATCH_LIMIT 12
+// ...and that the last this many bytes always be literals.
+#define LAST_LITERALS 5
+
+#define MAXIMUM_OFFSET 65535
+
+static cobalt_u32_t read16(const cobalt_u8_t *bytes)
+{
+    return (cobalt_u32_t)bytes[0] | ((cobalt_u32_t)bytes[1] << 8);
+}
+
+static cobalt_u32_t read32(const cobalt_u8_t *bytes)
+{
+    return read16(bytes) | (read16(bytes + 2) << 16);
+}
+
+static cobalt_u32_t hash(cobalt_u32_t sequence)
+{
+    return (sequence * 2654435761U) >> (32 - HASH_BITS);
+}
+
+static cobalt_u8_t *writeLength(cobalt_u8_t *out, cobalt_u64_t length)
+{
+    for (; length >= 255; length -= 255) *out++ = 255;
+    *out++ = (cobalt_u8_t)length;
+    return out;
+}
+
+// A match length of zero writes the final, literal-only sequence.
+static cobalt_u8_t *writeSequence(cobalt_u8_t *out,
+                                  const cobalt_u8_t *literals,
+                                  cobalt_u64_t literalLength,
+                                  cobalt_u64_t offset,
+                                  cobalt_u64_t matchLength)
+{
+    cobalt_u8_t *token = out++;
+    *token = (literalLength >= 15 ? 15 : literalLength) << 4;
+    if (literalLength >= 15) out = writeLength(out, literalLength - 15);
+
+    memcpy(out, literals, literalLength);
+    out += literalLength;
+    if (matchLength == 0) return out;
+
+    *out++ = (cobalt_u8_t)offset;
+    *out++ = (cobalt_u8_t)(offset >> 8);
+
+    matchLength -= 4;
+    *token |= matchLength >= 15 ? 15 : matchLength;
+    if (matchLength >= 15) out = writeLength(out, matchLength - 15);
+    return out;
+}
+
+cobalt_u64_t Cobalt_Compress(const cobalt_u8_t *source,
+                             cobalt_u64_t size, cobalt_u8_t *destination)
+{
+    // Positions are stored plus one so that zero means an empty slot.
+    static cobalt_u32_t table[1 << HASH_BITS];
+    memset(table, 0, sizeof(table));
+
+    const cobalt_u8_t *in = source, *anchor = source;
+    cobalt_u8_t *out = destination;
+
+    if (size > MATCH_LIMIT)
+    {
+        const cobalt_u8_t *const matchLimit = source + size - MATCH_LIMIT;
+        const cobalt_u8_t *const matchEnd = source + size - LAST_LITERALS;
+
+        while (in < matchLimit)
+        {
+            const cobalt_u32_t sequence = read32(in);
+            const cobalt_u32_t slot = hash(sequence);
+            const cobalt_u32_t candidate = table[slot];
+            table[slot] = (cobalt_u32_t)(in - source) + 1;
+
+            if (candidate == 0 ||
+                (cobalt_u64_t)(in - source) - (candidate - 1) >
+                    MAXIMUM_OFFSET ||
+                read32(source + candidate - 1) != sequence)
+            {
+                in++;
+                continue;
+            }
+
+            const cobalt_u8_t *match = source + candidate - 1;
+            while (in > anchor && match > source && in[-1] == match[-1])
+            {
+                in--;
+                match--;
+            }
+
+            cobalt_u64_t matchLength = 4;
+            while (in + matchLength < matchEnd &&
+                   in[matchLength] == match[matchLength])
+                matchLength++;
+
+            out = writeSequence(out, anchor, in - anchor, in - match,
+                                matchLength);
+            in += matchLength;
+            anchor = in;
+        }
+    }
+
+    out = writeSequence(out, anchor, source + size - anchor, 0, 0);
+    return out - destination;
+}
+
+cobalt_u64_t Cobalt_CompressBound(cobalt_u64_t size)
+{
+    return size + size / 255 + 16;
+}
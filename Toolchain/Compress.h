@@ -0,0 +1,46 @@
+/**
+ * @file Compress.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the interface of the host-side compressor,
+ * which writes the LZ4 blocks that the bootloader's decompressor reads.
+ * It's shared by the packer and the host tests, and never built into the
+ * OS itself.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_TOOLCHAIN_COMPRESS_H
+#define COBALT_TOOLCHAIN_COMPRESS_H
+
+#include <Types.h>
+
+/**
+ * @brief Compress a buffer into a single LZ4 block, greedily, with one
+ * probe of a hash table per position.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param source The buffer to compress.
+ * @param size The size of the buffer in bytes. This may be zero.
+ * @param destination The buffer to write the block into, which must be at
+ * least Cobalt_CompressBound(size) bytes.
+ * @return The size of the block in bytes.
+ */
+cobalt_u64_t Cobalt_Compress(const cobalt_u8_t *source, cobalt_u64_t size,
+                             cobalt_u8_t *destination);
+
+/**
+ * @brief Get the largest a block compressed from a buffer can be.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @param size The size of the buffer in bytes.
+ * @return The most bytes Cobalt_Compress can write for it.
+ */
+cobalt_u64_t Cobalt_CompressBound(cobalt_u64_t size);
+
+#endif // COBALT_TOOLCHAIN_COMPRESS_H
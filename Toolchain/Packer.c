@@ -0,0 +1,158 @@
+/**
+ * @file Packer.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The host-side kernel packer. This takes the kernel PE image and
+ * writes it out as a packed container (see Headers/Pack.h), compressing
+ * each section in the LZ4 block format (see Compress.h). Every section is
+ * decompressed again with the bootloader's own decompressor before it's
+ * written, so a container that leaves this program is known to unpack
+ * correctly.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <Bootloader/Decompress.h>
+#include <Compress.h>
+#include <Headers/Pack.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static cobalt_u32_t read16(const cobalt_u8_t *bytes)
+{
+    return (cobalt_u32_t)bytes[0] | ((cobalt_u32_t)bytes[1] << 8);
+}
+
+static cobalt_u32_t read32(const cobalt_u8_t *bytes)
+{
+    return read16(bytes) | (read16(bytes + 2) << 16);
+}
+
+static void *readFile(const char *path, cobalt_u64_t *size)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == nullptr) return nullptr;
+
+    cobalt_u8_t *buffer = nullptr;
+    if (fseek(file, 0, SEEK_END) == 0)
+    {
+        long length = ftell(file);
+        if (length >= 0 && fseek(file, 0, SEEK_SET) == 0)
+        {
+            buffer = malloc(length ? length : 1);
+            if (buffer != nullptr &&
+                fread(buffer, 1, length, file) != (size_t)length)
+            {
+                free(buffer);
+                buffer = nullptr;
+            }
+            *size = length;
+        }
+    }
+
+    fclose(file);
+    return buffer;
+}
+
+static int fail(const char *message, const char *path)
+{
+    fprintf(stderr, "Packer: %s '%s'.\n", message, path);
+    return EXIT_FAILURE;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "Usage: %s [kernel image] [output]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    cobalt_u64_t imageSize;
+    cobalt_u8_t *image = readFile(argv[1], &imageSize);
+    if (image == nullptr) return fail("Failed to read", argv[1]);
+
+    // The offsets below are those of the DOS header, COFF header, optional
+    // header, and section table fields; see Headers/PE.h.
+    if (imageSize < 64 || read16(image) != 0x5A4D)
+        return fail("Invalid DOS header in", argv[1]);
+    const cobalt_u64_t peOffset = read32(image + 0x3C);
+    if (peOffset + 88 > imageSize || read32(image + peOffset) != 0x4550)
+        return fail("Invalid PE header in", argv[1]);
+
+    const cobalt_u64_t sectionCount = read16(image + peOffset + 6);
+    const cobalt_u64_t sectionOffset =
+        peOffset + 24 + read16(image + peOffset + 20);
+    const cobalt_u64_t headerSize = read32(image + peOffset + 24 + 60);
+    if (headerSize > imageSize || sectionOffset > headerSize ||
+        sectionCount * 40 > headerSize - sectionOffset)
+        return fail("Invalid section table in", argv[1]);
+
+    cobalt_pack_section_t *entries =
+        calloc(sectionCount ? sectionCount : 1, sizeof(*entries));
+    cobalt_u8_t **streams =
+        calloc(sectionCount ? sectionCount : 1, sizeof(*streams));
+    if (entries == nullptr || streams == nullptr)
+        return fail("Out of memory packing", argv[1]);
+
+    cobalt_u64_t offset = sizeof(cobalt_pack_header_t) +
+                          sectionCount * sizeof(cobalt_pack_section_t) +
+                          headerSize;
+    for (cobalt_u64_t i = 0; i < sectionCount; i++)
+    {
+        const cobalt_u8_t *section = image + sectionOffset + i * 40;
+        const cobalt_u64_t virtualSize = read32(section + 8);
+        const cobalt_u64_t rawOffset = read32(section + 20);
+        cobalt_u64_t loadSize = read32(section + 16);
+        if (virtualSize != 0 && virtualSize < loadSize)
+            loadSize = virtualSize;
+        if (loadSize != 0 &&
+            (rawOffset > imageSize || loadSize > imageSize - rawOffset))
+            return fail("Section data out of bounds in", argv[1]);
+
+        streams[i] = malloc(Cobalt_CompressBound(loadSize));
+        cobalt_u8_t *check = malloc(loadSize ? loadSize : 1);
+        if (streams[i] == nullptr || check == nullptr)
+            return fail("Out of memory packing", argv[1]);
+
+        const cobalt_u64_t compressedSize =
+            Cobalt_Compress(image + rawOffset, loadSize, streams[i]);
+        if (!Cobalt_Decompress(streams[i], compressedSize, check,
+                               loadSize) ||
+            memcmp(check, image + rawOffset, loadSize) != 0)
+            return fail("Section failed to round-trip in", argv[1]);
+        free(check);
+
+        entries[i] = (cobalt_pack_section_t){
+            .offset = (cobalt_u32_t)offset,
+            .compressedSize = (cobalt_u32_t)compressedSize,
+            .decompressedSize = (cobalt_u32_t)loadSize};
+        offset += compressedSize;
+    }
+
+    FILE *output = fopen(argv[2], "wb");
+    if (output == nullptr) return fail("Failed to open", argv[2]);
+
+    cobalt_pack_header_t header = {COBALT_PACK_MAGIC, COBALT_PACK_VERSION,
+                                   (cobalt_u32_t)headerSize,
+                                   (cobalt_u32_t)sectionCount};
+    bool written = fwrite(&header, sizeof(header), 1, output) == 1;
+    written &= fwrite(entries, sizeof(*entries), sectionCount, output) ==
+               sectionCount;
+    written &= fwrite(image, 1, headerSize, output) == headerSize;
+    for (cobalt_u64_t i = 0; i < sectionCount; i++)
+        written &= fwrite(streams[i], 1, entries[i].compressedSize,
+                          output) == entries[i].compressedSize;
+    if (fclose(output) != 0 || !written)
+        return fail("Failed to write", argv[2]);
+
+    printf("Packed %s into %s: %lu -> %lu bytes.\n", argv[1], argv[2],
+           imageSize, offset);
+    return EXIT_SUCCESS;
+}
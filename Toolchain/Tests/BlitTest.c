@@ -0,0 +1,328 @@
+/**
+ * @file BlitTest.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The host-side test and benchmark of the drawing primitives. The
+ * scalar path is checked against the arithmetic the header promises, and
+ * every vector path this processor can run is checked against the scalar
+ * one, row by row at every length up to a few vectors and at every
+ * alignment, and rectangle by rectangle with clipping and overlap. Each
+ * primitive is then timed on each path over a surface of
+ * COBALT_BLIT_BENCHMARK_SIZE squared pixels.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <Blit.h>
+#include <Tests/Test.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The longest row checked, and the slack either side of it for offsets.
+#define ROW_LENGTH 160
+#define ROW_SLACK 16
+#define ROW_SIZE (ROW_LENGTH + 2 * ROW_SLACK)
+
+// The surface the rectangles are checked on, which is narrower than its
+// pitch so that clipping has something to cut off.
+#define SURFACE_WIDTH 50
+#define SURFACE_HEIGHT 40
+#define SURFACE_PITCH 64
+#define RECTANGLES 20000
+
+#define BENCHMARK_PIXELS                                                  \
+    (COBALT_BLIT_BENCHMARK_SIZE * COBALT_BLIT_BENCHMARK_SIZE)
+
+typedef void (*fill_t)(cobalt_u32_t *destination, cobalt_u32_t pixel,
+                       cobalt_u64_t count);
+typedef void (*copy_t)(cobalt_u32_t *destination,
+                       const cobalt_u32_t *source, cobalt_u64_t count);
+typedef void (*rect_t)(const cobalt_surface_t *destination,
+                       cobalt_u64_t x, cobalt_u64_t y,
+                       const cobalt_surface_t *source,
+                       cobalt_u64_t sourceX, cobalt_u64_t sourceY,
+                       cobalt_u64_t width, cobalt_u64_t height);
+
+static const char *const pathNames[COBALT_BLIT_PATH_COUNT] = {
+    "scalar", "SSE2", "AVX2"};
+static const char *const operationNames[COBALT_BLIT_OPERATION_COUNT] = {
+    "fill", "copy", "blend", "convert"};
+
+static const fill_t fills[COBALT_BLIT_PATH_COUNT] = {
+    Cobalt_FillPixels, Cobalt_FillPixelsSSE2, Cobalt_FillPixelsAVX2};
+// Copies, blends and conversions, by operation less one and by path.
+static const copy_t copies[3][COBALT_BLIT_PATH_COUNT] = {
+    {Cobalt_CopyPixels, Cobalt_CopyPixelsSSE2, Cobalt_CopyPixelsAVX2},
+    {Cobalt_BlendPixels, Cobalt_BlendPixelsSSE2, Cobalt_BlendPixelsAVX2},
+    {Cobalt_ConvertPixels, Cobalt_ConvertPixelsSSE2,
+     Cobalt_ConvertPixelsAVX2}};
+static const rect_t rects[3] = {Cobalt_CopyRect, Cobalt_BlendRect,
+                                Cobalt_ConvertRect};
+
+static void fillRandom(cobalt_u32_t *pixels, cobalt_u64_t count)
+{
+    for (cobalt_u64_t i = 0; i < count; i++)
+        pixels[i] = (cobalt_u32_t)Cobalt_TestRandom();
+}
+
+// The scalar blend has to be exactly what the header says: every byte
+// mixed by the source's alpha and rounded to nearest.
+static bool checkBlendArithmetic(void)
+{
+    for (cobalt_u32_t alpha = 0; alpha < 256; alpha++)
+        for (cobalt_u32_t source = 0; source < 256; source++)
+            for (cobalt_u32_t destination = 0; destination < 256;
+                 destination += 3)
+            {
+                const cobalt_u32_t top = alpha << 24;
+                const cobalt_u32_t sourcePixel = top | source * 0x010101;
+                cobalt_u32_t pixel = destination * 0x01010101;
+                Cobalt_BlendPixels(&pixel, &sourcePixel, 1);
+
+                const cobalt_u32_t low =
+                    (source * alpha + destination * (255 - alpha) + 127) /
+                    255;
+                const cobalt_u32_t high =
+                    (alpha * alpha + destination * (255 - alpha) + 127) /
+                    255;
+                if (pixel != (high << 24 | low * 0x010101))
+                {
+                    fprintf(stderr,
+                            "BlitTest: blending %u at alpha %u over %u "
+                            "gave %08X.\n",
+                            source, alpha, destination, pixel);
+                    return false;
+                }
+            }
+    return true;
+}
+
+// Run one row primitive on a path and on the scalar path, over the same
+// pixels, at every length and offset, and compare everything, including
+// the pixels either side of the row.
+static bool checkRows(cobalt_u32_t operation, cobalt_blit_path_t path)
+{
+    static cobalt_u32_t expected[ROW_SIZE], actual[ROW_SIZE],
+        source[ROW_SIZE];
+    for (cobalt_u64_t length = 0; length <= ROW_LENGTH; length++)
+        for (cobalt_u64_t offset = 0; offset < ROW_SLACK; offset++)
+        {
+            const cobalt_u64_t from = Cobalt_TestRandom() % ROW_SLACK;
+            fillRandom(expected, ROW_SIZE);
+            fillRandom(source, ROW_SIZE);
+            memcpy(actual, expected, sizeof(actual));
+
+            if (operation == COBALT_BLIT_FILL)
+            {
+                const cobalt_u32_t pixel =
+                    (cobalt_u32_t)Cobalt_TestRandom();
+                fills[COBALT_BLIT_SCALAR](expected + offset, pixel,
+                                          length);
+                fills[path](actual + offset, pixel, length);
+            }
+            else if (operation == COBALT_BLIT_COPY && (length & 1))
+            {
+                // Copies may overlap, so half are within the row, shifted
+                // either way.
+                copies[0][COBALT_BLIT_SCALAR](expected + offset,
+                                              expected + from, length);
+                copies[0][path](actual + offset, actual + from, length);
+            }
+            else
+            {
+                copies[operation - 1][COBALT_BLIT_SCALAR](
+                    expected + offset, source + from, length);
+                copies[operation - 1][path](actual + offset,
+                                            source + from, length);
+            }
+
+            if (memcmp(expected, actual, sizeof(actual)) != 0)
+            {
+                fprintf(stderr,
+                        "BlitTest: %s %s of %lu at +%lu from +%lu "
+                        "failed.\n",
+                        pathNames[path], operationNames[operation],
+                        length, offset, from);
+                return false;
+            }
+        }
+    return true;
+}
+
+// The part of a length from a start that fits on a surface of the given
+// size.
+static cobalt_u64_t clip(cobalt_u64_t start, cobalt_u64_t length,
+                         cobalt_u64_t size)
+{
+    if (start >= size) return 0;
+    return length < size - start ? length : size - start;
+}
+
+// Draw random rectangles, some hanging off the surface and some
+// overlapping themselves, through the rectangle functions on a path and
+// through the scalar row functions by hand.
+static bool checkRects(cobalt_blit_path_t path)
+{
+    static cobalt_u32_t actual[SURFACE_PITCH * SURFACE_HEIGHT],
+        expected[SURFACE_PITCH * SURFACE_HEIGHT],
+        original[SURFACE_PITCH * SURFACE_HEIGHT];
+    static cobalt_u32_t other[SURFACE_PITCH * SURFACE_HEIGHT];
+    const cobalt_surface_t surface = {actual, SURFACE_WIDTH,
+                                      SURFACE_HEIGHT, SURFACE_PITCH};
+    const cobalt_surface_t otherSurface = {other, SURFACE_WIDTH,
+                                           SURFACE_HEIGHT, SURFACE_PITCH};
+    Cobalt_SetBlitPath(path);
+
+    for (cobalt_u64_t i = 0; i < RECTANGLES; i++)
+    {
+        fillRandom(actual, SURFACE_PITCH * SURFACE_HEIGHT);
+        fillRandom(other, SURFACE_PITCH * SURFACE_HEIGHT);
+        memcpy(expected, actual, sizeof(expected));
+        memcpy(original, actual, sizeof(original));
+
+        const cobalt_u32_t operation =
+            Cobalt_TestRandom() % COBALT_BLIT_OPERATION_COUNT;
+        const cobalt_u64_t x = Cobalt_TestRandom() % 60,
+                           y = Cobalt_TestRandom() % 50;
+        const cobalt_u64_t sourceX = Cobalt_TestRandom() % 60,
+                           sourceY = Cobalt_TestRandom() % 50;
+        const cobalt_u64_t width = Cobalt_TestRandom() % 70,
+                           height = Cobalt_TestRandom() % 70;
+
+        if (operation == COBALT_BLIT_FILL)
+        {
+            const cobalt_u32_t pixel = (cobalt_u32_t)Cobalt_TestRandom();
+            Cobalt_FillRect(&surface, x, y, width, height, pixel);
+            const cobalt_u64_t rows = clip(y, height, SURFACE_HEIGHT);
+            const cobalt_u64_t columns = clip(x, width, SURFACE_WIDTH);
+            for (cobalt_u64_t row = 0; row < rows; row++)
+                for (cobalt_u64_t column = 0; column < columns; column++)
+                    expected[(y + row) * SURFACE_PITCH + x + column] =
+                        pixel;
+        }
+        else
+        {
+            // Copies are done within the one surface, to check overlap;
+            // the rest go between two.
+            const bool within = operation == COBALT_BLIT_COPY;
+            const cobalt_u32_t *from = within ? original : other;
+            rects[operation - 1](&surface, x, y,
+                                 within ? &surface : &otherSurface,
+                                 sourceX, sourceY, width, height);
+
+            cobalt_u64_t columns = clip(x, width, SURFACE_WIDTH);
+            columns = clip(sourceX, columns, SURFACE_WIDTH);
+            cobalt_u64_t rows = clip(y, height, SURFACE_HEIGHT);
+            rows = clip(sourceY, rows, SURFACE_HEIGHT);
+            for (cobalt_u64_t row = 0; row < rows; row++)
+                copies[operation - 1][COBALT_BLIT_SCALAR](
+                    expected + (y + row) * SURFACE_PITCH + x,
+                    from + (sourceY + row) * SURFACE_PITCH + sourceX,
+                    columns);
+        }
+
+        if (memcmp(expected, actual, sizeof(actual)) != 0)
+        {
+            fprintf(stderr,
+                    "BlitTest: %s %s rect %lux%lu at (%lu, %lu) from "
+                    "(%lu, %lu) failed.\n",
+                    pathNames[path], operationNames[operation], width,
+                    height, x, y, sourceX, sourceY);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Time one primitive on whatever path is set, and give back megapixels
+// per second.
+static cobalt_u64_t timeOperation(cobalt_u32_t operation,
+                                  const cobalt_surface_t *target,
+                                  const cobalt_surface_t *source)
+{
+    cobalt_u64_t rounds = 0, elapsed;
+    const cobalt_u64_t start = Cobalt_TestNanoseconds();
+    do
+    {
+        if (operation == COBALT_BLIT_FILL)
+            Cobalt_FillRect(target, 0, 0, COBALT_BLIT_BENCHMARK_SIZE,
+                            COBALT_BLIT_BENCHMARK_SIZE,
+                            (cobalt_u32_t)rounds);
+        else
+            rects[operation - 1](target, 0, 0, source, 0, 0,
+                                 COBALT_BLIT_BENCHMARK_SIZE,
+                                 COBALT_BLIT_BENCHMARK_SIZE);
+        rounds++;
+        elapsed = Cobalt_TestNanoseconds() - start;
+    } while (elapsed < COBALT_TEST_BENCHMARK_TIME);
+
+    // Pixels per microsecond are megapixels per second.
+    return BENCHMARK_PIXELS * rounds * 1000 / elapsed;
+}
+
+int main(void)
+{
+    bool passed = checkBlendArithmetic();
+    bool supported[COBALT_BLIT_PATH_COUNT];
+    for (cobalt_u32_t path = 0; path < COBALT_BLIT_PATH_COUNT; path++)
+    {
+        supported[path] = Cobalt_BlitPathSupported(path);
+        if (!supported[path])
+        {
+            printf("BlitTest: this processor can't run the %s path.\n",
+                   pathNames[path]);
+            continue;
+        }
+
+        for (cobalt_u32_t operation = 0;
+             operation < COBALT_BLIT_OPERATION_COUNT && passed &&
+             path != COBALT_BLIT_SCALAR;
+             operation++)
+            passed &= checkRows(operation, path);
+        if (passed) passed &= checkRects(path);
+    }
+
+    cobalt_u32_t *scratch =
+        malloc(2 * BENCHMARK_PIXELS * sizeof(cobalt_u32_t));
+    if (scratch == nullptr) return EXIT_FAILURE;
+    fillRandom(scratch, 2 * BENCHMARK_PIXELS);
+    const cobalt_surface_t target = {scratch, COBALT_BLIT_BENCHMARK_SIZE,
+                                     COBALT_BLIT_BENCHMARK_SIZE,
+                                     COBALT_BLIT_BENCHMARK_SIZE};
+    const cobalt_surface_t source = {
+        scratch + BENCHMARK_PIXELS, COBALT_BLIT_BENCHMARK_SIZE,
+        COBALT_BLIT_BENCHMARK_SIZE, COBALT_BLIT_BENCHMARK_SIZE};
+
+    printf("%-8s", "");
+    for (cobalt_u32_t path = 0; path < COBALT_BLIT_PATH_COUNT; path++)
+        printf(" %10s", pathNames[path]);
+    puts(" (Mpx/s)");
+    for (cobalt_u32_t operation = 0;
+         operation < COBALT_BLIT_OPERATION_COUNT && passed; operation++)
+    {
+        printf("%-8s", operationNames[operation]);
+        for (cobalt_u32_t path = 0; path < COBALT_BLIT_PATH_COUNT; path++)
+        {
+            if (!supported[path])
+            {
+                printf(" %10s", "-");
+                continue;
+            }
+            Cobalt_SetBlitPath(path);
+            printf(" %10lu", timeOperation(operation, &target, &source));
+        }
+        putchar('\n');
+    }
+    printf("The fastest path here is %s.\n",
+           pathNames[Cobalt_SelectBlitPath()]);
+
+    free(scratch);
+    puts(passed ? "BlitTest: passed." : "BlitTest: FAILED.");
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,208 @@
+/**
+ * @file ConfigTest.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The host-side test of the bootloader's configuration reader.
+ * The parser is given a handful of files, good and bad, and the reader is
+ * run over a stand-in for the firmware's file protocol that, like EDK2,
+ * refuses to allocate zero pages; a missing or empty file must leave the
+ * defaults be rather than stop the boot.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <Bootloader/Config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+    const char *text;
+    cobalt_u64_t timeout;
+    const char *kernelPath;
+    cobalt_u32_t graphicsWidth;
+    cobalt_u32_t graphicsHeight;
+    EFI_GRAPHICS_PIXEL_FORMAT graphicsFormat;
+    cobalt_u64_t badLine;
+} case_t;
+
+static const case_t cases[] = {
+    {"", 5, "\\KERNEL.efi", 0, 0, PixelFormatMax, 0},
+    {"\n\n# nothing but comments\n", 5, "\\KERNEL.efi", 0, 0,
+     PixelFormatMax, 0},
+    {"timeout=0\r\nkernel = \\BOOT\\K.efi\r\ngraphics=1024x768\r\n"
+     "format=bgr",
+     0, "\\BOOT\\K.efi", 1024, 768, PixelBlueGreenRedReserved8BitPerColor,
+     0},
+    {"timeout=3601\ntimeout=12\nbogus\ngraphics=800x\nformat=any\n", 12,
+     "\\KERNEL.efi", 0, 0, PixelFormatMax, 1},
+    {"kernel=\ngraphics=640x480", 5, "\\KERNEL.efi", 640, 480,
+     PixelFormatMax, 1},
+};
+
+// The file the stand-in firmware serves, or nullptr for none.
+static const char *served;
+
+EFI_STATUS Cobalt_PrimitivePrintf(COBALT_WIDESTR format, ...)
+{
+    (void)format;
+    return EFI_SUCCESS;
+}
+
+EFI_STATUS Cobalt_PrimitivePuts(COBALT_WIDESTR string)
+{
+    (void)string;
+    return EFI_SUCCESS;
+}
+
+static EFI_STATUS EFIAPI getInfo(EFI_FILE *file, EFI_GUID *type,
+                                 UINTN *size, VOID *buffer)
+{
+    (void)file, (void)type;
+    if (*size < sizeof(EFI_FILE_INFO))
+    {
+        *size = sizeof(EFI_FILE_INFO);
+        return EFI_BUFFER_TOO_SMALL;
+    }
+    ((EFI_FILE_INFO *)buffer)->FileSize = strlen(served);
+    return EFI_SUCCESS;
+}
+
+static EFI_STATUS EFIAPI setPosition(EFI_FILE *file, UINT64 position)
+{
+    (void)file;
+    return position <= strlen(served) ? EFI_SUCCESS : EFI_DEVICE_ERROR;
+}
+
+static EFI_STATUS EFIAPI readFile(EFI_FILE *file, UINTN *size,
+                                  VOID *buffer)
+{
+    (void)file;
+    if (*size > strlen(served)) *size = strlen(served);
+    memcpy(buffer, served, *size);
+    return EFI_SUCCESS;
+}
+
+static EFI_STATUS EFIAPI closeFile(EFI_FILE *file)
+{
+    (void)file;
+    return EFI_SUCCESS;
+}
+
+static EFI_FILE file = {.Close = closeFile,
+                        .Read = readFile,
+                        .SetPosition = setPosition,
+                        .GetInfo = getInfo};
+
+static EFI_STATUS EFIAPI openFile(EFI_FILE *root, EFI_FILE **opened,
+                                  CHAR16 *path, UINT64 mode,
+                                  UINT64 attributes)
+{
+    (void)root, (void)path, (void)mode, (void)attributes;
+    if (served == nullptr) return EFI_NOT_FOUND;
+    *opened = &file;
+    return EFI_SUCCESS;
+}
+
+// EDK2 turns down a request for zero pages as being out of resources.
+static EFI_STATUS EFIAPI allocatePages(EFI_ALLOCATE_TYPE type,
+                                       EFI_MEMORY_TYPE memoryType,
+                                       UINTN pages,
+                                       EFI_PHYSICAL_ADDRESS *address)
+{
+    (void)type, (void)memoryType;
+    if (pages == 0) return EFI_OUT_OF_RESOURCES;
+    void *memory = aligned_alloc(EFI_PAGE_SIZE, pages * EFI_PAGE_SIZE);
+    if (memory == nullptr) return EFI_OUT_OF_RESOURCES;
+    *address = (EFI_PHYSICAL_ADDRESS)memory;
+    return EFI_SUCCESS;
+}
+
+static EFI_STATUS EFIAPI freePages(EFI_PHYSICAL_ADDRESS address,
+                                   UINTN pages)
+{
+    (void)pages;
+    free((void *)address);
+    return EFI_SUCCESS;
+}
+
+static EFI_STATUS EFIAPI allocatePool(EFI_MEMORY_TYPE type, UINTN size,
+                                      VOID **buffer)
+{
+    (void)type;
+    *buffer = malloc(size);
+    return *buffer != nullptr ? EFI_SUCCESS : EFI_OUT_OF_RESOURCES;
+}
+
+static EFI_STATUS EFIAPI freePool(VOID *buffer)
+{
+    free(buffer);
+    return EFI_SUCCESS;
+}
+
+static bool matchesCase(const cobalt_boot_config_t *config,
+                        const case_t *expected)
+{
+    for (cobalt_u64_t i = 0;; i++)
+    {
+        const cobalt_u8_t character = (cobalt_u8_t)expected->kernelPath[i];
+        if (config->kernelPath[i] != character) return false;
+        if (character == 0) break;
+    }
+    return config->timeout == expected->timeout &&
+           config->graphicsWidth == expected->graphicsWidth &&
+           config->graphicsHeight == expected->graphicsHeight &&
+           config->graphicsFormat == expected->graphicsFormat;
+}
+
+int main(void)
+{
+    bool passed = true;
+    EFI_FILE root = {.Open = openFile};
+    EFI_BOOT_SERVICES bootServices = {.AllocatePages = allocatePages,
+                                      .FreePages = freePages,
+                                      .AllocatePool = allocatePool,
+                                      .FreePool = freePool};
+
+    for (cobalt_u64_t i = 0; i < sizeof(cases) / sizeof(*cases); i++)
+    {
+        cobalt_boot_config_t config;
+        Cobalt_DefaultConfig(&config);
+        const cobalt_u64_t badLine = Cobalt_ParseConfig(
+            cases[i].text, strlen(cases[i].text), &config);
+        if (badLine != cases[i].badLine ||
+            !matchesCase(&config, &cases[i]))
+        {
+            fprintf(stderr, "ConfigTest: parsing case %lu failed.\n", i);
+            passed = false;
+        }
+
+        served = cases[i].text;
+        const EFI_STATUS status =
+            Cobalt_ReadConfig(&root, &bootServices, &config);
+        if (status != EFI_SUCCESS || !matchesCase(&config, &cases[i]))
+        {
+            fprintf(stderr, "ConfigTest: reading case %lu failed.\n", i);
+            passed = false;
+        }
+    }
+
+    // No file at all keeps the defaults too.
+    served = nullptr;
+    cobalt_boot_config_t config;
+    if (Cobalt_ReadConfig(&root, &bootServices, &config) != EFI_SUCCESS ||
+        !matchesCase(&config, &cases[0]))
+    {
+        fputs("ConfigTest: reading a missing file failed.\n", stderr);
+        passed = false;
+    }
+
+    puts(passed ? "ConfigTest: passed." : "ConfigTest: FAILED.");
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
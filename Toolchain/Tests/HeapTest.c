@@ -0,0 +1,269 @@
+/**
+ * @file HeapTest.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The host-side test and benchmark of the kernel heap, built with
+ * COBALT_HOSTED so that it sits on the C library. A synthetic trace of
+ * allocations and frees, mostly small with a long tail of large and huge
+ * blocks, is replayed against the heap with every block stamped and
+ * checked, then timed against the C library's own allocator. The same is
+ * done from several threads at once, each with its own arena, and the
+ * survivors are all freed from one thread to exercise remote frees.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <Kernel/Heap.h>
+#include <Tests/Test.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <threads.h>
+
+// The operations in each trace, and the blocks one can hold at once.
+#define TRACE_LENGTH (1 << 21)
+#define SLOT_COUNT (1 << 14)
+
+#define THREAD_COUNT 4
+
+// A slot index, with this bit set if the operation frees the slot rather
+// than filling it.
+#define FREE_BIT 0x80000000U
+
+typedef struct
+{
+    cobalt_u32_t slot;
+    cobalt_u32_t size;
+} operation_t;
+
+typedef struct
+{
+    void *(*allocate)(size_t size);
+    void (*free)(void *block);
+    const char *name;
+} allocator_t;
+
+typedef struct
+{
+    const operation_t *trace;
+    void **slots;
+    const allocator_t *allocator;
+    bool check;
+    bool passed;
+} replay_t;
+
+static void *heapAllocate(size_t size) { return Cobalt_Allocate(size); }
+
+static const allocator_t allocators[2] = {
+    {heapAllocate, Cobalt_Free, "heap"}, {malloc, free, "libc"}};
+
+// Most kernel objects are a few dozen bytes; buffers run to pages, and a
+// few tables are bigger than a chunk.
+static cobalt_u32_t pickSize(void)
+{
+    const cobalt_u64_t roll = Cobalt_TestRandom() % 1000;
+    if (roll < 700) return 1 + Cobalt_TestRandom() % 128;
+    if (roll < 950) return 129 + Cobalt_TestRandom() % 3968;
+    if (roll < 999) return 4097 + Cobalt_TestRandom() % (60 * 1024);
+    return 64 * 1024 + Cobalt_TestRandom() % (2 * 1024 * 1024);
+}
+
+// Hitting a random slot frees it if it's full and fills it if not, so
+// lifetimes come out random too, and the number held hovers around half
+// the slots.
+static operation_t *buildTrace(void)
+{
+    operation_t *trace = malloc(TRACE_LENGTH * sizeof(operation_t));
+    bool *full = calloc(SLOT_COUNT, sizeof(bool));
+    if (trace == nullptr || full == nullptr) return nullptr;
+
+    for (cobalt_u64_t i = 0; i < TRACE_LENGTH; i++)
+    {
+        const cobalt_u32_t slot = Cobalt_TestRandom() % SLOT_COUNT;
+        trace[i] = full[slot] ? (operation_t){slot | FREE_BIT, 0}
+                              : (operation_t){slot, pickSize()};
+        full[slot] = !full[slot];
+    }
+    free(full);
+    return trace;
+}
+
+// Blocks are stamped at both ends with a tag of their slot, which
+// catches both blocks handed out twice and blocks that overlap.
+static cobalt_u8_t tag(cobalt_u32_t slot)
+{
+    return (cobalt_u8_t)(slot ^ slot >> 8);
+}
+
+static void stamp(cobalt_u8_t *block, cobalt_u32_t slot, cobalt_u32_t size)
+{
+    block[0] = block[size - 1] = tag(slot);
+}
+
+static bool stamped(const cobalt_u8_t *block, cobalt_u32_t slot,
+                    cobalt_u32_t size)
+{
+    return block[0] == tag(slot) && block[size - 1] == tag(slot);
+}
+
+static int replay(void *argument)
+{
+    replay_t *run = argument;
+    cobalt_u32_t sizes[SLOT_COUNT];
+    for (cobalt_u64_t i = 0; i < TRACE_LENGTH; i++)
+    {
+        const operation_t operation = run->trace[i];
+        const cobalt_u32_t slot = operation.slot & ~FREE_BIT;
+        if (operation.slot & FREE_BIT)
+        {
+            if (run->check &&
+                !stamped(run->slots[slot], slot, sizes[slot]))
+                run->passed = false;
+            run->allocator->free(run->slots[slot]);
+            run->slots[slot] = nullptr;
+            continue;
+        }
+
+        cobalt_u8_t *block = run->allocator->allocate(operation.size);
+        run->slots[slot] = block;
+        if (block == nullptr)
+        {
+            run->passed = false;
+            return 0;
+        }
+        if (!run->check) continue;
+
+        sizes[slot] = operation.size;
+        if ((cobalt_u64_t)block % COBALT_HEAP_ALIGNMENT != 0 ||
+            Cobalt_AllocationSize(block) < operation.size)
+            run->passed = false;
+        stamp(block, slot, operation.size);
+    }
+    return 0;
+}
+
+// Run the trace on each of the given number of threads at once, and give
+// back the operations per microsecond they managed between them.
+static cobalt_u64_t runTrace(const operation_t *const *traces,
+                             void **slots, cobalt_u64_t threads,
+                             const allocator_t *allocator, bool check,
+                             bool *passed)
+{
+    replay_t runs[THREAD_COUNT];
+    thrd_t handles[THREAD_COUNT];
+    const cobalt_u64_t start = Cobalt_TestNanoseconds();
+    for (cobalt_u64_t i = 0; i < threads; i++)
+    {
+        runs[i] = (replay_t){traces[i], slots + i * SLOT_COUNT, allocator,
+                             check, true};
+        if (thrd_create(&handles[i], replay, &runs[i]) != thrd_success)
+            *passed = false;
+    }
+    for (cobalt_u64_t i = 0; i < threads; i++)
+    {
+        thrd_join(handles[i], nullptr);
+        *passed &= runs[i].passed;
+    }
+    const cobalt_u64_t elapsed = Cobalt_TestNanoseconds() - start;
+
+    // Whatever's left is freed from here, which for the heap means from
+    // arenas other than the ones it came from.
+    for (cobalt_u64_t i = 0; i < threads * SLOT_COUNT; i++)
+    {
+        allocator->free(slots[i]);
+        slots[i] = nullptr;
+    }
+    return threads * TRACE_LENGTH * 1000 / (elapsed != 0 ? elapsed : 1);
+}
+
+// Realloc has to keep the contents it had, whichever way the block moves.
+static bool checkReallocate(void)
+{
+    cobalt_u8_t *block = nullptr;
+    cobalt_u64_t size = 0;
+    for (cobalt_u64_t i = 0; i < 4096; i++)
+    {
+        const cobalt_u64_t newSize = pickSize();
+        block = Cobalt_Reallocate(block, newSize);
+        if (block == nullptr) return false;
+        const cobalt_u64_t kept = size < newSize ? size : newSize;
+        for (cobalt_u64_t j = 0; j < kept; j += 61)
+            if (block[j] != (cobalt_u8_t)(j * 7)) return false;
+        for (cobalt_u64_t j = 0; j < newSize; j += 61)
+            block[j] = (cobalt_u8_t)(j * 7);
+        size = newSize;
+    }
+    return Cobalt_Reallocate(block, 0) == nullptr;
+}
+
+// Every power-of-two alignment a chunk can honour.
+static bool checkAlignment(void)
+{
+    for (cobalt_u64_t alignment = 1; alignment <= 64 * 1024;
+         alignment *= 2)
+        for (cobalt_u64_t size = 1; size < 32 * 1024; size = size * 3 + 1)
+        {
+            void *block = Cobalt_AllocateAligned(size, alignment);
+            if (block == nullptr || (cobalt_u64_t)block % alignment != 0)
+                return false;
+            Cobalt_Free(block);
+        }
+    return Cobalt_AllocateAligned(64, 48) == nullptr;
+}
+
+int main(void)
+{
+    const operation_t *traces[THREAD_COUNT];
+    for (cobalt_u64_t i = 0; i < THREAD_COUNT; i++)
+        if ((traces[i] = buildTrace()) == nullptr) return EXIT_FAILURE;
+    void **slots = calloc(THREAD_COUNT * SLOT_COUNT, sizeof(void *));
+    if (slots == nullptr) return EXIT_FAILURE;
+
+    bool passed = checkReallocate() && checkAlignment();
+    if (!passed) fputs("HeapTest: realloc or alignment failed.\n", stderr);
+    for (cobalt_u64_t threads = 1; threads <= THREAD_COUNT; threads *= 2)
+    {
+        bool checked = true;
+        runTrace(traces, slots, threads, &allocators[0], true, &checked);
+        if (!checked)
+            fprintf(stderr, "HeapTest: %lu threads' trace failed.\n",
+                    threads);
+        passed &= checked;
+    }
+
+    // Every block is back, so nothing should be counted as handed out.
+    cobalt_heap_stats_t stats;
+    Cobalt_GetHeapStats(&stats);
+    if (stats.activeBytes != 0 || stats.allocations != stats.frees)
+    {
+        fprintf(stderr,
+                "HeapTest: %lu bytes and %lu blocks left active.\n",
+                stats.activeBytes, stats.allocations - stats.frees);
+        passed = false;
+    }
+
+    for (cobalt_u64_t threads = 1; threads <= THREAD_COUNT; threads *= 2)
+        for (cobalt_u64_t i = 0; i < 2; i++)
+        {
+            bool timed = true;
+            const cobalt_u64_t rate = runTrace(traces, slots, threads,
+                                               &allocators[i], false,
+                                               &timed);
+            printf("%lu threads, %s: %lu operations/us%s\n", threads,
+                   allocators[i].name, rate, timed ? "" : " (failed)");
+            passed &= timed;
+        }
+    Cobalt_GetHeapStats(&stats);
+    printf("heap holds %lu KiB after the traces\n",
+           stats.mappedBytes / 1024);
+
+    free(slots);
+    for (cobalt_u64_t i = 0; i < THREAD_COUNT; i++)
+        free((void *)traces[i]);
+    puts(passed ? "HeapTest: passed." : "HeapTest: FAILED.");
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,213 @@
+/**
+ * @file MemoryTest.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The host-side test and benchmark of the shared memory library.
+ * Every primitive is checked against a plain byte loop at every size up
+ * to a few cache lines and at powers of two from there to 64 MiB, each
+ * at a spread of alignments, with moves overlapping in both directions.
+ * Each is then timed at every power-of-four size from 1 B to 64 MiB. The
+ * library takes over the C library's own memset and the like here, just
+ * as it does in the OS, so this program's every copy goes through it.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <Memory.h>
+#include <Tests/Test.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Keep the reference loops as loops, or they'd call the library under
+// test.
+#define NO_LIBRARY_CALLS                                                  \
+    __attribute__((optimize("no-tree-loop-distribute-patterns"), noipa))
+
+#define LARGEST_SIZE (64UL * 1024 * 1024)
+
+// Room either side of the largest buffer for misalignment and overlap.
+#define SLACK 256
+
+NO_LIBRARY_CALLS static void fillRandom(cobalt_u8_t *buffer, size_t size)
+{
+    for (size_t i = 0; i < size; i++) buffer[i] = (cobalt_u8_t)(i * 131);
+    for (size_t i = 0; i < size; i += 4093)
+        buffer[i] = (cobalt_u8_t)Cobalt_TestRandom();
+}
+
+NO_LIBRARY_CALLS static bool same(const cobalt_u8_t *left,
+                                  const cobalt_u8_t *right, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        if (left[i] != right[i]) return false;
+    return true;
+}
+
+// A byte-at-a-time move, through a copy so that overlap can't matter.
+NO_LIBRARY_CALLS static void referenceMove(cobalt_u8_t *reference,
+                                           cobalt_u8_t *scratch,
+                                           size_t to, size_t from,
+                                           size_t size)
+{
+    for (size_t i = 0; i < size; i++) scratch[i] = reference[from + i];
+    for (size_t i = 0; i < size; i++) reference[to + i] = scratch[i];
+}
+
+NO_LIBRARY_CALLS static bool checkSet(cobalt_u8_t *buffer, size_t offset,
+                                      size_t size, cobalt_u8_t value)
+{
+    for (size_t i = 0; i < SLACK; i++) buffer[i] = (cobalt_u8_t)~value;
+    buffer[offset + size] = (cobalt_u8_t)~value;
+    Cobalt_SetMemory(buffer + offset, value, size);
+
+    for (size_t i = 0; i < offset; i++)
+        if (buffer[i] == value) return false;
+    for (size_t i = 0; i < size; i++)
+        if (buffer[offset + i] != value) return false;
+    return buffer[offset + size] != value;
+}
+
+// Check every primitive at one size, for a handful of alignments.
+static bool checkSize(size_t size, cobalt_u8_t *buffer,
+                      cobalt_u8_t *reference, cobalt_u8_t *scratch)
+{
+    const size_t span = size + SLACK;
+    for (size_t trial = 0; trial < 4; trial++)
+    {
+        const size_t offset = Cobalt_TestRandom() % 64;
+        const cobalt_u8_t value = (cobalt_u8_t)Cobalt_TestRandom();
+        if (!checkSet(buffer, offset, size, value))
+        {
+            fprintf(stderr, "MemoryTest: set of %zu at +%zu failed.\n",
+                    size, offset);
+            return false;
+        }
+
+        // Copy between disjoint halves, then move within one buffer by a
+        // shift either way.
+        fillRandom(buffer, 2 * span);
+        Cobalt_CopyMemory(buffer + span + offset, buffer + 1, size);
+        if (!same(buffer + span + offset, buffer + 1, size))
+        {
+            fprintf(stderr, "MemoryTest: copy of %zu failed.\n", size);
+            return false;
+        }
+
+        const size_t shift = 1 + Cobalt_TestRandom() % 80;
+        const size_t froms[2] = {SLACK / 2 - shift / 2,
+                                 SLACK / 2 + shift / 2 + 1};
+        for (size_t direction = 0; direction < 2; direction++)
+        {
+            const size_t from = froms[direction];
+            const size_t to = froms[!direction];
+            fillRandom(buffer, span);
+            for (size_t i = 0; i < span; i++) reference[i] = buffer[i];
+            Cobalt_MoveMemory(buffer + to, buffer + from, size);
+            referenceMove(reference, scratch, to, from, size);
+            if (!same(buffer, reference, span))
+            {
+                fprintf(stderr, "MemoryTest: move of %zu by %zu %s "
+                                "failed.\n",
+                        size, shift, direction ? "down" : "up");
+                return false;
+            }
+        }
+
+        // Equal buffers, then a difference at a random byte, which has to
+        // be ordered by that byte alone.
+        fillRandom(buffer, size + 1);
+        for (size_t i = 0; i < size; i++) reference[i] = buffer[i];
+        if (Cobalt_CompareMemory(buffer, reference, size) != 0)
+        {
+            fprintf(stderr, "MemoryTest: compare of %zu failed.\n", size);
+            return false;
+        }
+        if (size != 0)
+        {
+            const size_t at = Cobalt_TestRandom() % size;
+            reference[at] = (cobalt_u8_t)(buffer[at] + 1 +
+                                          Cobalt_TestRandom() % 255);
+            const int expected = buffer[at] < reference[at] ? -1 : 1;
+            if (Cobalt_CompareMemory(buffer, reference, size) != expected)
+            {
+                fprintf(stderr,
+                        "MemoryTest: compare of %zu at %zu failed.\n",
+                        size, at);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Time one primitive at one size, and give back megabytes per second.
+static cobalt_u64_t timePrimitive(int primitive, cobalt_u8_t *buffer,
+                                  size_t size)
+{
+    cobalt_u8_t *other = buffer + LARGEST_SIZE + SLACK;
+    cobalt_u64_t rounds = 0, elapsed;
+    const cobalt_u64_t start = Cobalt_TestNanoseconds();
+    do
+    {
+        // Batch the small sizes, so the clock isn't what's measured.
+        for (int i = 0; i < 64; i++)
+            switch (primitive)
+            {
+                case 0:
+                    Cobalt_SetMemory(buffer, (cobalt_u8_t)i, size);
+                    break;
+                case 1: Cobalt_CopyMemory(other, buffer, size); break;
+                case 2: Cobalt_MoveMemory(buffer + 1, buffer, size); break;
+                default:
+                    __asm__ volatile("" : : "r"(Cobalt_CompareMemory(
+                                                   other, buffer, size)));
+                    break;
+            }
+        rounds += 64;
+        elapsed = Cobalt_TestNanoseconds() - start;
+    } while (elapsed < COBALT_TEST_BENCHMARK_TIME);
+
+    // Bytes per microsecond are megabytes per second.
+    return size * rounds * 1000 / elapsed;
+}
+
+int main(void)
+{
+    const size_t bufferSize = 2 * (LARGEST_SIZE + SLACK);
+    cobalt_u8_t *buffer = malloc(bufferSize);
+    cobalt_u8_t *reference = malloc(bufferSize);
+    cobalt_u8_t *scratch = malloc(bufferSize);
+    if (buffer == nullptr || reference == nullptr || scratch == nullptr)
+        return EXIT_FAILURE;
+    bool passed = true;
+
+    for (size_t size = 0; size <= 256 && passed; size++)
+        passed &= checkSize(size, buffer, reference, scratch);
+    for (size_t size = 512; size <= LARGEST_SIZE && passed; size *= 2)
+    {
+        passed &= checkSize(size - 1, buffer, reference, scratch);
+        passed &= checkSize(size, buffer, reference, scratch);
+    }
+
+    printf("%10s %10s %10s %10s %10s (MB/s)\n", "size", "set", "copy",
+           "move", "compare");
+    Cobalt_ZeroMemory(buffer, bufferSize);
+    for (size_t size = 1; size <= LARGEST_SIZE && passed; size *= 4)
+    {
+        printf("%10zu", size);
+        for (int primitive = 0; primitive < 4; primitive++)
+            printf(" %10lu", timePrimitive(primitive, buffer, size));
+        putchar('\n');
+    }
+
+    free(buffer);
+    free(reference);
+    free(scratch);
+    puts(passed ? "MemoryTest: passed." : "MemoryTest: FAILED.");
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
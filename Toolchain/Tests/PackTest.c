@@ -0,0 +1,185 @@
+/**
+ * @file PackTest.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The host-side test and benchmark of the kernel packer's format.
+ * Sample images are compressed with the packer's compressor, decompressed
+ * again with the bootloader's decompressor, and compared byte for byte,
+ * and then the decompressor is timed over each of them. Any files named
+ * on the command line are used as samples too, alongside the synthetic
+ * ones.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <Bootloader/Decompress.h>
+#include <Compress.h>
+#include <Tests/Test.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The size of each synthetic sample.
+#define SAMPLE_SIZE (4 * 1024 * 1024)
+
+static void *readFile(const char *path, cobalt_u64_t *size)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == nullptr) return nullptr;
+
+    cobalt_u8_t *buffer = nullptr;
+    if (fseek(file, 0, SEEK_END) == 0)
+    {
+        long length = ftell(file);
+        if (length >= 0 && fseek(file, 0, SEEK_SET) == 0)
+        {
+            buffer = malloc(length ? length : 1);
+            if (buffer != nullptr &&
+                fread(buffer, 1, length, file) != (size_t)length)
+            {
+                free(buffer);
+                buffer = nullptr;
+            }
+            *size = length;
+        }
+    }
+
+    fclose(file);
+    return buffer;
+}
+
+// Compress a sample, and make sure it comes back out exactly, and that
+// the decompressor turns down a block that's been cut short or that's
+// asked for the wrong size.
+static bool roundTrip(const cobalt_u8_t *sample, cobalt_u64_t size,
+                      cobalt_u8_t *block, cobalt_u8_t *output,
+                      cobalt_u64_t *blockSize)
+{
+    *blockSize = Cobalt_Compress(sample, size, block);
+    if (*blockSize > Cobalt_CompressBound(size)) return false;
+    if (!Cobalt_Decompress(block, *blockSize, output, size) ||
+        memcmp(output, sample, size) != 0)
+        return false;
+    // An empty sample compresses to a lone token, which leaves nothing
+    // to cut or shrink.
+    if (size == 0) return true;
+    return !Cobalt_Decompress(block, *blockSize - 1, output, size) &&
+           !Cobalt_Decompress(block, *blockSize, output, size - 1);
+}
+
+// Test and time one sample, returning whether or not it round-tripped.
+static bool runSample(const char *name, const cobalt_u8_t *sample,
+                      cobalt_u64_t size)
+{
+    cobalt_u8_t *block = malloc(Cobalt_CompressBound(size));
+    cobalt_u8_t *output = malloc(size ? size : 1);
+    if (block == nullptr || output == nullptr)
+    {
+        fprintf(stderr, "PackTest: out of memory for '%s'.\n", name);
+        exit(EXIT_FAILURE);
+    }
+
+    cobalt_u64_t blockSize;
+    const bool passed = roundTrip(sample, size, block, output, &blockSize);
+    if (!passed)
+        fprintf(stderr, "PackTest: '%s' failed to round-trip.\n", name);
+    else
+    {
+        cobalt_u64_t rounds = 0;
+        const cobalt_u64_t start = Cobalt_TestNanoseconds();
+        cobalt_u64_t elapsed;
+        do
+        {
+            Cobalt_Decompress(block, blockSize, output, size);
+            rounds++;
+            elapsed = Cobalt_TestNanoseconds() - start;
+        } while (elapsed < COBALT_TEST_BENCHMARK_TIME);
+
+        // Bytes per microsecond are megabytes per second.
+        printf("%-24s %9lu -> %9lu bytes (%3lu%%), decompressed at %lu "
+               "MB/s\n",
+               name, size, blockSize, blockSize * 100 / (size ? size : 1),
+               size * rounds * 1000 / elapsed);
+    }
+
+    free(block);
+    free(output);
+    return passed;
+}
+
+int main(int argc, char **argv)
+{
+    cobalt_u8_t *sample = malloc(SAMPLE_SIZE);
+    if (sample == nullptr) return EXIT_FAILURE;
+    bool passed = true;
+
+    // Every length up to a few sequences long, since the ends of a block
+    // are where the format's rules are fussiest.
+    for (cobalt_u64_t size = 0; size <= 64; size++)
+    {
+        for (cobalt_u64_t i = 0; i < size; i++)
+            sample[i] =
+                (cobalt_u8_t)(i % 3 == 0 ? Cobalt_TestRandom() : 'a');
+        cobalt_u8_t block[128], output[64];
+        cobalt_u64_t blockSize;
+        if (!roundTrip(sample, size, block, output, &blockSize))
+        {
+            fprintf(stderr, "PackTest: %lu bytes failed to round-trip.\n",
+                    size);
+            passed = false;
+        }
+    }
+
+    memset(sample, 0, SAMPLE_SIZE);
+    passed &= runSample("zeroes", sample, SAMPLE_SIZE);
+
+    for (cobalt_u64_t i = 0; i < SAMPLE_SIZE; i++)
+        sample[i] = (cobalt_u8_t)Cobalt_TestRandom();
+    passed &= runSample("random", sample, SAMPLE_SIZE);
+
+    static const char *const words[] = {
+        "kernel ", "section ", "page ", "the ", "of ", "map ", "\n",
+        "allocate ", "free ", "thread ", "lock ", "0x", "ffff ", "= "};
+    for (cobalt_u64_t i = 0; i < SAMPLE_SIZE;)
+    {
+        const char *word = words[Cobalt_TestRandom() % 14];
+        for (; *word != 0 && i < SAMPLE_SIZE; word++) sample[i++] = *word;
+    }
+    passed &= runSample("text", sample, SAMPLE_SIZE);
+
+    // Something like machine code: short random runs, and copies of
+    // recent runs at a range of distances, some past the window.
+    for (cobalt_u64_t i = 0; i < SAMPLE_SIZE;)
+    {
+        const cobalt_u64_t length = 4 + Cobalt_TestRandom() % 28;
+        const cobalt_u64_t distance = 1 + Cobalt_TestRandom() % 100000;
+        for (cobalt_u64_t j = 0; j < length && i < SAMPLE_SIZE; j++, i++)
+            sample[i] = i >= distance && Cobalt_TestRandom() % 4 != 0
+                            ? sample[i - distance]
+                            : (cobalt_u8_t)Cobalt_TestRandom();
+    }
+    passed &= runSample("code-like", sample, SAMPLE_SIZE);
+    free(sample);
+
+    for (int i = 1; i < argc; i++)
+    {
+        cobalt_u64_t size;
+        cobalt_u8_t *image = readFile(argv[i], &size);
+        if (image == nullptr)
+        {
+            fprintf(stderr, "PackTest: failed to read '%s'.\n", argv[i]);
+            passed = false;
+            continue;
+        }
+        passed &= runSample(argv[i], image, size);
+        free(image);
+    }
+
+    puts(passed ? "PackTest: passed." : "PackTest: FAILED.");
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
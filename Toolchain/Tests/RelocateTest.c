@@ -0,0 +1,270 @@
+/**
+ * @file RelocateTest.c
+ * @authors Israfil Argos (israfiel-a)
+ * @brief The host-side test and benchmark of the bootloader's base
+ * relocation engine. A synthetic image is given a relocation table of
+ * several megabytes, which is applied both by the engine and by a naive
+ * applier that works each entry out from scratch; the two images must
+ * come out identical, for positive and negative deltas alike. Malformed
+ * tables must be turned down at the right offset. Each applier is then
+ * timed over the whole table.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+
+#include <Bootloader/Relocate.h>
+#include <Tests/Test.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PAGE_SIZE 4096
+
+// The pages of the image that get fixed up, and the entries in each
+// page's block. Each entry fixes up its own sixteen bytes of the page.
+#define PAGE_COUNT 12288
+#define ENTRIES_PER_PAGE 255
+
+#define BLOCK_SIZE                                                        \
+    (sizeof(cobalt_image_base_relocation_t) + (ENTRIES_PER_PAGE + 1) * 2)
+#define TABLE_OFFSET (PAGE_COUNT * PAGE_SIZE)
+#define TABLE_SIZE (PAGE_COUNT * BLOCK_SIZE)
+#define IMAGE_SIZE (TABLE_OFFSET + TABLE_SIZE)
+
+#define BENCHMARK_ROUNDS 8
+// The whole table is far bigger than any cache, so it's timed over a
+// slice that fits as well, which shows the cost of the loop itself.
+#define CACHED_PAGES 32
+#define CACHED_ROUNDS 2048
+
+// Fill the image with noise, and lay out its table: mostly DIR64 fixups,
+// as a 64-bit image's are, with every other kind of entry the engine
+// knows sprinkled through, and each block padded to four bytes with an
+// ABSOLUTE entry as linkers do.
+static void buildImage(cobalt_u8_t *image)
+{
+    for (cobalt_u64_t i = 0; i < TABLE_OFFSET; i += 8)
+    {
+        const cobalt_u64_t noise = Cobalt_TestRandom();
+        memcpy(image + i, &noise, 8);
+    }
+
+    for (cobalt_u64_t page = 0; page < PAGE_COUNT; page++)
+    {
+        cobalt_u8_t *block = image + TABLE_OFFSET + page * BLOCK_SIZE;
+        const cobalt_image_base_relocation_t header = {
+            (cobalt_u32_t)(page * PAGE_SIZE), (cobalt_u32_t)BLOCK_SIZE};
+        memcpy(block, &header, sizeof(header));
+
+        cobalt_u8_t *entries = block + sizeof(header);
+        for (cobalt_u64_t i = 0; i <= ENTRIES_PER_PAGE; i++)
+        {
+            const cobalt_u64_t roll = Cobalt_TestRandom() % 64;
+            cobalt_u16_t type = COBALT_RELOCATION_DIR64;
+            if (roll == 0 || i == ENTRIES_PER_PAGE)
+                type = COBALT_RELOCATION_ABSOLUTE;
+            else if (roll == 1) type = COBALT_RELOCATION_HIGHLOW;
+            else if (roll == 2) type = COBALT_RELOCATION_HIGH;
+            else if (roll == 3) type = COBALT_RELOCATION_LOW;
+            const cobalt_u16_t entry =
+                (cobalt_u16_t)(type << 12 | (type != 0 ? i * 16 : 0));
+            entries[i * 2] = (cobalt_u8_t)entry;
+            entries[i * 2 + 1] = (cobalt_u8_t)(entry >> 8);
+        }
+    }
+}
+
+// The obvious way to apply a table: every entry looks up its block's
+// header and checks its own bounds, one by one. It's kept from being
+// specialized to this file's constant sizes, which the engine, built
+// apart, can't be either.
+__attribute__((noipa)) static bool
+naiveRelocate(cobalt_u8_t *image, cobalt_u64_t imageSize,
+              cobalt_u64_t tableOffset, cobalt_u64_t tableSize,
+              cobalt_i64_t delta)
+{
+    cobalt_u64_t blockOffset = 0;
+    while (blockOffset + 8 <= tableSize)
+    {
+        cobalt_image_base_relocation_t header;
+        memcpy(&header, image + tableOffset + blockOffset, 8);
+        if (header.SizeOfBlock == 0) break;
+        if (header.SizeOfBlock < 8) return false;
+
+        for (cobalt_u64_t entryOffset = 8;
+             entryOffset < header.SizeOfBlock; entryOffset += 2)
+        {
+            cobalt_u16_t entry;
+            memcpy(&entry, image + tableOffset + blockOffset + entryOffset,
+                   2);
+            const cobalt_u64_t address =
+                header.VirtualAddress + (entry & 0xFFF);
+            const cobalt_u32_t type = entry >> 12;
+
+            if (type == COBALT_RELOCATION_ABSOLUTE) continue;
+            if (type == COBALT_RELOCATION_DIR64)
+            {
+                if (address + 8 > imageSize) return false;
+                cobalt_u64_t field;
+                memcpy(&field, image + address, 8);
+                field += (cobalt_u64_t)delta;
+                memcpy(image + address, &field, 8);
+            }
+            else if (type == COBALT_RELOCATION_HIGHLOW)
+            {
+                if (address + 4 > imageSize) return false;
+                cobalt_u32_t field;
+                memcpy(&field, image + address, 4);
+                field += (cobalt_u32_t)delta;
+                memcpy(image + address, &field, 4);
+            }
+            else if (type == COBALT_RELOCATION_HIGH ||
+                     type == COBALT_RELOCATION_LOW)
+            {
+                if (address + 2 > imageSize) return false;
+                cobalt_u16_t field;
+                memcpy(&field, image + address, 2);
+                field += (cobalt_u16_t)(type == COBALT_RELOCATION_HIGH
+                                            ? (cobalt_u64_t)delta >> 16
+                                            : (cobalt_u64_t)delta);
+                memcpy(image + address, &field, 2);
+            }
+            else return false;
+        }
+        blockOffset += header.SizeOfBlock;
+    }
+    return true;
+}
+
+// Write one entry of the first block.
+static void setEntry(cobalt_u8_t *image, cobalt_u64_t index,
+                     cobalt_u16_t entry)
+{
+    cobalt_u8_t *field = image + TABLE_OFFSET +
+                         sizeof(cobalt_image_base_relocation_t) +
+                         index * 2;
+    field[0] = (cobalt_u8_t)entry;
+    field[1] = (cobalt_u8_t)(entry >> 8);
+}
+
+static bool expectFailure(cobalt_u8_t *image, const char *name,
+                          cobalt_relocate_status_t expected,
+                          cobalt_u64_t expectedOffset)
+{
+    cobalt_u64_t failureOffset = ~0UL;
+    const cobalt_relocate_status_t status =
+        Cobalt_Relocate(image, IMAGE_SIZE, TABLE_OFFSET, TABLE_SIZE, 4096,
+                        &failureOffset);
+    if (status == expected && failureOffset == expectedOffset) return true;
+    fprintf(stderr,
+            "RelocateTest: %s gave status %d at %lu, not %d at %lu.\n",
+            name, status, failureOffset, expected, expectedOffset);
+    return false;
+}
+
+// Time both appliers over the blocks of the first few pages, alternating
+// the delta's sign so the image ends up as it started.
+static bool benchmark(cobalt_u8_t *image, cobalt_u64_t pages,
+                      cobalt_u32_t rounds)
+{
+    const cobalt_u64_t tableSize = pages * BLOCK_SIZE;
+    cobalt_u64_t engineTime = 0, naiveTime = 0;
+    bool applied = true;
+    for (cobalt_u32_t round = 0; round < rounds; round++)
+    {
+        const cobalt_i64_t delta = round & 1 ? -0x200000 : 0x200000;
+        cobalt_u64_t failureOffset;
+        cobalt_u64_t start = Cobalt_TestNanoseconds();
+        applied &= Cobalt_Relocate(image, IMAGE_SIZE, TABLE_OFFSET,
+                                   tableSize, delta, &failureOffset) ==
+                   COBALT_RELOCATE_SUCCESS;
+        engineTime += Cobalt_TestNanoseconds() - start;
+
+        start = Cobalt_TestNanoseconds();
+        applied &= naiveRelocate(image, IMAGE_SIZE, TABLE_OFFSET,
+                                 tableSize, -delta);
+        naiveTime += Cobalt_TestNanoseconds() - start;
+    }
+
+    // Entries per microsecond are millions per second.
+    const cobalt_u64_t entries = pages * (ENTRIES_PER_PAGE + 1);
+    printf("%5lu KiB table, %7lu entries: engine %6lu us (%lu M "
+           "entries/s), naive %6lu us (%lu M entries/s)\n",
+           tableSize / 1024, entries, engineTime / rounds / 1000,
+           entries * rounds * 1000 / (engineTime + 1),
+           naiveTime / rounds / 1000,
+           entries * rounds * 1000 / (naiveTime + 1));
+    return applied;
+}
+
+int main(void)
+{
+    cobalt_u8_t *original = malloc(IMAGE_SIZE);
+    cobalt_u8_t *engine = malloc(IMAGE_SIZE);
+    cobalt_u8_t *naive = malloc(IMAGE_SIZE);
+    if (original == nullptr || engine == nullptr || naive == nullptr)
+        return EXIT_FAILURE;
+    buildImage(original);
+    bool passed = true;
+
+    static const cobalt_i64_t deltas[] = {0x1000, -0x200000,
+                                          0x123456789ABC, -1};
+    for (cobalt_u64_t i = 0; i < sizeof(deltas) / sizeof(*deltas); i++)
+    {
+        memcpy(engine, original, IMAGE_SIZE);
+        memcpy(naive, original, IMAGE_SIZE);
+        cobalt_u64_t failureOffset;
+        const bool applied =
+            Cobalt_Relocate(engine, IMAGE_SIZE, TABLE_OFFSET, TABLE_SIZE,
+                            deltas[i],
+                            &failureOffset) == COBALT_RELOCATE_SUCCESS;
+        if (!applied ||
+            !naiveRelocate(naive, IMAGE_SIZE, TABLE_OFFSET, TABLE_SIZE,
+                           deltas[i]) ||
+            memcmp(engine, naive, IMAGE_SIZE) != 0)
+        {
+            fprintf(stderr, "RelocateTest: delta %ld came out wrong.\n",
+                    deltas[i]);
+            passed = false;
+        }
+    }
+
+    // Each of these breaks the first block, so the engine has to stop
+    // there and say where.
+    const cobalt_u64_t firstEntry = sizeof(cobalt_image_base_relocation_t);
+    memcpy(engine, original, IMAGE_SIZE);
+    setEntry(engine, 3, 7 << 12);
+    passed &= expectFailure(engine, "an unknown type",
+                            COBALT_RELOCATE_UNKNOWN_TYPE, firstEntry + 6);
+
+    memcpy(engine, original, IMAGE_SIZE);
+    const cobalt_u32_t lastPage = (cobalt_u32_t)(IMAGE_SIZE - 4);
+    memcpy(engine + TABLE_OFFSET, &lastPage, sizeof(lastPage));
+    setEntry(engine, 0, COBALT_RELOCATION_DIR64 << 12);
+    passed &= expectFailure(engine, "a field past the end",
+                            COBALT_RELOCATE_ENTRY_OUT_OF_BOUNDS,
+                            firstEntry);
+
+    memcpy(engine, original, IMAGE_SIZE);
+    const cobalt_u32_t oddSize = BLOCK_SIZE - 1;
+    memcpy(engine + TABLE_OFFSET + 4, &oddSize, sizeof(oddSize));
+    passed &= expectFailure(engine, "an odd block size",
+                            COBALT_RELOCATE_MALFORMED_BLOCK, 0);
+
+    memcpy(engine, original, IMAGE_SIZE);
+    passed &= benchmark(engine, PAGE_COUNT, BENCHMARK_ROUNDS);
+    passed &= benchmark(engine, CACHED_PAGES, CACHED_ROUNDS);
+    passed &= memcmp(engine, original, IMAGE_SIZE) == 0;
+
+    free(original);
+    free(engine);
+    free(naive);
+    puts(passed ? "RelocateTest: passed." : "RelocateTest: FAILED.");
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
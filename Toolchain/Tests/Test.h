@@ -0,0 +1,66 @@
+/**
+ * @file Test.h
+ * @authors Israfil Argos (israfiel-a)
+ * @brief This file contains the helpers every host-side test shares: a
+ * seeded random number generator, so that each run checks the same
+ * inputs, and a clock to time the benchmarks with.
+ * @since 0.1.0.6
+ * @updated 0.1.0.6
+ *
+ * @copyright (c) 2025 Israfil Argos
+ * This file is under the AGPLv3. For information on what that entails, see
+ * the attached LICENSE.md file or
+ * https://www.gnu.org/licenses/agpl-3.0.en.html.
+ */
+#ifndef COBALT_TOOLCHAIN_TEST_H
+#define COBALT_TOOLCHAIN_TEST_H
+
+#include <Types.h>
+#include <time.h>
+
+/**
+ * @brief How long each benchmark is run over and over for, at least, in
+ * nanoseconds.
+ * @since 0.1.0.6
+ */
+#define COBALT_TEST_BENCHMARK_TIME 100000000
+
+/**
+ * @brief The state of the random number generator. Each test is one
+ * program with one translation unit including this, so each gets its own
+ * copy, starting from the same seed.
+ * @since 0.1.0.6
+ */
+static cobalt_u64_t cobalt_test_state = 0x9E3779B97F4A7C15;
+
+/**
+ * @brief Get the next number from a xorshift generator. This is nowhere
+ * near good enough for anything but making test inputs.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return The number.
+ */
+static inline cobalt_u64_t Cobalt_TestRandom(void)
+{
+    cobalt_test_state ^= cobalt_test_state << 13;
+    cobalt_test_state ^= cobalt_test_state >> 7;
+    cobalt_test_state ^= cobalt_test_state << 17;
+    return cobalt_test_state;
+}
+
+/**
+ * @brief Read the wall clock.
+ * @authors Israfil Argos
+ * @since 0.1.0.6
+ *
+ * @return The time in nanoseconds, from an arbitrary point.
+ */
+static inline cobalt_u64_t Cobalt_TestNanoseconds(void)
+{
+    struct timespec time;
+    timespec_get(&time, TIME_UTC);
+    return time.tv_sec * 1000000000UL + time.tv_nsec;
+}
+
+#endif // COBALT_TOOLCHAIN_TEST_H
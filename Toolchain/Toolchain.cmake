@@ -1,7 +1,7 @@
 ####################################################################
 ## PROJECT TOOLCHAIN
 ## SINCE 0.1.0.0
-## UPDATED 0.1.0.1
+## UPDATED 0.1.0.6
 ## This file contains the definition for the toolchain CMake will
 ## use to take the OS from source to binary. It includes
 ## definitions for things like the compiler and linker.
@@ -23,7 +23,7 @@ set(CMAKE_C_COMPILER_TARGET x86_64-none-elf)
 set(CMAKE_C_FLAGS_RELEASE "-ffreestanding -fpic                    \
     -fno-stack-protector -mno-stack-arg-probe -fshort-wchar        \
     -mno-red-zone -Wall -Wextra -Werror -Wpedantic -Ofast          \
-    -mgeneral-regs-only -mabi=ms -nostdlib -march=x86-64           \
+    -mabi=ms -nostdlib -march=x86-64                               \
     -mtune=native -flto -s -fno-asynchronous-unwind-tables         \
     -Wno-gnu-zero-variadic-macro-arguments")
 set(CMAKE_EXE_LINKER_FLAGS "LINKER:-Bsymbolic LINKER:-znocombreloc \